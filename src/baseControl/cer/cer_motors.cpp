@@ -47,9 +47,10 @@ bool CER_MotorControl::open(const Property &_options)
     ok = ok & control_board_driver->view(ivel);
     ok = ok & control_board_driver->view(ienc);
     ok = ok & control_board_driver->view(ipwm);
-    ok = ok & control_board_driver->view(ipid);
-    ok = ok & control_board_driver->view(iamp);
     ok = ok & control_board_driver->view(icmd);
+    //pid and amplifier interfaces are not used by the controller, so they are optional
+    control_board_driver->view(ipid);
+    control_board_driver->view(iamp);
     if(!ok)
     {
         yError("One or more devices has not been viewed, returning\n");
@@ -444,7 +444,10 @@ bool ControlThread::threadInit()
 
     int trials  = 0;
     double      start_time = yarp::os::Time::now();
-    Property    control_board_options("(device remote_controlboard)");
+    Property    control_board_options;
+
+    //the device can be replaced (e.g. by a simulated control board) for testing purposes
+    control_board_options.put("device", ctrl_options.check("control_board_device", Value("remote_controlboard"), "the device used to control the wheels").asString());
 
     control_board_options.put("remote", remoteName.c_str());
     control_board_options.put("local", localName.c_str());
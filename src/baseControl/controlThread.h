@@ -120,6 +120,7 @@ public:
     OdometryHandler* const      get_odometry_handler() { return m_odometry_handler;}
     MotorControl* const  get_motor_handler()    { return m_motor_handler;}
     Input* const         get_input_handler()    { return m_input_handler; }
+    PolyDriver* const    get_control_board_driver() { return control_board_driver; }
     void                 enable_debug(bool b);
 
 public:
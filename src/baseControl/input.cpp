@@ -27,42 +27,69 @@
 
 void Input::printStats()
 {
+    double now = Time::now();
     yInfo( "* Input thread:\n");
     if (rosInputEnabled)
     {
-       yInfo( "timeouts: %d joy1: %d joy2: %d aux: %d cmd: %d ros: %d\n", thread_timeout_counter, joy_timeout_counter[0], joy_timeout_counter[1], aux_timeout_counter, mov_timeout_counter, ros_timeout_counter);
+       yInfo( "timeouts: %d joy1: %d joy2: %d aux: %d cmd: %d ros: %d\n", thread_timeout_counter,
+              input_mux.timeout_counter(INPUT_SOURCE_JOYSTICK1), input_mux.timeout_counter(INPUT_SOURCE_JOYSTICK2),
+              input_mux.timeout_counter(INPUT_SOURCE_AUXILIARY), input_mux.timeout_counter(INPUT_SOURCE_COMMAND),
+              input_mux.timeout_counter(INPUT_SOURCE_ROS));
     }
     else
     {
-	   yInfo( "timeouts: %d joy1: %d joy2: %d aux: %d cmd: %d\n", thread_timeout_counter, joy_timeout_counter[0], joy_timeout_counter[1], aux_timeout_counter, mov_timeout_counter);
+       yInfo( "timeouts: %d joy1: %d joy2: %d aux: %d cmd: %d\n", thread_timeout_counter,
+              input_mux.timeout_counter(INPUT_SOURCE_JOYSTICK1), input_mux.timeout_counter(INPUT_SOURCE_JOYSTICK2),
+              input_mux.timeout_counter(INPUT_SOURCE_AUXILIARY), input_mux.timeout_counter(INPUT_SOURCE_COMMAND));
     }
 
-    if (joystick_received[0]>0) 
-        yInfo( "Under joystick1 control (%d)\n", joystick_received[0]);
-    if (joystick_received[1]>0) 
-        yInfo( "Under joystick2 control (%d)\n", joystick_received[1]);
+    if (input_mux.has_control(INPUT_SOURCE_JOYSTICK1, now))
+        yInfo( "Under joystick1 control\n");
+    if (input_mux.has_control(INPUT_SOURCE_JOYSTICK2, now))
+        yInfo( "Under joystick2 control\n");
 }
 
 void Input::close()
 {
+    if (rosInputEnabled)
+    {
+        rosSubscriberPort_twist.disableCallback();
+        rosSubscriberPort_twist.interrupt();
+        rosSubscriberPort_twist.close();
+        rosInputEnabled = false;
+    }
+    port_movement_control.disableCallback();
+    port_auxiliary_control.disableCallback();
     port_movement_control.interrupt();
     port_movement_control.close();
     port_auxiliary_control.interrupt();
     port_auxiliary_control.close();
     if (port_joystick_control[0])
     {
+        port_joystick_control[0]->disableCallback();
         port_joystick_control[0]->interrupt();
         port_joystick_control[0]->close();
         delete port_joystick_control[0];
         port_joystick_control[0]=0;
     }
+    if (reader_joystick_control[0])
+    {
+        delete reader_joystick_control[0];
+        reader_joystick_control[0]=0;
+    }
     if (port_joystick_control[1])
     {
+        port_joystick_control[1]->disableCallback();
         port_joystick_control[1]->interrupt();
         port_joystick_control[1]->close();
         delete port_joystick_control[1];
         port_joystick_control[1]=0;
     }
+    if (reader_joystick_control[1])
+    {
+        delete reader_joystick_control[1];
+        reader_joystick_control[1]=0;
+    }
 }
 
 Input::~Input()
@@ -185,9 +212,11 @@ bool Input::open(Property &_options)
     ctrl_options = _options;
     localName    = ctrl_options.find("local").asString();
 
-    // open control input ports
+    // open control input ports. Received commands are decoded by the reader callbacks as soon as they arrive.
     port_movement_control.open((localName+"/control:i").c_str());
     port_auxiliary_control.open((localName+"/aux_control:i").c_str());
+    port_movement_control.useCallback(reader_movement_control);
+    port_auxiliary_control.useCallback(reader_auxiliary_control);
 
     if (!ctrl_options.check("GENERAL"))
     {
@@ -209,6 +238,10 @@ bool Input::open(Property &_options)
     }
     useRos = general_options.check("use_ROS", Value(false), "enable ROS communication").asBool();
 
+    //a joystick command keeps the control of the robot for input_hold_time seconds (default: 100 cycles of 20ms)
+    input_mux.set_hold_time(general_options.check("input_hold_time", Value(2.0), "time a command keeps the control of the robot [s]").asDouble());
+    input_mux.set_watchdog_timeout(general_options.check("input_watchdog_timeout", Value(0.200), "timeout after which a command is zeroed [s]").asDouble());
+
     if (useRos)
     {
         if (ctrl_options.check("ROS_INPUT"))
@@ -228,6 +261,10 @@ bool Input::open(Property &_options)
             yError() << " opening " << rosTopicName_twist << " Topic, check your yarp-ROS network configuration\n";
             return false;
         }
+        if (rosInputEnabled)
+        {
+            rosSubscriberPort_twist.useCallback(rosReader_twist);
+        }
     }
     
 
@@ -256,6 +293,8 @@ bool Input::open(Property &_options)
         {
              port_joystick_control[0]=new BufferedPort<Bottle>;
              port_joystick_control[0]->open((localName+"/joystick1:i").c_str());
+             reader_joystick_control[0]=new InputPortReader(this, INPUT_SOURCE_JOYSTICK1);
+             port_joystick_control[0]->useCallback(*reader_joystick_control[0]);
         }
         else
         {
@@ -290,6 +329,8 @@ bool Input::open(Property &_options)
         {
              port_joystick_control[1]=new BufferedPort<Bottle>;
              port_joystick_control[1]->open((localName+"/joystick2:i").c_str());
+             reader_joystick_control[1]=new InputPortReader(this, INPUT_SOURCE_JOYSTICK2);
+             port_joystick_control[1]->useCallback(*reader_joystick_control[1]);
         }
         else
         {
@@ -310,51 +351,21 @@ bool Input::open(Property &_options)
     return true;
 }
 
-Input::Input()
+Input::Input() :
+    rosReader_twist(this),
+    reader_movement_control(this, INPUT_SOURCE_COMMAND),
+    reader_auxiliary_control(this, INPUT_SOURCE_AUXILIARY)
 {
     useRos                 = false;
+    rosInputEnabled        = false;
 
     thread_timeout_counter = 0;
+    wdt_old                = Time::now();
 
-    command_received       = 0;
-    rosInput_received      = 0;
-    joystick_received[0]   = 0;
-    joystick_received[1]   = 0;
-    auxiliary_received     = 0;
-                           
     port_joystick_control[0] =0;
     port_joystick_control[1] =0;
-
-    mov_timeout_counter    = 0;
-    joy_timeout_counter[0] = 0;
-    joy_timeout_counter[1] = 0;
-    aux_timeout_counter    = 0;
-    ros_timeout_counter    = 0;
-
-    joy_linear_speed[0]      = 0;
-    joy_angular_speed[0]     = 0;
-    joy_desired_direction[0] = 0;
-    joy_pwm_gain[0]          = 0;
-
-    joy_linear_speed[1]      = 0;
-    joy_angular_speed[1]     = 0;
-    joy_desired_direction[1] = 0;
-    joy_pwm_gain[1]          = 0;
-
-    cmd_linear_speed       = 0;
-    cmd_angular_speed      = 0;
-    cmd_desired_direction  = 0;
-    cmd_pwm_gain           = 0;
-
-    aux_linear_speed       = 0;
-    aux_angular_speed      = 0;
-    aux_desired_direction  = 0;
-    aux_pwm_gain           = 0;
-    
-    ros_linear_speed       = 0;
-    ros_angular_speed      = 0;
-    ros_desired_direction  = 0;
-    ros_pwm_gain           = 0;
+    reader_joystick_control[0] =0;
+    reader_joystick_control[1] =0;
 
     linear_vel_at_100_joy  = 0;
     angular_vel_at_100_joy = 0;
@@ -438,265 +449,107 @@ void Input::read_joystick_data(JoyDescription *jDescr, IJoypadController* iJoy,
     pwm_gain = (pwm_gain>0) ? pwm_gain : 0;
 }
 
-void Input::read_inputs(double& linear_speed,double& angular_speed,double& desired_direction, double& pwm_gain)
+void InputPortReader::onRead(Bottle& b)
 {
-    static double wdt_old_mov_cmd = Time::now();
-    static double wdt_old_ros_cmd = Time::now();
-    static double wdt_old_joy_cmd = Time::now();
-    static double wdt_old_aux_cmd = Time::now();
-    static double wdt_mov_cmd     = Time::now();
-    static double wdt_ros_cmd     = Time::now();
-    static double wdt_joy_cmd[2]  = {Time::now(), Time::now()};
-    static double wdt_aux_cmd     = Time::now();
-
-    //- - -read joysticks - - -
-    for (int id=0; id<2; id++)
-    {
-        if (port_joystick_control[id])
-        if (Bottle* b = port_joystick_control[id]->read(false))
-        {                
-            if (b->get(0).asInt()== BASECONTROL_COMMAND_PERCENT_POLAR)
-            {
-                //received a joystick command.
-                read_percent_polar(b, joy_desired_direction[id],joy_linear_speed[id],joy_angular_speed[id],joy_pwm_gain[id]);
-                joy_linear_speed[id] = (joy_linear_speed[id] > 100) ? 100 : joy_linear_speed[id];
-                joy_angular_speed[id] = (joy_angular_speed[id] > 100) ? 100 : joy_angular_speed[id];
-                joy_linear_speed[id] = (joy_linear_speed[id] < -100) ? -100 : joy_linear_speed[id];
-                joy_angular_speed[id] = (joy_angular_speed[id] < -100) ? -100 : joy_angular_speed[id];
-                joy_linear_speed[id] = joy_linear_speed[id] / 100 * linear_vel_at_100_joy;
-                joy_angular_speed[id] = joy_angular_speed[id] / 100 * angular_vel_at_100_joy;
-                wdt_old_joy_cmd = wdt_joy_cmd[id];
-                wdt_joy_cmd[id] = Time::now();
-
-                //Joystick commands have higher priority respect to movement commands.
-                //this make the joystick to take control for 100*20 ms
-                if (joy_pwm_gain[id]>10) joystick_received[id] = 100;
-            }
-            else if (b->get(0).asInt() == BASECONTROL_COMMAND_VELOCIY_POLAR)
-            {
-                //received a joystick command.
-                read_speed_polar(b, joy_desired_direction[id], joy_linear_speed[id], joy_angular_speed[id], joy_pwm_gain[id]);
-                joy_linear_speed[id] = (joy_linear_speed[id] > 100) ? 100 : joy_linear_speed[id];
-                joy_angular_speed[id] = (joy_angular_speed[id] > 100) ? 100 : joy_angular_speed[id];
-                joy_linear_speed[id] = (joy_linear_speed[id] < -100) ? -100 : joy_linear_speed[id];
-                joy_angular_speed[id] = (joy_angular_speed[id] < -100) ? -100 : joy_angular_speed[id];
-                joy_linear_speed[id] = joy_linear_speed[id] / 100 * linear_vel_at_100_joy;
-                joy_angular_speed[id] = joy_angular_speed[id] / 100 * angular_vel_at_100_joy;
-                wdt_old_joy_cmd = wdt_joy_cmd[id];
-                wdt_joy_cmd[id] = Time::now();
-
-                //Joystick commands have higher priority respect to movement commands.
-                //this make the joystick to take control for 100*20 ms
-                if (joy_pwm_gain[id]>10) joystick_received[id] = 100;
-            }
-            else if (b->get(0).asInt() == BASECONTROL_COMMAND_VELOCIY_CARTESIAN)
-            {
-                //received a joystick command.
-                read_speed_cart(b, joy_desired_direction[id], joy_linear_speed[id], joy_angular_speed[id], joy_pwm_gain[id]);
-                joy_linear_speed[id] = (joy_linear_speed[id] > 100) ? 100 : joy_linear_speed[id];
-                joy_angular_speed[id] = (joy_angular_speed[id] > 100) ? 100 : joy_angular_speed[id];
-                joy_linear_speed[id] = (joy_linear_speed[id] < -100) ? -100 : joy_linear_speed[id];
-                joy_angular_speed[id] = (joy_angular_speed[id] < -100) ? -100 : joy_angular_speed[id];
-                joy_linear_speed[id] = joy_linear_speed[id] / 100 * linear_vel_at_100_joy;
-                joy_angular_speed[id] = joy_angular_speed[id] / 100 * angular_vel_at_100_joy;
-                wdt_old_joy_cmd = wdt_joy_cmd[id];
-                wdt_joy_cmd[id] = Time::now();
-
-                //Joystick commands have higher priority respect to movement commands.
-                //this make the joystick to take control for 100*20 ms
-                if (joy_pwm_gain[id]>10) joystick_received[id] = 100;
-            }
-            else
-            {
-                yError() << "Invalid format received on port_joystick_control";
-            }
-        }
+    m_input->push_port_command(m_source, b);
+}
 
-        //- - -read joystick2 - - -
-        if(iJoy[id])
-        {
-            read_joystick_data(&jDescr[id], iJoy[id],joy_desired_direction[id], joy_linear_speed[id], joy_angular_speed[id], joy_pwm_gain[id]);
-            joy_linear_speed[id] = (joy_linear_speed[id] > 100) ? 100 : joy_linear_speed[id];
-            joy_angular_speed[id] = (joy_angular_speed[id] > 100) ? 100 : joy_angular_speed[id];
-            joy_linear_speed[id] = (joy_linear_speed[id] < -100) ? -100 : joy_linear_speed[id];
-            joy_angular_speed[id] = (joy_angular_speed[id] < -100) ? -100 : joy_angular_speed[id];
-            joy_linear_speed[id] = joy_linear_speed[id] / 100 * linear_vel_at_100_joy;
-            joy_angular_speed[id] = joy_angular_speed[id] / 100 * angular_vel_at_100_joy;
-            wdt_old_joy_cmd = wdt_joy_cmd[id];
-            wdt_joy_cmd[id] = Time::now();
-
-            //Joystick commands have higher priority respect to movement commands.
-            //this make the joystick to take control for 100*20 ms
-            if (joy_pwm_gain[id]>10) joystick_received[id] = 100;
-        }
-    }
+void InputRosReader::onRead(yarp::rosmsg::geometry_msgs::Twist& twist)
+{
+    m_input->push_ros_command(twist);
+}
 
-    //- - - read command port - - -
-    if (Bottle *b = port_movement_control.read(false))
-    {
-        if (b->get(0).asInt()== BASECONTROL_COMMAND_PERCENT_POLAR)
-        {
-            read_percent_polar(b, cmd_desired_direction,cmd_linear_speed,cmd_angular_speed,cmd_pwm_gain);
-            wdt_old_mov_cmd = wdt_mov_cmd;
-            wdt_mov_cmd = Time::now();
-            command_received = 100;
-        }
-        else if (b->get(0).asInt()== BASECONTROL_COMMAND_VELOCIY_POLAR)
-        {
-            read_speed_polar(b, cmd_desired_direction,cmd_linear_speed,cmd_angular_speed,cmd_pwm_gain);
-            wdt_old_mov_cmd = wdt_mov_cmd;
-            wdt_mov_cmd = Time::now();
-            command_received = 100;
-        }
-        else if (b->get(0).asInt()== BASECONTROL_COMMAND_VELOCIY_CARTESIAN)
-        {
-            read_speed_cart(b, cmd_desired_direction,cmd_linear_speed,cmd_angular_speed,cmd_pwm_gain);
-            wdt_old_mov_cmd = wdt_mov_cmd;
-            wdt_mov_cmd = Time::now();
-            command_received = 100;
-        }
-        else
-        {
-            yError() << "Invalid format received on port_movement_control";
-        }
-    }
+void Input::push_joystick_command(int id, double des_dir, double lin_spd, double ang_spd, double pwm_gain)
+{
+    lin_spd = (lin_spd > 100) ? 100 : lin_spd;
+    ang_spd = (ang_spd > 100) ? 100 : ang_spd;
+    lin_spd = (lin_spd < -100) ? -100 : lin_spd;
+    ang_spd = (ang_spd < -100) ? -100 : ang_spd;
+    lin_spd = lin_spd / 100 * linear_vel_at_100_joy;
+    ang_spd = ang_spd / 100 * angular_vel_at_100_joy;
+
+    //Joystick commands have higher priority respect to movement commands.
+    //this make the joystick to take control for input_hold_time seconds
+    input_source_enum src = (id == 0) ? INPUT_SOURCE_JOYSTICK1 : INPUT_SOURCE_JOYSTICK2;
+    input_mux.slot(src).push(des_dir, lin_spd, ang_spd, pwm_gain, pwm_gain > 10);
+}
 
-    //- - -read aux port - - -
-    if (Bottle *b = port_auxiliary_control.read(false))
-    {
-        if (b->get(0).asInt()== BASECONTROL_COMMAND_PERCENT_POLAR)
-        {
-            read_percent_polar(b, aux_desired_direction,aux_linear_speed,aux_angular_speed,aux_pwm_gain);
-            wdt_old_aux_cmd = wdt_aux_cmd;
-            wdt_aux_cmd = Time::now();
-            auxiliary_received = 100;
-        }
-        else if (b->get(0).asInt()== BASECONTROL_COMMAND_VELOCIY_POLAR)
-        {
-            read_speed_polar(b, aux_desired_direction,aux_linear_speed,aux_angular_speed,aux_pwm_gain);
-            wdt_old_aux_cmd = wdt_aux_cmd;
-            wdt_aux_cmd = Time::now();
-            auxiliary_received = 100;
-        }
-        else if (b->get(0).asInt()== BASECONTROL_COMMAND_VELOCIY_CARTESIAN)
-        {
-            read_speed_cart(b, aux_desired_direction,aux_linear_speed,aux_angular_speed,aux_pwm_gain);
-            wdt_old_aux_cmd = wdt_aux_cmd;
-            wdt_aux_cmd = Time::now();
-            auxiliary_received = 100;
-        }
-        else
-        {
-            yError() << "Invalid format received on port_auxiliary_control";
-        }
-    }
-    
-    //- - - read ROS commands - - -
-    if (rosInputEnabled)
-    {
-        if (yarp::rosmsg::geometry_msgs::Twist* rosTwist = rosSubscriberPort_twist.read(false))
-        {
-            Bottle b;
-            b.addInt(3);
-            b.addDouble(rosTwist->linear.x);
-            b.addDouble(rosTwist->linear.y);
-            b.addDouble(rosTwist->angular.z * 180 / M_PI);
-            b.addDouble(100);
-            read_speed_cart(&b, ros_desired_direction, ros_linear_speed, ros_angular_speed, ros_pwm_gain);
-            wdt_old_ros_cmd   = wdt_ros_cmd;
-            wdt_ros_cmd       = Time::now();
-            rosInput_received = 100;
-        }
-    }
+void Input::push_port_command(input_source_enum src, const Bottle& b)
+{
+    double des_dir  = 0;
+    double lin_spd  = 0;
+    double ang_spd  = 0;
+    double pwm_gain = 0;
 
-    //- - - priority test - - -
-    if (joystick_received[0]>0)
+    int type = b.get(0).asInt();
+    if (type == BASECONTROL_COMMAND_PERCENT_POLAR)
     {
-        desired_direction  = joy_desired_direction[0];
-        linear_speed       = joy_linear_speed[0];
-        angular_speed      = joy_angular_speed[0];
-        pwm_gain           = joy_pwm_gain[0];
+        read_percent_polar(&b, des_dir, lin_spd, ang_spd, pwm_gain);
     }
-    else if (joystick_received[1]>0)
+    else if (type == BASECONTROL_COMMAND_VELOCIY_POLAR)
     {
-        desired_direction  = joy_desired_direction[1];
-        linear_speed       = joy_linear_speed[1];
-        angular_speed      = joy_angular_speed[1];
-        pwm_gain           = joy_pwm_gain[1];
+        read_speed_polar(&b, des_dir, lin_spd, ang_spd, pwm_gain);
     }
-    else if (auxiliary_received>0)
+    else if (type == BASECONTROL_COMMAND_VELOCIY_CARTESIAN)
     {
-        desired_direction  = aux_desired_direction;
-        linear_speed       = aux_linear_speed;
-        angular_speed      = aux_angular_speed;
-        pwm_gain           = aux_pwm_gain;
+        read_speed_cart(&b, des_dir, lin_spd, ang_spd, pwm_gain);
     }
-    else if (rosInput_received>0)
-    {
-        desired_direction  = ros_desired_direction;
-        linear_speed       = ros_linear_speed;
-        angular_speed      = ros_angular_speed;
-        pwm_gain           = ros_pwm_gain;
-    }
-    else //if (command_received>0)
+    else
     {
-        desired_direction  = cmd_desired_direction;
-        linear_speed       = cmd_linear_speed;
-        angular_speed      = cmd_angular_speed;
-        pwm_gain           = cmd_pwm_gain;
+        if      (src == INPUT_SOURCE_COMMAND)   yError() << "Invalid format received on port_movement_control";
+        else if (src == INPUT_SOURCE_AUXILIARY) yError() << "Invalid format received on port_auxiliary_control";
+        else                                    yError() << "Invalid format received on port_joystick_control";
+        return;
     }
 
-    //watchdog on received commands
-    static double wdt_old=Time::now();
-    double wdt=Time::now();
-    //yDebug("period: %f\n", wdt-wdt_old);
-    if (wdt-wdt_mov_cmd > 0.200)
-    {
-        cmd_desired_direction=0;
-        cmd_linear_speed=0;
-        cmd_angular_speed=0;
-        cmd_pwm_gain=0;
-        mov_timeout_counter++; 
-    }
-    if (wdt-wdt_joy_cmd[0] > 0.200)
-    {
-        joy_desired_direction[0]=0;
-        joy_linear_speed[0]=0;
-        joy_angular_speed[0]=0;
-        joy_pwm_gain[0]=0;
-        joy_timeout_counter[0]++;
-    }
-    if (wdt-wdt_joy_cmd[1] > 0.200)
+    if (src == INPUT_SOURCE_JOYSTICK1 || src == INPUT_SOURCE_JOYSTICK2)
     {
-        joy_desired_direction[1]=0;
-        joy_linear_speed[1]=0;
-        joy_angular_speed[1]=0;
-        joy_pwm_gain[1]=0;
-        joy_timeout_counter[1]++;
+        push_joystick_command((src == INPUT_SOURCE_JOYSTICK1) ? 0 : 1, des_dir, lin_spd, ang_spd, pwm_gain);
     }
-    if (wdt-wdt_aux_cmd > 0.200)
+    else
     {
-        aux_desired_direction=0;
-        aux_linear_speed=0;
-        aux_angular_speed=0;
-        aux_pwm_gain=0;
-        aux_timeout_counter++;
+        input_mux.slot(src).push(des_dir, lin_spd, ang_spd, pwm_gain, true);
     }
-    if (wdt-wdt_ros_cmd > 0.200)
+}
+
+void Input::push_ros_command(const yarp::rosmsg::geometry_msgs::Twist& twist)
+{
+    Bottle b;
+    b.addInt(BASECONTROL_COMMAND_VELOCIY_CARTESIAN);
+    b.addDouble(twist.linear.x);
+    b.addDouble(twist.linear.y);
+    b.addDouble(twist.angular.z * 180 / M_PI);
+    b.addDouble(100);
+
+    double des_dir, lin_spd, ang_spd, pwm_gain;
+    read_speed_cart(&b, des_dir, lin_spd, ang_spd, pwm_gain);
+    input_mux.slot(INPUT_SOURCE_ROS).push(des_dir, lin_spd, ang_spd, pwm_gain, true);
+}
+
+void Input::read_inputs(double& linear_speed,double& angular_speed,double& desired_direction, double& pwm_gain)
+{
+    //- - -read joypad devices - - -
+    //joypad devices do not provide a callback mechanism, so they are sampled here
+    for (int id=0; id<2; id++)
     {
-        ros_desired_direction=0;
-        ros_linear_speed=0;
-        ros_angular_speed=0;
-        ros_pwm_gain=0;
-        ros_timeout_counter++;
+        if(iJoy[id])
+        {
+            double des_dir, lin_spd, ang_spd, gain;
+            read_joystick_data(&jDescr[id], iJoy[id], des_dir, lin_spd, ang_spd, gain);
+            push_joystick_command(id, des_dir, lin_spd, ang_spd, gain);
+        }
     }
 
+    //- - - priority test and watchdog on received commands - - -
+    //all the other sources have been already decoded by the reader callbacks
+    double wdt = Time::now();
+    InputCommand cmd;
+    input_mux.select(wdt, cmd);
+    desired_direction  = cmd.desired_direction;
+    linear_speed       = cmd.linear_speed;
+    angular_speed      = cmd.angular_speed;
+    pwm_gain           = cmd.pwm_gain;
+
     if (wdt-wdt_old > 0.040) { thread_timeout_counter++;  }
     wdt_old=wdt;
-
-    if (joystick_received[0]>0)  { joystick_received[0]--;  }
-    if (joystick_received[1]>0)  { joystick_received[1]--;  }
-    if (command_received>0)    { command_received--;   }
-    if (auxiliary_received>0)  { auxiliary_received--; }
-    if (rosInput_received>0)   { rosInput_received--; }
 }
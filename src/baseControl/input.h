@@ -40,11 +40,40 @@
 #include <string>
 #include <math.h>
 
+#include "inputMux.h"
+
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::dev;
 
+class Input;
+
+/**
+* Reader callback for the YARP command ports. Decodes the received bottle and pushes it into the slot of its source.
+*/
+class InputPortReader : public TypedReaderCallback<Bottle>
+{
+    Input*             m_input;
+    input_source_enum  m_source;
 
+public:
+    InputPortReader(Input* input, input_source_enum source) : m_input(input), m_source(source) {}
+    using TypedReaderCallback<Bottle>::onRead;
+    virtual void onRead(Bottle& b) override;
+};
+
+/**
+* Reader callback for the ROS cmd_vel topic.
+*/
+class InputRosReader : public TypedReaderCallback<yarp::rosmsg::geometry_msgs::Twist>
+{
+    Input*             m_input;
+
+public:
+    InputRosReader(Input* input) : m_input(input) {}
+    using TypedReaderCallback<yarp::rosmsg::geometry_msgs::Twist>::onRead;
+    virtual void onRead(yarp::rosmsg::geometry_msgs::Twist& twist) override;
+};
 
 class Input
 {
@@ -79,44 +108,14 @@ private:
     Property            ctrl_options;
     string              localName;
     int                 thread_timeout_counter;
+    double              wdt_old;
 
-    int                 command_received;
-    int                 rosInput_received;
-    int                 auxiliary_received;
-    int                 joystick_received[2];
     JoyDescription      jDescr[2];
-
-    //watchdog counters
-    int                 mov_timeout_counter;
-    int                 aux_timeout_counter;
-    int                 joy_timeout_counter[2];
-    int                 ros_timeout_counter;
-
-    //movement control variables: joypad input
-    double              joy_linear_speed[2];
-    double              joy_angular_speed[2];
-    double              joy_desired_direction[2];
-    double              joy_pwm_gain[2];
     double              linear_vel_at_100_joy;
     double              angular_vel_at_100_joy;
 
-    //standard input via YARP port
-    double              cmd_linear_speed;
-    double              cmd_angular_speed;
-    double              cmd_desired_direction;
-    double              cmd_pwm_gain;
-
-    //aux input via YARP port
-    double              aux_linear_speed;
-    double              aux_angular_speed;
-    double              aux_desired_direction;
-    double              aux_pwm_gain;
-    
-    //ROS input
-    double              ros_linear_speed;
-    double              ros_angular_speed;
-    double              ros_desired_direction;
-    double              ros_pwm_gain;
+    //the commands received from all the sources, one slot per source
+    InputMux            input_mux;
 
 protected:
     // ROS input
@@ -125,10 +124,15 @@ protected:
     bool                              useRos;
     bool                              rosInputEnabled;
 
+    InputRosReader                    rosReader_twist;
+
     // YARP ports input
     BufferedPort<Bottle>              port_movement_control;
     BufferedPort<Bottle>              port_auxiliary_control;
     BufferedPort<Bottle>*             port_joystick_control[2];
+    InputPortReader                   reader_movement_control;
+    InputPortReader                   reader_auxiliary_control;
+    InputPortReader*                  reader_joystick_control[2];
 
     //Joypad input
     PolyDriver                        joyPolyDriver[2];
@@ -172,7 +176,21 @@ public:
     * @param pwm_gain the pwm gain (0-100). Joypad emergency button typically sets this value to zero to stop the robot. User modules, instead, do not use this value (always set to 100)/
     */
     void   read_inputs        (double& linear_speed, double& angular_speed, double& desired_direction, double& pwm_gain);
-    
+
+    /**
+    * Decodes a command bottle received from a YARP port and stores it in the slot of the given source.
+    * This method is called by the port reader callbacks, as soon as a command is received.
+    * @param src the source of the command
+    * @param b the received bottle
+    */
+    void   push_port_command  (input_source_enum src, const Bottle& b);
+
+    /**
+    * Decodes a twist received from the ROS topic and stores it in the ROS slot.
+    * @param twist the received message
+    */
+    void   push_ros_command   (const yarp::rosmsg::geometry_msgs::Twist& twist);
+
 private:
 
     /**
@@ -190,6 +208,9 @@ private:
     void   read_speed_cart    (const Bottle *b, double& des_dir, double& lin_spd, double& ang_spd, double& pwm_gain);
     void   read_joystick_data (JoyDescription *jDescr,IJoypadController* iJoy, double& des_dir, double& lin_spd, double& ang_spd, double& pwm_gain);
 
+    //Converts joystick units (percent) to metric units and stores the command in the joystick slot
+    void   push_joystick_command (int id, double des_dir, double lin_spd, double ang_spd, double pwm_gain);
+
     //Performs conversion from joypad stick units to metric units
     double get_linear_vel_at_100_joy()   { return linear_vel_at_100_joy; }
     double get_angular_vel_at_100_joy()  { return angular_vel_at_100_joy; }
@@ -0,0 +1,99 @@
+/*
+* Copyright (C)2015  iCub Facility - Istituto Italiano di Tecnologia
+* Author: Marco Randazzo
+* email:  marco.randazzo@iit.it
+* website: www.robotcub.org
+* Permission is granted to copy, distribute, and/or modify this program
+* under the terms of the GNU General Public License, version 2 or any
+* later version published by the Free Software Foundation.
+*
+* A copy of the license can be found at
+* http://www.robotcub.org/icub/license/gpl.txt
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details
+*/
+
+#include "inputMux.h"
+#include <yarp/os/Time.h>
+
+InputSlot::InputSlot() : m_write_index(0)
+{
+}
+
+void InputSlot::push(double desired_direction, double linear_speed, double angular_speed, double pwm_gain, bool take_control)
+{
+    //only the producer writes the index, so a relaxed load is enough here
+    unsigned int idx = m_write_index.load(std::memory_order_relaxed);
+    const InputCommand& prev = m_buffer[idx % SLOT_SIZE];
+    InputCommand& next = m_buffer[(idx + 1) % SLOT_SIZE];
+
+    next.desired_direction = desired_direction;
+    next.linear_speed      = linear_speed;
+    next.angular_speed     = angular_speed;
+    next.pwm_gain          = pwm_gain;
+    next.stamp             = yarp::os::Time::now();
+    next.control_stamp     = take_control ? next.stamp : prev.control_stamp;
+
+    m_write_index.store(idx + 1, std::memory_order_release);
+}
+
+InputCommand InputSlot::peek() const
+{
+    while (true)
+    {
+        unsigned int idx1 = m_write_index.load(std::memory_order_acquire);
+        if (idx1 == 0) return InputCommand();
+        InputCommand cmd = m_buffer[idx1 % SLOT_SIZE];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned int idx2 = m_write_index.load(std::memory_order_relaxed);
+        //the copied entry is reused by the producer only after SLOT_SIZE-1 further pushes
+        if (idx2 - idx1 < SLOT_SIZE - 1) return cmd;
+    }
+}
+
+InputMux::InputMux()
+{
+    m_hold_time        = 2.0;
+    m_watchdog_timeout = 0.200;
+    for (int i = 0; i < INPUT_SOURCE_NUMBER; i++)
+    {
+        m_timeout_counter[i] = 0;
+    }
+}
+
+bool InputMux::has_control(input_source_enum src, double now) const
+{
+    InputCommand cmd = m_slots[src].peek();
+    return (now - cmd.control_stamp < m_hold_time);
+}
+
+input_source_enum InputMux::select(double now, InputCommand& cmd)
+{
+    input_source_enum winner = INPUT_SOURCE_COMMAND;
+    bool found = false;
+    for (int i = 0; i < INPUT_SOURCE_NUMBER; i++)
+    {
+        InputCommand c = m_slots[i].peek();
+        bool expired = (now - c.stamp > m_watchdog_timeout);
+        if (expired)
+        {
+            c.desired_direction = 0;
+            c.linear_speed = 0;
+            c.angular_speed = 0;
+            c.pwm_gain = 0;
+            m_timeout_counter[i]++;
+        }
+        //the first source (in priority order) which holds the control wins.
+        //If no source holds the control, the standard command port is used.
+        if (!found && (now - c.control_stamp < m_hold_time || i == INPUT_SOURCE_COMMAND))
+        {
+            winner = (input_source_enum)(i);
+            cmd = c;
+            found = true;
+        }
+    }
+    return winner;
+}
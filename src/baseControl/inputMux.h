@@ -0,0 +1,126 @@
+/*
+* Copyright (C)2015  iCub Facility - Istituto Italiano di Tecnologia
+* Author: Marco Randazzo
+* email:  marco.randazzo@iit.it
+* website: www.robotcub.org
+* Permission is granted to copy, distribute, and/or modify this program
+* under the terms of the GNU General Public License, version 2 or any
+* later version published by the Free Software Foundation.
+*
+* A copy of the license can be found at
+* http://www.robotcub.org/icub/license/gpl.txt
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+* Public License for more details
+*/
+
+#ifndef INPUT_MUX_H
+#define INPUT_MUX_H
+
+#include <atomic>
+
+/**
+* The sources of velocity commands handled by baseControl.
+* The order of the enum is the priority order: lower values win over higher values.
+*/
+enum input_source_enum
+{
+    INPUT_SOURCE_JOYSTICK1 = 0,
+    INPUT_SOURCE_JOYSTICK2 = 1,
+    INPUT_SOURCE_AUXILIARY = 2,
+    INPUT_SOURCE_ROS       = 3,
+    INPUT_SOURCE_COMMAND   = 4,
+    INPUT_SOURCE_NUMBER    = 5
+};
+
+/**
+* A velocity command, as received from one of the input sources.
+*/
+struct InputCommand
+{
+    double desired_direction;
+    double linear_speed;
+    double angular_speed;
+    double pwm_gain;
+    double stamp;            //time of reception of the command
+    double control_stamp;    //time of reception of the last command which claimed the control of the robot
+
+    InputCommand() : desired_direction(0), linear_speed(0), angular_speed(0), pwm_gain(0), stamp(-1e9), control_stamp(-1e9) {}
+};
+
+/**
+* A single-producer/single-consumer lock-free slot holding the most recent command of an input source.
+* The producer (typically a port reader callback) calls push(), the consumer (the control thread) calls peek().
+* The slot is a small ring: the producer never waits, the consumer retries only if the producer has
+* overwritten the entry it was copying.
+*/
+class InputSlot
+{
+    static const unsigned int SLOT_SIZE = 4;
+
+    InputCommand               m_buffer[SLOT_SIZE];
+    std::atomic<unsigned int>  m_write_index;
+
+public:
+    InputSlot();
+
+    /**
+    * Stores a new command. Must be called by a single producer thread.
+    * @param take_control if true, the command claims the control of the robot (updates the control_stamp)
+    */
+    void         push(double desired_direction, double linear_speed, double angular_speed, double pwm_gain, bool take_control);
+
+    /**
+    * Returns a copy of the most recent command. If no command has been received yet, a zero command is returned.
+    */
+    InputCommand peek() const;
+
+    /**
+    * Returns the number of commands received so far.
+    */
+    unsigned int count() const { return m_write_index.load(std::memory_order_acquire); }
+};
+
+/**
+* Multiplexes the velocity commands received from the different sources.
+* Each source owns a slot; the command to be executed is the one of the highest priority source which
+* claimed the control in the last hold_time seconds. Commands older than watchdog_timeout are replaced by a zero command.
+*/
+class InputMux
+{
+    InputSlot  m_slots[INPUT_SOURCE_NUMBER];
+    int        m_timeout_counter[INPUT_SOURCE_NUMBER];
+    double     m_hold_time;
+    double     m_watchdog_timeout;
+
+public:
+    InputMux();
+
+    void   set_hold_time        (double t) { m_hold_time = t; }
+    void   set_watchdog_timeout (double t) { m_watchdog_timeout = t; }
+    double get_hold_time        () const   { return m_hold_time; }
+
+    /**
+    * Returns the slot of a given source. Producers push their commands directly into the slot.
+    */
+    InputSlot& slot(input_source_enum src) { return m_slots[src]; }
+
+    /**
+    * Selects the winning command.
+    * @param now the current time
+    * @param cmd the selected command (zeroed if expired)
+    * @return the source of the selected command
+    */
+    input_source_enum select(double now, InputCommand& cmd);
+
+    /**
+    * Returns true if the given source currently holds the control of the robot
+    */
+    bool   has_control    (input_source_enum src, double now) const;
+
+    int    timeout_counter(input_source_enum src) const { return m_timeout_counter[src]; }
+};
+
+#endif
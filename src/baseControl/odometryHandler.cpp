@@ -293,3 +293,12 @@ double OdometryHandler::get_base_vel_theta()
 {
     return this->base_vel_theta;
 }
+
+void OdometryHandler::get_odometry(double& x, double& y, double& theta)
+{
+    mutex.wait();
+    x = this->odom_x;
+    y = this->odom_y;
+    theta = this->odom_theta;
+    mutex.post();
+}
@@ -174,6 +174,14 @@ public:
     */
     virtual double get_base_vel_theta();
 
+    /**
+    * Get the current robot pose, expressed in the odometry reference frame
+    * @param x the x position [m]
+    * @param y the y position [m]
+    * @param theta the orientation [deg]
+    */
+    virtual void   get_odometry(double& x, double& y, double& theta);
+
     /**
     * Returns the linear velocity coefficient, defined by robot kinematic model
     * @return the coefficient
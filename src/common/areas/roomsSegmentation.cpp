@@ -0,0 +1,291 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * \section roomsSegmentation
+ * This tool splits the maps of a map server into rooms and stores them in the server as areas.
+ * The maps are segmented in parallel and the results are cached: a map is segmented again only if its content changed.
+ */
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Network.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/IMap2D.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/math/Vec2D.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rooms_segmentation.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+
+struct map_rooms
+{
+    string                name;
+    MapGrid2D             map;
+    uint64_t              hash;
+    bool                  cached;
+    bool                  valid;
+    vector<string>        names;
+    vector<Map2DArea>     areas;
+
+    map_rooms() : hash(0), cached(false), valid(false) {}
+};
+
+//the cache is a text file with the hash of each map and the areas computed for it
+static void loadCache(const string& filename, std::map<string, map_rooms>& cache)
+{
+    ifstream in(filename);
+    if (!in.is_open())
+    {
+        return;
+    }
+    string tag;
+    while (in >> tag)
+    {
+        if (tag != "map") break;
+        string map_name;
+        size_t num_areas = 0;
+        map_rooms entry;
+        in >> map_name >> std::hex >> entry.hash >> std::dec >> num_areas;
+        for (size_t i = 0; in && i < num_areas; i++)
+        {
+            string area_name;
+            size_t num_points = 0;
+            in >> tag >> area_name >> num_points;
+            Map2DArea area;
+            area.map_id = map_name;
+            for (size_t k = 0; in && k < num_points; k++)
+            {
+                double x = 0, y = 0;
+                in >> x >> y;
+                area.points.push_back(yarp::math::Vec2D<double>(x, y));
+            }
+            entry.names.push_back(area_name);
+            entry.areas.push_back(area);
+        }
+        if (!in)
+        {
+            yWarning() << "Invalid cache file" << filename << ", all the maps will be segmented";
+            cache.clear();
+            return;
+        }
+        entry.name = map_name;
+        entry.valid = true;
+        cache[map_name] = entry;
+    }
+}
+
+static bool saveCache(const string& filename, const vector<map_rooms>& maps)
+{
+    ofstream out(filename);
+    if (!out.is_open())
+    {
+        yError() << "Unable to write" << filename;
+        return false;
+    }
+    out.precision(17);
+    for (size_t m = 0; m < maps.size(); m++)
+    {
+        if (!maps[m].valid) continue;
+        out << "map " << maps[m].name << " " << std::hex << maps[m].hash << std::dec << " " << maps[m].areas.size() << "\n";
+        for (size_t i = 0; i < maps[m].areas.size(); i++)
+        {
+            const Map2DArea& area = maps[m].areas[i];
+            out << "area " << maps[m].names[i] << " " << area.points.size();
+            for (size_t k = 0; k < area.points.size(); k++)
+            {
+                out << " " << area.points[k].x << " " << area.points[k].y;
+            }
+            out << "\n";
+        }
+    }
+    return true;
+}
+
+static void segmentMaps(const rooms_segmentation& segmentation, vector<map_rooms>& maps, atomic<size_t>& next_map)
+{
+    for (size_t m = next_map++; m < maps.size(); m = next_map++)
+    {
+        if (maps[m].cached) continue;
+        double t_start = Time::now();
+        maps[m].valid = segmentation.segment(maps[m].map, maps[m].areas, maps[m].names);
+        yInfo() << "Map" << maps[m].name << ":" << maps[m].areas.size() << "rooms found in" << Time::now() - t_start << "s";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Network yarp;
+    if (!yarp.checkNetwork())
+    {
+        yError("check Yarp network.\n");
+        return -1;
+    }
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.configure(argc, argv);
+
+    if (rf.check("help"))
+    {
+        yInfo() << "Options:";
+        yInfo() << "--remote <port> (default /mapServer)";
+        yInfo() << "--maps \"(<map_id> ...)\" (default all the maps of the server)";
+        yInfo() << "--cache <file> (default roomsSegmentation.cache)";
+        yInfo() << "--threads <number> (default as many as the cores)";
+        yInfo() << "--peaks_threshold <0-1>";
+        yInfo() << "--polygon_accuracy <cells>";
+        yInfo() << "--min_room_area <m^2>";
+        yInfo() << "--area_prefix <string>";
+        yInfo() << "--dry_run (does not store the areas into the server)";
+        return 0;
+    }
+
+    string remote = rf.check("remote", Value("/mapServer")).asString();
+    string cache_file = rf.check("cache", Value("roomsSegmentation.cache")).asString();
+    size_t num_threads = rf.check("threads", Value(0)).asInt32();
+    bool dry_run = rf.check("dry_run");
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+
+    rooms_segmentation::parameters params;
+    params.peaks_threshold = rf.check("peaks_threshold", Value(params.peaks_threshold)).asFloat64();
+    params.polygon_accuracy = rf.check("polygon_accuracy", Value(params.polygon_accuracy)).asFloat64();
+    params.min_room_area = rf.check("min_room_area", Value(params.min_room_area)).asFloat64();
+    params.area_prefix = rf.check("area_prefix", Value(params.area_prefix)).asString();
+    rooms_segmentation segmentation(params);
+
+    //open a client for the server
+    PolyDriver pMap;
+    IMap2D* iMap = nullptr;
+    Property map_options;
+    map_options.put("device", "map2DClient");
+    map_options.put("local", "/roomsSegmentation"); //This is just a prefix. map2DClient will complete the port name.
+    map_options.put("remote", remote);
+    if (pMap.open(map_options) == false)
+    {
+        yError() << "Unable to open map2DClient";
+        return -1;
+    }
+    pMap.view(iMap);
+    if (iMap == nullptr)
+    {
+        yError() << "Unable to open map interface";
+        return -1;
+    }
+
+    vector<string> map_names;
+    if (rf.check("maps") && rf.find("maps").isList())
+    {
+        Bottle* b = rf.find("maps").asList();
+        for (size_t i = 0; i < b->size(); i++) map_names.push_back(b->get(i).asString());
+    }
+    else if (!iMap->get_map_names(map_names))
+    {
+        yError() << "Unable to get the list of the maps";
+        return -1;
+    }
+
+    //the maps are received from the server one at a time, the cpu intensive part is done in parallel
+    std::map<string, map_rooms> cache;
+    loadCache(cache_file, cache);
+    vector<map_rooms> maps(map_names.size());
+    size_t to_segment = 0;
+    for (size_t m = 0; m < map_names.size(); m++)
+    {
+        maps[m].name = map_names[m];
+        if (!iMap->get_map(map_names[m], maps[m].map))
+        {
+            yError() << "Map" << map_names[m] << "not found";
+            maps[m].cached = true;
+            continue;
+        }
+        maps[m].hash = segmentation.hash(maps[m].map);
+        auto it = cache.find(map_names[m]);
+        if (it != cache.end() && it->second.hash == maps[m].hash)
+        {
+            yInfo() << "Map" << map_names[m] << "is not changed, using the cached rooms";
+            maps[m].names = it->second.names;
+            maps[m].areas = it->second.areas;
+            maps[m].cached = true;
+            maps[m].valid = true;
+            continue;
+        }
+        to_segment++;
+    }
+
+    double t_start = Time::now();
+    atomic<size_t> next_map(0);
+    vector<thread> workers;
+    for (size_t i = 1; i < std::min(num_threads, to_segment); i++)
+    {
+        workers.push_back(thread(segmentMaps, std::cref(segmentation), std::ref(maps), std::ref(next_map)));
+    }
+    segmentMaps(segmentation, maps, next_map);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    yInfo() << to_segment << "of" << maps.size() << "maps segmented in" << Time::now() - t_start << "s";
+
+    //keep also the maps which have not been received this time
+    for (auto it = cache.begin(); it != cache.end(); it++)
+    {
+        if (std::find(map_names.begin(), map_names.end(), it->first) != map_names.end()) continue;
+        maps.push_back(it->second);
+    }
+    saveCache(cache_file, maps);
+
+    if (dry_run)
+    {
+        pMap.close();
+        return 0;
+    }
+
+    vector<string> server_areas;
+    iMap->getAreasList(server_areas);
+    int errors = 0;
+    for (size_t m = 0; m < map_names.size(); m++)
+    {
+        if (!maps[m].valid) continue;
+
+        //remove the rooms of a previous segmentation which are not present anymore
+        string prefix = map_names[m] + "_" + params.area_prefix;
+        for (size_t i = 0; i < server_areas.size(); i++)
+        {
+            if (server_areas[i].compare(0, prefix.size(), prefix) != 0) continue;
+            if (std::find(maps[m].names.begin(), maps[m].names.end(), server_areas[i]) != maps[m].names.end()) continue;
+            iMap->deleteArea(server_areas[i]);
+        }
+
+        for (size_t i = 0; i < maps[m].areas.size(); i++)
+        {
+            if (!iMap->storeArea(maps[m].names[i], maps[m].areas[i]))
+            {
+                yError() << "Area" << maps[m].names[i] << "failed to store into map server";
+                errors++;
+            }
+        }
+        yInfo() << maps[m].areas.size() << "areas of map" << map_names[m] << "stored into map server";
+    }
+
+    pMap.close();
+    return (errors == 0) ? 0 : -1;
+}
@@ -0,0 +1,208 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "rooms_segmentation.h"
+#include <yarp/math/Vec2D.h>
+#include <yarp/os/LogStream.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace yarp::dev::Nav2D;
+
+//https://docs.opencv.org/3.1.0/d2/dbd/tutorial_distance_transform.html
+
+namespace
+{
+    void hash_bytes(uint64_t& hash, const void* data, size_t size)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ p[i]) * 1099511628211ULL;
+        }
+    }
+
+    void hash_double(uint64_t& hash, double v)
+    {
+        unsigned char b[sizeof(double)];
+        memcpy(b, &v, sizeof(double));
+        hash_bytes(hash, b, sizeof(double));
+    }
+}
+
+rooms_segmentation::parameters::parameters()
+{
+    peaks_threshold = 0.4;
+    polygon_accuracy = 3;
+    min_room_area = 1.0;
+    area_prefix = "auto_area";
+}
+
+rooms_segmentation::rooms_segmentation(const parameters& params)
+{
+    m_params = params;
+}
+
+bool rooms_segmentation::segment(const MapGrid2D& map, std::vector<Map2DArea>& areas, std::vector<std::string>& names) const
+{
+    areas.clear();
+    names.clear();
+    size_t w = map.width();
+    size_t h = map.height();
+    if (w == 0 || h == 0)
+    {
+        yError() << "rooms_segmentation: the map" << map.getMapName() << "is empty";
+        return false;
+    }
+    double resolution = 0;
+    map.getResolution(resolution);
+
+    //free cells are white, walls and unknown cells are black
+    cv::Mat img(h, w, CV_8UC1);
+    cv::Mat unknown = cv::Mat::zeros(h, w, CV_8UC1);
+    XYCell cell;
+    for (cell.y = 0; cell.y < h; cell.y++)
+    {
+        unsigned char* img_row = img.ptr<unsigned char>(cell.y);
+        unsigned char* unknown_row = unknown.ptr<unsigned char>(cell.y);
+        for (cell.x = 0; cell.x < w; cell.x++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(cell, flag);
+            img_row[cell.x] = (flag == MapGrid2D::map_flags::MAP_CELL_WALL || flag == MapGrid2D::map_flags::MAP_CELL_UNKNOWN) ? 0 : 255;
+            unknown_row[cell.x] = (flag == MapGrid2D::map_flags::MAP_CELL_UNKNOWN) ? 255 : 0;
+        }
+    }
+
+    //the peaks of the distance from the obstacles are the centers of the rooms
+    cv::Mat dist;
+    cv::distanceTransform(img, dist, cv::DIST_L2, 3);
+    cv::normalize(dist, dist, 0, 1., cv::NORM_MINMAX);
+    cv::threshold(dist, dist, m_params.peaks_threshold, 1., cv::THRESH_BINARY);
+    cv::Mat kernel = cv::Mat::ones(3, 3, CV_8UC1);
+    cv::dilate(dist, dist, kernel);
+    cv::Mat peaks;
+    dist.convertTo(peaks, CV_8U);
+    std::vector<std::vector<cv::Point> > seeds;
+    cv::findContours(peaks, seeds, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+    if (seeds.empty())
+    {
+        yWarning() << "rooms_segmentation: no rooms found in map" << map.getMapName();
+        return true;
+    }
+
+    //markers for the watershed: the seeds are labeled 1..n, the unknown cells are the background
+    int num_seeds = static_cast<int>(seeds.size());
+    cv::Mat markers = cv::Mat::zeros(h, w, CV_32SC1);
+    for (int i = 0; i < num_seeds; i++)
+    {
+        cv::drawContours(markers, seeds, i, cv::Scalar::all(i + 1), cv::FILLED);
+    }
+    markers.setTo(cv::Scalar::all(num_seeds + 1), unknown);
+
+    cv::Mat img_rgb;
+    cv::cvtColor(img, img_rgb, cv::COLOR_GRAY2BGR);
+    cv::watershed(img_rgb, markers);
+
+    //bounding box of each room, so that each contour is searched only in its own region
+    std::vector<cv::Rect> boxes(num_seeds);
+    for (int y = 0; y < markers.rows; y++)
+    {
+        const int* row = markers.ptr<int>(y);
+        for (int x = 0; x < markers.cols; x++)
+        {
+            int label = row[x];
+            if (label < 1 || label > num_seeds) continue;
+            cv::Rect& box = boxes[label - 1];
+            if (box.area() == 0)
+            {
+                box = cv::Rect(x, y, 1, 1);
+            }
+            else
+            {
+                box |= cv::Rect(x, y, 1, 1);
+            }
+        }
+    }
+
+    double min_cells = m_params.min_room_area / (resolution * resolution);
+    for (int i = 0; i < num_seeds; i++)
+    {
+        if (boxes[i].area() == 0) continue;
+
+        cv::Mat room = (markers(boxes[i]) == (i + 1));
+        std::vector<std::vector<cv::Point> > contours;
+        cv::findContours(room, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE, boxes[i].tl());
+
+        //a room is a single basin, the other contours are fragments separated by the watershed lines
+        size_t largest = 0;
+        double largest_area = -1;
+        for (size_t k = 0; k < contours.size(); k++)
+        {
+            double a = cv::contourArea(contours[k]);
+            if (a > largest_area)
+            {
+                largest_area = a;
+                largest = k;
+            }
+        }
+        if (contours.empty() || largest_area < min_cells) continue;
+
+        std::vector<cv::Point> polygon;
+        cv::approxPolyDP(contours[largest], polygon, m_params.polygon_accuracy, true);
+        if (polygon.size() < 3) continue;
+
+        Map2DArea area;
+        area.map_id = map.getMapName();
+        for (size_t k = 0; k < polygon.size(); k++)
+        {
+            XYWorld world = map.cell2World(XYCell(polygon[k].x, polygon[k].y));
+            area.points.push_back(yarp::math::Vec2D<double>(world.x, world.y));
+        }
+        names.push_back(map.getMapName() + "_" + m_params.area_prefix + std::to_string(areas.size()));
+        areas.push_back(area);
+    }
+    return true;
+}
+
+uint64_t rooms_segmentation::hash(const MapGrid2D& map) const
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    //parameters
+    hash_double(hash, m_params.peaks_threshold);
+    hash_double(hash, m_params.polygon_accuracy);
+    hash_double(hash, m_params.min_room_area);
+    hash_bytes(hash, m_params.area_prefix.data(), m_params.area_prefix.size());
+
+    //geometry
+    double x0 = 0, y0 = 0, t0 = 0, resolution = 0;
+    map.getOrigin(x0, y0, t0);
+    map.getResolution(resolution);
+    hash_double(hash, x0);
+    hash_double(hash, y0);
+    hash_double(hash, t0);
+    hash_double(hash, resolution);
+    uint64_t size[2] = { map.width(), map.height() };
+    hash_bytes(hash, size, sizeof(size));
+
+    //content
+    XYCell cell;
+    for (cell.y = 0; cell.y < map.height(); cell.y++)
+    {
+        for (cell.x = 0; cell.x < map.width(); cell.x++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(cell, flag);
+            unsigned char v = static_cast<unsigned char>(flag);
+            hash = (hash ^ v) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
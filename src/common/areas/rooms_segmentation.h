@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef ROOMS_SEGMENTATION_H
+#define ROOMS_SEGMENTATION_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DArea.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+* Splits the free space of a map into rooms, without any display.
+* The peaks of the distance transform of the free space are the seeds of a watershed, each basin is a room.
+* The contour of each room is simplified to a polygon and returned as a Map2DArea, in world coordinates.
+* The class has no state besides the parameters, so the same object can be used by several threads.
+*/
+class rooms_segmentation
+{
+public:
+    struct parameters
+    {
+        double       peaks_threshold;      //the seeds are the cells with normalized distance from the obstacles above this value (0-1)
+        double       polygon_accuracy;     //maximum distance between the contour and the polygon (cells)
+        double       min_room_area;        //smaller rooms are discarded (m^2)
+        std::string  area_prefix;          //the areas are named <map_name>_<area_prefix><n>
+
+        parameters();
+    };
+
+private:
+    parameters m_params;
+
+public:
+    rooms_segmentation(const parameters& params = parameters());
+
+    const parameters& get_parameters() const { return m_params; }
+
+    /**
+    * Segments a map.
+    * @param map the map, the name of the areas is computed from its map_name
+    * @param areas the rooms found
+    * @param names the names of the areas
+    * @return false if the map is empty
+    */
+    bool segment(const yarp::dev::Nav2D::MapGrid2D& map, std::vector<yarp::dev::Nav2D::Map2DArea>& areas, std::vector<std::string>& names) const;
+
+    /**
+    * @return a hash of the content of the map (size, resolution, origin and cell flags) and of the parameters
+    * of the segmentation, so that the rooms of a map need to be computed again only if the hash changes.
+    */
+    uint64_t hash(const yarp::dev::Nav2D::MapGrid2D& map) const;
+};
+
+#endif
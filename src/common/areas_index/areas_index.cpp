@@ -0,0 +1,349 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "areas_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    //the grids have at most MAX_BUCKETS buckets per side, whatever the number and the extent of the elements
+    const size_t MAX_BUCKETS = 1024;
+
+    //crossing number test (W. Randolph Franklin), the same of obstacles_class::pnpoly()
+    bool inside(const Map2DArea& area, double x, double y)
+    {
+        bool c = false;
+        size_t n = area.points.size();
+        if (n == 0) return false;
+        for (size_t i = 0, j = n - 1; i < n; j = i++)
+        {
+            const yarp::math::Vec2D<double>& pi = area.points[i];
+            const yarp::math::Vec2D<double>& pj = area.points[j];
+            if (((pi.y > y) != (pj.y > y)) &&
+                (x < (pj.x - pi.x) * (y - pi.y) / (pj.y - pi.y) + pi.x))
+            {
+                c = !c;
+            }
+        }
+        return c;
+    }
+
+    double surface(const Map2DArea& area)
+    {
+        double s = 0;
+        if (area.points.empty()) return 0;
+        size_t n = area.points.size();
+        for (size_t i = 0, j = n - 1; i < n; j = i++)
+        {
+            s += area.points[j].x * area.points[i].y - area.points[i].x * area.points[j].y;
+        }
+        return fabs(s) / 2;
+    }
+}
+
+void areas_index::grid::init(double min_x, double min_y, double max_x, double max_y, size_t num_items)
+{
+    double w = std::max(max_x - min_x, 1e-3);
+    double h = std::max(max_y - min_y, 1e-3);
+    //about one element per bucket
+    cell_size = sqrt(w * h / std::max<size_t>(num_items, 1));
+    cell_size = std::max(cell_size, std::max(w, h) / MAX_BUCKETS);
+    x0 = min_x;
+    y0 = min_y;
+    nx = std::min<size_t>(static_cast<size_t>(w / cell_size) + 1, MAX_BUCKETS);
+    ny = std::min<size_t>(static_cast<size_t>(h / cell_size) + 1, MAX_BUCKETS);
+    buckets.assign(nx * ny, std::vector<size_t>());
+}
+
+size_t areas_index::grid::cell_x(double x) const
+{
+    double c = floor((x - x0) / cell_size);
+    if (c < 0) return 0;
+    if (c >= nx) return nx - 1;
+    return static_cast<size_t>(c);
+}
+
+size_t areas_index::grid::cell_y(double y) const
+{
+    double c = floor((y - y0) / cell_size);
+    if (c < 0) return 0;
+    if (c >= ny) return ny - 1;
+    return static_cast<size_t>(c);
+}
+
+void areas_index::set_map(const std::string& map_id,
+                          const std::vector<std::string>& area_names, const std::vector<Map2DArea>& areas,
+                          const std::vector<std::string>& location_names, const std::vector<Map2DLocation>& locations)
+{
+    std::shared_ptr<map_index> index = std::make_shared<map_index>();
+
+    //areas. The degenerate ones are kept in the list but they are not inserted in the grid.
+    double min_x = std::numeric_limits<double>::max(), min_y = min_x;
+    double max_x = -min_x, max_y = -min_x;
+    size_t num_valid = 0;
+    for (size_t i = 0; i < areas.size() && i < area_names.size(); i++)
+    {
+        if (areas[i].map_id != map_id) continue;
+        double box[4] = { 0, 0, -1, -1 };
+        if (areas[i].points.size() >= 3)
+        {
+            box[0] = box[2] = areas[i].points[0].x;
+            box[1] = box[3] = areas[i].points[0].y;
+            for (size_t j = 1; j < areas[i].points.size(); j++)
+            {
+                box[0] = std::min(box[0], areas[i].points[j].x);
+                box[1] = std::min(box[1], areas[i].points[j].y);
+                box[2] = std::max(box[2], areas[i].points[j].x);
+                box[3] = std::max(box[3], areas[i].points[j].y);
+            }
+            min_x = std::min(min_x, box[0]);
+            min_y = std::min(min_y, box[1]);
+            max_x = std::max(max_x, box[2]);
+            max_y = std::max(max_y, box[3]);
+            num_valid++;
+        }
+        index->area_names.push_back(area_names[i]);
+        index->areas.push_back(areas[i]);
+        index->area_boxes.insert(index->area_boxes.end(), box, box + 4);
+        index->area_sizes.push_back(surface(areas[i]));
+    }
+    if (num_valid > 0)
+    {
+        grid& g = index->areas_grid;
+        g.init(min_x, min_y, max_x, max_y, num_valid);
+        for (size_t i = 0; i < index->areas.size(); i++)
+        {
+            const double* box = &index->area_boxes[i * 4];
+            if (box[0] > box[2]) continue;
+            for (size_t y = g.cell_y(box[1]); y <= g.cell_y(box[3]); y++)
+            {
+                for (size_t x = g.cell_x(box[0]); x <= g.cell_x(box[2]); x++)
+                {
+                    g.buckets[y * g.nx + x].push_back(i);
+                }
+            }
+        }
+    }
+
+    //locations
+    min_x = std::numeric_limits<double>::max(); min_y = min_x;
+    max_x = -min_x; max_y = -min_x;
+    for (size_t i = 0; i < locations.size() && i < location_names.size(); i++)
+    {
+        if (locations[i].map_id != map_id) continue;
+        min_x = std::min(min_x, locations[i].x);
+        min_y = std::min(min_y, locations[i].y);
+        max_x = std::max(max_x, locations[i].x);
+        max_y = std::max(max_y, locations[i].y);
+        index->location_names.push_back(location_names[i]);
+        index->locations.push_back(locations[i]);
+    }
+    if (!index->locations.empty())
+    {
+        grid& g = index->locations_grid;
+        g.init(min_x, min_y, max_x, max_y, index->locations.size());
+        for (size_t i = 0; i < index->locations.size(); i++)
+        {
+            g.buckets[g.cell_y(index->locations[i].y) * g.nx + g.cell_x(index->locations[i].x)].push_back(i);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (index->areas.empty() && index->locations.empty())
+    {
+        m_maps.erase(map_id);
+    }
+    else
+    {
+        m_maps[map_id] = index;
+    }
+}
+
+bool areas_index::set_all(const std::vector<std::string>& area_names, const std::vector<Map2DArea>& areas,
+                          const std::vector<std::string>& location_names, const std::vector<Map2DLocation>& locations)
+{
+    //the elements are grouped by map
+    struct map_content
+    {
+        std::vector<std::string>      area_names;
+        std::vector<Map2DArea>        areas;
+        std::vector<std::string>      location_names;
+        std::vector<Map2DLocation>    locations;
+    };
+    std::map<std::string, map_content> contents;
+    for (size_t i = 0; i < areas.size() && i < area_names.size(); i++)
+    {
+        map_content& c = contents[areas[i].map_id];
+        c.area_names.push_back(area_names[i]);
+        c.areas.push_back(areas[i]);
+    }
+    for (size_t i = 0; i < locations.size() && i < location_names.size(); i++)
+    {
+        map_content& c = contents[locations[i].map_id];
+        c.location_names.push_back(location_names[i]);
+        c.locations.push_back(locations[i]);
+    }
+
+    bool changed = false;
+    std::vector<std::string> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_maps.begin(); it != m_maps.end(); it++)
+        {
+            if (contents.find(it->first) == contents.end()) removed.push_back(it->first);
+        }
+        for (size_t i = 0; i < removed.size(); i++)
+        {
+            m_maps.erase(removed[i]);
+            changed = true;
+        }
+    }
+
+    for (auto it = contents.begin(); it != contents.end(); it++)
+    {
+        std::shared_ptr<const map_index> old = get_index(it->first);
+        const map_content& c = it->second;
+        if (old &&
+            old->area_names == c.area_names && old->areas == c.areas &&
+            old->location_names == c.location_names && old->locations == c.locations)
+        {
+            continue;
+        }
+        set_map(it->first, c.area_names, c.areas, c.location_names, c.locations);
+        changed = true;
+    }
+    return changed;
+}
+
+void areas_index::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maps.clear();
+}
+
+std::shared_ptr<const areas_index::map_index> areas_index::get_index(const std::string& map_id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_maps.find(map_id);
+    if (it == m_maps.end()) return nullptr;
+    return it->second;
+}
+
+bool areas_index::find_areas(const Map2DLocation& loc, std::vector<std::string>& names) const
+{
+    names.clear();
+    std::shared_ptr<const map_index> index = get_index(loc.map_id);
+    if (!index || index->areas_grid.buckets.empty()) return false;
+
+    const grid& g = index->areas_grid;
+    const std::vector<size_t>& bucket = g.buckets[g.cell_y(loc.y) * g.nx + g.cell_x(loc.x)];
+    std::vector<size_t> found;
+    for (size_t i = 0; i < bucket.size(); i++)
+    {
+        const double* box = &index->area_boxes[bucket[i] * 4];
+        if (loc.x < box[0] || loc.y < box[1] || loc.x > box[2] || loc.y > box[3]) continue;
+        if (inside(index->areas[bucket[i]], loc.x, loc.y)) found.push_back(bucket[i]);
+    }
+    std::sort(found.begin(), found.end(), [&index](size_t a, size_t b) { return index->area_sizes[a] < index->area_sizes[b]; });
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        names.push_back(index->area_names[found[i]]);
+    }
+    return !names.empty();
+}
+
+bool areas_index::find_area(const Map2DLocation& loc, std::string& name) const
+{
+    std::vector<std::string> names;
+    if (!find_areas(loc, names)) return false;
+    name = names[0];
+    return true;
+}
+
+size_t areas_index::find_nearest_locations(const Map2DLocation& loc, size_t k, std::vector<std::string>& names, std::vector<double>* distances) const
+{
+    names.clear();
+    if (distances) distances->clear();
+    std::shared_ptr<const map_index> index = get_index(loc.map_id);
+    if (!index || index->locations.empty() || k == 0) return 0;
+
+    const grid& g = index->locations_grid;
+    long cx = static_cast<long>(g.cell_x(loc.x));
+    long cy = static_cast<long>(g.cell_y(loc.y));
+    long nx = static_cast<long>(g.nx);
+    long ny = static_cast<long>(g.ny);
+    long max_ring = std::max(nx, ny);
+
+    //the k nearest locations found so far, sorted by distance
+    std::vector<std::pair<double, size_t> > best;
+    for (long d = 0; d <= max_ring; d++)
+    {
+        if (d > 0 && best.size() == k)
+        {
+            //all the buckets not visited yet are outside the square of the rings 0..d-1
+            double bx0 = g.x0 + (cx - d + 1) * g.cell_size;
+            double by0 = g.y0 + (cy - d + 1) * g.cell_size;
+            double bx1 = g.x0 + (cx + d) * g.cell_size;
+            double by1 = g.y0 + (cy + d) * g.cell_size;
+            double bound = 0;
+            if (loc.x >= bx0 && loc.x <= bx1 && loc.y >= by0 && loc.y <= by1)
+            {
+                bound = std::min(std::min(loc.x - bx0, bx1 - loc.x), std::min(loc.y - by0, by1 - loc.y));
+            }
+            if (bound >= best.back().first) break;
+        }
+
+        //visit the buckets at distance d from the bucket of the point
+        for (long y = std::max(cy - d, 0L); y <= std::min(cy + d, ny - 1); y++)
+        {
+            bool border_row = (y == cy - d || y == cy + d);
+            long step = border_row ? 1 : 2 * d;
+            for (long x = cx - d; x <= cx + d; x += step)
+            {
+                if (x < 0 || x >= nx) continue;
+                const std::vector<size_t>& bucket = g.buckets[y * nx + x];
+                for (size_t i = 0; i < bucket.size(); i++)
+                {
+                    const Map2DLocation& l = index->locations[bucket[i]];
+                    double dist = sqrt((l.x - loc.x) * (l.x - loc.x) + (l.y - loc.y) * (l.y - loc.y));
+                    if (best.size() == k && dist >= best.back().first) continue;
+                    auto pos = std::upper_bound(best.begin(), best.end(), std::make_pair(dist, bucket[i]));
+                    best.insert(pos, std::make_pair(dist, bucket[i]));
+                    if (best.size() > k) best.pop_back();
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < best.size(); i++)
+    {
+        names.push_back(index->location_names[best[i].second]);
+        if (distances) distances->push_back(best[i].first);
+    }
+    return names.size();
+}
+
+void areas_index::get_map(const std::string& map_id,
+                          std::vector<std::string>& area_names, std::vector<Map2DArea>& areas,
+                          std::vector<std::string>& location_names, std::vector<Map2DLocation>& locations) const
+{
+    area_names.clear();
+    areas.clear();
+    location_names.clear();
+    locations.clear();
+    std::shared_ptr<const map_index> index = get_index(map_id);
+    if (!index) return;
+    area_names = index->area_names;
+    areas = index->areas;
+    location_names = index->location_names;
+    locations = index->locations;
+}
@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef AREAS_INDEX_H
+#define AREAS_INDEX_H
+
+#include <yarp/dev/Map2DArea.h>
+#include <yarp/dev/Map2DLocation.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+* A spatial index of the areas and of the locations stored in a map server, to answer "which area contains this point"
+* and "which are the k locations nearest to this point" without scanning all of them.
+* Each map has a uniform grid: each bucket lists the areas whose bounding box overlaps it and the locations it contains,
+* so a point-in-area query tests only the few polygons of one bucket and a nearest-locations query visits the buckets
+* in rings of increasing distance, stopping as soon as no closer location can be found.
+* The index of a map is rebuilt only when its areas or locations change. The rebuilt index replaces the previous one
+* atomically, so the queries (e.g. from a control loop) never wait for a rebuild.
+*/
+class areas_index
+{
+    struct grid
+    {
+        double                               x0;
+        double                               y0;
+        double                               cell_size;
+        size_t                               nx;
+        size_t                               ny;
+        std::vector<std::vector<size_t> >    buckets;
+
+        void   init(double min_x, double min_y, double max_x, double max_y, size_t num_items);
+        size_t cell_x(double x) const;
+        size_t cell_y(double y) const;
+    };
+
+    struct map_index
+    {
+        std::vector<std::string>                       area_names;
+        std::vector<yarp::dev::Nav2D::Map2DArea>       areas;
+        std::vector<double>                            area_boxes;   //min_x min_y max_x max_y of each area
+        std::vector<double>                            area_sizes;   //surface of each area
+        grid                                           areas_grid;
+
+        std::vector<std::string>                       location_names;
+        std::vector<yarp::dev::Nav2D::Map2DLocation>   locations;
+        grid                                           locations_grid;
+    };
+
+    mutable std::mutex                                          m_mutex;
+    std::map<std::string, std::shared_ptr<const map_index> >    m_maps;
+
+public:
+    /**
+    * Replaces the areas and the locations of a map and rebuilds its index.
+    * The elements which do not belong to the map are ignored.
+    */
+    void   set_map(const std::string& map_id,
+                   const std::vector<std::string>& area_names, const std::vector<yarp::dev::Nav2D::Map2DArea>& areas,
+                   const std::vector<std::string>& location_names, const std::vector<yarp::dev::Nav2D::Map2DLocation>& locations);
+
+    /**
+    * Replaces all the areas and the locations, as returned by a map server.
+    * Only the indexes of the maps whose areas or locations changed are rebuilt.
+    * @return true if at least one map changed
+    */
+    bool   set_all(const std::vector<std::string>& area_names, const std::vector<yarp::dev::Nav2D::Map2DArea>& areas,
+                   const std::vector<std::string>& location_names, const std::vector<yarp::dev::Nav2D::Map2DLocation>& locations);
+
+    void   clear();
+
+    /**
+    * Finds the areas which contain a point, i.e. loc.x loc.y of the map loc.map_id.
+    * @param names the areas containing the point, the smallest first
+    * @return true if the point is inside at least one area
+    */
+    bool   find_areas(const yarp::dev::Nav2D::Map2DLocation& loc, std::vector<std::string>& names) const;
+
+    /**
+    * Finds the smallest area which contains a point.
+    */
+    bool   find_area(const yarp::dev::Nav2D::Map2DLocation& loc, std::string& name) const;
+
+    /**
+    * Finds the k locations nearest to a point (the orientation is not considered).
+    * @param names the locations, the nearest first
+    * @param distances if not null, the distances of the locations
+    * @return the number of locations found (less than k if the map has less than k locations)
+    */
+    size_t find_nearest_locations(const yarp::dev::Nav2D::Map2DLocation& loc, size_t k, std::vector<std::string>& names, std::vector<double>* distances = nullptr) const;
+
+    /**
+    * Gets the areas and the locations of a map.
+    */
+    void   get_map(const std::string& map_id,
+                   std::vector<std::string>& area_names, std::vector<yarp::dev::Nav2D::Map2DArea>& areas,
+                   std::vector<std::string>& location_names, std::vector<yarp::dev::Nav2D::Map2DLocation>& locations) const;
+
+private:
+    std::shared_ptr<const map_index> get_index(const std::string& map_id) const;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * \section bitGridCheck
+ * This tool checks that bit_grid::is_line_clear() visits the same cells as map_utilites::checkStraightLine(), i.e.
+ * the cells of the per-cell Bresenham algorithm. The lines are chosen at random (fixed seed), plus the lines which
+ * cross the boundaries of the 64-bit words and the lines in all the octants.
+ * For each line, each cell of the reference line is set alone (the line must be blocked), then each neighbour of the
+ * line which is not part of it is set alone (the line must be clear).
+ * Returns 0 if all the checks pass.
+ */
+
+#include <yarp/os/LogStream.h>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include "bit_grid.h"
+
+using namespace std;
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    const size_t WIDTH = 200;   //not a multiple of 64, so the last word of each row is partially used
+    const size_t HEIGHT = 150;
+    const size_t RANDOM_LINES = 2000;
+
+    //the cells visited by map_utilites::checkStraightLine()
+    vector<XYCell> bresenham(XYCell src, XYCell dst)
+    {
+        vector<XYCell> cells;
+        int dx = abs(int(dst.x) - int(src.x));
+        int dy = abs(int(dst.y) - int(src.y));
+        int err = dx - dy;
+        int sx = (src.x < dst.x) ? 1 : -1;
+        int sy = (src.y < dst.y) ? 1 : -1;
+        while (1)
+        {
+            cells.push_back(src);
+            if (src.x == dst.x && src.y == dst.y) break;
+            int e2 = err * 2;
+            if (e2 > -dy)
+            {
+                err = err - dy;
+                src.x += sx;
+            }
+            if (e2 < dx)
+            {
+                err = err + dx;
+                src.y += sy;
+            }
+        }
+        return cells;
+    }
+
+    bool check_line(bit_grid& grid, XYCell src, XYCell dst)
+    {
+        vector<XYCell> line = bresenham(src, dst);
+        set<pair<size_t, size_t>> on_line;
+        for (const auto& c : line) on_line.insert(make_pair(c.x, c.y));
+
+        grid.clear();
+        if (!grid.is_line_clear(src, dst))
+        {
+            yError() << "empty grid: line" << src.x << src.y << "->" << dst.x << dst.y << "is blocked";
+            return false;
+        }
+        for (const auto& c : line)
+        {
+            grid.set(c.x, c.y);
+            bool clear = grid.is_line_clear(src, dst);
+            grid.reset(c.x, c.y);
+            if (clear)
+            {
+                yError() << "line" << src.x << src.y << "->" << dst.x << dst.y << "does not visit the cell" << c.x << c.y;
+                return false;
+            }
+        }
+        for (const auto& c : line)
+        {
+            for (int ny = int(c.y) - 1; ny <= int(c.y) + 1; ny++)
+            {
+                for (int nx = int(c.x) - 1; nx <= int(c.x) + 1; nx++)
+                {
+                    if (nx < 0 || ny < 0 || nx >= int(WIDTH) || ny >= int(HEIGHT)) continue;
+                    if (on_line.count(make_pair(size_t(nx), size_t(ny)))) continue;
+                    grid.set(nx, ny);
+                    bool clear = grid.is_line_clear(src, dst);
+                    grid.reset(nx, ny);
+                    if (!clear)
+                    {
+                        yError() << "line" << src.x << src.y << "->" << dst.x << dst.y << "visits the cell" << nx << ny;
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    bit_grid grid(WIDTH, HEIGHT);
+    vector<pair<XYCell, XYCell>> lines;
+
+    //random lines
+    mt19937 rng(12345);
+    uniform_int_distribution<size_t> rand_x(0, WIDTH - 1);
+    uniform_int_distribution<size_t> rand_y(0, HEIGHT - 1);
+    for (size_t i = 0; i < RANDOM_LINES; i++)
+    {
+        lines.push_back(make_pair(XYCell(rand_x(rng), rand_y(rng)), XYCell(rand_x(rng), rand_y(rng))));
+    }
+
+    //lines which start or end next to the boundaries of the words, or cross them
+    const size_t boundaries[] = { 0, 1, 62, 63, 64, 65, 126, 127, 128, 129, 191, 192, 198, 199 };
+    for (size_t x0 : boundaries)
+    {
+        for (size_t x1 : boundaries)
+        {
+            size_t y = rand_y(rng);
+            lines.push_back(make_pair(XYCell(x0, y), XYCell(x1, y)));
+            lines.push_back(make_pair(XYCell(x0, y), XYCell(x1, rand_y(rng))));
+            lines.push_back(make_pair(XYCell(x0, 0), XYCell(x1, HEIGHT - 1)));
+        }
+    }
+
+    //lines from the center in all the octants, including the horizontal, vertical and diagonal ones
+    const XYCell center(WIDTH / 2, HEIGHT / 2);
+    const int steps[][2] = { { 70, 0 }, { 70, 23 }, { 70, 70 }, { 23, 70 }, { 0, 70 }, { -23, 70 }, { -70, 70 }, { -70, 23 },
+                             { -70, 0 }, { -70, -23 }, { -70, -70 }, { -23, -70 }, { 0, -70 }, { 23, -70 }, { 70, -70 }, { 70, -23 },
+                             { 1, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 }, { 1, 2 }, { 0, 0 } };
+    for (const auto& s : steps)
+    {
+        XYCell dst(size_t(int(center.x) + s[0]), size_t(int(center.y) + s[1]));
+        lines.push_back(make_pair(center, dst));
+        lines.push_back(make_pair(dst, center));
+    }
+
+    size_t failed = 0;
+    for (const auto& l : lines)
+    {
+        if (!check_line(grid, l.first, l.second)) failed++;
+    }
+
+    //the cells outside the grid count as blocked
+    if (grid.is_line_clear(XYCell(0, 0), XYCell(WIDTH, 0)) || grid.is_line_clear(XYCell(0, HEIGHT), XYCell(0, 0)))
+    {
+        yError() << "a line which leaves the grid is clear";
+        failed++;
+    }
+
+    if (failed > 0)
+    {
+        yError() << failed << "of" << lines.size() << "lines failed";
+        return 1;
+    }
+    yInfo() << "bit_grid::is_line_clear() checked on" << lines.size() << "lines";
+    return 0;
+}
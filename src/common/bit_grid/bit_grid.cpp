@@ -0,0 +1,249 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "bit_grid.h"
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    inline size_t popcount64(uint64_t w)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        return __popcnt64(w);
+#else
+        w = w - ((w >> 1) & 0x5555555555555555ULL);
+        w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+        w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (w * 0x0101010101010101ULL) >> 56;
+#endif
+    }
+
+    //index of the lowest set bit, w must not be zero
+    inline size_t lowest_bit64(uint64_t w)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, w);
+        return index;
+#else
+        return popcount64((w & (~w + 1)) - 1);
+#endif
+    }
+
+    //the bits from b0 to b1 (included) of a word
+    inline uint64_t span_mask(size_t b0, size_t b1)
+    {
+        return (~uint64_t(0) << b0) & (~uint64_t(0) >> (63 - b1));
+    }
+}
+
+bit_grid::bit_grid()
+{
+    m_width = 0;
+    m_height = 0;
+    m_words_per_row = 0;
+}
+
+bit_grid::bit_grid(size_t width, size_t height)
+{
+    resize(width, height);
+}
+
+void bit_grid::resize(size_t width, size_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_words_per_row = (width + 63) / 64;
+    m_words.assign(m_words_per_row * height, 0);
+}
+
+size_t bit_grid::popcount(uint64_t word)
+{
+    return popcount64(word);
+}
+
+size_t bit_grid::lowest_bit(uint64_t word)
+{
+    return lowest_bit64(word);
+}
+
+void bit_grid::clear()
+{
+    std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+void bit_grid::set_span(size_t y, size_t x0, size_t x1, bool value)
+{
+    uint64_t* r = row(y);
+    size_t w0 = x0 >> 6;
+    size_t w1 = x1 >> 6;
+    for (size_t w = w0; w <= w1; w++)
+    {
+        uint64_t m = span_mask(w == w0 ? x0 & 63 : 0, w == w1 ? x1 & 63 : 63);
+        if (value) r[w] |= m;
+        else       r[w] &= ~m;
+    }
+}
+
+bool bit_grid::any_in_span(size_t y, size_t x0, size_t x1) const
+{
+    const uint64_t* r = row(y);
+    size_t w0 = x0 >> 6;
+    size_t w1 = x1 >> 6;
+    if (w0 == w1)
+    {
+        return (r[w0] & span_mask(x0 & 63, x1 & 63)) != 0;
+    }
+    if (r[w0] & span_mask(x0 & 63, 63)) return true;
+    for (size_t w = w0 + 1; w < w1; w++)
+    {
+        if (r[w]) return true;
+    }
+    return (r[w1] & span_mask(0, x1 & 63)) != 0;
+}
+
+bool bit_grid::merge(const bit_grid& other)
+{
+    if (!same_size(other)) return false;
+    for (size_t i = 0; i < m_words.size(); i++) m_words[i] |= other.m_words[i];
+    return true;
+}
+
+bool bit_grid::subtract(const bit_grid& other)
+{
+    if (!same_size(other)) return false;
+    for (size_t i = 0; i < m_words.size(); i++) m_words[i] &= ~other.m_words[i];
+    return true;
+}
+
+bool bit_grid::intersect(const bit_grid& other)
+{
+    if (!same_size(other)) return false;
+    for (size_t i = 0; i < m_words.size(); i++) m_words[i] &= other.m_words[i];
+    return true;
+}
+
+size_t bit_grid::count() const
+{
+    size_t n = 0;
+    for (size_t i = 0; i < m_words.size(); i++) n += popcount64(m_words[i]);
+    return n;
+}
+
+size_t bit_grid::count(size_t x0, size_t y0, size_t x1, size_t y1) const
+{
+    if (m_width == 0 || m_height == 0 || x0 > x1 || y0 > y1 || x0 >= m_width || y0 >= m_height) return 0;
+    x1 = std::min(x1, m_width - 1);
+    y1 = std::min(y1, m_height - 1);
+    size_t w0 = x0 >> 6;
+    size_t w1 = x1 >> 6;
+    size_t n = 0;
+    for (size_t y = y0; y <= y1; y++)
+    {
+        const uint64_t* r = row(y);
+        for (size_t w = w0; w <= w1; w++)
+        {
+            n += popcount64(r[w] & span_mask(w == w0 ? x0 & 63 : 0, w == w1 ? x1 & 63 : 63));
+        }
+    }
+    return n;
+}
+
+bool bit_grid::is_line_clear(XYCell src, XYCell dst) const
+{
+    if (src.x >= m_width || src.y >= m_height || dst.x >= m_width || dst.y >= m_height) return false;
+
+    //Bresenham algorithm, as in map_utilites::checkStraightLine(). The consecutive cells of the same row are
+    //collected in a span, which is checked when the line moves to the next row.
+    int x = int(src.x);
+    int y = int(src.y);
+    int dx = abs(int(dst.x) - x);
+    int dy = abs(int(dst.y) - y);
+    int err = dx - dy;
+    int sx = (x < int(dst.x)) ? 1 : -1;
+    int sy = (y < int(dst.y)) ? 1 : -1;
+    int span_start = x;
+    while (1)
+    {
+        if (x == int(dst.x) && y == int(dst.y)) break;
+        int e2 = err * 2;
+        int nx = x;
+        if (e2 > -dy)
+        {
+            err = err - dy;
+            nx += sx;
+        }
+        if (e2 < dx)
+        {
+            err = err + dx;
+            if (any_in_span(y, std::min(span_start, x), std::max(span_start, x))) return false;
+            y += sy;
+            span_start = nx;
+        }
+        x = nx;
+    }
+    return !any_in_span(y, std::min(span_start, x), std::max(span_start, x));
+}
+
+void bit_grid::from_map(const MapGrid2D& map, unsigned int flags_mask)
+{
+    resize(map.width(), map.height());
+    for (size_t y = 0; y < m_height; y++)
+    {
+        uint64_t* r = row(y);
+        for (size_t w = 0; w < m_words_per_row; w++)
+        {
+            //MapGrid2D has no access to its rows, so each cell is read once and the words are filled locally
+            uint64_t word = 0;
+            size_t x_end = std::min(m_width, (w + 1) * 64);
+            for (size_t x = w * 64; x < x_end; x++)
+            {
+                MapGrid2D::map_flags flag = MapGrid2D::map_flags::MAP_CELL_FREE;
+                map.getMapFlag(XYCell(x, y), flag);
+                if (flags_mask & mask(flag)) word |= uint64_t(1) << (x & 63);
+            }
+            r[w] = word;
+        }
+    }
+}
+
+size_t bit_grid::to_map(MapGrid2D& map, MapGrid2D::map_flags flag, unsigned int overwrite_mask) const
+{
+    if (map.width() != m_width || map.height() != m_height) return 0;
+    size_t n = 0;
+    for (size_t y = 0; y < m_height; y++)
+    {
+        const uint64_t* r = row(y);
+        for (size_t w = 0; w < m_words_per_row; w++)
+        {
+            for (uint64_t word = r[w]; word != 0; word &= word - 1)
+            {
+                XYCell cell(w * 64 + lowest_bit64(word), y);
+                MapGrid2D::map_flags current = MapGrid2D::map_flags::MAP_CELL_FREE;
+                map.getMapFlag(cell, current);
+                if (current != flag && (overwrite_mask & mask(current)))
+                {
+                    map.setMapFlag(cell, flag);
+                    n++;
+                }
+            }
+        }
+    }
+    return n;
+}
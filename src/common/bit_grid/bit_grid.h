@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef BIT_GRID_H
+#define BIT_GRID_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <cstdint>
+#include <vector>
+
+/**
+* A grid of cells packed in one bit each (e.g. 1 = blocked, 0 = free), used by the planner in place of the per-cell
+* accessors of MapGrid2D. Each row is stored in 64-bit words, so the operations on the whole grid (merging layers of
+* obstacles, counting cells) and on horizontal spans of cells (line of sight checks) process 64 cells at a time.
+* The bits beyond the width of the grid (in the last word of each row) are always zero.
+* The cells are not bounds-checked: the callers must keep the coordinates inside the grid.
+*/
+class bit_grid
+{
+    size_t                  m_width;
+    size_t                  m_height;
+    size_t                  m_words_per_row;
+    std::vector<uint64_t>   m_words;
+
+public:
+    bit_grid();
+    bit_grid(size_t width, size_t height);
+
+    /**
+    * Changes the size of the grid. All the cells are cleared.
+    */
+    void   resize(size_t width, size_t height);
+    void   clear();
+
+    size_t width() const { return m_width; }
+    size_t height() const { return m_height; }
+    size_t words_per_row() const { return m_words_per_row; }
+    bool   same_size(const bit_grid& other) const { return m_width == other.m_width && m_height == other.m_height; }
+
+    uint64_t*       row(size_t y) { return m_words.data() + y * m_words_per_row; }
+    const uint64_t* row(size_t y) const { return m_words.data() + y * m_words_per_row; }
+
+    bool   get(size_t x, size_t y) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+    void   set(size_t x, size_t y) { row(y)[x >> 6] |= uint64_t(1) << (x & 63); }
+    void   reset(size_t x, size_t y) { row(y)[x >> 6] &= ~(uint64_t(1) << (x & 63)); }
+
+    /**
+    * Sets (or clears) the cells from x0 to x1 (included) of the row y.
+    */
+    void   set_span(size_t y, size_t x0, size_t x1, bool value = true);
+
+    /**
+    * @return true if at least one of the cells from x0 to x1 (included) of the row y is set
+    */
+    bool   any_in_span(size_t y, size_t x0, size_t x1) const;
+
+    /**
+    * Bitwise operations with a grid of the same size.
+    * @return false if the grids have different sizes
+    */
+    bool   merge(const bit_grid& other);        //this |= other
+    bool   subtract(const bit_grid& other);     //this &= ~other
+    bool   intersect(const bit_grid& other);    //this &= other
+
+    /**
+    * @return the number of set cells, in the whole grid or in the rectangle (x0,y0)-(x1,y1) (included, clipped to the grid)
+    */
+    size_t count() const;
+    size_t count(size_t x0, size_t y0, size_t x1, size_t y1) const;
+
+    /**
+    * Checks the cells of the straight line from src to dst, the same cells visited by map_utilites::checkStraightLine().
+    * The line is split in horizontal spans, each one is checked a word at a time.
+    * @return true if none of the cells is set. The cells outside the grid count as set.
+    */
+    bool   is_line_clear(yarp::dev::Nav2D::XYCell src, yarp::dev::Nav2D::XYCell dst) const;
+
+    /**
+    * Builds a grid with the same size of a map. The cells whose flag is in flags_mask are set.
+    * @param flags_mask a combination of mask(flag). The default value sets the cells which are not free.
+    */
+    void   from_map(const yarp::dev::Nav2D::MapGrid2D& map, unsigned int flags_mask = blocked_mask());
+
+    /**
+    * Writes a flag into the cells of a map of the same size which are set in the grid. Only the cells whose current
+    * flag is in overwrite_mask are modified. The words without set cells are skipped.
+    * @return the number of modified cells
+    */
+    size_t to_map(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::MapGrid2D::map_flags flag, unsigned int overwrite_mask) const;
+
+    /**
+    * Helpers for the code which processes the rows directly: the number of set bits of a word and the index of its
+    * lowest set bit (the word must not be zero).
+    */
+    static size_t popcount(uint64_t word);
+    static size_t lowest_bit(uint64_t word);
+
+    static unsigned int mask(yarp::dev::Nav2D::MapGrid2D::map_flags flag) { return 1u << flag; }
+    static unsigned int blocked_mask() { return ~mask(yarp::dev::Nav2D::MapGrid2D::map_flags::MAP_CELL_FREE); }
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "likelihood_field.h"
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    const double INF_DIST = 1e20;
+
+    //1D squared euclidean distance transform (Felzenszwalb & Huttenlocher), in place on f[0..n-1]
+    void edt_1d(double* f, size_t n, std::vector<double>& d, std::vector<int>& v, std::vector<double>& z)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -INF_DIST;
+        z[1] = +INF_DIST;
+        for (int q = 1; q < (int)n; q++)
+        {
+            double s = ((f[q] + q*q) - (f[v[k]] + v[k] * v[k])) / (2.0*q - 2.0*v[k]);
+            while (s <= z[k])
+            {
+                k--;
+                s = ((f[q] + q*q) - (f[v[k]] + v[k] * v[k])) / (2.0*q - 2.0*v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = +INF_DIST;
+        }
+        k = 0;
+        for (int q = 0; q < (int)n; q++)
+        {
+            while (z[k + 1] < q) k++;
+            d[q] = (q - v[k])*(q - v[k]) + f[v[k]];
+        }
+        for (size_t q = 0; q < n; q++) f[q] = d[q];
+    }
+}
+
+likelihood_field::likelihood_field()
+{
+    m_width = 0;
+    m_height = 0;
+    m_resolution = 1.0;
+    m_origin_x = 0;
+    m_origin_y = 0;
+}
+
+bool likelihood_field::build(const MapGrid2D& map, double sigma, double max_dist)
+{
+    m_field.clear();
+    m_width = map.width();
+    m_height = map.height();
+    m_map_name = map.getMapName();
+    double origin_t = 0;
+    map.getResolution(m_resolution);
+    map.getOrigin(m_origin_x, m_origin_y, origin_t);
+    if (m_width == 0 || m_height == 0 || m_resolution <= 0 || sigma <= 0)
+    {
+        yError() << "likelihood_field: invalid map" << m_map_name;
+        return false;
+    }
+    if (origin_t != 0)
+    {
+        yWarning() << "likelihood_field: the rotation of the origin of map" << m_map_name << "is ignored";
+    }
+
+    //squared distance (in cells) from the closest wall
+    std::vector<double> dist(m_width*m_height);
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++)
+        {
+            dist[y*m_width + x] = map.isWall(XYCell(x, y)) ? 0 : INF_DIST;
+        }
+
+    size_t n = std::max(m_width, m_height);
+    std::vector<double> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+    //transform along the columns, then along the rows
+    for (size_t x = 0; x < m_width; x++)
+    {
+        for (size_t y = 0; y < m_height; y++) f[y] = dist[y*m_width + x];
+        edt_1d(f.data(), m_height, d, v, z);
+        for (size_t y = 0; y < m_height; y++) dist[y*m_width + x] = f[y];
+    }
+    for (size_t y = 0; y < m_height; y++)
+    {
+        edt_1d(&dist[y*m_width], m_width, d, v, z);
+    }
+
+    m_field.resize(m_width*m_height);
+    double max_dist2 = max_dist * max_dist;
+    double k = 1.0 / (2 * sigma * sigma);
+    for (size_t i = 0; i < m_field.size(); i++)
+    {
+        double d2 = dist[i] * m_resolution * m_resolution;
+        if (d2 > max_dist2) d2 = max_dist2;
+        m_field[i] = (float)(exp(-d2 * k));
+    }
+    return true;
+}
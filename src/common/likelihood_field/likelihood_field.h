@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef LIKELIHOOD_FIELD_H
+#define LIKELIHOOD_FIELD_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <vector>
+#include <string>
+
+/**
+* A likelihood field computed from a MapGrid2D.
+* Each cell stores exp(-d^2/(2*sigma^2)), where d is the distance (in meters) of the cell from the closest wall.
+* Distances larger than max_dist are clamped, so that the value of a cell far from any obstacle is a small constant.
+* The field is computed once when the map is loaded (exact euclidean distance transform, linear in the number of cells),
+* after that evaluating a laser beam endpoint costs a single memory access.
+*/
+class likelihood_field
+{
+    std::vector<float>  m_field;
+    size_t              m_width;
+    size_t              m_height;
+    double              m_resolution;
+    double              m_origin_x;
+    double              m_origin_y;
+    std::string         m_map_name;
+
+public:
+    likelihood_field();
+
+    /**
+    * Computes the field from a map.
+    * @param map the source map
+    * @param sigma the standard deviation of the measurement noise [m]
+    * @param max_dist the maximum distance taken into account [m]
+    * @return true/false
+    */
+    bool   build(const yarp::dev::Nav2D::MapGrid2D& map, double sigma, double max_dist);
+
+    bool   is_valid()   const { return !m_field.empty(); }
+    size_t width()      const { return m_width; }
+    size_t height()     const { return m_height; }
+    double resolution() const { return m_resolution; }
+    std::string map_name() const { return m_map_name; }
+
+    /**
+    * Converts world coordinates in (fractional) cell coordinates, with the same convention of MapGrid2D::world2Cell()
+    */
+    inline void world2cell(double wx, double wy, double& cx, double& cy) const
+    {
+        cx = (wx - m_origin_x) / m_resolution;
+        cy = (m_origin_y - wy) / m_resolution + (double)(m_height) - 1;
+    }
+
+    /**
+    * Returns the value of a cell. Cells outside the map have zero likelihood.
+    */
+    inline float at_cell(int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= (int)m_width || y >= (int)m_height) return 0;
+        return m_field[y*m_width + x];
+    }
+
+    /**
+    * Returns the value of the cell containing the given world point.
+    */
+    inline float at_world(double wx, double wy) const
+    {
+        double cx, cy;
+        world2cell(wx, wy, cx, cy);
+        if (cx < 0 || cy < 0) return 0;
+        return at_cell((int)(cx), (int)(cy));
+    }
+};
+
+#endif
@@ -0,0 +1,138 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+/**
+ * \section mapFileConverter
+ * This tool converts a map (a .map file with its image and metadata, or a map of a map server) into the compact
+ * binary format of map_file, which can be memory-mapped by the tools which use the map.
+ */
+
+#include <yarp/os/Network.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/IMap2D.h>
+#include <yarp/dev/PolyDriver.h>
+#include <string>
+#include "map_file.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+
+static int printInfo(const string& filename)
+{
+    map_file file;
+    if (!file.open(filename))
+    {
+        return -1;
+    }
+    double x = 0, y = 0, t = 0;
+    file.origin(x, y, t);
+    yInfo() << "name:" << file.name();
+    yInfo() << "size:" << file.width() << "x" << file.height() << "cells";
+    yInfo() << "resolution:" << file.resolution();
+    yInfo() << "origin:" << x << y << t;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.configure(argc, argv);
+
+    if (rf.check("help"))
+    {
+        yInfo() << "Options:";
+        yInfo() << "--from <file.map> (a map in the yarp format)";
+        yInfo() << "--from_server <map_id> (a map of the map server)";
+        yInfo() << "--remote <port> (default /mapServer, used with --from_server)";
+        yInfo() << "--to <file.navmap>";
+        yInfo() << "--tile_size <cells> (a multiple of 4, at most 4096, default 64)";
+        yInfo() << "--info <file.navmap> (prints the header of a file)";
+        return 0;
+    }
+
+    if (rf.check("info"))
+    {
+        return printInfo(rf.find("info").asString());
+    }
+
+    if (!rf.check("to") || rf.check("from") == rf.check("from_server"))
+    {
+        yError() << "Usage: mapFileConverter (--from <file.map> | --from_server <map_id>) --to <file.navmap>";
+        return -1;
+    }
+    string to = rf.find("to").asString();
+    int tile_size = rf.check("tile_size", Value(64)).asInt32();
+    if (tile_size <= 0 || tile_size % 4 != 0 || tile_size > (int)map_file::MAX_TILE_SIZE)
+    {
+        yError() << "Invalid tile_size" << tile_size << ": it must be a positive multiple of 4, at most" << map_file::MAX_TILE_SIZE;
+        return -1;
+    }
+
+    MapGrid2D map;
+    double t_start = Time::now();
+    if (rf.check("from"))
+    {
+        string from = rf.find("from").asString();
+        if (!map.loadFromFile(from))
+        {
+            yError() << "Unable to load map" << from;
+            return -1;
+        }
+    }
+    else
+    {
+        Network yarp;
+        if (!yarp.checkNetwork())
+        {
+            yError("check Yarp network.\n");
+            return -1;
+        }
+        string map_name = rf.find("from_server").asString();
+        string remote = rf.check("remote", Value("/mapServer")).asString();
+        PolyDriver pMap;
+        IMap2D* iMap = nullptr;
+        Property map_options;
+        map_options.put("device", "map2DClient");
+        map_options.put("local", "/mapFileConverter"); //This is just a prefix. map2DClient will complete the port name.
+        map_options.put("remote", remote);
+        if (pMap.open(map_options) == false)
+        {
+            yError() << "Unable to open map2DClient";
+            return -1;
+        }
+        pMap.view(iMap);
+        if (iMap == nullptr || !iMap->get_map(map_name, map))
+        {
+            yError() << "Map" << map_name << "not found";
+            return -1;
+        }
+        pMap.close();
+    }
+    double t_loaded = Time::now();
+
+    if (!map_file::save(map, to, tile_size))
+    {
+        return -1;
+    }
+    yInfo() << "Map" << map.getMapName() << "loaded in" << t_loaded - t_start << "s, written to" << to << "in" << Time::now() - t_loaded << "s";
+
+    //check the file: the unsupported flags (temporary and enlarged obstacles) are stored as free cells
+    map_file file;
+    if (!file.open(to) || file.width() != map.width() || file.height() != map.height())
+    {
+        yError() << "Verification of" << to << "failed";
+        return -1;
+    }
+    return 0;
+}
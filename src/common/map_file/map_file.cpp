@@ -0,0 +1,308 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "map_file.h"
+#include <yarp/os/LogStream.h>
+#include <yarp/sig/Image.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace yarp::dev::Nav2D;
+
+const size_t map_file::MAX_TILE_SIZE;
+
+namespace
+{
+    static_assert(sizeof(map_file::header_t) == 80, "unexpected padding in map_file::header_t");
+
+    const char     MAGIC[8] = { 'Y', 'N', 'A', 'V', 'M', 'A', 'P', '1' };
+    const uint32_t FORMAT = 1;
+    const size_t   ALIGNMENT = 64;
+
+    //2 bits codes of the flags
+    const unsigned char CODE_FREE = 0;
+    const unsigned char CODE_WALL = 1;
+    const unsigned char CODE_UNKNOWN = 2;
+    const unsigned char CODE_KEEP_OUT = 3;
+
+    inline size_t align(size_t offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    inline unsigned char flag_to_code(MapGrid2D::map_flags flag)
+    {
+        switch (flag)
+        {
+            case MapGrid2D::map_flags::MAP_CELL_WALL:     return CODE_WALL;
+            case MapGrid2D::map_flags::MAP_CELL_UNKNOWN:  return CODE_UNKNOWN;
+            case MapGrid2D::map_flags::MAP_CELL_KEEP_OUT: return CODE_KEEP_OUT;
+            default:                                      return CODE_FREE;
+        }
+    }
+
+    inline MapGrid2D::map_flags code_to_flag(unsigned char code)
+    {
+        switch (code)
+        {
+            case CODE_WALL:     return MapGrid2D::map_flags::MAP_CELL_WALL;
+            case CODE_UNKNOWN:  return MapGrid2D::map_flags::MAP_CELL_UNKNOWN;
+            case CODE_KEEP_OUT: return MapGrid2D::map_flags::MAP_CELL_KEEP_OUT;
+            default:            return MapGrid2D::map_flags::MAP_CELL_FREE;
+        }
+    }
+}
+
+map_file::map_file()
+{
+    m_data = nullptr;
+    m_size = 0;
+    memset(&m_header, 0, sizeof(m_header));
+    m_tiles_x = 0;
+    m_tile_cells = 0;
+}
+
+map_file::~map_file()
+{
+    close();
+}
+
+bool map_file::open(const std::string& filename)
+{
+    close();
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        yError() << "map_file: unable to open" << filename;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(header_t))
+    {
+        ::close(fd);
+        yError() << "map_file:" << filename << "is not a valid map file";
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        yError() << "map_file: unable to map" << filename << "in memory";
+        return false;
+    }
+    m_data = (const unsigned char*)data;
+    m_size = st.st_size;
+#else
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in)
+    {
+        yError() << "map_file: unable to open" << filename;
+        return false;
+    }
+    m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    if (m_size < sizeof(header_t))
+    {
+        close();
+        yError() << "map_file:" << filename << "is not a valid map file";
+        return false;
+    }
+#endif
+
+    memcpy(&m_header, m_data, sizeof(header_t));
+    bool valid = memcmp(m_header.magic, MAGIC, sizeof(MAGIC)) == 0 && m_header.format == FORMAT &&
+                 m_header.tile_size > 0 && m_header.tile_size % 4 == 0 && m_header.tile_size <= MAX_TILE_SIZE;
+    if (valid)
+    {
+        m_tiles_x = (m_header.width + m_header.tile_size - 1) / m_header.tile_size;
+        size_t tiles_y = (m_header.height + m_header.tile_size - 1) / m_header.tile_size;
+        m_tile_cells = size_t(m_header.tile_size) * m_header.tile_size;
+        size_t cells = m_tiles_x * tiles_y * m_tile_cells;
+        valid = sizeof(header_t) + m_header.name_length <= m_header.flags_offset &&
+                m_header.flags_offset + cells / 4 <= m_header.occupancy_offset &&
+                m_header.occupancy_offset + cells <= m_size;
+    }
+    if (!valid)
+    {
+        close();
+        yError() << "map_file:" << filename << "is not a valid map file";
+        return false;
+    }
+    m_name.assign((const char*)m_data + sizeof(header_t), m_header.name_length);
+    return true;
+}
+
+void map_file::close()
+{
+#ifndef _WIN32
+    if (m_data != nullptr && m_buffer.empty())
+    {
+        munmap((void*)m_data, m_size);
+    }
+#endif
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    memset(&m_header, 0, sizeof(m_header));
+    m_name.clear();
+}
+
+void map_file::origin(double& x, double& y, double& theta) const
+{
+    x = m_header.origin_x;
+    y = m_header.origin_y;
+    theta = m_header.origin_theta;
+}
+
+size_t map_file::cell_index(size_t x, size_t y) const
+{
+    size_t t = m_header.tile_size;
+    size_t tile = (y / t) * m_tiles_x + (x / t);
+    return tile * m_tile_cells + (y % t) * t + (x % t);
+}
+
+MapGrid2D::map_flags map_file::get_flag(size_t x, size_t y) const
+{
+    size_t i = cell_index(x, y);
+    unsigned char byte = m_data[m_header.flags_offset + i / 4];
+    return code_to_flag((byte >> ((i % 4) * 2)) & 0x03);
+}
+
+unsigned char map_file::get_occupancy(size_t x, size_t y) const
+{
+    return m_data[m_header.occupancy_offset + cell_index(x, y)];
+}
+
+bool map_file::to_map(MapGrid2D& map) const
+{
+    if (!is_open()) return false;
+    size_t w = width();
+    size_t h = height();
+    map.setSize_in_cells(w, h);
+    map.setResolution(m_header.resolution);
+    map.setOrigin(m_header.origin_x, m_header.origin_y, m_header.origin_theta);
+    map.setMapName(m_name);
+
+    yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy;
+    occupancy.resize(w, h);
+    for (size_t y = 0; y < h; y++)
+    {
+        unsigned char* row = occupancy.getRow(y);
+        for (size_t x = 0; x < w; x++)
+        {
+            row[x] = get_occupancy(x, y);
+            //MapGrid2D has no bulk setter for the flags
+            map.setMapFlag(XYCell(x, y), get_flag(x, y));
+        }
+    }
+    return map.setOccupancyGrid(occupancy);
+}
+
+bool map_file::save(const MapGrid2D& map, const std::string& filename, size_t tile_size)
+{
+    if (tile_size == 0 || tile_size % 4 != 0 || tile_size > MAX_TILE_SIZE)
+    {
+        yError() << "map_file: the tile size must be a multiple of 4, at most" << MAX_TILE_SIZE;
+        return false;
+    }
+    size_t w = map.width();
+    size_t h = map.height();
+    size_t tiles_x = (w + tile_size - 1) / tile_size;
+    size_t tiles_y = (h + tile_size - 1) / tile_size;
+    size_t tile_cells = tile_size * tile_size;
+    size_t cells = tiles_x * tiles_y * tile_cells;
+    std::string name = map.getMapName();
+
+    header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format = FORMAT;
+    header.width = (uint32_t)w;
+    header.height = (uint32_t)h;
+    header.tile_size = (uint32_t)tile_size;
+    header.name_length = (uint32_t)name.size();
+    map.getResolution(header.resolution);
+    map.getOrigin(header.origin_x, header.origin_y, header.origin_theta);
+    header.flags_offset = align(sizeof(header_t) + name.size());
+    header.occupancy_offset = align(header.flags_offset + cells / 4);
+
+    yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy;
+    map.getOccupancyGrid(occupancy);
+    bool has_occupancy = occupancy.width() == w && occupancy.height() == h;
+    if (!has_occupancy)
+    {
+        yWarning() << "map_file: map" << name << "has no occupancy data";
+    }
+
+    //the cells outside the map (in the last row/column of tiles) are unknown
+    std::vector<unsigned char> flags(cells / 4, 0);
+    std::vector<unsigned char> occupancy_plane(cells, 255);
+    for (size_t i = 0; i < cells; i++)
+    {
+        flags[i / 4] |= CODE_UNKNOWN << ((i % 4) * 2);
+    }
+    for (size_t y = 0; y < h; y++)
+    {
+        size_t ty = y / tile_size;
+        size_t iy = y % tile_size;
+        const unsigned char* row = has_occupancy ? occupancy.getRow(y) : nullptr;
+        for (size_t x = 0; x < w; x++)
+        {
+            size_t i = (ty * tiles_x + x / tile_size) * tile_cells + iy * tile_size + (x % tile_size);
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            unsigned char shift = (unsigned char)((i % 4) * 2);
+            flags[i / 4] = (unsigned char)((flags[i / 4] & ~(0x03 << shift)) | (flag_to_code(flag) << shift));
+            if (row) occupancy_plane[i] = row[x];
+        }
+    }
+
+    //the file is written with a temporary name and then renamed, so the processes which have mapped the previous
+    //version of the file keep reading it consistently
+    std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream out(tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            yError() << "map_file: unable to write" << tmp_filename;
+            return false;
+        }
+        std::vector<char> padding(ALIGNMENT, 0);
+        out.write((const char*)&header, sizeof(header));
+        out.write(name.data(), name.size());
+        out.write(padding.data(), header.flags_offset - sizeof(header) - name.size());
+        out.write((const char*)flags.data(), flags.size());
+        out.write(padding.data(), header.occupancy_offset - header.flags_offset - flags.size());
+        out.write((const char*)occupancy_plane.data(), occupancy_plane.size());
+        if (!out)
+        {
+            yError() << "map_file: unable to write" << tmp_filename;
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        yError() << "map_file: unable to write" << filename;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+* A compact binary format for the maps, which is memory-mapped read-only: opening a map costs only the mapping of the file,
+* and get_flag()/get_occupancy() read the cells directly from it. to_map() instead copies every cell into a MapGrid2D.
+* The file contains a header (size, resolution, origin, name), followed by two tiled planes: the flags of the cells
+* packed in 2 bits and the occupancy in 8 bits. Each tile stores tile_size*tile_size cells contiguously, so a rectangular
+* region of the map is read from a few pages only.
+* The flags are the static ones: free, wall, unknown and keep out. The temporary and enlarged obstacles are computed at
+* runtime, so they are stored as free cells.
+*/
+class map_file
+{
+public:
+    struct header_t
+    {
+        char     magic[8];
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tile_size;
+        uint32_t name_length;
+        uint32_t reserved;
+        double   resolution;
+        double   origin_x;
+        double   origin_y;
+        double   origin_theta;
+        uint64_t flags_offset;      //from the beginning of the file
+        uint64_t occupancy_offset;  //from the beginning of the file
+    };
+
+private:
+    const unsigned char*       m_data;
+    size_t                     m_size;
+    std::vector<unsigned char> m_buffer;    //used when memory mapping is not available
+    header_t                   m_header;
+    std::string                m_name;
+    size_t                     m_tiles_x;
+    size_t                     m_tile_cells;
+
+public:
+    map_file();
+    ~map_file();
+    static const size_t MAX_TILE_SIZE = 4096;
+
+    map_file(const map_file&) = delete;
+    map_file& operator=(const map_file&) = delete;
+
+    /**
+    * Opens (and maps in memory) a map file.
+    */
+    bool open(const std::string& filename);
+    void close();
+    bool is_open() const { return m_data != nullptr; }
+
+    size_t      width() const { return m_header.width; }
+    size_t      height() const { return m_header.height; }
+    double      resolution() const { return m_header.resolution; }
+    void        origin(double& x, double& y, double& theta) const;
+    std::string name() const { return m_name; }
+
+    /**
+    * Reads a cell. The cell must be inside the map.
+    */
+    yarp::dev::Nav2D::MapGrid2D::map_flags get_flag(size_t x, size_t y) const;
+    unsigned char                          get_occupancy(size_t x, size_t y) const;
+
+    /**
+    * Copies the whole map into a MapGrid2D
+    */
+    bool to_map(yarp::dev::Nav2D::MapGrid2D& map) const;
+
+    /**
+    * Writes a map in the binary format.
+    * @param tile_size the size of the tiles, in cells (a multiple of 4, at most MAX_TILE_SIZE)
+    */
+    static bool save(const yarp::dev::Nav2D::MapGrid2D& map, const std::string& filename, size_t tile_size = 64);
+
+private:
+    size_t cell_index(size_t x, size_t y) const;
+};
+
+#endif
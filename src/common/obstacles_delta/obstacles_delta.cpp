@@ -0,0 +1,275 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "obstacles_delta.h"
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    const unsigned char FREE_FLAG = (unsigned char)(MapGrid2D::MAP_CELL_FREE);
+}
+
+//------------------------------------------------------------------------------------------------
+obstacles_delta_encoder::obstacles_delta_encoder(double keyframe_period)
+{
+    m_width = 0;
+    m_height = 0;
+    m_seq = 0;
+    m_keyframe_period = keyframe_period;
+    m_last_keyframe_time = 0;
+}
+
+void obstacles_delta_encoder::reset()
+{
+    m_flags.clear();
+    m_width = 0;
+    m_height = 0;
+    m_map_name.clear();
+}
+
+bool obstacles_delta_encoder::encode(const MapGrid2D& map, double now, yarp::os::Bottle& msg)
+{
+    bool keyframe = m_flags.empty() ||
+                    m_width != map.width() ||
+                    m_height != map.height() ||
+                    m_map_name != map.getMapName() ||
+                    now - m_last_keyframe_time > m_keyframe_period;
+
+    if (keyframe)
+    {
+        m_width = map.width();
+        m_height = map.height();
+        m_map_name = map.getMapName();
+        m_flags.assign(m_width*m_height, FREE_FLAG);
+        m_last_keyframe_time = now;
+    }
+
+    //a keyframe is a delta w.r.t. an empty map
+    std::vector<int> runs;
+    size_t i = 0;
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++, i++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            unsigned char f = (unsigned char)(flag);
+            if (f == m_flags[i])
+            {
+                continue;
+            }
+            m_flags[i] = f;
+            //extends the current run if the previous cell changed to the same flag
+            size_t n = runs.size();
+            if (n >= 3 && runs[n - 1] == f && (size_t)(runs[n - 3] + runs[n - 2]) == i)
+            {
+                runs[n - 2]++;
+                continue;
+            }
+            runs.push_back((int)i);
+            runs.push_back(1);
+            runs.push_back(f);
+        }
+
+    if (!keyframe && runs.empty())
+    {
+        return false;
+    }
+
+    msg.clear();
+    msg.addInt32(m_seq++);
+    msg.addInt32(keyframe ? 1 : 0);
+    msg.addString(m_map_name);
+    msg.addInt32((int)m_width);
+    msg.addInt32((int)m_height);
+    yarp::os::Bottle& runs_bot = msg.addList();
+    for (size_t r = 0; r < runs.size(); r++)
+    {
+        runs_bot.addInt32(runs[r]);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------
+obstacles_delta_decoder::obstacles_delta_decoder()
+{
+    m_width = 0;
+    m_height = 0;
+    m_last_seq = 0;
+    m_synced = false;
+    clear_dirty();
+}
+
+bool obstacles_delta_decoder::apply(const yarp::os::Bottle& msg)
+{
+    if (msg.size() != 6 || msg.get(5).isList() == false)
+    {
+        yError() << "obstacles_delta_decoder: invalid message";
+        return false;
+    }
+    int seq = msg.get(0).asInt32();
+    bool keyframe = msg.get(1).asInt32() != 0;
+    std::string map_name = msg.get(2).asString();
+    size_t width = (size_t)msg.get(3).asInt32();
+    size_t height = (size_t)msg.get(4).asInt32();
+    const yarp::os::Bottle* runs = msg.get(5).asList();
+
+    if (!keyframe)
+    {
+        if (!m_synced || seq != m_last_seq + 1 || width != m_width || height != m_height || map_name != m_map_name)
+        {
+            //a message was lost: the deltas are meaningless until the next keyframe
+            m_synced = false;
+            return false;
+        }
+    }
+
+    std::vector<unsigned char> old_flags;
+    if (keyframe)
+    {
+        if (width != m_width || height != m_height)
+        {
+            m_width = width;
+            m_height = height;
+            m_flags.assign(m_width*m_height, FREE_FLAG);
+            mark_all_dirty();
+        }
+        old_flags.swap(m_flags);
+        m_flags.assign(m_width*m_height, FREE_FLAG);
+        m_map_name = map_name;
+    }
+
+    size_t ncells = m_flags.size();
+    for (size_t r = 0; r + 2 < runs->size(); r += 3)
+    {
+        size_t start = (size_t)runs->get(r).asInt32();
+        size_t len = (size_t)runs->get(r + 1).asInt32();
+        unsigned char f = (unsigned char)runs->get(r + 2).asInt32();
+        if (start >= ncells || len > ncells - start)
+        {
+            yError() << "obstacles_delta_decoder: run out of the map";
+            m_synced = false;
+            return false;
+        }
+        std::fill(m_flags.begin() + start, m_flags.begin() + start + len, f);
+        if (!keyframe)
+        {
+            mark_dirty(start);
+            mark_dirty(start + len - 1);
+            //a run spanning more than one row touches the whole width of the map
+            if (start / m_width != (start + len - 1) / m_width)
+            {
+                mark_dirty((start / m_width) * m_width);
+                mark_dirty((start / m_width) * m_width + m_width - 1);
+            }
+        }
+    }
+
+    if (keyframe)
+    {
+        for (size_t i = 0; i < ncells; i++)
+        {
+            if (old_flags[i] != m_flags[i]) mark_dirty(i);
+        }
+    }
+
+    m_last_seq = seq;
+    m_synced = true;
+    return true;
+}
+
+void obstacles_delta_decoder::load(const MapGrid2D& map)
+{
+    if (map.width() != m_width || map.height() != m_height)
+    {
+        m_width = map.width();
+        m_height = map.height();
+        m_flags.assign(m_width*m_height, FREE_FLAG);
+        mark_all_dirty();
+    }
+    m_map_name = map.getMapName();
+    size_t i = 0;
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++, i++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            unsigned char f = (unsigned char)(flag);
+            if (m_flags[i] != f)
+            {
+                m_flags[i] = f;
+                mark_dirty(i);
+            }
+        }
+    m_synced = false;
+}
+
+MapGrid2D::map_flags obstacles_delta_decoder::flag_at(size_t x, size_t y) const
+{
+    if (x >= m_width || y >= m_height) return MapGrid2D::MAP_CELL_FREE;
+    return (MapGrid2D::map_flags)(m_flags[y*m_width + x]);
+}
+
+void obstacles_delta_decoder::get_cells(const std::vector<MapGrid2D::map_flags>& flags, std::vector<XYCell>& cells) const
+{
+    bool selected[256] = { false };
+    for (size_t i = 0; i < flags.size(); i++)
+    {
+        selected[(unsigned char)(flags[i])] = true;
+    }
+    cells.clear();
+    size_t i = 0;
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++, i++)
+        {
+            if (selected[m_flags[i]]) cells.push_back(XYCell(x, y));
+        }
+}
+
+bool obstacles_delta_decoder::get_dirty_region(XYCell& min, XYCell& max) const
+{
+    if (!m_dirty) return false;
+    min = XYCell(m_dirty_min_x, m_dirty_min_y);
+    max = XYCell(m_dirty_max_x, m_dirty_max_y);
+    return true;
+}
+
+void obstacles_delta_decoder::clear_dirty()
+{
+    m_dirty = false;
+    m_dirty_min_x = 0;
+    m_dirty_min_y = 0;
+    m_dirty_max_x = 0;
+    m_dirty_max_y = 0;
+}
+
+void obstacles_delta_decoder::mark_dirty(size_t index)
+{
+    size_t x = index % m_width;
+    size_t y = index / m_width;
+    if (!m_dirty)
+    {
+        m_dirty = true;
+        m_dirty_min_x = m_dirty_max_x = x;
+        m_dirty_min_y = m_dirty_max_y = y;
+        return;
+    }
+    m_dirty_min_x = std::min(m_dirty_min_x, x);
+    m_dirty_min_y = std::min(m_dirty_min_y, y);
+    m_dirty_max_x = std::max(m_dirty_max_x, x);
+    m_dirty_max_y = std::max(m_dirty_max_y, y);
+}
+
+void obstacles_delta_decoder::mark_all_dirty()
+{
+    if (m_width == 0 || m_height == 0) return;
+    mark_dirty(0);
+    mark_dirty(m_width*m_height - 1);
+}
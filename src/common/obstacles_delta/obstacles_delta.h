@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef OBSTACLES_DELTA_H
+#define OBSTACLES_DELTA_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/os/Bottle.h>
+#include <string>
+#include <vector>
+
+/**
+* Encoding of the flags of an obstacles map as a stream of deltas, used to publish the local obstacles map of a navigation
+* device without sending the whole MapGrid2D at every update.
+* Each message is a bottle: `seq keyframe map_name width height (start length flag start length flag ...)`.
+* A keyframe lists the runs of cells which are not free, a delta lists the runs of cells whose flag changed w.r.t. the previous message.
+* Cells are indexed row-major (index = y * width + x).
+*/
+class obstacles_delta_encoder
+{
+    std::vector<unsigned char>   m_flags;
+    std::string                  m_map_name;
+    size_t                       m_width;
+    size_t                       m_height;
+    int                          m_seq;
+    double                       m_keyframe_period;
+    double                       m_last_keyframe_time;
+
+public:
+    /**
+    * @param keyframe_period the maximum time between two keyframes [s]
+    */
+    obstacles_delta_encoder(double keyframe_period = 5.0);
+
+    void   set_keyframe_period(double period) { m_keyframe_period = period; }
+
+    /**
+    * Encodes the current status of the map.
+    * A keyframe is generated if the size or the name of the map changed, if keyframe_period expired or after a reset().
+    * @param map the current obstacles map
+    * @param now the current time [s]
+    * @param msg the encoded message
+    * @return false if nothing changed since the last message, i.e. there is nothing to send
+    */
+    bool   encode(const yarp::dev::Nav2D::MapGrid2D& map, double now, yarp::os::Bottle& msg);
+
+    /**
+    * Forgets the previous status, so that the next message will be a keyframe.
+    */
+    void   reset();
+};
+
+/**
+* Decoder of the messages generated by obstacles_delta_encoder. It keeps a copy of the flags of the remote map,
+* detects the lost messages through the sequence numbers and keeps track of the region modified by the received messages.
+*/
+class obstacles_delta_decoder
+{
+    std::vector<unsigned char>   m_flags;
+    std::string                  m_map_name;
+    size_t                       m_width;
+    size_t                       m_height;
+    int                          m_last_seq;
+    bool                         m_synced;
+
+    //bounding box of the cells modified since the last clear_dirty()
+    bool                         m_dirty;
+    size_t                       m_dirty_min_x;
+    size_t                       m_dirty_min_y;
+    size_t                       m_dirty_max_x;
+    size_t                       m_dirty_max_y;
+
+public:
+    obstacles_delta_decoder();
+
+    /**
+    * Applies a message to the local copy of the map.
+    * A delta received after a lost message is discarded: the decoder waits for the next keyframe.
+    * @return false if the message was discarded or invalid
+    */
+    bool   apply(const yarp::os::Bottle& msg);
+
+    /**
+    * Loads the flags of a whole map, e.g. obtained through INavigation2D::getCurrentNavigationMap().
+    * The decoder remains unsynced until the next keyframe is received, since the map is not related to a sequence number.
+    */
+    void   load(const yarp::dev::Nav2D::MapGrid2D& map);
+
+    /**
+    * @return true if the local copy is aligned with the stream
+    */
+    bool   is_synced() const { return m_synced; }
+
+    size_t width() const { return m_width; }
+    size_t height() const { return m_height; }
+    const std::string& map_name() const { return m_map_name; }
+
+    /**
+    * @return the flag of the cell (x,y), MAP_CELL_FREE if the cell is outside the map
+    */
+    yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(size_t x, size_t y) const;
+
+    /**
+    * Gets the cells marked with one of the given flags.
+    */
+    void   get_cells(const std::vector<yarp::dev::Nav2D::MapGrid2D::map_flags>& flags, std::vector<yarp::dev::Nav2D::XYCell>& cells) const;
+
+    /**
+    * Gets the bounding box of the cells modified since the last call to clear_dirty().
+    * @return false if no cell was modified
+    */
+    bool   get_dirty_region(yarp::dev::Nav2D::XYCell& min, yarp::dev::Nav2D::XYCell& max) const;
+    void   clear_dirty();
+
+private:
+    void   mark_dirty(size_t index);
+    void   mark_all_dirty();
+};
+
+#endif
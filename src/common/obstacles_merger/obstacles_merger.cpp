@@ -0,0 +1,181 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "obstacles_merger.h"
+#include <algorithm>
+#include <limits>
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    const size_t NO_ROW = std::numeric_limits<size_t>::max();
+
+    //writes a flag into the cells of the row y which are set in word w
+    size_t write_cells(MapGrid2D& map, size_t y, size_t w, uint64_t cells, MapGrid2D::map_flags flag)
+    {
+        size_t n = 0;
+        for (; cells != 0; cells &= cells - 1)
+        {
+            map.setMapFlag(XYCell(w * 64 + bit_grid::lowest_bit(cells), y), flag);
+            n++;
+        }
+        return n;
+    }
+}
+
+obstacles_merger::obstacles_merger()
+{
+    m_decay_time = 0;
+    m_slots = 1;
+    m_dirty_min_row = NO_ROW;
+    m_dirty_max_row = 0;
+}
+
+void obstacles_merger::configure(double decay_time, size_t slots)
+{
+    m_decay_time = decay_time;
+    m_slots = std::max<size_t>(1, slots);
+}
+
+void obstacles_merger::reset(const MapGrid2D& base_map)
+{
+    m_base_free.from_map(base_map, bit_grid::mask(MapGrid2D::map_flags::MAP_CELL_FREE));
+    m_layers.clear();
+    m_applied_temporary.resize(base_map.width(), base_map.height());
+    m_applied_enlarged.resize(base_map.width(), base_map.height());
+    m_dirty_min_row = NO_ROW;
+    m_dirty_max_row = 0;
+}
+
+void obstacles_merger::mark_dirty(size_t min_row, size_t max_row)
+{
+    if (min_row > max_row) return;
+    m_dirty_min_row = std::min(m_dirty_min_row, min_row);
+    m_dirty_max_row = std::max(m_dirty_max_row, max_row);
+}
+
+bool obstacles_merger::merge(const MapGrid2D& obstacles_map, double time)
+{
+    if (obstacles_map.width() != m_base_free.width() || obstacles_map.height() != m_base_free.height())
+    {
+        return false;
+    }
+
+    //a new layer is started at the beginning of each time slot
+    if (m_layers.empty() || (m_decay_time > 0 && time - m_layers.front().start_time >= m_decay_time / m_slots))
+    {
+        layer_t layer;
+        layer.temporary.resize(m_base_free.width(), m_base_free.height());
+        layer.enlarged.resize(m_base_free.width(), m_base_free.height());
+        layer.start_time = time;
+        layer.min_row = NO_ROW;
+        layer.max_row = 0;
+        m_layers.push_front(layer);
+    }
+    layer_t& layer = m_layers.front();
+
+    //each cell of the obstacles map is read once: the temporary and the enlarged obstacles are collected in the same pass
+    size_t width = m_base_free.width();
+    size_t min_row = NO_ROW;
+    size_t max_row = 0;
+    for (size_t y = 0; y < m_base_free.height(); y++)
+    {
+        const uint64_t* free_row = m_base_free.row(y);
+        uint64_t* lt_row = layer.temporary.row(y);
+        uint64_t* le_row = layer.enlarged.row(y);
+        uint64_t any = 0;
+        for (size_t w = 0; w < m_base_free.words_per_row(); w++)
+        {
+            uint64_t t = 0;
+            uint64_t e = 0;
+            size_t x_end = std::min(width, (w + 1) * 64);
+            for (size_t x = w * 64; x < x_end; x++)
+            {
+                MapGrid2D::map_flags flag = MapGrid2D::map_flags::MAP_CELL_FREE;
+                obstacles_map.getMapFlag(XYCell(x, y), flag);
+                if (flag == MapGrid2D::map_flags::MAP_CELL_TEMPORARY_OBSTACLE)     t |= uint64_t(1) << (x & 63);
+                else if (flag == MapGrid2D::map_flags::MAP_CELL_ENLARGED_OBSTACLE) e |= uint64_t(1) << (x & 63);
+            }
+            t &= free_row[w];
+            e &= free_row[w];
+            lt_row[w] |= t;
+            le_row[w] |= e;
+            any |= t | e;
+        }
+        if (any)
+        {
+            min_row = std::min(min_row, y);
+            max_row = y;
+        }
+    }
+    layer.min_row = std::min(layer.min_row, min_row);
+    layer.max_row = (layer.min_row == NO_ROW) ? 0 : std::max(layer.max_row, max_row);
+    mark_dirty(min_row, max_row);
+    return true;
+}
+
+bool obstacles_merger::decay(double time)
+{
+    if (m_decay_time <= 0) return false;
+    bool removed = false;
+    while (!m_layers.empty() && time - m_layers.back().start_time > m_decay_time)
+    {
+        if (m_layers.back().min_row != NO_ROW)
+        {
+            mark_dirty(m_layers.back().min_row, m_layers.back().max_row);
+            removed = true;
+        }
+        m_layers.pop_back();
+    }
+    return removed;
+}
+
+size_t obstacles_merger::apply(MapGrid2D& map)
+{
+    if (map.width() != m_base_free.width() || map.height() != m_base_free.height() || m_dirty_min_row == NO_ROW)
+    {
+        return 0;
+    }
+
+    //each word of the dirty rows is compared with the cells already written into the map, only the differences are written
+    size_t n = 0;
+    size_t words = m_base_free.words_per_row();
+    for (size_t y = m_dirty_min_row; y <= m_dirty_max_row; y++)
+    {
+        uint64_t* at_row = m_applied_temporary.row(y);
+        uint64_t* ae_row = m_applied_enlarged.row(y);
+        for (size_t w = 0; w < words; w++)
+        {
+            uint64_t t = 0;
+            uint64_t e = 0;
+            for (size_t i = 0; i < m_layers.size(); i++)
+            {
+                t |= m_layers[i].temporary.row(y)[w];
+                e |= m_layers[i].enlarged.row(y)[w];
+            }
+            e &= ~t;
+            uint64_t at = at_row[w];
+            uint64_t ae = ae_row[w];
+            if (t == at && e == ae) continue;
+            n += write_cells(map, y, w, t & ~at, MapGrid2D::map_flags::MAP_CELL_TEMPORARY_OBSTACLE);
+            n += write_cells(map, y, w, e & ~ae, MapGrid2D::map_flags::MAP_CELL_ENLARGED_OBSTACLE);
+            n += write_cells(map, y, w, (at | ae) & ~(t | e), MapGrid2D::map_flags::MAP_CELL_FREE);
+            at_row[w] = t;
+            ae_row[w] = e;
+        }
+    }
+    m_dirty_min_row = NO_ROW;
+    m_dirty_max_row = 0;
+    return n;
+}
+
+size_t obstacles_merger::count() const
+{
+    return m_applied_temporary.count() + m_applied_enlarged.count();
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef OBSTACLES_MERGER_H
+#define OBSTACLES_MERGER_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <deque>
+#include "bit_grid.h"
+
+/**
+* Merges the obstacles detected at runtime (the temporary and enlarged obstacles of a map built from the laser scans)
+* into a planning map, e.g. to replan around them after a navigation failure.
+* The obstacles are accumulated in bit-packed layers: each layer collects the obstacles merged during a time slot of
+* decay_time/slots seconds and is dropped when it becomes older than decay_time, so the obstacles which are not seen
+* anymore (e.g. a person who walked away) leave the planning map. With decay_time<=0 the obstacles are kept until reset().
+* apply() writes into the planning map only the cells which changed since the previous call, scanning only the rows
+* which may contain them.
+* Only the cells which are free in the base map are modified.
+*/
+class obstacles_merger
+{
+    struct layer_t
+    {
+        bit_grid   temporary;
+        bit_grid   enlarged;
+        double     start_time;
+        size_t     min_row;     //the rows which contain at least one obstacle
+        size_t     max_row;
+    };
+
+    double                  m_decay_time;
+    size_t                  m_slots;
+    bit_grid                m_base_free;        //the free cells of the base map
+    std::deque<layer_t>     m_layers;           //the most recent first
+    bit_grid                m_applied_temporary;
+    bit_grid                m_applied_enlarged;
+    size_t                  m_dirty_min_row;    //the rows which may differ from the content of the planning map
+    size_t                  m_dirty_max_row;
+
+public:
+    obstacles_merger();
+
+    /**
+    * @param decay_time the time [s] after which a merged obstacle is removed. A value <=0 disables the decay.
+    * @param slots the number of layers in which decay_time is divided. More slots make the decay smoother.
+    */
+    void   configure(double decay_time, size_t slots = 4);
+
+    /**
+    * Removes all the obstacles and sets the base map, i.e. the planning map without merged obstacles.
+    */
+    void   reset(const yarp::dev::Nav2D::MapGrid2D& base_map);
+
+    /**
+    * Adds the temporary and enlarged obstacles of a map with the same size of the base map.
+    * @return false if the sizes differ
+    */
+    bool   merge(const yarp::dev::Nav2D::MapGrid2D& obstacles_map, double time);
+
+    /**
+    * Drops the layers older than decay_time.
+    * @return true if some obstacles have been removed, i.e. the planning map must be updated
+    */
+    bool   decay(double time);
+
+    /**
+    * Updates a planning map (the base map, possibly already modified by a previous call) with the current obstacles.
+    * @return the number of modified cells
+    */
+    size_t apply(yarp::dev::Nav2D::MapGrid2D& map);
+
+    /**
+    * @return the number of cells blocked by merged obstacles in the planning map, as of the last apply()
+    */
+    size_t count() const;
+
+private:
+    void   mark_dirty(size_t min_row, size_t max_row);
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "pose_buffer.h"
+#include <yarp/os/Vocab.h>
+#include <math.h>
+
+using namespace yarp::dev::Nav2D;
+
+pose_buffer::pose_buffer(size_t capacity)
+{
+    m_ring.resize(capacity > 1 ? capacity : 2);
+    m_head = 0;
+    m_count = 0;
+}
+
+void pose_buffer::set_capacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ring.clear();
+    m_ring.resize(capacity > 1 ? capacity : 2);
+    m_head = 0;
+    m_count = 0;
+}
+
+void pose_buffer::add_pose(double stamp, const Map2DLocation& loc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count > 0)
+    {
+        const stamped_pose& newest = at(m_count - 1);
+        if (stamp < newest.stamp) return;
+        if (stamp == newest.stamp)
+        {
+            //same stamp: the newest sample is replaced
+            m_ring[(m_head + m_ring.size() - 1) % m_ring.size()].pose = loc;
+            return;
+        }
+    }
+    m_ring[m_head].stamp = stamp;
+    m_ring[m_head].pose = loc;
+    m_head = (m_head + 1) % m_ring.size();
+    if (m_count < m_ring.size()) m_count++;
+}
+
+bool pose_buffer::get_pose_at(double stamp, Map2DLocation& loc, double tolerance) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == 0) return false;
+
+    const stamped_pose& newest = at(m_count - 1);
+    if (stamp >= newest.stamp)
+    {
+        if (stamp - newest.stamp > tolerance) return false;
+        loc = newest.pose;
+        return true;
+    }
+    if (stamp < at(0).stamp) return false;
+
+    //binary search of the first sample newer than stamp
+    size_t lo = 0;
+    size_t hi = m_count - 1;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (at(mid).stamp <= stamp) lo = mid + 1;
+        else                        hi = mid;
+    }
+    const stamped_pose& p1 = at(lo - 1);
+    const stamped_pose& p2 = at(lo);
+
+    double alpha = (stamp - p1.stamp) / (p2.stamp - p1.stamp);
+    if (p1.pose.map_id != p2.pose.map_id)
+    {
+        loc = (alpha < 0.5) ? p1.pose : p2.pose;
+        return true;
+    }
+    double dtheta = fmod(p2.pose.theta - p1.pose.theta + 540.0, 360.0) - 180.0;
+    loc.map_id = p1.pose.map_id;
+    loc.x = p1.pose.x + alpha * (p2.pose.x - p1.pose.x);
+    loc.y = p1.pose.y + alpha * (p2.pose.y - p1.pose.y);
+    loc.theta = p1.pose.theta + alpha * dtheta;
+    return true;
+}
+
+bool pose_buffer::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply) const
+{
+    if (command.get(0).asString() != "get_pose_at") return false;
+
+    Map2DLocation loc;
+    if (command.size() > 1 && get_pose_at(command.get(1).asFloat64(), loc))
+    {
+        reply.addVocab(yarp::os::Vocab::encode("ok"));
+        reply.addString(loc.map_id);
+        reply.addFloat64(loc.x);
+        reply.addFloat64(loc.y);
+        reply.addFloat64(loc.theta);
+    }
+    else
+    {
+        reply.addVocab(yarp::os::Vocab::encode("fail"));
+    }
+    return true;
+}
+
+void pose_buffer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_head = 0;
+    m_count = 0;
+}
+
+size_t pose_buffer::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
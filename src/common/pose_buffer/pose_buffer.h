@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef POSE_BUFFER_H
+#define POSE_BUFFER_H
+
+#include <yarp/dev/Map2DLocation.h>
+#include <yarp/os/Bottle.h>
+#include <mutex>
+#include <vector>
+
+/**
+* A time-indexed ring buffer of robot poses.
+* Localization devices push each new estimate together with its timestamp, consumers ask for the pose at a given instant
+* (e.g. the acquisition time of a laser scan) and obtain the pose linearly interpolated between the two closest samples.
+* The class is thread safe: one thread can add poses while others query the buffer.
+*/
+class pose_buffer
+{
+    struct stamped_pose
+    {
+        double                           stamp;
+        yarp::dev::Nav2D::Map2DLocation  pose;
+    };
+
+    mutable std::mutex           m_mutex;
+    std::vector<stamped_pose>    m_ring;
+    size_t                       m_head;    //position of the next write
+    size_t                       m_count;   //number of valid samples
+
+public:
+    /**
+    * @param capacity the number of poses stored by the buffer
+    */
+    pose_buffer(size_t capacity = 500);
+
+    /**
+    * Changes the number of poses stored by the buffer. The content of the buffer is discarded.
+    */
+    void   set_capacity(size_t capacity);
+
+    /**
+    * Adds a new pose. Poses must be added in chronological order: a pose older than the most recent one is discarded.
+    * @param stamp the time at which the pose was valid [s]
+    * @param loc the pose
+    */
+    void   add_pose(double stamp, const yarp::dev::Nav2D::Map2DLocation& loc);
+
+    /**
+    * Gets the pose at a given time.
+    * If the time falls between two samples, the pose is linearly interpolated (theta along the shortest arc).
+    * If the two samples refer to different maps, the closest one is returned.
+    * @param stamp the requested time [s]
+    * @param loc the returned pose
+    * @param tolerance a request at most tolerance seconds newer than the most recent sample returns the most recent sample
+    * @return false if the requested time is not covered by the buffer
+    */
+    bool   get_pose_at(double stamp, yarp::dev::Nav2D::Map2DLocation& loc, double tolerance = 0.05) const;
+
+    /**
+    * Serves a `get_pose_at <timestamp>` rpc request, replying `ok map_id x y theta` or `fail`.
+    * Used by the rpc handlers of the localization devices.
+    * @return false if the request is not a `get_pose_at` command
+    */
+    bool   respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply) const;
+
+    void   clear();
+    size_t size() const;
+
+private:
+    const stamped_pose& at(size_t i) const { return m_ring[(m_head + m_ring.size() - m_count + i) % m_ring.size()]; }
+};
+
+#endif
@@ -0,0 +1,160 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "ros_map_conversion.h"
+#include <yarp/os/LogStream.h>
+#include <yarp/sig/Image.h>
+#include <cstring>
+#include <math.h>
+
+using namespace yarp::dev::Nav2D;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    inline uint64_t hash_word(uint64_t h, uint64_t w)
+    {
+        h ^= w;
+        h *= FNV_PRIME;
+        h ^= h >> 29;
+        return h;
+    }
+
+    inline uint64_t hash_double(uint64_t h, double v)
+    {
+        uint64_t w = 0;
+        memcpy(&w, &v, sizeof(v));
+        return hash_word(h, w);
+    }
+}
+
+bool ros_map_conversion::yarp_to_ros(const MapGrid2D& map, yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid)
+{
+    size_t w = map.width();
+    size_t h = map.height();
+    double res = 0;
+    double ox = 0;
+    double oy = 0;
+    double ot = 0;
+    map.getResolution(res);
+    map.getOrigin(ox, oy, ot);
+
+    ogrid.info.map_load_time.sec = 0;
+    ogrid.info.map_load_time.nsec = 0;
+    ogrid.info.resolution = res;
+    ogrid.info.width = w;
+    ogrid.info.height = h;
+    ogrid.info.origin.position.x = ox;
+    ogrid.info.origin.position.y = oy;
+    ogrid.info.origin.position.z = 0;
+    //rotation around the z axis only
+    double half_t = ot * M_PI / 180.0 / 2.0;
+    ogrid.info.origin.orientation.x = 0;
+    ogrid.info.origin.orientation.y = 0;
+    ogrid.info.origin.orientation.z = sin(half_t);
+    ogrid.info.origin.orientation.w = cos(half_t);
+
+    yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy;
+    map.getOccupancyGrid(occupancy);
+    ogrid.data.resize(w*h);
+    if (occupancy.width() != w || occupancy.height() != h)
+    {
+        yError() << "ros_map_conversion: the occupancy data of map" << map.getMapName() << "has an invalid size";
+        return false;
+    }
+
+    //ROS rows are stored bottom-up
+    for (size_t y = 0; y < h; y++)
+    {
+        const unsigned char* src = occupancy.getRow(h - 1 - y);
+        int8_t* dst = ogrid.data.data() + y*w;
+        for (size_t x = 0; x < w; x++)
+        {
+            unsigned char v = src[x];
+            dst[x] = (v <= 100) ? (int8_t)v : (int8_t)(-1);
+        }
+    }
+    return true;
+}
+
+bool ros_map_conversion::ros_to_yarp(const yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid, MapGrid2D& map, const std::string& map_name, int free_threshold)
+{
+    size_t w = ogrid.info.width;
+    size_t h = ogrid.info.height;
+    if (ogrid.data.size() != w*h)
+    {
+        yError() << "ros_map_conversion: the occupancy grid has" << ogrid.data.size() << "cells instead of" << w*h;
+        return false;
+    }
+
+    const auto& q = ogrid.info.origin.orientation;
+    double yaw = atan2(2.0 * (q.w*q.z + q.x*q.y), 1.0 - 2.0 * (q.y*q.y + q.z*q.z));
+    map.setSize_in_cells(w, h);
+    map.setResolution(ogrid.info.resolution);
+    map.setMapName(map_name);
+    map.setOrigin(ogrid.info.origin.position.x, ogrid.info.origin.position.y, yaw * 180.0 / M_PI);
+
+    yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy;
+    occupancy.resize(w, h);
+    std::vector<MapGrid2D::map_flags> flags(w);
+    for (size_t y = 0; y < h; y++)
+    {
+        //ROS rows are stored bottom-up
+        size_t yarp_y = h - 1 - y;
+        const int8_t* src = ogrid.data.data() + y*w;
+        unsigned char* dst = occupancy.getRow(yarp_y);
+        for (size_t x = 0; x < w; x++)
+        {
+            dst[x] = occupancy_to_yarp(src[x]);
+        }
+        for (size_t x = 0; x < w; x++)
+        {
+            flags[x] = occupancy_to_flag(src[x], free_threshold);
+        }
+        //MapGrid2D has no bulk setter for the flags
+        for (size_t x = 0; x < w; x++)
+        {
+            map.setMapFlag(XYCell(x, yarp_y), flags[x]);
+        }
+    }
+    return map.setOccupancyGrid(occupancy);
+}
+
+uint64_t ros_map_conversion::fingerprint(const yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid)
+{
+    uint64_t h = FNV_OFFSET;
+    h = hash_word(h, ogrid.info.width);
+    h = hash_word(h, ogrid.info.height);
+    h = hash_double(h, ogrid.info.resolution);
+    h = hash_double(h, ogrid.info.origin.position.x);
+    h = hash_double(h, ogrid.info.origin.position.y);
+    h = hash_double(h, ogrid.info.origin.orientation.z);
+    h = hash_double(h, ogrid.info.origin.orientation.w);
+
+    //the data are hashed eight bytes at a time
+    size_t n = ogrid.data.size();
+    const int8_t* data = ogrid.data.data();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t w = 0;
+        memcpy(&w, data + i, 8);
+        h = hash_word(h, w);
+    }
+    for (; i < n; i++)
+    {
+        h = hash_word(h, (uint8_t)data[i]);
+    }
+    return h;
+}
@@ -0,0 +1,62 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef ROS_MAP_CONVERSION_H
+#define ROS_MAP_CONVERSION_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/rosmsg/nav_msgs/OccupancyGrid.h>
+#include <cstdint>
+
+/**
+* Conversions between yarp maps (MapGrid2D) and ROS occupancy grids (nav_msgs::OccupancyGrid).
+* The whole occupancy buffer is converted row by row (ROS grids are stored bottom-up, yarp maps top-down) with
+* tight per-row loops on bytes, instead of one getOccupancyData()/setOccupancyData() call per cell.
+*/
+namespace ros_map_conversion
+{
+    /**
+    * Fills the info and data fields of an occupancy grid. The header is left untouched.
+    * Unknown cells (occupancy 255 in the yarp map) are converted to -1.
+    */
+    bool yarp_to_ros(const yarp::dev::Nav2D::MapGrid2D& map, yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid);
+
+    /**
+    * Converts an occupancy grid to a yarp map with the given name.
+    * The occupancy is converted by occupancy_to_yarp(), the flags are computed as: free if occupancy <= free_threshold,
+    * wall if free_threshold < occupancy <= 100, unknown otherwise (e.g. -1).
+    */
+    bool ros_to_yarp(const yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid, yarp::dev::Nav2D::MapGrid2D& map, const std::string& map_name, int free_threshold = 70);
+
+    /**
+    * Converts a ROS occupancy value to the occupancy of a yarp map: 0..100 is copied, any other value (e.g. -1) is unknown (255).
+    */
+    inline unsigned char occupancy_to_yarp(int occupancy)
+    {
+        if (occupancy < 0 || occupancy > 100)  return 255;
+        return (unsigned char)occupancy;
+    }
+
+    /**
+    * Computes the flag of a cell from its ROS occupancy value, with the same rules used by ros_to_yarp().
+    */
+    inline yarp::dev::Nav2D::MapGrid2D::map_flags occupancy_to_flag(int occupancy, int free_threshold = 70)
+    {
+        if (occupancy < 0 || occupancy > 100)  return yarp::dev::Nav2D::MapGrid2D::MAP_CELL_UNKNOWN;
+        if (occupancy <= free_threshold)       return yarp::dev::Nav2D::MapGrid2D::MAP_CELL_FREE;
+        return yarp::dev::Nav2D::MapGrid2D::MAP_CELL_WALL;
+    }
+
+    /**
+    * Computes a 64 bit hash of the info and data fields of an occupancy grid.
+    * Used to avoid publishing again a map which did not change.
+    */
+    uint64_t fingerprint(const yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid);
+}
+
+#endif
@@ -0,0 +1,338 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "transform_cache.h"
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Network.h>
+#include <yarp/os/Time.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    //rigid transforms are stored as the first three rows of the homogeneous matrix (row major)
+    void identity(double* m)
+    {
+        std::fill(m, m + 12, 0.0);
+        m[0] = m[5] = m[10] = 1.0;
+    }
+
+    void compose(const double* a, const double* b, double* out)
+    {
+        for (size_t r = 0; r < 3; r++)
+        {
+            for (size_t c = 0; c < 4; c++)
+            {
+                double v = a[r * 4 + 0] * b[0 * 4 + c] + a[r * 4 + 1] * b[1 * 4 + c] + a[r * 4 + 2] * b[2 * 4 + c];
+                out[r * 4 + c] = (c == 3) ? v + a[r * 4 + 3] : v;
+            }
+        }
+    }
+
+    void invert(const double* a, double* out)
+    {
+        for (size_t r = 0; r < 3; r++)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                out[r * 4 + c] = a[c * 4 + r];
+            }
+            out[r * 4 + 3] = -(a[0 * 4 + r] * a[3] + a[1 * 4 + r] * a[7] + a[2 * 4 + r] * a[11]);
+        }
+    }
+
+    //sample: timestamp x y z qw qx qy qz
+    void sample_to_matrix(const double* s, double* m)
+    {
+        double w = s[4], x = s[5], y = s[6], z = s[7];
+        double n = sqrt(w * w + x * x + y * y + z * z);
+        if (n > 0) { w /= n; x /= n; y /= n; z /= n; }
+        else { w = 1; }
+        m[0] = 1 - 2 * (y * y + z * z); m[1] = 2 * (x * y - z * w);     m[2] = 2 * (x * z + y * w);      m[3] = s[1];
+        m[4] = 2 * (x * y + z * w);     m[5] = 1 - 2 * (x * x + z * z); m[6] = 2 * (y * z - x * w);      m[7] = s[2];
+        m[8] = 2 * (x * z - y * w);     m[9] = 2 * (y * z + x * w);     m[10] = 1 - 2 * (x * x + y * y); m[11] = s[3];
+    }
+}
+
+const size_t transform_cache::MAX_EDGES;
+const size_t transform_cache::RING_SIZE;
+const size_t transform_cache::SAMPLE_SIZE;
+
+transform_cache::transform_cache(double timeout)
+{
+    m_num_edges = 0;
+    m_timeout = timeout;
+    m_full_warned = false;
+}
+
+transform_cache::~transform_cache()
+{
+    close();
+}
+
+bool transform_cache::open(const std::string& local_port, const std::string& server_name)
+{
+    if (!m_port.open(local_port))
+    {
+        yError() << "transform_cache: unable to open port" << local_port;
+        return false;
+    }
+    m_port.useCallback(*this);
+    std::string server_port = server_name + "/transforms:o";
+    if (!yarp::os::Network::connect(server_port, local_port))
+    {
+        yError() << "transform_cache: unable to connect to" << server_port;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void transform_cache::close()
+{
+    m_port.interrupt();
+    m_port.disableCallback();
+    m_port.close();
+}
+
+void transform_cache::onRead(yarp::os::Bottle& transforms)
+{
+    update(transforms);
+}
+
+transform_cache::edge* transform_cache::find_edge(const std::string& parent, const std::string& child) const
+{
+    size_t n = m_num_edges.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (m_edges[i]->child == child && m_edges[i]->parent == parent) return m_edges[i].get();
+    }
+    return nullptr;
+}
+
+const transform_cache::edge* transform_cache::find_parent_edge(const std::string& child, double now) const
+{
+    size_t n = m_num_edges.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; i++)
+    {
+        const edge& e = *m_edges[i];
+        if (e.child != child) continue;
+        if (m_timeout > 0 && now - e.last_received.load(std::memory_order_acquire) > m_timeout) continue;
+        return &e;
+    }
+    return nullptr;
+}
+
+void transform_cache::update(const yarp::os::Bottle& transforms)
+{
+    std::lock_guard<std::mutex> lock(m_writer_mutex);
+    double now = yarp::os::Time::now();
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        const yarp::os::Bottle* t = transforms.get(i).asList();
+        if (t == nullptr || t->size() < 2 + SAMPLE_SIZE) continue;
+
+        std::string parent = t->get(0).asString();
+        std::string child = t->get(1).asString();
+        double s[SAMPLE_SIZE];
+        for (size_t k = 0; k < SAMPLE_SIZE; k++)
+        {
+            s[k] = t->get(2 + k).asFloat64();
+        }
+
+        edge* e = find_edge(parent, child);
+        if (e == nullptr)
+        {
+            size_t n = m_num_edges.load(std::memory_order_relaxed);
+            if (n >= MAX_EDGES)
+            {
+                if (!m_full_warned) yWarning() << "transform_cache: too many transforms, the new ones are ignored";
+                m_full_warned = true;
+                continue;
+            }
+            e = new edge;
+            e->parent = parent;
+            e->child = child;
+            e->written.store(0, std::memory_order_relaxed);
+            for (size_t j = 0; j < RING_SIZE; j++)
+            {
+                e->seq[j].store(0, std::memory_order_relaxed);
+                for (size_t k = 0; k < SAMPLE_SIZE; k++) e->data[j][k].store(0, std::memory_order_relaxed);
+            }
+            e->last_received.store(now, std::memory_order_relaxed);
+            m_edges[n].reset(e);
+            //the edge becomes visible to the readers only when it is complete
+            m_num_edges.store(n + 1, std::memory_order_release);
+        }
+
+        //the server sends all its transforms at each cycle: a sample is added only if it is newer than the last one
+        uint64_t written = e->written.load(std::memory_order_relaxed);
+        double last_stamp = (written > 0) ? e->data[(written - 1) % RING_SIZE][0].load(std::memory_order_relaxed) : 0;
+        if (written == 0 || s[0] > last_stamp)
+        {
+            size_t slot = written % RING_SIZE;
+            uint32_t seq = e->seq[slot].load(std::memory_order_relaxed);
+            e->seq[slot].store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t k = 0; k < SAMPLE_SIZE; k++)
+            {
+                e->data[slot][k].store(s[k], std::memory_order_relaxed);
+            }
+            e->seq[slot].store(seq + 2, std::memory_order_release);
+            e->written.store(written + 1, std::memory_order_release);
+        }
+        e->last_received.store(now, std::memory_order_release);
+    }
+}
+
+bool transform_cache::read_sample(const edge& e, double stamp, double* sample) const
+{
+    uint64_t written = e.written.load(std::memory_order_acquire);
+    if (written == 0) return false;
+
+    size_t available = (size_t)std::min<uint64_t>(written, RING_SIZE);
+    double newer[SAMPLE_SIZE];
+    bool have_newer = false;
+    for (size_t i = 0; i < available; i++)
+    {
+        size_t slot = (written - 1 - i) % RING_SIZE;
+        double s[SAMPLE_SIZE];
+        for (;;)
+        {
+            uint32_t seq1 = e.seq[slot].load(std::memory_order_acquire);
+            if (seq1 & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t k = 0; k < SAMPLE_SIZE; k++) s[k] = e.data[slot][k].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.seq[slot].load(std::memory_order_relaxed) == seq1) break;
+        }
+
+        //the slot has been overwritten by a newer sample while walking back in the ring
+        if (have_newer && s[0] >= newer[0]) break;
+
+        if (stamp <= 0 || s[0] <= stamp)
+        {
+            if (!have_newer || stamp <= 0 || s[0] == stamp)
+            {
+                std::copy(s, s + SAMPLE_SIZE, sample);
+                return true;
+            }
+            //interpolation between s and the next sample
+            double alpha = (stamp - s[0]) / (newer[0] - s[0]);
+            double dot = s[4] * newer[4] + s[5] * newer[5] + s[6] * newer[6] + s[7] * newer[7];
+            double sign = (dot < 0) ? -1.0 : 1.0;
+            sample[0] = stamp;
+            for (size_t k = 1; k < 4; k++) sample[k] = s[k] + alpha * (newer[k] - s[k]);
+            for (size_t k = 4; k < 8; k++) sample[k] = (1 - alpha) * s[k] + alpha * sign * newer[k];
+            return true;
+        }
+        std::copy(s, s + SAMPLE_SIZE, newer);
+        have_newer = true;
+    }
+
+    //the requested time is older than all the samples
+    std::copy(newer, newer + SAMPLE_SIZE, sample);
+    return true;
+}
+
+bool transform_cache::chain_to_root(const std::string& frame, double stamp, double now, double* transform, std::string& root) const
+{
+    identity(transform);
+    std::string current = frame;
+    for (size_t depth = 0; depth < MAX_EDGES; depth++)
+    {
+        const edge* e = find_parent_edge(current, now);
+        if (e == nullptr)
+        {
+            root = current;
+            return true;
+        }
+        double s[SAMPLE_SIZE];
+        if (!read_sample(*e, stamp, s)) return false;
+        double m[12], tmp[12];
+        sample_to_matrix(s, m);
+        compose(m, transform, tmp);
+        std::copy(tmp, tmp + 12, transform);
+        current = e->parent;
+    }
+    //the transforms contain a loop
+    return false;
+}
+
+bool transform_cache::get_transform(const std::string& target_frame_id, const std::string& source_frame_id, yarp::sig::Matrix& transform, double stamp) const
+{
+    double m[12];
+    if (target_frame_id == source_frame_id)
+    {
+        identity(m);
+    }
+    else
+    {
+        double now = yarp::os::Time::now();
+        double target_to_root[12], source_to_root[12], root_to_source[12];
+        std::string target_root, source_root;
+        if (!chain_to_root(target_frame_id, stamp, now, target_to_root, target_root) ||
+            !chain_to_root(source_frame_id, stamp, now, source_to_root, source_root) ||
+            target_root != source_root)
+        {
+            return false;
+        }
+        invert(source_to_root, root_to_source);
+        compose(root_to_source, target_to_root, m);
+    }
+
+    transform.resize(4, 4);
+    for (size_t r = 0; r < 3; r++)
+    {
+        for (size_t c = 0; c < 4; c++) transform(r, c) = m[r * 4 + c];
+    }
+    transform(3, 0) = transform(3, 1) = transform(3, 2) = 0;
+    transform(3, 3) = 1;
+    return true;
+}
+
+bool transform_cache::transform_point(const std::string& target_frame_id, const std::string& source_frame_id, const yarp::sig::Vector& input_point, yarp::sig::Vector& transformed_point, double stamp) const
+{
+    if (input_point.size() != 3)
+    {
+        yError() << "transform_cache: the input point must be a 3D point";
+        return false;
+    }
+    yarp::sig::Matrix m;
+    if (!get_transform(target_frame_id, source_frame_id, m, stamp)) return false;
+    transformed_point.resize(3);
+    for (size_t r = 0; r < 3; r++)
+    {
+        transformed_point[r] = m(r, 0) * input_point[0] + m(r, 1) * input_point[1] + m(r, 2) * input_point[2] + m(r, 3);
+    }
+    return true;
+}
+
+bool transform_cache::can_transform(const std::string& target_frame_id, const std::string& source_frame_id) const
+{
+    yarp::sig::Matrix m;
+    return get_transform(target_frame_id, source_frame_id, m);
+}
+
+void transform_cache::get_all_frame_ids(std::vector<std::string>& ids) const
+{
+    ids.clear();
+    double now = yarp::os::Time::now();
+    size_t n = m_num_edges.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; i++)
+    {
+        const edge& e = *m_edges[i];
+        if (m_timeout > 0 && now - e.last_received.load(std::memory_order_acquire) > m_timeout) continue;
+        if (std::find(ids.begin(), ids.end(), e.parent) == ids.end()) ids.push_back(e.parent);
+        if (std::find(ids.begin(), ids.end(), e.child) == ids.end()) ids.push_back(e.child);
+    }
+}
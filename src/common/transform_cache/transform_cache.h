@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef TRANSFORM_CACHE_H
+#define TRANSFORM_CACHE_H
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/TypedReaderCallback.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/sig/Vector.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+* A local copy of the transforms published by a transformServer.
+* The cache is connected to the streaming port of the server (`<server>/transforms:o`) and stores, for each pair of
+* frames, the last RING_SIZE time-stamped transforms. Chained transforms are composed locally and, if a time is
+* specified, each transform of the chain is interpolated between the two closest samples, so the control loops
+* which query several transforms at each cycle do not wait for the transform client.
+* The semantic of get_transform() and transform_point() is the same of yarp::dev::IFrameTransform.
+* The samples are received by one thread and read without locks: each slot of the ring is protected by a sequence counter.
+*/
+class transform_cache : public yarp::os::TypedReaderCallback<yarp::os::Bottle>
+{
+public:
+    static const size_t MAX_EDGES = 128;
+    static const size_t RING_SIZE = 16;
+
+private:
+    //a transform between two frames: timestamp, translation (x y z), rotation quaternion (w x y z)
+    static const size_t SAMPLE_SIZE = 8;
+
+    struct edge
+    {
+        std::string            parent;
+        std::string            child;
+        std::atomic<uint64_t>  written;                        //number of samples written since the creation of the edge
+        std::atomic<uint32_t>  seq[RING_SIZE];                 //odd while the slot is being written
+        std::atomic<double>    data[RING_SIZE][SAMPLE_SIZE];
+        std::atomic<double>    last_received;                  //local time of the last message containing the edge
+    };
+
+    std::unique_ptr<edge>                     m_edges[MAX_EDGES];
+    std::atomic<size_t>                       m_num_edges;
+    std::mutex                                m_writer_mutex;
+    yarp::os::BufferedPort<yarp::os::Bottle>  m_port;
+    double                                    m_timeout;
+    bool                                      m_full_warned;
+
+public:
+    /**
+    * @param timeout a transform not received for more than timeout seconds is ignored (0 to never ignore a transform)
+    */
+    transform_cache(double timeout = 1.0);
+    ~transform_cache();
+
+    /**
+    * Opens a port and connects it to the streaming port of the transform server.
+    * @param local_port the name of the port opened by the cache
+    * @param server_name the name of the transform server (e.g. /transformServer)
+    */
+    bool   open(const std::string& local_port, const std::string& server_name);
+    void   close();
+
+    /**
+    * Adds the transforms contained in a message of the transform server.
+    * Each element of the message is a list `src dst timestamp x y z qw qx qy qz`.
+    */
+    void   update(const yarp::os::Bottle& transforms);
+    void   onRead(yarp::os::Bottle& transforms) override;
+
+    /**
+    * Gets the transform between two frames, composing the chain of transforms which connects them.
+    * @param stamp the time at which the transform is requested, 0 for the most recent transforms
+    * @return false if the two frames are not connected
+    */
+    bool   get_transform(const std::string& target_frame_id, const std::string& source_frame_id, yarp::sig::Matrix& transform, double stamp = 0) const;
+
+    /**
+    * Transforms a 3D point, see get_transform().
+    */
+    bool   transform_point(const std::string& target_frame_id, const std::string& source_frame_id, const yarp::sig::Vector& input_point, yarp::sig::Vector& transformed_point, double stamp = 0) const;
+
+    bool   can_transform(const std::string& target_frame_id, const std::string& source_frame_id) const;
+    void   get_all_frame_ids(std::vector<std::string>& ids) const;
+
+    /**
+    * @return true if at least one transform has been received
+    */
+    bool   is_receiving() const { return m_num_edges.load(std::memory_order_acquire) > 0; }
+
+private:
+    edge*  find_edge(const std::string& parent, const std::string& child) const;
+    const edge* find_parent_edge(const std::string& child, double now) const;
+    bool   read_sample(const edge& e, double stamp, double* sample) const;
+    bool   chain_to_root(const std::string& frame, double stamp, double now, double* transform, std::string& root) const;
+};
+
+#endif
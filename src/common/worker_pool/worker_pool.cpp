@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#include "worker_pool.h"
+
+worker_pool::worker_pool()
+{
+    m_job = nullptr;
+    m_count = 0;
+    m_next = 0;
+    m_running = 0;
+    m_generation = 0;
+    m_stop = false;
+}
+
+worker_pool::~worker_pool()
+{
+    stop();
+}
+
+bool worker_pool::start(size_t num_threads)
+{
+    if (!m_workers.empty() || num_threads == 0)
+    {
+        return false;
+    }
+    m_stop = false;
+    for (size_t i = 1; i < num_threads; i++)
+    {
+        m_workers.push_back(std::thread(&worker_pool::loop, this));
+    }
+    return true;
+}
+
+void worker_pool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv_start.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void worker_pool::execute(const std::function<void(size_t)>& job, size_t count)
+{
+    //each thread takes the next job to execute
+    for (size_t i = m_next++; i < count; i = m_next++)
+    {
+        job(i);
+    }
+}
+
+void worker_pool::run(size_t count, const std::function<void(size_t)>& job)
+{
+    if (m_workers.empty() || count <= 1)
+    {
+        for (size_t i = 0; i < count; i++) job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_next = 0;
+        m_running = m_workers.size();
+        m_generation++;
+    }
+    m_cv_start.notify_all();
+    execute(job, count);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv_done.wait(lock, [this] { return m_running == 0; });
+    m_job = nullptr;
+}
+
+void worker_pool::loop()
+{
+    size_t generation = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv_start.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+        if (m_stop)
+        {
+            return;
+        }
+        generation = m_generation;
+        const std::function<void(size_t)>* job = m_job;
+        size_t count = m_count;
+
+        lock.unlock();
+        execute(*job, count);
+        lock.lock();
+
+        if (--m_running == 0)
+        {
+            m_cv_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+    All rights reserved.
+
+    This software may be modified and distributed under the terms of the
+    GPL-2+ license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* A set of threads created once and reused to split a computation in parallel jobs, so that a periodic thread does not
+* pay the creation of its helper threads at every cycle.
+* run() executes job(0)...job(count-1) on the calling thread and on the workers, then waits for all of them.
+* Only one run() at a time is allowed.
+*/
+class worker_pool
+{
+    std::vector<std::thread>             m_workers;
+    std::mutex                           m_mutex;
+    std::condition_variable              m_cv_start;
+    std::condition_variable              m_cv_done;
+    const std::function<void(size_t)>*   m_job;
+    size_t                               m_count;
+    std::atomic<size_t>                  m_next;        //the next job to be taken
+    size_t                               m_running;     //the workers which have not finished the current run yet
+    size_t                               m_generation;  //incremented by each run
+    bool                                 m_stop;
+
+public:
+    worker_pool();
+    ~worker_pool();
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+
+    /**
+    * Creates the workers.
+    * @param num_threads the number of threads which execute the jobs, including the caller of run()
+    */
+    bool start(size_t num_threads);
+    void stop();
+
+    /**
+    * @return the number of threads which execute the jobs, including the caller of run()
+    */
+    size_t size() const { return m_workers.size() + 1; }
+
+    /**
+    * Executes job(i) for each i in [0, count) and returns when all the jobs are done.
+    */
+    void run(size_t count, const std::function<void(size_t)>& job);
+
+private:
+    void loop();
+    void execute(const std::function<void(size_t)>& job, size_t count);
+};
+
+#endif
@@ -600,6 +600,13 @@ bool extendedRangefinder2DWrapper::open(yarp::os::Searchable &config)
              return false;
         }
         yInfo() << "tranformClient successfully open";
+
+        //the human frames are read at each cycle from a local copy of the transforms, updated by the stream of the server
+        std::string localTC = config.check("localTC") ? config.find("localTC").asString() : "/extendedRangefinder2D/transformClient";
+        if (!transformCache.open(localTC + "/cache:i", config.find("remoteTC").asString()))
+        {
+            yWarning() << "Unable to open the transform cache, the transforms will be asked to the transform client";
+        }
     }
     else
     {
@@ -682,6 +689,7 @@ void extendedRangefinder2DWrapper::threadRelease()
     rpcPortMod.close();
     streamingPortDebug.interrupt();
     streamingPortDebug.close();
+    transformCache.close();
 }
 
 void extendedRangefinder2DWrapper::run()
@@ -736,7 +744,10 @@ void extendedRangefinder2DWrapper::run()
                 debVect[17] = -2;
                 // READ HUMAN PRESENCE AD ERASE LEGS
                 //scan only for /human#/shoulderCenter reference systems
-                transformClientInt->getAllFrameIds(allFrameIds);
+                if (transformCache.is_receiving())
+                    transformCache.get_all_frame_ids(allFrameIds);
+                else
+                    transformClientInt->getAllFrameIds(allFrameIds);
 
                 for (int i=0; i<allFrameIds.size(); i++)
                 {
@@ -758,7 +769,8 @@ void extendedRangefinder2DWrapper::run()
                         if (verbose)
                             yDebug() << "FRAME: " << *it << ": " ;
 
-                        if (transformClientInt->getTransform(*it, targetFrame, transformMat) == false)
+                        if (transformCache.get_transform(*it, targetFrame, transformMat) == false &&
+                            transformClientInt->getTransform(*it, targetFrame, transformMat) == false)
                         {
                             if (verbose)
                                 yDebug() << "no transform between: " << *it << " and " << targetFrame;
@@ -46,6 +46,7 @@
 #include <yarp/dev/PreciselyTimed.h>
 
 #include <yarp/dev/IFrameTransform.h>
+#include <transform_cache.h>
 
 // ROS state publisher
 #include <yarp/os/Node.h>
@@ -91,6 +92,7 @@ private:
     yarp::dev::PolyDriver laserDriver;
     yarp::dev::PolyDriver transformClientDriver;
     yarp::dev::IFrameTransform *transformClientInt;
+    transform_cache transformCache;
     std::string partName;
     std::string streamingPortName;
     std::string streamingPortNameMod;
@@ -427,6 +427,7 @@ bool Follower::close()
 
     std::lock_guard<std::mutex> lock(m_mutex);
     m_stateMachine_st = StateMachine::none;
+    m_transformData.cache.close();
     m_transformData.driver.close();
 
     m_outputPort2baseCtr.interrupt();
@@ -723,7 +724,8 @@ bool Follower::transformPointInBaseFrame(Target_t &validTarget, yarp::sig::Vecto
     }
     else
     {
-        bool res = m_transformData.transformClient->transformPoint( ReferenceFrameOfTarget2String(validTarget.refFrame) , m_transformData.baseFrameId, validTarget.point3D, pointOutput);
+        bool res = m_transformData.cache.transform_point(ReferenceFrameOfTarget2String(validTarget.refFrame), m_transformData.baseFrameId, validTarget.point3D, pointOutput) ||
+                   m_transformData.transformClient->transformPoint( ReferenceFrameOfTarget2String(validTarget.refFrame) , m_transformData.baseFrameId, validTarget.point3D, pointOutput);
         if(res)
         {
             //        yDebug() << "point (" << pointInput.toString() << ") has been transformed in (" << pointOutput.toString() << ")";
@@ -746,7 +748,8 @@ bool Follower::transformPointInCamFrame(Target_t &validTarget, yarp::sig::Vector
     }
     else
     {
-        bool res = m_transformData.transformClient->transformPoint( ReferenceFrameOfTarget2String(validTarget.refFrame) , "depth_rgb", validTarget.point3D, pointOutput);
+        bool res = m_transformData.cache.transform_point(ReferenceFrameOfTarget2String(validTarget.refFrame), "depth_rgb", validTarget.point3D, pointOutput) ||
+                   m_transformData.transformClient->transformPoint( ReferenceFrameOfTarget2String(validTarget.refFrame) , "depth_rgb", validTarget.point3D, pointOutput);
         if(res)
         {
             //        yDebug() << "point (" << pointInput.toString() << ") has been transformed in (" << pointOutput.toString() << ")";
@@ -763,7 +766,8 @@ bool Follower::transformPointInCamFrame(Target_t &validTarget, yarp::sig::Vector
 
 bool Follower::transformPointInHeadFrame(std::string frame_src, yarp::sig::Vector &pointInput, yarp::sig::Vector &pointOutput)
 {
-    bool res = m_transformData.transformClient->transformPoint(frame_src, "head_link", pointInput, pointOutput);
+    bool res = m_transformData.cache.transform_point(frame_src, "head_link", pointInput, pointOutput) ||
+               m_transformData.transformClient->transformPoint(frame_src, "head_link", pointInput, pointOutput);
     if(res)
     {
         //        yDebug() << "point (" << pointBallInput.toString() << ") has been transformed in (" << pointBallOutput.toString() << ")";
@@ -859,6 +863,13 @@ bool Follower::initTransformClient(void)
     }
 
     //from now I can use m_transformData.transformClient
+
+    //the transforms are read from a local copy, updated by the stream of the server: the client is used only if the
+    //cache has not received the requested frames
+    if(!m_transformData.cache.open("/transformClient-follower/cache:i", "/transformServer"))
+    {
+        yWarning() << "Unable to open the transform cache. The transforms will be asked to the FrameTransformClient.";
+    }
     return true;
 }
 
@@ -1054,7 +1065,8 @@ void Follower::sendtargets4Debug(yarp::sig::Vector &VonCamFrame, yarp::sig::Vect
 
 bool Follower::getMatrix(yarp::sig::Matrix &transform)
 {
-    bool res = m_transformData.transformClient->getTransform (m_transformData.targetFrameId, m_transformData.baseFrameId, transform);
+    bool res = m_transformData.cache.get_transform(m_transformData.targetFrameId, m_transformData.baseFrameId, transform) ||
+               m_transformData.transformClient->getTransform (m_transformData.targetFrameId, m_transformData.baseFrameId, transform);
     if(res)
     {
         //         yDebug() << "FOLLOWER: i get the transform matrix:"; // << transform.toString();
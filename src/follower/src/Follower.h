@@ -28,6 +28,7 @@
 #include "GazeController.h"
 #include "NavigationController.h"
 #include "ObstacleAvoidance.h"
+#include <transform_cache.h>
 
 namespace FollowerTarget
 {
@@ -176,6 +177,7 @@ namespace FollowerTarget
         {
             yarp::dev::IFrameTransform* transformClient;
             yarp::dev::PolyDriver      driver;
+            transform_cache            cache;
 
             const std::string redBallFrameId = "head_leopard_left";
             const std::string personFrameId = "depth_center";
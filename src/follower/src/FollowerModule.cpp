@@ -54,7 +54,15 @@ bool FollowerModule::updateModule()
     double t=yarp::os::Time::now();
     Target_t targetpoint(ReferenceFrameOfTarget_t::mobile_base_body_link);
 
-    targetpoint = m_pointRetriever_ptr->getTarget();
+    if(m_tracker.isRunning())
+    {
+        bool newFrame = m_pointRetriever_ptr->getTargets(m_detectedTargets);
+        targetpoint = m_tracker.update(m_detectedTargets, newFrame, m_pointRetriever_ptr->getRefFrame(), t);
+    }
+    else
+    {
+        targetpoint = m_pointRetriever_ptr->getTarget();
+    }
     m_followerResult= m_follower.followTarget(targetpoint);
     double diff = yarp::os::Time::now()-t;
 
@@ -124,6 +132,7 @@ bool FollowerModule::respond(const Bottle& command, Bottle& reply)
     {
         reply.addString("OK.stopped");
         m_follower.stop();
+        m_tracker.reset();
     }
     else if(command.get(0).asString()=="setGazeTimeout")
     {
@@ -139,7 +148,10 @@ bool FollowerModule::respond(const Bottle& command, Bottle& reply)
         DebugLevel_t level=static_cast<DebugLevel_t>(command.get(1).asInt());
         bool on=command.get(2).asBool();
         if((level == DebugLevel_t::targetRetriever) && (m_pointRetriever_ptr != nullptr))
+        {
             m_pointRetriever_ptr->setDebug(on);
+            m_tracker.setDebug(on);
+        }
         else if(level == DebugLevel_t::DurationStatisticsInfo)
         {
             int count=command.get(3).asInt32();
@@ -244,6 +256,14 @@ bool FollowerModule::configure(yarp::os::ResourceFinder &rf)
         return false;
     }
 
+    // 4) initialize the tracker between the target retriever and the follower
+    m_tracker.setDebug(debugOn);
+    if(!m_tracker.configure(rf))
+    {
+        yError() << "Error in initializing the Target Tracker";
+        return false;
+    }
+
     m_rpcPort.open("/follower/rpc");
     attach(m_rpcPort);
     #ifdef TICK_SERVER
@@ -321,6 +341,7 @@ ReturnStatus FollowerModule::request_status()
 ReturnStatus FollowerModule::request_halt(const std::string& params)
 {
     m_follower.stop();
+    m_tracker.reset();
     return ReturnStatus::BT_HALTED;
 }
 
@@ -22,6 +22,7 @@
 
 #include "TargetRetriever.h"
 #include "Follower.h"
+#include "TargetTracker.h"
 #include "BTMonitor.h"
 #ifdef TICK_SERVER
 #include <tick_server.h>
@@ -113,6 +114,8 @@ private:
 
     FollowerTarget::TargetType_t         m_targetType;
     std::unique_ptr<FollowerTarget::TargetRetriever> m_pointRetriever_ptr;
+    FollowerTarget::Tracker::TargetTracker m_tracker;
+    std::vector<FollowerTarget::Target_t> m_detectedTargets;
 
     yarp::os::Port m_rpcPort;
     #ifdef TICK_SERVER
@@ -39,31 +39,73 @@ Target_t Person3DPointRetriever::getTarget(void)
         return t;
     }
 
-    if (b1->check("tag"))
+    readSkeleton(*b1, t);
+    return t;
+}
+
+bool Person3DPointRetriever::getTargets(std::vector<Target_t> &targets)
+{
+    targets.clear();
+
+    Bottle *b = m_inputPort.read(false); //use false in order to make the reading not blocking
+    if(nullptr == b)
     {
-        Property prop(b1->toString().c_str());
-        m_sk_target.fromProperty(prop);
         if(m_debugOn)
-            yDebug() << "Person3DPPointRetriver: skeleton is updated!";
+            yDebug() <<" Person3DPointRetriever::getTargets: I received nothing!";
+
+        return false;
     }
-    else
+
+    //one skeleton for each person in the scene
+    for(size_t i=0; i<b->size(); i++)
+    {
+        Bottle *sk=b->get(i).asList();
+        if(nullptr == sk)
+            continue;
+        Target_t t(m_refFrame);
+        if(readSkeleton(*sk, t))
+            targets.push_back(t);
+    }
+    return true;
+}
+
+bool Person3DPointRetriever::readSkeleton(const Bottle &skeleton, Target_t &t)
+{
+    if (!skeleton.check("tag"))
     {
         if(m_debugOn)
             yDebug() << "Person3DPPointRetriver: tag not exist!";
-        return t;
+        return false;
     }
 
+    //the joints are read directly from the bottle. The conversion to Property is used only if the format is not
+    //the expected one, since the string round trip is the most expensive part of the processing of each frame.
+    if (!decodeSkeleton(skeleton))
+    {
+        Property prop(skeleton.toString().c_str());
+        m_sk_target.fromProperty(prop);
+        m_target_tag = m_sk_target.getTag();
+        const KeyPoint* kp = m_sk_target[KeyPointTag::shoulder_center];
+        m_target_kp.found = (kp != nullptr);
+        if (kp != nullptr)
+        {
+            m_target_kp.point = kp->getPoint();
+            m_target_kp.pixel = kp->getPixel();
+            m_target_kp.updated = kp->isUpdated();
+        }
+    }
+    if(m_debugOn)
+        yDebug() << "Person3DPPointRetriver: skeleton is updated!";
 
-    const KeyPoint* targetPoint_ptr = m_sk_target[KeyPointTag::shoulder_center];
-    if(targetPoint_ptr != nullptr)//is necessary this check??? maybe yes if I can't see the shoulders
+    if(m_target_kp.found)//is necessary this check??? maybe yes if I can't see the shoulders
     {
-        if(targetPoint_ptr->isUpdated())
+        if(m_target_kp.updated)
         {
-            t.point3D=targetPoint_ptr->getPoint();
-            t.pixel = targetPoint_ptr->getPixel();
+            t.point3D = m_target_kp.point;
+            t.pixel = m_target_kp.pixel;
             t.isValid=true;
             if(m_debugOn)
-               yDebug() << "Person3DPPointRetriver: get the point!! OK!! TAG=" << m_sk_target.getTag();
+               yDebug() << "Person3DPPointRetriver: get the point!! OK!! TAG=" << m_target_tag;
         }
         else
         {
@@ -77,7 +119,60 @@ Target_t Person3DPointRetriever::getTarget(void)
             yDebug() << "Person3DPPointRetriver: shoulder_center point is null!";
     }
 
-    return t;
+    return t.isValid;
+}
+
+bool Person3DPointRetriever::decodeSkeleton(const Bottle &skeleton)
+{
+    //the bottle is the serialization of Skeleton::toProperty(): (tag <name>) ... (skeleton (<keypoint> ...)),
+    //where each keypoint is ((tag <name>) (status updated|stale) (position (x y z)) (pixel (u v)) (child (<keypoint> ...)))
+    const Bottle *keypoints = skeleton.find("skeleton").asList();
+    if (keypoints == nullptr)
+    {
+        return false;
+    }
+    m_target_tag = skeleton.find("tag").asString();
+    m_target_kp.found = false;
+    findKeyPoint(*keypoints, KeyPointTag::shoulder_center);
+    return true;
+}
+
+bool Person3DPointRetriever::findKeyPoint(const Bottle &keypoints, const std::string &kp_tag)
+{
+    for (size_t i = 0; i < keypoints.size(); i++)
+    {
+        const Bottle *kp = keypoints.get(i).asList();
+        if (kp == nullptr)
+        {
+            continue;
+        }
+        if (kp->find("tag").asString() == kp_tag)
+        {
+            const Bottle *position = kp->find("position").asList();
+            if (position == nullptr || position->size() < 3)
+            {
+                return false;
+            }
+            for (size_t j = 0; j < 3; j++)
+            {
+                m_target_kp.point[j] = position->get(j).asDouble();
+            }
+            const Bottle *pixel = kp->find("pixel").asList();
+            for (size_t j = 0; j < 2; j++)
+            {
+                m_target_kp.pixel[j] = (pixel != nullptr && pixel->size() >= 2) ? pixel->get(j).asDouble() : -1.0;
+            }
+            m_target_kp.updated = (kp->find("status").asString() == "updated");
+            m_target_kp.found = true;
+            return true;
+        }
+        const Bottle *children = kp->find("child").asList();
+        if (children != nullptr && findKeyPoint(*children, kp_tag))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool Person3DPointRetriever::init(yarp::os::ResourceFinder &rf)
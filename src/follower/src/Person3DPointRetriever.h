@@ -21,10 +21,28 @@ namespace FollowerTarget
     {
     public:
         Target_t getTarget(void);
+        bool getTargets(std::vector<Target_t> &targets);
         bool init(yarp::os::ResourceFinder &rf);
         bool deinit(void);
     private:
         assistive_rehab::SkeletonStd m_sk_target;
+
+        //the target keypoint, decoded directly from the skeleton bottle.
+        //It is preallocated and reused at each frame.
+        struct TargetKeyPoint_t
+        {
+            yarp::sig::Vector point;
+            yarp::sig::Vector pixel;
+            bool updated;
+            bool found;
+            TargetKeyPoint_t(): point(3, 0.0), pixel(2, -1.0), updated(false), found(false) {;}
+        };
+        TargetKeyPoint_t m_target_kp;
+        std::string m_target_tag;
+
+        bool readSkeleton(const yarp::os::Bottle &skeleton, Target_t &t);
+        bool decodeSkeleton(const yarp::os::Bottle &skeleton);
+        bool findKeyPoint(const yarp::os::Bottle &keypoints, const std::string &kp_tag);
     };
 }
 
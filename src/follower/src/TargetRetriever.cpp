@@ -31,6 +31,17 @@ bool TargetRetriever::initInputPort(std::string inputPortName)
     return true;
 }
 
+bool TargetRetriever::getTargets(std::vector<Target_t> &targets)
+{
+    //the retrievers which can see only one target use getTarget()
+    targets.clear();
+    Target_t t = getTarget();
+    if(!t.isValid)
+        return false;
+    targets.push_back(t);
+    return true;
+}
+
 bool TargetRetriever::deinitInputPort(void)
 {
     m_inputPort.interrupt();
@@ -54,6 +65,10 @@ std::string Target_tBIS::toString(void)
             str+= " pixel NOT valid";
         }
         str+= " ref_frame=" + ReferenceFrameOfTarget2String(refFrame);
+        if(id>=0)
+        {
+            str+= " id=" + std::to_string(id) + " velocity=(" + std::to_string(velocity[0]) + " " + std::to_string(velocity[1]) + " " + std::to_string(velocity[2]) + ")";
+        }
     }
     else
     {
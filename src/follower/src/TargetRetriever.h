@@ -18,6 +18,7 @@
 #include <yarp/os/Bottle.h>
 #include <yarp/sig/Vector.h>
 #include <yarp/os/ResourceFinder.h>
+#include <vector>
 //#include <utility>
 
 namespace FollowerTarget
@@ -46,9 +47,11 @@ namespace FollowerTarget
     public:
             yarp::sig::Vector point3D;
             yarp::sig::Vector pixel;
+            yarp::sig::Vector velocity; //estimated by the tracker, zero otherwise
+            int id; //id of the track assigned by the tracker, -1 otherwise
             bool isValid;
             ReferenceFrameOfTarget_t refFrame;
-            Target_tBIS(ReferenceFrameOfTarget_t frame): point3D(3, 0.0), pixel(2, -1.0), isValid(false), refFrame(frame)
+            Target_tBIS(ReferenceFrameOfTarget_t frame): point3D(3, 0.0), pixel(2, -1.0), velocity(3, 0.0), id(-1), isValid(false), refFrame(frame)
             {;};
 
             ~Target_tBIS()=default;
@@ -84,9 +87,12 @@ namespace FollowerTarget
     public:
         TargetRetriever();
         virtual Target_t getTarget(void)=0;
+        //gets all the targets received in the last frame. Returns false if nothing has been received.
+        virtual bool getTargets(std::vector<Target_t> &targets);
         virtual bool init(yarp::os::ResourceFinder &rf)=0;
         virtual bool deinit(void)=0;
         void setDebug(bool on) {m_debugOn=on;}
+        ReferenceFrameOfTarget_t getRefFrame(void) {return m_refFrame;}
     protected:
 
         bool initInputPort(std::string inputPortName);
@@ -0,0 +1,279 @@
+
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file TargetTracker.cpp
+ * @authors: Valentina Gaggero <valentina.gaggero@iit.it>
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+
+#include "TargetTracker.h"
+
+using namespace FollowerTarget;
+using namespace FollowerTarget::Tracker;
+using namespace yarp::os;
+
+TargetTracker::TargetTracker(): m_gateDistance(GateDistance), m_reacquireDistance(ReacquireDistance), m_maxCoastTime(MaxCoastTime),
+m_processNoise(ProcessNoise), m_measurementNoise(MeasurementNoise), m_confirmHits(ConfirmHits), m_nextId(0), m_followedId(-1),
+m_lastFollowedPoint(3, 0.0), m_hasLastFollowedPoint(false), m_followedLostTime(0), m_lastTime(0), m_isRunning(false), m_debugOn(false)
+{;}
+
+bool TargetTracker::configure(yarp::os::ResourceFinder &rf)
+{
+    bool enabled=false;
+    Bottle config_group = rf.findGroup("TRACKER");
+    if (config_group.isNull())
+    {
+        yWarning() << "Missing TRACKER group! the module will follow the first target sent by the target retriever!";
+    }
+    else
+    {
+        if (config_group.check("enabled"))  {enabled = config_group.find("enabled").asBool(); }
+        if (config_group.check("gateDistance"))  {m_gateDistance = config_group.find("gateDistance").asDouble(); }
+        if (config_group.check("reacquireDistance"))  {m_reacquireDistance = config_group.find("reacquireDistance").asDouble(); }
+        if (config_group.check("maxCoastTime"))  {m_maxCoastTime = config_group.find("maxCoastTime").asDouble(); }
+        if (config_group.check("processNoise"))  {m_processNoise = config_group.find("processNoise").asDouble(); }
+        if (config_group.check("measurementNoise"))  {m_measurementNoise = config_group.find("measurementNoise").asDouble(); }
+        if (config_group.check("confirmHits"))  {m_confirmHits = config_group.find("confirmHits").asInt(); }
+    }
+
+    if(m_gateDistance<=0 || m_maxCoastTime<0 || m_processNoise<=0 || m_measurementNoise<=0)
+    {
+        yError() << "TRACKER: gateDistance, processNoise and measurementNoise must be positive, maxCoastTime must not be negative";
+        return false;
+    }
+
+    m_isRunning = enabled;
+
+    if(m_debugOn)
+        yInfo () << "TRACKER has been configured! enabled=" << m_isRunning;
+    return true;
+}
+
+bool TargetTracker::isRunning()
+{
+    return m_isRunning;
+}
+
+void TargetTracker::reset(void)
+{
+    m_tracks.clear();
+    m_followedId=-1;
+    m_hasLastFollowedPoint=false;
+    m_followedLostTime=0;
+    m_lastTime=0;
+}
+
+Target_t TargetTracker::update(const std::vector<Target_t> &detections, bool newFrame, ReferenceFrameOfTarget_t refFrame, double now)
+{
+    // 1) predict all the tracks up to now
+    double dt = (m_lastTime > 0) ? (now - m_lastTime) : 0.0;
+    m_lastTime = now;
+    for(auto &track : m_tracks)
+    {
+        predict(track, dt);
+        track.updatedNow = false;
+    }
+
+    // 2) associate the detections to the tracks: the closest pairs are assigned first
+    if(newFrame)
+    {
+        m_candidates.clear();
+        for(size_t i=0; i<m_tracks.size(); i++)
+        {
+            for(size_t j=0; j<detections.size(); j++)
+            {
+                if(!detections[j].isValid)
+                    continue;
+                double d = distance(m_tracks[i], detections[j]);
+                if(d < m_gateDistance)
+                    m_candidates.push_back({d, i, j});
+            }
+        }
+        std::sort(m_candidates.begin(), m_candidates.end(), [](const Association_t &a, const Association_t &b){return a.distance < b.distance;});
+
+        m_trackAssigned.assign(m_tracks.size(), false);
+        m_detectionAssigned.assign(detections.size(), false);
+        for(const auto &c : m_candidates)
+        {
+            if(m_trackAssigned[c.track] || m_detectionAssigned[c.detection])
+                continue;
+            correct(m_tracks[c.track], detections[c.detection], now);
+            m_trackAssigned[c.track] = true;
+            m_detectionAssigned[c.detection] = true;
+        }
+
+        // 3) a new track for each detection not associated
+        for(size_t j=0; j<detections.size(); j++)
+        {
+            if(!detections[j].isValid || m_detectionAssigned[j])
+                continue;
+            Track_t track;
+            initTrack(track, detections[j], now);
+            m_tracks.push_back(track);
+        }
+    }
+
+    // 4) remove the tracks not detected for too long. The loss of the followed track starts the time in which
+    //    a track close to its last point is preferred
+    for(const auto &track : m_tracks)
+    {
+        if(track.id == m_followedId && (now - track.lastUpdateTime) > m_maxCoastTime)
+        {
+            if(m_debugOn)
+                yDebug() << "TargetTracker: track" << m_followedId << "lost";
+            m_followedId = -1;
+            m_followedLostTime = now;
+        }
+    }
+    m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(),
+                                  [this, now](const Track_t &t){return (now - t.lastUpdateTime) > m_maxCoastTime;}),
+                   m_tracks.end());
+
+    // 5) give the followed track to the follower
+    Target_t t(refFrame);
+    int idx = selectFollowedTrack();
+    if(idx < 0)
+        return t;
+
+    const Track_t &track = m_tracks[idx];
+    if(track.id != m_followedId)
+    {
+        if(m_debugOn)
+            yDebug() << "TargetTracker: following track" << track.id << "(previous=" << m_followedId << ")";
+        m_followedId = track.id;
+    }
+    for(size_t k=0; k<3; k++)
+    {
+        t.point3D[k] = track.axis[k].x;
+        t.velocity[k] = track.axis[k].v;
+        m_lastFollowedPoint[k] = track.axis[k].x;
+    }
+    m_hasLastFollowedPoint = true;
+    //the pixel is not predicted: when the track is not detected in this frame the gaze must not look at an old pixel
+    if(track.updatedNow)
+        t.pixel = track.pixel;
+    t.id = track.id;
+    t.isValid = true;
+    return t;
+}
+
+int TargetTracker::selectFollowedTrack(void)
+{
+    for(size_t i=0; i<m_tracks.size(); i++)
+    {
+        if(m_tracks[i].id == m_followedId)
+            return static_cast<int>(i);
+    }
+
+    //the followed track does not exist anymore (or it has never been chosen): take the confirmed track closest to the last followed point.
+    //If none is close enough for longer than maxCoastTime, the target has gone and the closest one to the camera is taken.
+    bool nearLastPoint = m_hasLastFollowedPoint && ((m_lastTime - m_followedLostTime) <= m_maxCoastTime);
+    int best=-1;
+    double bestDistance=std::numeric_limits<double>::max();
+    for(size_t i=0; i<m_tracks.size(); i++)
+    {
+        const Track_t &track = m_tracks[i];
+        if(track.hits < m_confirmHits)
+            continue;
+        double d=0;
+        for(size_t k=0; k<3; k++)
+        {
+            double e = track.axis[k].x - (nearLastPoint ? m_lastFollowedPoint[k] : 0.0);
+            d += e*e;
+        }
+        d = sqrt(d);
+        if(nearLastPoint && d > m_reacquireDistance)
+            continue;
+        if(d < bestDistance)
+        {
+            bestDistance = d;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+void TargetTracker::predict(Track_t &track, double dt)
+{
+    if(dt <= 0)
+        return;
+    //white noise acceleration model
+    double q = m_processNoise*m_processNoise;
+    double dt2 = dt*dt;
+    for(auto &a : track.axis)
+    {
+        a.x += a.v*dt;
+        double p00 = a.P[0][0] + dt*(a.P[0][1] + a.P[1][0]) + dt2*a.P[1][1] + q*dt2*dt2/4.0;
+        double p01 = a.P[0][1] + dt*a.P[1][1] + q*dt2*dt/2.0;
+        double p10 = a.P[1][0] + dt*a.P[1][1] + q*dt2*dt/2.0;
+        double p11 = a.P[1][1] + q*dt2;
+        a.P[0][0] = p00; a.P[0][1] = p01;
+        a.P[1][0] = p10; a.P[1][1] = p11;
+    }
+}
+
+void TargetTracker::correct(Track_t &track, const Target_t &detection, double now)
+{
+    double r = m_measurementNoise*m_measurementNoise;
+    for(size_t k=0; k<3; k++)
+    {
+        KalmanAxis_t &a = track.axis[k];
+        double s = a.P[0][0] + r;
+        double k0 = a.P[0][0]/s;
+        double k1 = a.P[1][0]/s;
+        double innovation = detection.point3D[k] - a.x;
+        a.x += k0*innovation;
+        a.v += k1*innovation;
+        double p00 = (1-k0)*a.P[0][0];
+        double p01 = (1-k0)*a.P[0][1];
+        double p10 = a.P[1][0] - k1*a.P[0][0];
+        double p11 = a.P[1][1] - k1*a.P[0][1];
+        a.P[0][0] = p00; a.P[0][1] = p01;
+        a.P[1][0] = p10; a.P[1][1] = p11;
+    }
+    track.pixel = detection.pixel;
+    track.lastUpdateTime = now;
+    track.hits++;
+    track.updatedNow = true;
+}
+
+void TargetTracker::initTrack(Track_t &track, const Target_t &detection, double now)
+{
+    track.id = m_nextId++;
+    for(size_t k=0; k<3; k++)
+    {
+        KalmanAxis_t &a = track.axis[k];
+        a.x = detection.point3D[k];
+        a.v = 0.0;
+        a.P[0][0] = m_measurementNoise*m_measurementNoise;
+        a.P[0][1] = a.P[1][0] = 0.0;
+        a.P[1][1] = 1.0; //the velocity is unknown: 1 m/s standard deviation
+    }
+    track.pixel = detection.pixel;
+    track.lastUpdateTime = now;
+    track.hits = 1;
+    track.updatedNow = true;
+}
+
+double TargetTracker::distance(const Track_t &track, const Target_t &detection)
+{
+    double d=0;
+    for(size_t k=0; k<3; k++)
+    {
+        double e = track.axis[k].x - detection.point3D[k];
+        d += e*e;
+    }
+    return sqrt(d);
+}
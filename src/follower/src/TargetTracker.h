@@ -0,0 +1,106 @@
+
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file TargetTracker.h
+ * @authors: Valentina Gaggero <valentina.gaggero@iit.it>
+ */
+
+#ifndef TARGETTRACKER_H
+#define TARGETTRACKER_H
+
+#include <vector>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/sig/Vector.h>
+
+#include "TargetRetriever.h"
+
+namespace FollowerTarget
+{
+    namespace Tracker
+    {
+        double const GateDistance = 0.8;         //meters
+        double const ReacquireDistance = 1.0;    //meters
+        double const MaxCoastTime = 0.5;         //seconds
+        double const ProcessNoise = 1.0;         //m/s^2
+        double const MeasurementNoise = 0.05;    //meters
+        int const ConfirmHits = 2;
+
+        //This class keeps a track for each target detected by the target retriever, in the reference frame of the retriever.
+        //Each track is a constant velocity Kalman filter, independent on the three axes. At each frame the detections are associated
+        //to the tracks (gated nearest neighbour), then the follower receives the track with the same id as the previous one,
+        //even if in the current frame it has not been detected or it is not the first one sent by the retriever.
+        //NOTE: the reference frame of the retriever moves with the head of the robot, so the velocity is relative to the camera.
+        class TargetTracker
+        {
+        public:
+            TargetTracker();
+            //return false in case of error, else true
+            bool configure(yarp::os::ResourceFinder &rf);
+            //return true if it has been enabled
+            bool isRunning();
+            //newFrame is false if the retriever did not receive anything, so that the tracks are only predicted
+            Target_t update(const std::vector<Target_t> &detections, bool newFrame, ReferenceFrameOfTarget_t refFrame, double now);
+            void reset(void);
+            void setDebug(bool on) {m_debugOn=on;}
+        private:
+            struct KalmanAxis_t
+            {
+                double x;
+                double v;
+                double P[2][2];
+            };
+
+            struct Track_t
+            {
+                int id;
+                KalmanAxis_t axis[3];
+                yarp::sig::Vector pixel;
+                double lastUpdateTime;
+                int hits;
+                bool updatedNow;
+            };
+
+            double m_gateDistance;
+            double m_reacquireDistance;
+            double m_maxCoastTime;
+            double m_processNoise;
+            double m_measurementNoise;
+            int m_confirmHits;
+
+            std::vector<Track_t> m_tracks;
+            int m_nextId;
+            int m_followedId;
+            yarp::sig::Vector m_lastFollowedPoint;
+            bool m_hasLastFollowedPoint;
+            double m_followedLostTime;
+            double m_lastTime;
+            bool m_isRunning;
+            bool m_debugOn;
+
+            struct Association_t
+            {
+                double distance;
+                size_t track;
+                size_t detection;
+            };
+            std::vector<Association_t> m_candidates;
+            std::vector<bool> m_trackAssigned;
+            std::vector<bool> m_detectionAssigned;
+
+            void predict(Track_t &track, double dt);
+            void correct(Track_t &track, const Target_t &detection, double now);
+            void initTrack(Track_t &track, const Target_t &detection, double now);
+            double distance(const Track_t &track, const Target_t &detection);
+            int selectFollowedTrack(void);
+        };
+    }
+}
+#endif
+
@@ -51,6 +51,10 @@ void gazeboLocalizerRPCHandler::setInterface(gazeboLocalizer* iface)
 bool gazeboLocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
 {
     reply.clear();
+    if (interface->thread && interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
     reply.addVocab(Vocab::encode("many"));
     reply.addString("Not yet Implemented");
     return true;
@@ -141,6 +145,10 @@ void gazeboLocalizerThread::run()
     m_localization_data.theta = m_gazebo_data.theta*RAD2DEG + m_map_to_gazebo_transform.theta;
     if      (m_localization_data.theta >= +360) m_localization_data.theta -= 360;
     else if (m_localization_data.theta <= -360) m_localization_data.theta += 360;
+    if (ret)
+    {
+        m_pose_buffer.add_pose(current_time, m_localization_data);
+    }
 }
 
 bool gazeboLocalizerThread::initializeLocalization(const Map2DLocation& loc)
@@ -153,6 +161,7 @@ bool gazeboLocalizerThread::initializeLocalization(const Map2DLocation& loc)
     m_map_to_gazebo_transform.x = loc.x;
     m_map_to_gazebo_transform.y = loc.y;
     m_map_to_gazebo_transform.theta = loc.theta;
+    m_pose_buffer.clear();
 
     return true;
 }
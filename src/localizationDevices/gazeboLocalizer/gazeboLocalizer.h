@@ -31,6 +31,7 @@
 #include <yarp/os/RpcClient.h>
 #include <math.h>
 #include <mutex>
+#include <pose_buffer.h>
 #include <yarp/dev/IMap2D.h>
 
 #ifndef GAZEBO_LOCALIZER_H
@@ -133,6 +134,7 @@ protected:
     yarp::dev::Nav2D::Map2DLocation     m_localization_data;
     yarp::dev::Nav2D::Map2DLocation     m_gazebo_data;
     std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
     yarp::os::Searchable&        m_cfg;
     std::string                  m_local_name_prefix;
     std::string                  m_local_gazebo_port_name;
@@ -153,6 +155,7 @@ public:
 public:
     bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc);
     bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
 };
 
 #endif
@@ -0,0 +1,1005 @@
+/*
+ * Copyright (C)2019  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Port.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/INavigation2D.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_set>
+#include <mutex>
+#include "mclLocalizer.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RAD2DEG 180/M_PI
+#define DEG2RAD M_PI/180
+
+namespace
+{
+    //returns the angle a-b, in the range [-180, 180)
+    double angle_diff(double a, double b)
+    {
+        double d = fmod(a - b + 180.0, 360.0);
+        if (d < 0) d += 360.0;
+        return d - 180.0;
+    }
+
+    //applies to pose the motion measured by the odometry between odom_from and odom_to
+    void apply_odometry(const Map2DLocation& odom_from, const Map2DLocation& odom_to, Map2DLocation& pose)
+    {
+        double dx = odom_to.x - odom_from.x;
+        double dy = odom_to.y - odom_from.y;
+        double co = cos(odom_from.theta*DEG2RAD);
+        double so = sin(odom_from.theta*DEG2RAD);
+        double rx =  dx * co + dy * so;
+        double ry = -dx * so + dy * co;
+        double cl = cos(pose.theta*DEG2RAD);
+        double sl = sin(pose.theta*DEG2RAD);
+        pose.x += rx * cl - ry * sl;
+        pose.y += rx * sl + ry * cl;
+        pose.theta = angle_diff(pose.theta + angle_diff(odom_to.theta, odom_from.theta), 0);
+    }
+}
+
+void mclLocalizerRPCHandler::setInterface(mclLocalizer* iface)
+{
+    this->interface = iface;
+}
+
+//This function parses the user commands received through the RPC port
+bool mclLocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
+{
+    reply.clear();
+    if (interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
+    if (command.get(0).asString() == "global_localization")
+    {
+        if (interface->thread->globalLocalization()) reply.addVocab(Vocab::encode("ok"));
+        else                                         reply.addVocab(Vocab::encode("fail"));
+    }
+    else
+    {
+        reply.addVocab(Vocab::encode("many"));
+        reply.addString("Available commands:");
+        reply.addString("global_localization: spreads the particles over the free space of the current map");
+        reply.addString("get_pose_at <timestamp>: returns the pose of the robot at the given time");
+    }
+    return true;
+}
+
+bool   mclLocalizer::getLocalizationStatus(yarp::dev::LocalizationStatusEnum& status)
+{
+    if (thread->isLocalized())
+    {
+        status = yarp::dev::LocalizationStatusEnum::localization_status_localized_ok;
+    }
+    else
+    {
+        status = yarp::dev::LocalizationStatusEnum::localization_status_not_yet_localized;
+    }
+    return true;
+}
+
+bool   mclLocalizer::getEstimatedPoses(std::vector<Map2DLocation>& poses)
+{
+    return thread->getParticles(poses);
+}
+
+bool   mclLocalizer::getCurrentPosition(Map2DLocation& loc)
+{
+    return thread->getCurrentLoc(loc);
+}
+
+bool   mclLocalizer::setInitialPose(const Map2DLocation& loc)
+{
+    return thread->initializeLocalization(loc);
+}
+
+//////////////////////////
+
+mclLocalizerThread::mclLocalizerThread(double _period, yarp::os::Searchable& _cfg) : PeriodicThread(_period), m_cfg(_cfg), m_rand_gen(std::random_device()())
+{
+    m_last_odometry_data_received = -1;
+    m_last_statistics_printed = -1;
+    m_enabled = true;
+    m_init_counter = 0;
+
+    m_estimate.map_id = m_odom_at_update.map_id = m_current_odom.map_id = "unknown";
+    m_estimate.x      = m_odom_at_update.x      = m_current_odom.x      = 0;
+    m_estimate.y      = m_odom_at_update.y      = m_current_odom.y      = 0;
+    m_estimate.theta  = m_odom_at_update.theta  = m_current_odom.theta  = 0;
+    m_estimate_cov.resize(3, 3);
+    m_estimate_cov.zero();
+    m_odom_received = false;
+    m_localized = false;
+    m_force_update = false;
+    m_w_slow = 0;
+    m_w_fast = 0;
+
+    m_odom_model_omni = false;
+    m_alpha1 = 0.2;
+    m_alpha2 = 0.2;
+    m_alpha3 = 0.2;
+    m_alpha4 = 0.2;
+    m_alpha5 = 0.2;
+
+    m_iMap = 0;
+    m_iLaser = 0;
+    m_iLaserTimed = 0;
+    m_last_scan_stamp = -1;
+    m_laser_pos_x = 0;
+    m_laser_pos_y = 0;
+    m_laser_pos_t = 0;
+    m_max_range = 10.0;
+    m_max_beams = 60;
+    m_z_hit = 0.95;
+    m_z_rand = 0.05;
+    m_likelihood_sigma = 0.2;
+    m_likelihood_max_dist = 2.0;
+
+    m_min_particles = 100;
+    m_max_particles = 5000;
+    m_kld_err = 0.01;
+    m_kld_z = 0.99;
+    m_kld_bin_xy = 0.5;
+    m_kld_bin_theta = 10.0;
+    m_update_min_d = 0.1;
+    m_update_min_a = 10.0;
+    m_alpha_slow = 0.001;
+    m_alpha_fast = 0.1;
+    m_localized_max_std = 0.3;
+    m_initial_cov_xx = 0.25;
+    m_initial_cov_yy = 0.25;
+    m_initial_cov_aa = 100.0;
+    m_num_threads = 4;
+
+    m_stat_updates = 0;
+    m_stat_update_time = 0;
+}
+
+void mclLocalizerThread::run()
+{
+    double current_time = yarp::os::Time::now();
+
+    //print some stats every 10 seconds
+    if (current_time - m_last_statistics_printed > 10.0)
+    {
+        if (m_stat_updates > 0)
+        {
+            lock_guard<std::mutex> lock(m_mutex);
+            yInfo() << "mclLocalizer: performed" << m_stat_updates << "updates, average time:"
+                    << m_stat_update_time / m_stat_updates * 1000.0 << "ms, particles:" << m_particles.size();
+        }
+        m_stat_updates = 0;
+        m_stat_update_time = 0;
+        m_last_statistics_printed = yarp::os::Time::now();
+    }
+
+    updateOdometry();
+
+    if (m_enabled)
+    {
+        updateFilter();
+    }
+
+    if (current_time - m_last_odometry_data_received > 0.1)
+    {
+        yWarning() << "No odometry data received for more than 0.1s!";
+    }
+}
+
+void mclLocalizerThread::updateOdometry()
+{
+    yarp::dev::OdometryData *odom = m_port_odometry_input.read(false);
+    if (odom == nullptr) return;
+
+    lock_guard<std::mutex> lock(m_mutex);
+    m_last_odometry_data_received = yarp::os::Time::now();
+    m_current_odom.x = odom->odom_x;
+    m_current_odom.y = odom->odom_y;
+    m_current_odom.theta = odom->odom_theta;
+    if (m_odom_received == false)
+    {
+        m_odom_at_update = m_current_odom;
+        m_odom_received = true;
+    }
+
+    //the pose is stamped with the time of the odometry data, if available
+    yarp::os::Stamp stamp;
+    bool stamped = m_port_odometry_input.getEnvelope(stamp) && stamp.isValid();
+    Map2DLocation loc = m_estimate;
+    apply_odometry(m_odom_at_update, m_current_odom, loc);
+    m_pose_buffer.add_pose(stamped ? stamp.getTime() : m_last_odometry_data_received, loc);
+}
+
+bool mclLocalizerThread::readScan()
+{
+    //a scan is processed only once. If the timestamp is not available, the scan is processed every 0.1s.
+    double stamp = 0;
+    if (m_iLaserTimed) stamp = m_iLaserTimed->getLastInputStamp().getTime();
+    else               stamp = floor(yarp::os::Time::now() * 10.0) / 10.0;
+    if (stamp == m_last_scan_stamp) return false;
+
+    std::vector<LaserMeasurementData> scan;
+    if (m_iLaser->getLaserMeasurement(scan) == false) return false;
+    m_last_scan_stamp = stamp;
+
+    //the scan is decimated and transformed in the robot reference frame
+    size_t decimation = (scan.size() + m_max_beams - 1) / m_max_beams;
+    if (decimation == 0) decimation = 1;
+    double cl = cos(m_laser_pos_t*DEG2RAD);
+    double sl = sin(m_laser_pos_t*DEG2RAD);
+    m_scan_x.clear();
+    m_scan_y.clear();
+    for (size_t i = 0; i < scan.size(); i += decimation)
+    {
+        double las_x = 0;
+        double las_y = 0;
+        scan[i].get_cartesian(las_x, las_y);
+        if (!std::isfinite(las_x) || !std::isfinite(las_y)) continue;
+        if (las_x*las_x + las_y*las_y > m_max_range*m_max_range) continue;
+        m_scan_x.push_back(las_x * cl - las_y * sl + m_laser_pos_x);
+        m_scan_y.push_back(las_x * sl + las_y * cl + m_laser_pos_y);
+    }
+    return (m_scan_x.size() > 0);
+}
+
+void mclLocalizerThread::moveParticles(std::vector<mclParticle>& particles, const Map2DLocation& odom_from, const Map2DLocation& odom_to)
+{
+    //sample motion model based on odometry (Thrun, Burgard, Fox - Probabilistic Robotics)
+    double dx = odom_to.x - odom_from.x;
+    double dy = odom_to.y - odom_from.y;
+    double delta_trans = sqrt(dx*dx + dy*dy);
+    double delta_rot = angle_diff(odom_to.theta, odom_from.theta) * DEG2RAD;
+    std::normal_distribution<double> gauss(0.0, 1.0);
+
+    if (m_odom_model_omni)
+    {
+        double delta_bearing = (delta_trans < 0.01) ? 0 : angle_diff(atan2(dy, dx)*RAD2DEG, odom_from.theta) * DEG2RAD;
+        //the same meaning of alpha1..alpha4 as in the differential model, the strafe noise due to rotation uses alpha4
+        double trans_std  = sqrt(m_alpha3 * delta_trans*delta_trans + m_alpha4 * delta_rot*delta_rot);
+        double rot_std    = sqrt(m_alpha1 * delta_rot*delta_rot + m_alpha2 * delta_trans*delta_trans);
+        double strafe_std = sqrt(m_alpha4 * delta_rot*delta_rot + m_alpha5 * delta_trans*delta_trans);
+        for (size_t i = 0; i < particles.size(); i++)
+        {
+            mclParticle& p = particles[i];
+            double bearing = delta_bearing + p.theta * DEG2RAD;
+            double trans  = delta_trans + trans_std * gauss(m_rand_gen);
+            double strafe = strafe_std * gauss(m_rand_gen);
+            double rot    = delta_rot + rot_std * gauss(m_rand_gen);
+            p.x += trans * cos(bearing) + strafe * sin(bearing);
+            p.y += trans * sin(bearing) - strafe * cos(bearing);
+            p.theta = angle_diff(p.theta + rot * RAD2DEG, 0);
+        }
+    }
+    else
+    {
+        //rotations are computed modulo 180deg to deal with a robot moving backward
+        double delta_rot1 = (delta_trans < 0.01) ? 0 : angle_diff(atan2(dy, dx)*RAD2DEG, odom_from.theta) * DEG2RAD;
+        double delta_rot2 = delta_rot - delta_rot1;
+        double delta_rot1_noise = std::min(fabs(delta_rot1), fabs(M_PI - fabs(delta_rot1)));
+        double delta_rot2_noise = std::min(fabs(delta_rot2), fabs(M_PI - fabs(delta_rot2)));
+        double rot1_std  = sqrt(m_alpha1 * delta_rot1_noise*delta_rot1_noise + m_alpha2 * delta_trans*delta_trans);
+        double trans_std = sqrt(m_alpha3 * delta_trans*delta_trans + m_alpha4 * (delta_rot1_noise*delta_rot1_noise + delta_rot2_noise*delta_rot2_noise));
+        double rot2_std  = sqrt(m_alpha1 * delta_rot2_noise*delta_rot2_noise + m_alpha2 * delta_trans*delta_trans);
+        for (size_t i = 0; i < particles.size(); i++)
+        {
+            mclParticle& p = particles[i];
+            double rot1  = delta_rot1 + rot1_std * gauss(m_rand_gen);
+            double trans = delta_trans + trans_std * gauss(m_rand_gen);
+            double rot2  = delta_rot2 + rot2_std * gauss(m_rand_gen);
+            double t = p.theta * DEG2RAD + rot1;
+            p.x += trans * cos(t);
+            p.y += trans * sin(t);
+            p.theta = angle_diff((t + rot2) * RAD2DEG, 0);
+        }
+    }
+}
+
+void mclLocalizerThread::weightParticles(const likelihood_field& field, mclParticle* particles, size_t count, double& weight_sum) const
+{
+    //likelihood field model: each beam contributes with the cube of its probability (as done by AMCL),
+    //which is more robust than the product of the probabilities to unmodeled obstacles
+    const size_t n_beams = m_scan_x.size();
+    weight_sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        mclParticle& p = particles[i];
+        double c = cos(p.theta * DEG2RAD);
+        double s = sin(p.theta * DEG2RAD);
+        double w = 1.0;
+        for (size_t j = 0; j < n_beams; j++)
+        {
+            double wx = p.x + m_scan_x[j] * c - m_scan_y[j] * s;
+            double wy = p.y + m_scan_x[j] * s + m_scan_y[j] * c;
+            double pz = m_z_hit * field.at_world(wx, wy) + m_z_rand;
+            w += pz * pz * pz;
+        }
+        p.weight *= w;
+        weight_sum += p.weight;
+    }
+}
+
+size_t mclLocalizerThread::kldLimit(size_t k) const
+{
+    //number of particles required to approximate a distribution which occupies k bins (Fox, KLD-sampling)
+    if (k <= 1) return 0;
+    double a = 1;
+    double b = 2 / (9 * ((double)k - 1));
+    double c = sqrt(2 / (9 * ((double)k - 1))) * m_kld_z;
+    double x = a - b + c;
+    return (size_t)(ceil((k - 1) / (2 * m_kld_err) * x * x * x));
+}
+
+mclParticle mclLocalizerThread::randomParticle(const mclMapModel& model, std::mt19937& gen) const
+{
+    std::uniform_int_distribution<size_t> cell_dist(0, model.free_cells.size() - 1);
+    std::uniform_real_distribution<double> theta_dist(-180.0, 180.0);
+    const std::pair<double, double>& cell = model.free_cells[cell_dist(gen)];
+    mclParticle p;
+    p.x = cell.first;
+    p.y = cell.second;
+    p.theta = theta_dist(gen);
+    p.weight = 1.0;
+    return p;
+}
+
+void mclLocalizerThread::resampleParticles(const mclMapModel& model, const std::vector<mclParticle>& particles, double w_random, std::vector<mclParticle>& new_particles)
+{
+    std::vector<double> cumulative(particles.size());
+    double total = 0;
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        total += particles[i].weight;
+        cumulative[i] = total;
+    }
+
+    //KLD sampling: particles are drawn until their number is enough to represent the histogram of the occupied bins
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::unordered_set<long long> bins;
+    new_particles.clear();
+    new_particles.reserve(m_max_particles);
+    while (new_particles.size() < m_max_particles)
+    {
+        mclParticle p;
+        if (model.free_cells.size() > 0 && uniform(m_rand_gen) < w_random)
+        {
+            p = randomParticle(model, m_rand_gen);
+        }
+        else
+        {
+            double r = uniform(m_rand_gen) * total;
+            size_t idx = std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin();
+            if (idx >= particles.size()) idx = particles.size() - 1;
+            p = particles[idx];
+        }
+        p.weight = 1.0;
+        new_particles.push_back(p);
+
+        long long bx = (long long)(floor(p.x / m_kld_bin_xy)) & 0x1FFFFF;
+        long long by = (long long)(floor(p.y / m_kld_bin_xy)) & 0x1FFFFF;
+        long long bt = (long long)(floor(p.theta / m_kld_bin_theta)) & 0x1FFFFF;
+        bins.insert((bx << 42) | (by << 21) | bt);
+
+        if (new_particles.size() >= m_min_particles && new_particles.size() >= kldLimit(bins.size())) break;
+    }
+
+    for (size_t i = 0; i < new_particles.size(); i++)
+    {
+        new_particles[i].weight = 1.0 / new_particles.size();
+    }
+}
+
+void mclLocalizerThread::computeEstimate(const std::vector<mclParticle>& particles, Map2DLocation& loc, yarp::sig::Matrix& cov) const
+{
+    double sw = 0, sx = 0, sy = 0, sc = 0, ss = 0;
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        const mclParticle& p = particles[i];
+        sw += p.weight;
+        sx += p.weight * p.x;
+        sy += p.weight * p.y;
+        sc += p.weight * cos(p.theta * DEG2RAD);
+        ss += p.weight * sin(p.theta * DEG2RAD);
+    }
+    if (sw <= 0) return;
+    loc.x = sx / sw;
+    loc.y = sy / sw;
+    loc.theta = atan2(ss, sc) * RAD2DEG;
+
+    cov.resize(3, 3);
+    cov.zero();
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        const mclParticle& p = particles[i];
+        double w = p.weight / sw;
+        double ex = p.x - loc.x;
+        double ey = p.y - loc.y;
+        double et = angle_diff(p.theta, loc.theta);
+        cov(0, 0) += w * ex * ex;
+        cov(0, 1) += w * ex * ey;
+        cov(1, 1) += w * ey * ey;
+        cov(2, 2) += w * et * et;
+    }
+    cov(1, 0) = cov(0, 1);
+}
+
+void mclLocalizerThread::updateFilter()
+{
+    std::vector<mclParticle> particles;
+    std::shared_ptr<const mclMapModel> model;
+    Map2DLocation odom_from;
+    Map2DLocation odom_to;
+    size_t init_counter = 0;
+    bool force_update = false;
+    {
+        lock_guard<std::mutex> lock(m_mutex);
+        if (!m_odom_received || !m_map_model || m_particles.empty()) return;
+        odom_from = m_odom_at_update;
+        odom_to = m_current_odom;
+        force_update = m_force_update;
+        model = m_map_model;
+        init_counter = m_init_counter;
+    }
+
+    //the filter is updated only when the robot moved enough, otherwise the particles would collapse on a wrong estimate
+    double dx = odom_to.x - odom_from.x;
+    double dy = odom_to.y - odom_from.y;
+    double da = fabs(angle_diff(odom_to.theta, odom_from.theta));
+    if (!force_update && sqrt(dx*dx + dy*dy) < m_update_min_d && da < m_update_min_a) return;
+    if (readScan() == false) return;
+
+    double t0 = yarp::os::Time::now();
+    {
+        lock_guard<std::mutex> lock(m_mutex);
+        particles = m_particles;
+    }
+
+    moveParticles(particles, odom_from, odom_to);
+
+    //the particles are split among the worker threads
+    const size_t n_threads = std::max((size_t)1, std::min((size_t)m_num_threads, particles.size()));
+    std::vector<double> weight_sums(n_threads, 0.0);
+    m_workers.run(n_threads, [&](size_t w)
+    {
+        size_t begin = particles.size() * w / n_threads;
+        size_t end = particles.size() * (w + 1) / n_threads;
+        weightParticles(model->field, particles.data() + begin, end - begin, weight_sums[w]);
+    });
+    double total_weight = 0;
+    for (size_t w = 0; w < n_threads; w++)
+    {
+        total_weight += weight_sums[w];
+    }
+    if (total_weight <= 0) return;
+
+    //the short and long term averages of the weights detect the kidnapping of the robot
+    //(the weights are normalized before each update, so total_weight is the average likelihood of the particles)
+    double w_avg = total_weight;
+    double w_slow = (m_w_slow == 0) ? w_avg : m_w_slow + m_alpha_slow * (w_avg - m_w_slow);
+    double w_fast = (m_w_fast == 0) ? w_avg : m_w_fast + m_alpha_fast * (w_avg - m_w_fast);
+    double w_random = 0;
+    if (m_alpha_slow > 0 && m_alpha_fast > 0)
+    {
+        w_random = std::max(0.0, 1.0 - w_fast / w_slow);
+    }
+
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        particles[i].weight /= total_weight;
+    }
+    Map2DLocation estimate;
+    yarp::sig::Matrix estimate_cov;
+    computeEstimate(particles, estimate, estimate_cov);
+
+    std::vector<mclParticle> new_particles;
+    resampleParticles(*model, particles, w_random, new_particles);
+
+    m_stat_updates++;
+    m_stat_update_time += yarp::os::Time::now() - t0;
+
+    lock_guard<std::mutex> lock(m_mutex);
+    if (init_counter != m_init_counter) return;
+    m_particles.swap(new_particles);
+    estimate.map_id = m_estimate.map_id;
+    m_estimate = estimate;
+    m_estimate_cov = estimate_cov;
+    m_odom_at_update = odom_to;
+    m_force_update = false;
+    m_w_slow = w_slow;
+    m_w_fast = w_fast;
+    m_localized = (sqrt(estimate_cov(0, 0) + estimate_cov(1, 1)) < m_localized_max_std);
+}
+
+std::shared_ptr<const mclMapModel> mclLocalizerThread::loadMap(const std::string& map_id)
+{
+    lock_guard<std::mutex> lock(m_map_cache_mutex);
+    std::map<std::string, std::shared_ptr<const mclMapModel>>::iterator it = m_map_cache.find(map_id);
+    if (it != m_map_cache.end())
+    {
+        return it->second;
+    }
+
+    MapGrid2D map;
+    if (m_iMap == 0 || m_iMap->get_map(map_id, map) == false)
+    {
+        yError() << "Map " << map_id << " not found.";
+        return nullptr;
+    }
+
+    double t0 = yarp::os::Time::now();
+    std::shared_ptr<mclMapModel> model(new mclMapModel);
+    if (model->field.build(map, m_likelihood_sigma, m_likelihood_max_dist) == false)
+    {
+        return nullptr;
+    }
+    for (size_t y = 0; y < map.height(); y++)
+        for (size_t x = 0; x < map.width(); x++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            if (flag == MapGrid2D::MAP_CELL_FREE)
+            {
+                XYWorld world = map.cell2World(XYCell(x, y));
+                model->free_cells.push_back(std::make_pair(world.x, world.y));
+            }
+        }
+    yInfo() << "Likelihood field of map" << map_id << "computed in" << yarp::os::Time::now() - t0 << "s";
+
+    m_map_cache[map_id] = model;
+    return model;
+}
+
+bool mclLocalizerThread::initializeLocalization(const Map2DLocation& loc)
+{
+    yarp::sig::Matrix cov(3, 3);
+    cov.zero();
+    cov(0, 0) = m_initial_cov_xx;
+    cov(1, 1) = m_initial_cov_yy;
+    cov(2, 2) = m_initial_cov_aa;
+    return initializeLocalization(loc, cov);
+}
+
+bool mclLocalizerThread::initializeLocalization(const Map2DLocation& loc, const yarp::sig::Matrix& cov)
+{
+    yInfo() << "mclLocalizer: Localization init request: (" << loc.map_id << ")";
+    if (cov.rows() < 3 || cov.cols() < 3)
+    {
+        yError() << "Invalid covariance matrix";
+        return false;
+    }
+
+    std::shared_ptr<const mclMapModel> model = loadMap(loc.map_id);
+    if (!model) return false;
+
+    //the particles are drawn from a gaussian distribution (the off-diagonal terms of the covariance are ignored)
+    std::mt19937 gen(std::random_device{}());
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    double std_x = sqrt(fabs(cov(0, 0)));
+    double std_y = sqrt(fabs(cov(1, 1)));
+    double std_t = sqrt(fabs(cov(2, 2)));
+    std::vector<mclParticle> particles(m_max_particles);
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        particles[i].x = loc.x + std_x * gauss(gen);
+        particles[i].y = loc.y + std_y * gauss(gen);
+        particles[i].theta = angle_diff(loc.theta + std_t * gauss(gen), 0);
+        particles[i].weight = 1.0 / particles.size();
+    }
+
+    lock_guard<std::mutex> lock(m_mutex);
+    if (m_estimate.map_id != loc.map_id)
+    {
+        yInfo() << "Map changed from: " << m_estimate.map_id << " to: " << loc.map_id;
+    }
+    m_map_model = model;
+    m_particles.swap(particles);
+    m_estimate = loc;
+    m_estimate_cov = cov.submatrix(0, 2, 0, 2);
+    m_odom_at_update = m_current_odom;
+    m_localized = false;
+    m_force_update = true;
+    m_w_slow = 0;
+    m_w_fast = 0;
+    m_init_counter++;
+    m_pose_buffer.clear();
+    return true;
+}
+
+bool mclLocalizerThread::globalLocalization()
+{
+    yInfo() << "mclLocalizer: global localization request";
+    std::string map_id;
+    {
+        lock_guard<std::mutex> lock(m_mutex);
+        map_id = m_estimate.map_id;
+    }
+    std::shared_ptr<const mclMapModel> model = loadMap(map_id);
+    if (!model || model->free_cells.empty())
+    {
+        yError() << "Global localization is not possible on map" << map_id;
+        return false;
+    }
+
+    std::mt19937 gen(std::random_device{}());
+    std::vector<mclParticle> particles(m_max_particles);
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        particles[i] = randomParticle(*model, gen);
+        particles[i].weight = 1.0 / particles.size();
+    }
+    Map2DLocation estimate;
+    yarp::sig::Matrix estimate_cov;
+    estimate.map_id = map_id;
+    computeEstimate(particles, estimate, estimate_cov);
+
+    lock_guard<std::mutex> lock(m_mutex);
+    m_map_model = model;
+    m_particles.swap(particles);
+    m_estimate = estimate;
+    m_estimate_cov = estimate_cov;
+    m_odom_at_update = m_current_odom;
+    m_localized = false;
+    m_force_update = true;
+    m_w_slow = 0;
+    m_w_fast = 0;
+    m_init_counter++;
+    m_pose_buffer.clear();
+    return true;
+}
+
+bool mclLocalizerThread::getCurrentLoc(Map2DLocation& loc)
+{
+    //the estimate of the last update is moved with the odometry received since then
+    lock_guard<std::mutex> lock(m_mutex);
+    loc = m_estimate;
+    apply_odometry(m_odom_at_update, m_current_odom, loc);
+    return true;
+}
+
+bool mclLocalizerThread::getCurrentLoc(Map2DLocation& loc, yarp::sig::Matrix& cov)
+{
+    lock_guard<std::mutex> lock(m_mutex);
+    loc = m_estimate;
+    apply_odometry(m_odom_at_update, m_current_odom, loc);
+    cov = m_estimate_cov;
+    return true;
+}
+
+bool mclLocalizerThread::getParticles(std::vector<Map2DLocation>& poses)
+{
+    lock_guard<std::mutex> lock(m_mutex);
+    poses.resize(m_particles.size());
+    for (size_t i = 0; i < m_particles.size(); i++)
+    {
+        poses[i].map_id = m_estimate.map_id;
+        poses[i].x = m_particles[i].x;
+        poses[i].y = m_particles[i].y;
+        poses[i].theta = m_particles[i].theta;
+        apply_odometry(m_odom_at_update, m_current_odom, poses[i]);
+    }
+    return true;
+}
+
+bool mclLocalizerThread::isLocalized()
+{
+    lock_guard<std::mutex> lock(m_mutex);
+    return m_localized;
+}
+
+void mclLocalizerThread::enable(bool val)
+{
+    m_enabled = val;
+}
+
+bool mclLocalizerThread::threadInit()
+{
+    //configuration file checking
+    Bottle general_group = m_cfg.findGroup("GENERAL");
+    if (general_group.isNull())
+    {
+        yError() << "Missing GENERAL group!";
+        return false;
+    }
+
+    Bottle initial_group = m_cfg.findGroup("INITIAL_POS");
+    if (initial_group.isNull())
+    {
+        yError() << "Missing INITIAL_POS group!";
+        return false;
+    }
+
+    Bottle odometry_group = m_cfg.findGroup("ODOMETRY");
+    if (odometry_group.isNull())
+    {
+        yError() << "Missing ODOMETRY group!";
+        return false;
+    }
+
+    Bottle laser_group = m_cfg.findGroup("LASER");
+    if (laser_group.isNull())
+    {
+        yError() << "Missing LASER group!";
+        return false;
+    }
+
+    //general group
+    m_local_name = "mclLocalizer";
+    if (general_group.check("local_name")) { m_local_name = general_group.find("local_name").asString();}
+
+    //odometry group
+    if (odometry_group.check("odometry_broadcast_port") == false)
+    {
+        yError() << "Missing `odometry_broadcast_port` in [ODOMETRY] group";
+        return false;
+    }
+    m_port_broadcast_odometry_name = odometry_group.find("odometry_broadcast_port").asString();
+    if (odometry_group.check("odom_model_type"))
+    {
+        std::string model_type = odometry_group.find("odom_model_type").asString();
+        if      (model_type == "omni") { m_odom_model_omni = true; }
+        else if (model_type == "diff") { m_odom_model_omni = false; }
+        else { yError() << "Invalid `odom_model_type` in [ODOMETRY] group"; return false; }
+    }
+    if (odometry_group.check("odom_alpha1")) { m_alpha1 = odometry_group.find("odom_alpha1").asDouble(); }
+    if (odometry_group.check("odom_alpha2")) { m_alpha2 = odometry_group.find("odom_alpha2").asDouble(); }
+    if (odometry_group.check("odom_alpha3")) { m_alpha3 = odometry_group.find("odom_alpha3").asDouble(); }
+    if (odometry_group.check("odom_alpha4")) { m_alpha4 = odometry_group.find("odom_alpha4").asDouble(); }
+    if (odometry_group.check("odom_alpha5")) { m_alpha5 = odometry_group.find("odom_alpha5").asDouble(); }
+
+    //opens a YARP port to receive odometry data
+    std::string odom_portname = "/" + m_local_name + "/odometry:i";
+    bool b1 = m_port_odometry_input.open(odom_portname.c_str());
+    bool b2 = yarp::os::Network::sync(odom_portname.c_str(), false);
+    bool b3 = yarp::os::Network::connect(m_port_broadcast_odometry_name.c_str(), odom_portname.c_str());
+    if (b1 == false || b2 == false || b3 == false)
+    {
+        yError() << "Unable to initialize odometry port connection from " << m_port_broadcast_odometry_name.c_str() << "to:" << odom_portname.c_str();
+        return false;
+    }
+
+    //map group
+    m_map_server_name = "/mapServer";
+    Bottle map_group = m_cfg.findGroup("MAP");
+    if (map_group.check("mapServer_name")) { m_map_server_name = map_group.find("mapServer_name").asString(); }
+
+    //opens a client to receive the maps from the mapServer
+    Property map_options;
+    map_options.put("device", "map2DClient");
+    map_options.put("local", "/" + m_local_name); //This is just a prefix. map2DClient will complete the port name.
+    map_options.put("remote", m_map_server_name);
+    if (m_pMap.open(map_options) == false)
+    {
+        yError() << "Unable to open mapClient";
+        return false;
+    }
+    m_pMap.view(m_iMap);
+    if (m_pMap.isValid() == false || m_iMap == 0)
+    {
+        yError() << "Unable to view map interface";
+        return false;
+    }
+
+    //laser group
+    if (laser_group.check("laser_port") == false)
+    {
+        yError() << "Missing `laser_port` in [LASER] group";
+        return false;
+    }
+    std::string laser_remote_port = laser_group.find("laser_port").asString();
+    if (laser_group.check("laser_pos_x"))         { m_laser_pos_x = laser_group.find("laser_pos_x").asDouble(); }
+    if (laser_group.check("laser_pos_y"))         { m_laser_pos_y = laser_group.find("laser_pos_y").asDouble(); }
+    if (laser_group.check("laser_pos_theta"))     { m_laser_pos_t = laser_group.find("laser_pos_theta").asDouble(); }
+    if (laser_group.check("max_range"))           { m_max_range = laser_group.find("max_range").asDouble(); }
+    if (laser_group.check("max_beams"))           { m_max_beams = laser_group.find("max_beams").asInt(); }
+    if (laser_group.check("z_hit"))               { m_z_hit = laser_group.find("z_hit").asDouble(); }
+    if (laser_group.check("z_rand"))              { m_z_rand = laser_group.find("z_rand").asDouble(); }
+    if (laser_group.check("likelihood_sigma"))    { m_likelihood_sigma = laser_group.find("likelihood_sigma").asDouble(); }
+    if (laser_group.check("likelihood_max_dist")) { m_likelihood_max_dist = laser_group.find("likelihood_max_dist").asDouble(); }
+    if (m_max_beams == 0 || m_likelihood_sigma <= 0)
+    {
+        yError() << "Invalid parameters in [LASER] group";
+        return false;
+    }
+
+    Property las_options;
+    las_options.put("device", "Rangefinder2DClient");
+    las_options.put("local", "/" + m_local_name + "/laser:i");
+    las_options.put("remote", laser_remote_port);
+    if (m_pLas.open(las_options) == false)
+    {
+        yError() << "Unable to open laser driver";
+        return false;
+    }
+    m_pLas.view(m_iLaser);
+    if (m_iLaser == 0)
+    {
+        yError() << "Unable to open laser interface";
+        return false;
+    }
+    m_pLas.view(m_iLaserTimed);
+    if (m_iLaserTimed == 0)
+    {
+        yWarning() << "Laser timestamps not available, scans will be processed every 0.1s";
+    }
+
+    //particle filter group
+    Bottle filter_group = m_cfg.findGroup("PARTICLE_FILTER");
+    if (filter_group.check("min_particles"))       { m_min_particles = filter_group.find("min_particles").asInt(); }
+    if (filter_group.check("max_particles"))       { m_max_particles = filter_group.find("max_particles").asInt(); }
+    if (filter_group.check("kld_err"))             { m_kld_err = filter_group.find("kld_err").asDouble(); }
+    if (filter_group.check("kld_z"))               { m_kld_z = filter_group.find("kld_z").asDouble(); }
+    if (filter_group.check("kld_bin_xy"))          { m_kld_bin_xy = filter_group.find("kld_bin_xy").asDouble(); }
+    if (filter_group.check("kld_bin_theta"))       { m_kld_bin_theta = filter_group.find("kld_bin_theta").asDouble(); }
+    if (filter_group.check("update_min_d"))        { m_update_min_d = filter_group.find("update_min_d").asDouble(); }
+    if (filter_group.check("update_min_a"))        { m_update_min_a = filter_group.find("update_min_a").asDouble(); }
+    if (filter_group.check("recovery_alpha_slow")) { m_alpha_slow = filter_group.find("recovery_alpha_slow").asDouble(); }
+    if (filter_group.check("recovery_alpha_fast")) { m_alpha_fast = filter_group.find("recovery_alpha_fast").asDouble(); }
+    if (filter_group.check("localized_max_std"))   { m_localized_max_std = filter_group.find("localized_max_std").asDouble(); }
+    if (filter_group.check("num_threads"))         { m_num_threads = filter_group.find("num_threads").asInt(); }
+    if (m_min_particles == 0 || m_max_particles < m_min_particles || m_kld_err <= 0 || m_kld_bin_xy <= 0 || m_kld_bin_theta <= 0 || m_num_threads <= 0)
+    {
+        yError() << "Invalid parameters in [PARTICLE_FILTER] group";
+        return false;
+    }
+    //the threads which weight the particles are created once, every update reuses them
+    m_workers.start(m_num_threads);
+
+    //initial location initialization
+    if (initial_group.check("initial_cov_xx")) { m_initial_cov_xx = initial_group.find("initial_cov_xx").asDouble(); }
+    if (initial_group.check("initial_cov_yy")) { m_initial_cov_yy = initial_group.find("initial_cov_yy").asDouble(); }
+    if (initial_group.check("initial_cov_aa")) { m_initial_cov_aa = initial_group.find("initial_cov_aa").asDouble(); }
+    Map2DLocation tmp_loc;
+    if (initial_group.check("initial_x")) { tmp_loc.x = initial_group.find("initial_x").asDouble(); }
+    else { yError() << "missing initial_x param"; return false; }
+    if (initial_group.check("initial_y")) { tmp_loc.y = initial_group.find("initial_y").asDouble(); }
+    else { yError() << "missing initial_y param"; return false; }
+    if (initial_group.check("initial_theta")) { tmp_loc.theta = initial_group.find("initial_theta").asDouble(); }
+    else { yError() << "missing initial_theta param"; return false; }
+    if (initial_group.check("initial_map")) { tmp_loc.map_id = initial_group.find("initial_map").asString(); }
+    else { yError() << "missing initial_map param"; return false; }
+    if (this->initializeLocalization(tmp_loc) == false)
+    {
+        yError() << "Unable to initialize the localization on map" << tmp_loc.map_id;
+        return false;
+    }
+
+    return true;
+}
+
+void mclLocalizerThread::threadRelease()
+{
+    m_workers.stop();
+    m_port_odometry_input.interrupt();
+    m_port_odometry_input.close();
+    if (m_pLas.isValid()) m_pLas.close();
+    if (m_pMap.isValid()) m_pMap.close();
+}
+
+
+bool mclLocalizer::open(yarp::os::Searchable& config)
+{
+    yDebug() << "config configuration: \n" << config.toString().c_str();
+
+    std::string context_name = "mclLocalizer";
+    std::string file_name = "mclLocalizer.ini";
+
+    if (config.check("context"))   context_name = config.find("context").asString();
+    if (config.check("from")) file_name = config.find("from").asString();
+
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultContext(context_name.c_str());
+    rf.setDefaultConfigFile(file_name.c_str());
+
+    Property p;
+    std::string configFile = rf.findFile("from");
+    if (configFile != "") p.fromConfigFile(configFile.c_str());
+    yDebug() << "mclLocalizer configuration: \n" << p.toString().c_str();
+
+    thread = new mclLocalizerThread(0.010, p);
+
+    if (!thread->start())
+    {
+        delete thread;
+        thread = NULL;
+        return false;
+    }
+
+    std::string local_name = "mclLocalizer";
+    Bottle general_group = p.findGroup("GENERAL");
+    if (general_group.isNull()==false)
+    {
+        if (general_group.check("local_name")) { local_name = general_group.find("local_name").asString(); }
+    }
+    bool ret = rpcPort.open("/"+local_name+"/rpc");
+    if (ret == false)
+    {
+        yError() << "Unable to open module ports";
+        return false;
+    }
+
+    rpcPortHandler.setInterface(this);
+    rpcPort.setReader(rpcPortHandler);
+
+    return true;
+}
+
+mclLocalizer::mclLocalizer()
+{
+    thread = NULL;
+}
+
+mclLocalizer::~mclLocalizer()
+{
+    if (thread)
+    {
+        delete thread;
+        thread = NULL;
+    }
+}
+
+bool mclLocalizer::close()
+{
+    if (thread)
+    {
+        thread->stop();
+    }
+    rpcPort.interrupt();
+    rpcPort.close();
+    return true;
+}
+
+bool   mclLocalizer::getCurrentPosition(Map2DLocation& loc, yarp::sig::Matrix& cov)
+{
+    return thread->getCurrentLoc(loc, cov);
+}
+
+bool   mclLocalizer::setInitialPose(const Map2DLocation& loc, const yarp::sig::Matrix& cov)
+{
+    return thread->initializeLocalization(loc, cov);
+}
+
+bool    mclLocalizer::startLocalizationService()
+{
+    thread->enable(true);
+    return true;
+}
+
+bool    mclLocalizer::stopLocalizationService()
+{
+    thread->enable(false);
+    return true;
+}
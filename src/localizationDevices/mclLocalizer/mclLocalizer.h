@@ -0,0 +1,316 @@
+/*
+ * Copyright (C)2019  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Port.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/INavigation2D.h>
+#include <yarp/dev/IMap2D.h>
+#include <yarp/dev/IRangefinder2D.h>
+#include <yarp/dev/PreciselyTimed.h>
+#include <yarp/dev/OdometryData.h>
+#include <yarp/os/PeriodicThread.h>
+#include <likelihood_field.h>
+#include <pose_buffer.h>
+#include <worker_pool.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <math.h>
+
+using namespace yarp::os;
+
+/**
+ * \section mclLocalizer
+ * A localization device which can be wrapped by a Localization2DServer.
+ * The device implements an adaptive Monte Carlo localization: the particles are moved with the odometry data, weighted
+ * with the laser scan over the likelihood field of the current map, and resampled with KLD sampling, so that the number
+ * of particles (and the cpu load) decreases when the robot is well localized. Random particles are injected when the
+ * average weight drops (kidnapped robot), allowing the filter to recover the global localization.
+ * The weighting step is split among `num_threads` worker threads. The likelihood fields are cached per map.
+ * getEstimatedPoses() returns the particle cloud; the RPC command `global_localization` spreads the particles over
+ * the whole free space of the current map.
+ *
+ *  Parameters required by this device are:
+ * | Parameter name  | SubParameter        | Type    | Units  | Default Value | Required | Description                                                       | Notes |
+ * |:---------------:|:-------------------:|:-------:|:------:|:-------------:|:--------:|:-----------------------------------------------------------------:|:-----:|
+ * | GENERAL         |  local_name         | string  | -      | mclLocalizer  | No       | The name of the module use to open ports                          |       |
+ * | INITIAL_POS     |  initial_x          | double  | m      | 0.0           | Yes      | Initial estimation of robot position                              | -     |
+ * | INITIAL_POS     |  initial_y          | double  | m      | 0.0           | Yes      | Initial estimation of robot position                              | -     |
+ * | INITIAL_POS     |  initial_theta      | double  | deg    | 0.0           | Yes      | Initial estimation of robot position                              | -     |
+ * | INITIAL_POS     |  initial_map        | string  | -      |   -           | Yes      | Name of the map on which localization is performed                | -     |
+ * | INITIAL_POS     |  initial_cov_xx     | double  | m^2    | 0.25          | No       | Variance of the initial estimation, used by setInitialPose() without covariance | - |
+ * | INITIAL_POS     |  initial_cov_yy     | double  | m^2    | 0.25          | No       | Variance of the initial estimation, used by setInitialPose() without covariance | - |
+ * | INITIAL_POS     |  initial_cov_aa     | double  | deg^2  | 100.0         | No       | Variance of the initial estimation, used by setInitialPose() without covariance | - |
+ * | ODOMETRY        |  odometry_broadcast_port | string | - |   -           | Yes      | Full name of port broadcasting the odometry data. The device will connect to this port. | - |
+ * | ODOMETRY        |  odom_model_type    | string  | -      | diff          | No       | Motion model: `diff` (differential drive) or `omni` (omnidirectional) | -  |
+ * | ODOMETRY        |  odom_alpha1        | double  | -      | 0.2           | No       | Rotation noise due to rotation                                    | -     |
+ * | ODOMETRY        |  odom_alpha2        | double  | -      | 0.2           | No       | Rotation noise due to translation                                 | -     |
+ * | ODOMETRY        |  odom_alpha3        | double  | -      | 0.2           | No       | Translation noise due to translation                              | -     |
+ * | ODOMETRY        |  odom_alpha4        | double  | -      | 0.2           | No       | Translation (and strafe, omni model) noise due to rotation        | -     |
+ * | ODOMETRY        |  odom_alpha5        | double  | -      | 0.2           | No       | Strafe noise due to translation (omni model only)                 | -     |
+ * | MAP             |  mapServer_name     | string  | -      | /mapServer    | No       | Full name of the map server                                       | -     |
+ * | LASER           |  laser_port         | string  | -      |   -           | Yes      | Full name of the port broadcasting the laser scans                | -     |
+ * | LASER           |  laser_pos_x        | double  | m      | 0.0           | No       | Position of the laser w.r.t. the robot frame                      | -     |
+ * | LASER           |  laser_pos_y        | double  | m      | 0.0           | No       | Position of the laser w.r.t. the robot frame                      | -     |
+ * | LASER           |  laser_pos_theta    | double  | deg    | 0.0           | No       | Orientation of the laser w.r.t. the robot frame                   | -     |
+ * | LASER           |  max_range          | double  | m      | 10.0          | No       | Laser measurements beyond this distance are discarded             | -     |
+ * | LASER           |  max_beams          | int     | -      | 60            | No       | Number of beams of the scan used to weight the particles          | -     |
+ * | LASER           |  z_hit              | double  | -      | 0.95          | No       | Weight of the likelihood field in the sensor model                | -     |
+ * | LASER           |  z_rand             | double  | -      | 0.05          | No       | Weight of the random measurements in the sensor model             | -     |
+ * | LASER           |  likelihood_sigma   | double  | m      | 0.2           | No       | Standard deviation of the laser measurement noise                 | -     |
+ * | LASER           |  likelihood_max_dist| double  | m      | 2.0           | No       | Maximum distance from an obstacle considered by the likelihood field | -  |
+ * | PARTICLE_FILTER |  min_particles      | int     | -      | 100           | No       | Minimum number of particles                                       | -     |
+ * | PARTICLE_FILTER |  max_particles      | int     | -      | 5000          | No       | Maximum number of particles                                       | -     |
+ * | PARTICLE_FILTER |  kld_err            | double  | -      | 0.01          | No       | Maximum error between the true and the estimated distribution     | -     |
+ * | PARTICLE_FILTER |  kld_z              | double  | -      | 0.99          | No       | Upper standard normal quantile for the KLD bound (same meaning of the AMCL parameter) | - |
+ * | PARTICLE_FILTER |  kld_bin_xy         | double  | m      | 0.5           | No       | Size of the histogram bins used by KLD sampling                   | -     |
+ * | PARTICLE_FILTER |  kld_bin_theta      | double  | deg    | 10.0          | No       | Size of the histogram bins used by KLD sampling                   | -     |
+ * | PARTICLE_FILTER |  update_min_d       | double  | m      | 0.1           | No       | Translation required before performing a filter update            | -     |
+ * | PARTICLE_FILTER |  update_min_a       | double  | deg    | 10.0          | No       | Rotation required before performing a filter update               | -     |
+ * | PARTICLE_FILTER |  recovery_alpha_slow| double  | -      | 0.001         | No       | Decay rate of the slow average weight (0 disables the recovery)   | -     |
+ * | PARTICLE_FILTER |  recovery_alpha_fast| double  | -      | 0.1           | No       | Decay rate of the fast average weight (0 disables the recovery)   | -     |
+ * | PARTICLE_FILTER |  localized_max_std  | double  | m      | 0.3           | No       | The robot is considered localized if the particles spread is below this value | - |
+ * | PARTICLE_FILTER |  num_threads        | int     | -      | 4             | No       | Number of threads used to weight the particles                    | -     |
+ */
+
+class mclLocalizer;
+class mclLocalizerThread;
+
+class mclLocalizerRPCHandler : public yarp::dev::DeviceResponder
+{
+protected:
+    mclLocalizer * interface;
+    bool respond(const yarp::os::Bottle& cmd, yarp::os::Bottle& response) override;
+
+public:
+    mclLocalizerRPCHandler() : interface(NULL) { }
+    void setInterface(mclLocalizer* iface);
+};
+
+class mclLocalizer : public yarp::dev::DeviceDriver,
+                     public yarp::dev::ILocalization2D
+{
+public:
+    mclLocalizerThread*    thread;
+    mclLocalizerRPCHandler rpcPortHandler;
+    yarp::os::Port         rpcPort;
+
+public:
+    virtual bool open(yarp::os::Searchable& config) override;
+
+    mclLocalizer();
+    virtual ~mclLocalizer();
+
+    virtual bool close() override;
+
+public:
+    /**
+    * Gets the current status of the localization task.
+    * @return true/false
+    */
+    bool   getLocalizationStatus(yarp::dev::LocalizationStatusEnum& status) override;
+
+    /**
+    * Gets a set of pose estimates computed by the localization algorithm.
+    * @return true/false
+    */
+    bool   getEstimatedPoses(std::vector<yarp::dev::Nav2D::Map2DLocation>& poses) override;
+
+    /**
+    * Gets the current position of the robot w.r.t world reference frame
+    * @param loc the location of the robot
+    * @return true/false
+    */
+    bool   getCurrentPosition(yarp::dev::Nav2D::Map2DLocation& loc) override;
+
+    /**
+    * Sets the initial pose for the localization algorithm which estimates the current position of the robot w.r.t world reference frame.
+    * @param loc the location of the robot
+    * @return true/false
+    */
+    bool   setInitialPose(const yarp::dev::Nav2D::Map2DLocation& loc) override;
+
+    /**
+     * Gets the current position of the robot w.r.t world reference frame, plus the covariance
+     * @param loc the location of the robot
+     * @param cov the 3x3 covariance matrix
+     * @return true/false
+     */
+    bool   getCurrentPosition(yarp::dev::Nav2D::Map2DLocation& loc, yarp::sig::Matrix& cov) override;
+
+    /**
+    * Sets the initial pose for the localization algorithm which estimates the current position of the robot w.r.t world reference frame.
+    * @param loc the location of the robot
+    * @param cov the 3x3 covariance matrix
+    * @return true/false
+    */
+    bool   setInitialPose(const yarp::dev::Nav2D::Map2DLocation& loc, const yarp::sig::Matrix& cov) override;
+
+    /**
+    * Starts the localization service
+    * @return true/false
+    */
+    bool   startLocalizationService() override;
+
+    /**
+    * Stops the localization service
+    * @return true/false
+    */
+    bool   stopLocalizationService() override;
+};
+
+/**
+* A particle of the filter. The pose is expressed in the map reference frame, theta in degrees.
+*/
+struct mclParticle
+{
+    double x;
+    double y;
+    double theta;
+    double weight;
+};
+
+/**
+* The data computed once for each map: the likelihood field and the list of the free cells, used to draw random particles.
+*/
+struct mclMapModel
+{
+    likelihood_field                        field;
+    std::vector<std::pair<double, double>>  free_cells;
+};
+
+class mclLocalizerThread : public yarp::os::PeriodicThread
+{
+protected:
+    //general
+    double                       m_last_statistics_printed;
+    std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
+    yarp::os::Searchable&        m_cfg;
+    std::string                  m_local_name;
+    bool                         m_enabled;
+    size_t                       m_init_counter;
+    std::mt19937                 m_rand_gen;           //used only by the filter thread
+
+    //filter status, protected by m_mutex
+    std::vector<mclParticle>     m_particles;
+    yarp::dev::Nav2D::Map2DLocation  m_estimate;           //estimate computed at the last filter update
+    yarp::sig::Matrix            m_estimate_cov;
+    yarp::dev::Nav2D::Map2DLocation  m_odom_at_update;     //odometry at the last filter update
+    yarp::dev::Nav2D::Map2DLocation  m_current_odom;
+    bool                         m_odom_received;
+    bool                         m_localized;
+    bool                         m_force_update;
+    double                       m_w_slow;
+    double                       m_w_fast;
+
+    //odometry port and motion model
+    std::string                  m_port_broadcast_odometry_name;
+    yarp::os::BufferedPort<yarp::dev::OdometryData>  m_port_odometry_input;
+    double                       m_last_odometry_data_received;
+    bool                         m_odom_model_omni;
+    double                       m_alpha1;
+    double                       m_alpha2;
+    double                       m_alpha3;
+    double                       m_alpha4;
+    double                       m_alpha5;
+
+    //map
+    std::string                  m_map_server_name;
+    yarp::dev::PolyDriver        m_pMap;
+    yarp::dev::Nav2D::IMap2D*    m_iMap;
+    std::shared_ptr<const mclMapModel>                          m_map_model;
+    std::map<std::string, std::shared_ptr<const mclMapModel>>   m_map_cache;
+    std::mutex                   m_map_cache_mutex;
+
+    //laser and sensor model
+    yarp::dev::PolyDriver        m_pLas;
+    yarp::dev::IRangefinder2D*   m_iLaser;
+    yarp::dev::IPreciselyTimed*  m_iLaserTimed;
+    double                       m_last_scan_stamp;
+    double                       m_laser_pos_x;
+    double                       m_laser_pos_y;
+    double                       m_laser_pos_t;
+    double                       m_max_range;
+    size_t                       m_max_beams;
+    double                       m_z_hit;
+    double                       m_z_rand;
+    double                       m_likelihood_sigma;
+    double                       m_likelihood_max_dist;
+    std::vector<double>          m_scan_x;
+    std::vector<double>          m_scan_y;
+
+    //particle filter parameters
+    size_t                       m_min_particles;
+    size_t                       m_max_particles;
+    double                       m_kld_err;
+    double                       m_kld_z;
+    double                       m_kld_bin_xy;
+    double                       m_kld_bin_theta;
+    double                       m_update_min_d;
+    double                       m_update_min_a;
+    double                       m_alpha_slow;
+    double                       m_alpha_fast;
+    double                       m_localized_max_std;
+    double                       m_initial_cov_xx;
+    double                       m_initial_cov_yy;
+    double                       m_initial_cov_aa;
+    int                          m_num_threads;
+    worker_pool                  m_workers;
+
+    //statistics
+    size_t                       m_stat_updates;
+    double                       m_stat_update_time;
+
+public:
+    mclLocalizerThread(const double _period, yarp::os::Searchable& _cfg);
+    virtual bool threadInit() override;
+    virtual void threadRelease() override;
+    virtual void run() override;
+
+public:
+    bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc);
+    bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc, const yarp::sig::Matrix& cov);
+    bool globalLocalization();
+    bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
+    bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc, yarp::sig::Matrix& cov);
+    bool getParticles(std::vector<yarp::dev::Nav2D::Map2DLocation>& poses);
+    bool isLocalized();
+    void enable(bool val);
+
+private:
+    std::shared_ptr<const mclMapModel> loadMap(const std::string& map_id);
+    void updateOdometry();
+    bool readScan();
+    void updateFilter();
+    void moveParticles(std::vector<mclParticle>& particles, const yarp::dev::Nav2D::Map2DLocation& odom_from, const yarp::dev::Nav2D::Map2DLocation& odom_to);
+    void weightParticles(const likelihood_field& field, mclParticle* particles, size_t count, double& weight_sum) const;
+    void resampleParticles(const mclMapModel& model, const std::vector<mclParticle>& particles, double w_random, std::vector<mclParticle>& new_particles);
+    void computeEstimate(const std::vector<mclParticle>& particles, yarp::dev::Nav2D::Map2DLocation& loc, yarp::sig::Matrix& cov) const;
+    size_t kldLimit(size_t k) const;
+    mclParticle randomParticle(const mclMapModel& model, std::mt19937& gen) const;
+};
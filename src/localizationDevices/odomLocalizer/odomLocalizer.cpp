@@ -53,6 +53,10 @@ void odomLocalizerRPCHandler::setInterface(odomLocalizer* iface)
 bool odomLocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
 {
     reply.clear();
+    if (interface->thread && interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
     reply.addVocab(Vocab::encode("many"));
     reply.addString("Not yet Implemented");
     return true;
@@ -148,6 +152,11 @@ void odomLocalizerThread::run()
 
         if      (m_current_loc.theta >= +360) m_current_loc.theta -= 360;
         else if (m_current_loc.theta <= -360) m_current_loc.theta += 360;
+
+        //the pose is stamped with the time of the odometry data, if available
+        yarp::os::Stamp stamp;
+        bool stamped = m_port_odometry_input.getEnvelope(stamp) && stamp.isValid();
+        m_pose_buffer.add_pose(stamped ? stamp.getTime() : m_last_odometry_data_received, m_current_loc);
     }
     if (current_time - m_last_odometry_data_received > 0.1)
     {
@@ -166,6 +175,7 @@ bool odomLocalizerThread::initializeLocalization(const Map2DLocation& loc)
     m_initial_odom.x = m_current_odom.x;
     m_initial_odom.y = m_current_odom.y;
     m_initial_odom.theta = m_current_odom.theta;
+    m_pose_buffer.clear();
 
     if (m_current_loc.map_id != m_initial_loc.map_id)
     {
@@ -30,6 +30,7 @@
 #include <yarp/dev/OdometryData.h>
 #include <yarp/os/PeriodicThread.h>
 #include <mutex>
+#include <pose_buffer.h>
 #include <math.h>
 
 using namespace yarp::os;
@@ -145,6 +146,7 @@ protected:
     yarp::dev::Nav2D::Map2DLocation     m_current_loc;
     yarp::dev::Nav2D::Map2DLocation     m_current_odom;
     std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
     yarp::os::Searchable&        m_cfg;
     std::string                  m_local_name;
 
@@ -162,4 +164,5 @@ public:
 public:
     bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc);
     bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
 };
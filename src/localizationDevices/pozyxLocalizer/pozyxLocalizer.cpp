@@ -53,6 +53,10 @@ void pozyxLocalizerRPCHandler::setInterface(pozyxLocalizer* iface)
 bool pozyxLocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
 {
     reply.clear();
+    if (interface->thread && interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
     reply.addVocab(Vocab::encode("many"));
     reply.addString("Not yet Implemented");
     return true;
@@ -127,6 +131,7 @@ void pozyxLocalizerThread::run()
     m_localization_data.theta = m_pozyx_data.theta + m_map_to_pozyx_transform.theta;
     if      (m_localization_data.theta >= +360) m_localization_data.theta -= 360;
     else if (m_localization_data.theta <= -360) m_localization_data.theta += 360;
+    m_pose_buffer.add_pose(current_time, m_localization_data);
 }
 
 bool pozyxLocalizerThread::initializeLocalization(const Map2DLocation& loc)
@@ -139,6 +144,7 @@ bool pozyxLocalizerThread::initializeLocalization(const Map2DLocation& loc)
     m_map_to_pozyx_transform.x = loc.x;
     m_map_to_pozyx_transform.y = loc.y;
     m_map_to_pozyx_transform.theta = loc.theta;
+    m_pose_buffer.clear();
 
     if (get_anchors_location())
     {
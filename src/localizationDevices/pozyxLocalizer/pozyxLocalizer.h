@@ -29,6 +29,7 @@
 #include <yarp/dev/ControlBoardInterfaces.h>
 #include <yarp/os/PeriodicThread.h>
 #include <mutex>
+#include <pose_buffer.h>
 #include <math.h>
 #include <yarp/dev/IMap2D.h>
 
@@ -133,6 +134,7 @@ protected:
     yarp::dev::Nav2D::Map2DLocation     m_pozyx_data;
     std::vector<yarp::dev::Nav2D::Map2DLocation> m_anchors_pos;
     std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
     yarp::os::Searchable&        m_cfg;
     std::string                  m_local_name;
     std::string                  m_local_name_prefix;
@@ -157,6 +159,7 @@ public:
 public:
     bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc);
     bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
 };
 
 #endif
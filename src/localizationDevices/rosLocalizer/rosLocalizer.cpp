@@ -37,6 +37,7 @@
 #include <math.h>
 #include <mutex>
 #include "rosLocalizer.h"
+#include <ros_map_conversion.h>
 
 using namespace std;
 using namespace yarp::os;
@@ -58,6 +59,10 @@ void rosLocalizerRPCHandler::setInterface(rosLocalizer* iface)
 bool rosLocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
 {
     reply.clear();
+    if (interface->thread && interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
     reply.addVocab(Vocab::encode("many"));
     reply.addString("Not yet Implemented");
     return true;
@@ -132,42 +137,30 @@ rosLocalizerThread::rosLocalizerThread(double _period, yarp::os::Searchable& _cf
       
     m_seq_counter=0;
     m_rosTime = yarp::os::Time::now();
+    m_map_published = false;
+    m_published_map_fingerprint = 0;
 }
 
 void rosLocalizerThread::publish_map()
 {
-    double tmp=0;
     yarp::rosmsg::nav_msgs::OccupancyGrid& ogrid = m_rosPublisher_occupancyGrid.prepare();
     ogrid.clear();
-    ogrid.info.height=m_current_map.height();
-    ogrid.info.width=m_current_map.width();
-    m_current_map.getResolution(tmp);
-    ogrid.info.resolution=tmp;
     ogrid.header.frame_id="map";
-    ogrid.info.map_load_time.sec=0;
-    ogrid.info.map_load_time.nsec=0;
-    double x, y, t;
-    m_current_map.getOrigin(x,y,t);
-    ogrid.info.origin.position.x=x;
-    ogrid.info.origin.position.y=y;
-    yarp::math::Quaternion q;
-    yarp::sig::Vector v(4);
-    v[0]=0; v[1]=0; v[2]=1; v[3]=t*DEG2RAD;
-    q.fromAxisAngle(v);
-    ogrid.info.origin.orientation.x = q.x();
-    ogrid.info.origin.orientation.y = q.y();
-    ogrid.info.origin.orientation.z = q.z();
-    ogrid.info.origin.orientation.w = q.w();
-    ogrid.data.resize(m_current_map.width()*m_current_map.height());
-    int index=0;
-    yarp::dev::Nav2D::XYCell cell;
-    for (cell.y=m_current_map.height(); cell.y-- > 0;)
-      for (cell.x=0; cell.x<m_current_map.width(); cell.x++)
-      {
-        m_current_map.getOccupancyData(cell,tmp);
-        ogrid.data[index++]=(int)tmp;
-      }
-      
+    if (ros_map_conversion::yarp_to_ros(m_current_map, ogrid) == false)
+    {
+        m_rosPublisher_occupancyGrid.unprepare();
+        return;
+    }
+
+    //the map is published only if it changed
+    uint64_t fp = ros_map_conversion::fingerprint(ogrid);
+    if (m_map_published && fp == m_published_map_fingerprint)
+    {
+        m_rosPublisher_occupancyGrid.unprepare();
+        return;
+    }
+    m_published_map_fingerprint = fp;
+    m_map_published = true;
     m_rosPublisher_occupancyGrid.write();
 }
 
@@ -194,6 +187,7 @@ void rosLocalizerThread::run()
         m_localization_data.x = pose[0];
         m_localization_data.y = pose[1];
         m_localization_data.theta = pose[5] * RAD2DEG;
+        m_pose_buffer.add_pose(m_tf_data_received, m_localization_data);
     }
     if (current_time - m_tf_data_received > 0.1)
     {
@@ -231,6 +225,7 @@ bool rosLocalizerThread::initializeLocalization(const yarp::dev::Nav2D::Map2DLoc
     m_localization_data.x = loc.x;
     m_localization_data.y = loc.y;
     m_localization_data.theta = loc.theta;
+    m_pose_buffer.clear();
     
     //send data to ROS localization module
     m_rosTime = (yarp::os::Time::now());
@@ -38,6 +38,7 @@
 #include <yarp/rosmsg/nav_msgs/OccupancyGrid.h>
 #include <yarp/rosmsg/geometry_msgs/PoseArray.h>
 #include <mutex>
+#include <pose_buffer.h>
 #include <math.h>
 
 using namespace yarp::os;
@@ -161,9 +162,12 @@ protected:
     std::string                  m_module_name;
     double                       m_last_statistics_printed;
     double                       m_last_published_map;
+    bool                         m_map_published;
+    uint64_t                     m_published_map_fingerprint;
     yarp::dev::Nav2D::MapGrid2D         m_current_map;
     yarp::dev::Nav2D::Map2DLocation     m_localization_data;
     std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
     yarp::os::Searchable&        m_cfg;
     std::string                  m_local_name;
 
@@ -206,6 +210,7 @@ public:
 public:
     bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc, const yarp::sig::Matrix& roscov6x6);
     bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
     bool getEstimatedPoses(std::vector<yarp::dev::Nav2D::Map2DLocation>& poses);
     bool startLoc();
     bool stopLoc();
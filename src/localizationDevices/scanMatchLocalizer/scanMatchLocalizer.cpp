@@ -0,0 +1,676 @@
+/*
+ * Copyright (C)2019  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Port.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/INavigation2D.h>
+#include <math.h>
+#include <algorithm>
+#include <mutex>
+#include "scanMatchLocalizer.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RAD2DEG 180/M_PI
+#define DEG2RAD M_PI/180
+
+void scanMatchLocalizerRPCHandler::setInterface(scanMatchLocalizer* iface)
+{
+    this->interface = iface;
+}
+
+//This function parses the user commands received through the RPC port
+bool scanMatchLocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
+{
+    reply.clear();
+    if (interface->thread && interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
+    reply.addVocab(Vocab::encode("many"));
+    reply.addString("Not yet Implemented");
+    return true;
+}
+
+bool   scanMatchLocalizer::getLocalizationStatus(yarp::dev::LocalizationStatusEnum& status)
+{
+    if (thread->isLocalized())
+    {
+        status = yarp::dev::LocalizationStatusEnum::localization_status_localized_ok;
+    }
+    else
+    {
+        status = yarp::dev::LocalizationStatusEnum::localization_status_not_yet_localized;
+    }
+    return true;
+}
+
+bool   scanMatchLocalizer::getEstimatedPoses(std::vector<Map2DLocation>& poses)
+{
+    poses.clear();
+    Map2DLocation loc;
+    thread->getCurrentLoc(loc);
+    poses.push_back(loc);
+    return true;
+}
+
+bool   scanMatchLocalizer::getCurrentPosition(Map2DLocation& loc)
+{
+    thread->getCurrentLoc(loc);
+    return true;
+}
+
+bool   scanMatchLocalizer::setInitialPose(const Map2DLocation& loc)
+{
+    return thread->initializeLocalization(loc);
+}
+
+//////////////////////////
+
+scanMatchLocalizerThread::scanMatchLocalizerThread(double _period, yarp::os::Searchable& _cfg) : PeriodicThread(_period), m_cfg(_cfg)
+{
+    m_last_odometry_data_received = -1;
+    m_last_statistics_printed = -1;
+    m_odom_received = false;
+    m_enabled = true;
+    m_init_counter = 0;
+
+    m_current_loc.map_id = m_last_odom.map_id = "unknown";
+    m_current_loc.x      = m_last_odom.x      = 0;
+    m_current_loc.y      = m_last_odom.y      = 0;
+    m_current_loc.theta  = m_last_odom.theta  = 0;
+
+    m_iMap = 0;
+    m_iLaser = 0;
+    m_iLaserTimed = 0;
+    m_last_scan_stamp = -1;
+    m_laser_pos_x = 0;
+    m_laser_pos_y = 0;
+    m_laser_pos_t = 0;
+    m_max_range = 10.0;
+    m_max_points = 180;
+
+    m_linear_window = 0.3;
+    m_angular_window = 10.0;
+    m_linear_step = 1;
+    m_angular_step = 1.0;
+    m_likelihood_sigma = 0.1;
+    m_likelihood_max_dist = 0.5;
+    m_min_score = 0.4;
+    m_correction_gain = 1.0;
+    m_num_threads = 4;
+
+    m_localized = false;
+    m_last_score = 0;
+    m_stat_matches = 0;
+    m_stat_accepted = 0;
+    m_stat_match_time = 0;
+}
+
+void scanMatchLocalizerThread::run()
+{
+    double current_time = yarp::os::Time::now();
+
+    //print some stats every 10 seconds
+    if (current_time - m_last_statistics_printed > 10.0)
+    {
+        if (m_stat_matches > 0)
+        {
+            yInfo() << "scanMatchLocalizer: matched" << m_stat_matches << "scans (" << m_stat_accepted << "accepted), average time:"
+                    << m_stat_match_time / m_stat_matches * 1000.0 << "ms, last score:" << m_last_score;
+        }
+        m_stat_matches = 0;
+        m_stat_accepted = 0;
+        m_stat_match_time = 0;
+        m_last_statistics_printed = yarp::os::Time::now();
+    }
+
+    updateOdometry();
+
+    if (m_enabled && readScan())
+    {
+        matchScan();
+    }
+
+    if (current_time - m_last_odometry_data_received > 0.1)
+    {
+        yWarning() << "No odometry data received for more than 0.1s!";
+    }
+}
+
+void scanMatchLocalizerThread::updateOdometry()
+{
+    yarp::dev::OdometryData *odom = m_port_odometry_input.read(false);
+    if (odom == nullptr) return;
+
+    lock_guard<std::mutex> lock(m_mutex);
+    m_last_odometry_data_received = yarp::os::Time::now();
+    if (m_odom_received)
+    {
+        //the odometry increment is first expressed in the robot frame, then applied to the current pose
+        double dx = odom->odom_x - m_last_odom.x;
+        double dy = odom->odom_y - m_last_odom.y;
+        double co = cos(m_last_odom.theta*DEG2RAD);
+        double so = sin(m_last_odom.theta*DEG2RAD);
+        double rx =  dx * co + dy * so;
+        double ry = -dx * so + dy * co;
+        double cl = cos(m_current_loc.theta*DEG2RAD);
+        double sl = sin(m_current_loc.theta*DEG2RAD);
+        m_current_loc.x += rx * cl - ry * sl;
+        m_current_loc.y += rx * sl + ry * cl;
+        m_current_loc.theta += odom->odom_theta - m_last_odom.theta;
+
+        if      (m_current_loc.theta >= +360) m_current_loc.theta -= 360;
+        else if (m_current_loc.theta <= -360) m_current_loc.theta += 360;
+    }
+    m_last_odom.x = odom->odom_x;
+    m_last_odom.y = odom->odom_y;
+    m_last_odom.theta = odom->odom_theta;
+    m_odom_received = true;
+
+    //the pose is stamped with the time of the odometry data, if available
+    yarp::os::Stamp stamp;
+    bool stamped = m_port_odometry_input.getEnvelope(stamp) && stamp.isValid();
+    m_pose_buffer.add_pose(stamped ? stamp.getTime() : m_last_odometry_data_received, m_current_loc);
+}
+
+bool scanMatchLocalizerThread::readScan()
+{
+    //a scan is processed only once. If the timestamp is not available, the scan is processed every 0.1s.
+    double stamp = 0;
+    if (m_iLaserTimed) stamp = m_iLaserTimed->getLastInputStamp().getTime();
+    else               stamp = floor(yarp::os::Time::now() * 10.0) / 10.0;
+    if (stamp == m_last_scan_stamp) return false;
+
+    std::vector<LaserMeasurementData> scan;
+    if (m_iLaser->getLaserMeasurement(scan) == false) return false;
+    m_last_scan_stamp = stamp;
+
+    //the scan is decimated and transformed in the robot reference frame
+    size_t decimation = (scan.size() + m_max_points - 1) / m_max_points;
+    if (decimation == 0) decimation = 1;
+    double cl = cos(m_laser_pos_t*DEG2RAD);
+    double sl = sin(m_laser_pos_t*DEG2RAD);
+    m_scan_x.clear();
+    m_scan_y.clear();
+    for (size_t i = 0; i < scan.size(); i += decimation)
+    {
+        double las_x = 0;
+        double las_y = 0;
+        scan[i].get_cartesian(las_x, las_y);
+        if (!std::isfinite(las_x) || !std::isfinite(las_y)) continue;
+        if (las_x*las_x + las_y*las_y > m_max_range*m_max_range) continue;
+        m_scan_x.push_back(las_x * cl - las_y * sl + m_laser_pos_x);
+        m_scan_y.push_back(las_x * sl + las_y * cl + m_laser_pos_y);
+    }
+    return (m_scan_x.size() > 0);
+}
+
+void scanMatchLocalizerThread::searchOrientations(const likelihood_field& field, const Map2DLocation& pred, int t_begin, int t_end,
+                                                  double& best_score, int& best_ix, int& best_iy, int& best_it) const
+{
+    const double res = field.resolution();
+    const int n_lin = (int)(m_linear_window / res) / m_linear_step;
+    const int n_ang = (int)(m_angular_window / m_angular_step);
+    const size_t n_points = m_scan_x.size();
+
+    double ccx, ccy;
+    field.world2cell(pred.x, pred.y, ccx, ccy);
+
+    std::vector<int> px(n_points);
+    std::vector<int> py(n_points);
+    for (int it = t_begin; it < t_end; it++)
+    {
+        //the scan is rotated once per orientation, the translations are pure offsets in cells
+        double t = (pred.theta + (it - n_ang) * m_angular_step) * DEG2RAD;
+        double c = cos(t);
+        double s = sin(t);
+        for (size_t i = 0; i < n_points; i++)
+        {
+            double wx = m_scan_x[i] * c - m_scan_y[i] * s;
+            double wy = m_scan_x[i] * s + m_scan_y[i] * c;
+            px[i] = (int)floor(ccx + wx / res);
+            py[i] = (int)floor(ccy - wy / res);
+        }
+        for (int iy = -n_lin; iy <= n_lin; iy++)
+        {
+            int oy = iy * m_linear_step;
+            for (int ix = -n_lin; ix <= n_lin; ix++)
+            {
+                int ox = ix * m_linear_step;
+                double sum = 0;
+                for (size_t i = 0; i < n_points; i++)
+                {
+                    sum += field.at_cell(px[i] + ox, py[i] + oy);
+                }
+                double score = sum / n_points;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best_ix = ox;
+                    best_iy = oy;
+                    best_it = it;
+                }
+            }
+        }
+    }
+}
+
+void scanMatchLocalizerThread::matchScan()
+{
+    std::shared_ptr<const likelihood_field> field;
+    Map2DLocation pred;
+    size_t init_counter = 0;
+    {
+        lock_guard<std::mutex> lock(m_mutex);
+        field = m_field;
+        pred = m_current_loc;
+        init_counter = m_init_counter;
+    }
+    if (!field || field->map_name() != pred.map_id) return;
+
+    double t0 = yarp::os::Time::now();
+
+    //the orientations of the search window are split among the worker threads
+    const int n_ang = (int)(m_angular_window / m_angular_step);
+    const int n_orientations = 2 * n_ang + 1;
+    const int n_threads = std::max(1, std::min(m_num_threads, n_orientations));
+    std::vector<double> best_score(n_threads, -1.0);
+    std::vector<int> best_ix(n_threads, 0);
+    std::vector<int> best_iy(n_threads, 0);
+    std::vector<int> best_it(n_threads, n_ang);
+    m_workers.run(n_threads, [&](size_t w)
+    {
+        int t_begin = n_orientations * (int)w / n_threads;
+        int t_end = n_orientations * ((int)w + 1) / n_threads;
+        searchOrientations(*field, pred, t_begin, t_end, best_score[w], best_ix[w], best_iy[w], best_it[w]);
+    });
+
+    int best = 0;
+    for (int w = 1; w < n_threads; w++)
+    {
+        if (best_score[w] > best_score[best]) best = w;
+    }
+
+    m_stat_matches++;
+    m_stat_match_time += yarp::os::Time::now() - t0;
+    m_last_score = best_score[best];
+    if (best_score[best] < m_min_score) return;
+
+    //the correction is computed w.r.t. the prediction and applied to the current pose
+    double res = field->resolution();
+    double corr_x = best_ix[best] * res;
+    double corr_y = -best_iy[best] * res;
+    double corr_t = (best_it[best] - n_ang) * m_angular_step;
+
+    lock_guard<std::mutex> lock(m_mutex);
+    if (init_counter != m_init_counter) return;
+    m_current_loc.x += corr_x * m_correction_gain;
+    m_current_loc.y += corr_y * m_correction_gain;
+    m_current_loc.theta += corr_t * m_correction_gain;
+    m_localized = true;
+    m_stat_accepted++;
+}
+
+bool scanMatchLocalizerThread::initializeLocalization(const Map2DLocation& loc)
+{
+    yInfo() << "scanMatchLocalizer: Localization init request: (" << loc.map_id << ")";
+
+    //the likelihood field is rebuilt only when the map changes
+    std::shared_ptr<const likelihood_field> field;
+    {
+        lock_guard<std::mutex> lock(m_mutex);
+        field = m_field;
+    }
+    if (!field || field->map_name() != loc.map_id)
+    {
+        MapGrid2D map;
+        if (m_iMap == 0 || m_iMap->get_map(loc.map_id, map) == false)
+        {
+            yError() << "Map " << loc.map_id << " not found.";
+            return false;
+        }
+        double t0 = yarp::os::Time::now();
+        std::shared_ptr<likelihood_field> new_field(new likelihood_field);
+        if (new_field->build(map, m_likelihood_sigma, m_likelihood_max_dist) == false)
+        {
+            return false;
+        }
+        yInfo() << "Likelihood field of map" << loc.map_id << "computed in" << yarp::os::Time::now() - t0 << "s";
+        field = new_field;
+    }
+
+    lock_guard<std::mutex> lock(m_mutex);
+    if (m_current_loc.map_id != loc.map_id)
+    {
+        yInfo() << "Map changed from: " << m_current_loc.map_id << " to: " << loc.map_id;
+    }
+    m_field = field;
+    m_current_loc = loc;
+    m_pose_buffer.clear();
+    m_localized = false;
+    m_init_counter++;
+    return true;
+}
+
+bool scanMatchLocalizerThread::getCurrentLoc(Map2DLocation& loc)
+{
+    lock_guard<std::mutex> lock(m_mutex);
+    loc = m_current_loc;
+    return true;
+}
+
+bool scanMatchLocalizerThread::getCurrentLoc(Map2DLocation& loc, yarp::sig::Matrix& cov)
+{
+    lock_guard<std::mutex> lock(m_mutex);
+    loc = m_current_loc;
+
+    //the uncertainty is the resolution of the search if the scan is matched, the size of the search window otherwise
+    double res = m_field ? m_field->resolution() : 0.05;
+    double sx = m_localized ? res * m_linear_step : m_linear_window;
+    double st = m_localized ? m_angular_step : m_angular_window;
+    cov.resize(3, 3);
+    cov.zero();
+    cov(0, 0) = sx * sx;
+    cov(1, 1) = sx * sx;
+    cov(2, 2) = st * st;
+    return true;
+}
+
+bool scanMatchLocalizerThread::isLocalized()
+{
+    lock_guard<std::mutex> lock(m_mutex);
+    return m_localized;
+}
+
+void scanMatchLocalizerThread::enable(bool val)
+{
+    m_enabled = val;
+}
+
+bool scanMatchLocalizerThread::threadInit()
+{
+    //configuration file checking
+    Bottle general_group = m_cfg.findGroup("GENERAL");
+    if (general_group.isNull())
+    {
+        yError() << "Missing GENERAL group!";
+        return false;
+    }
+
+    Bottle initial_group = m_cfg.findGroup("INITIAL_POS");
+    if (initial_group.isNull())
+    {
+        yError() << "Missing INITIAL_POS group!";
+        return false;
+    }
+
+    Bottle odometry_group = m_cfg.findGroup("ODOMETRY");
+    if (odometry_group.isNull())
+    {
+        yError() << "Missing ODOMETRY group!";
+        return false;
+    }
+
+    Bottle laser_group = m_cfg.findGroup("LASER");
+    if (laser_group.isNull())
+    {
+        yError() << "Missing LASER group!";
+        return false;
+    }
+
+    //general group
+    m_local_name = "scanMatchLocalizer";
+    if (general_group.check("local_name")) { m_local_name = general_group.find("local_name").asString();}
+
+    //odometry group
+    if (odometry_group.check("odometry_broadcast_port") == false)
+    {
+        yError() << "Missing `odometry_broadcast_port` in [ODOMETRY] group";
+        return false;
+    }
+    m_port_broadcast_odometry_name = odometry_group.find("odometry_broadcast_port").asString();
+
+    //opens a YARP port to receive odometry data
+    std::string odom_portname = "/" + m_local_name + "/odometry:i";
+    bool b1 = m_port_odometry_input.open(odom_portname.c_str());
+    bool b2 = yarp::os::Network::sync(odom_portname.c_str(), false);
+    bool b3 = yarp::os::Network::connect(m_port_broadcast_odometry_name.c_str(), odom_portname.c_str());
+    if (b1 == false || b2 == false || b3 == false)
+    {
+        yError() << "Unable to initialize odometry port connection from " << m_port_broadcast_odometry_name.c_str() << "to:" << odom_portname.c_str();
+        return false;
+    }
+
+    //map group
+    m_map_server_name = "/mapServer";
+    Bottle map_group = m_cfg.findGroup("MAP");
+    if (map_group.check("mapServer_name")) { m_map_server_name = map_group.find("mapServer_name").asString(); }
+
+    //opens a client to receive the maps from the mapServer
+    Property map_options;
+    map_options.put("device", "map2DClient");
+    map_options.put("local", "/" + m_local_name); //This is just a prefix. map2DClient will complete the port name.
+    map_options.put("remote", m_map_server_name);
+    if (m_pMap.open(map_options) == false)
+    {
+        yError() << "Unable to open mapClient";
+        return false;
+    }
+    m_pMap.view(m_iMap);
+    if (m_pMap.isValid() == false || m_iMap == 0)
+    {
+        yError() << "Unable to view map interface";
+        return false;
+    }
+
+    //laser group
+    if (laser_group.check("laser_port") == false)
+    {
+        yError() << "Missing `laser_port` in [LASER] group";
+        return false;
+    }
+    std::string laser_remote_port = laser_group.find("laser_port").asString();
+    if (laser_group.check("laser_pos_x"))     { m_laser_pos_x = laser_group.find("laser_pos_x").asDouble(); }
+    if (laser_group.check("laser_pos_y"))     { m_laser_pos_y = laser_group.find("laser_pos_y").asDouble(); }
+    if (laser_group.check("laser_pos_theta")) { m_laser_pos_t = laser_group.find("laser_pos_theta").asDouble(); }
+    if (laser_group.check("max_range"))       { m_max_range = laser_group.find("max_range").asDouble(); }
+    if (laser_group.check("max_points"))      { m_max_points = laser_group.find("max_points").asInt(); }
+    if (m_max_points == 0)
+    {
+        yError() << "Invalid `max_points` in [LASER] group";
+        return false;
+    }
+
+    Property las_options;
+    las_options.put("device", "Rangefinder2DClient");
+    las_options.put("local", "/" + m_local_name + "/laser:i");
+    las_options.put("remote", laser_remote_port);
+    if (m_pLas.open(las_options) == false)
+    {
+        yError() << "Unable to open laser driver";
+        return false;
+    }
+    m_pLas.view(m_iLaser);
+    if (m_iLaser == 0)
+    {
+        yError() << "Unable to open laser interface";
+        return false;
+    }
+    m_pLas.view(m_iLaserTimed);
+    if (m_iLaserTimed == 0)
+    {
+        yWarning() << "Laser timestamps not available, scans will be matched every 0.1s";
+    }
+
+    //scan matching group
+    Bottle matching_group = m_cfg.findGroup("SCAN_MATCHING");
+    if (matching_group.check("linear_window"))       { m_linear_window = matching_group.find("linear_window").asDouble(); }
+    if (matching_group.check("angular_window"))      { m_angular_window = matching_group.find("angular_window").asDouble(); }
+    if (matching_group.check("linear_step"))         { m_linear_step = matching_group.find("linear_step").asInt(); }
+    if (matching_group.check("angular_step"))        { m_angular_step = matching_group.find("angular_step").asDouble(); }
+    if (matching_group.check("likelihood_sigma"))    { m_likelihood_sigma = matching_group.find("likelihood_sigma").asDouble(); }
+    if (matching_group.check("likelihood_max_dist")) { m_likelihood_max_dist = matching_group.find("likelihood_max_dist").asDouble(); }
+    if (matching_group.check("min_score"))           { m_min_score = matching_group.find("min_score").asDouble(); }
+    if (matching_group.check("correction_gain"))     { m_correction_gain = matching_group.find("correction_gain").asDouble(); }
+    if (matching_group.check("num_threads"))         { m_num_threads = matching_group.find("num_threads").asInt(); }
+    if (m_linear_step <= 0 || m_angular_step <= 0 || m_linear_window < 0 || m_angular_window < 0 || m_likelihood_sigma <= 0 || m_num_threads <= 0)
+    {
+        yError() << "Invalid parameters in [SCAN_MATCHING] group";
+        return false;
+    }
+    //the threads of the scan matching are created once, matchScan() reuses them at every scan
+    m_workers.start(m_num_threads);
+
+    //initial location initialization
+    Map2DLocation tmp_loc;
+    if (initial_group.check("initial_x")) { tmp_loc.x = initial_group.find("initial_x").asDouble(); }
+    else { yError() << "missing initial_x param"; return false; }
+    if (initial_group.check("initial_y")) { tmp_loc.y = initial_group.find("initial_y").asDouble(); }
+    else { yError() << "missing initial_y param"; return false; }
+    if (initial_group.check("initial_theta")) { tmp_loc.theta = initial_group.find("initial_theta").asDouble(); }
+    else { yError() << "missing initial_theta param"; return false; }
+    if (initial_group.check("initial_map")) { tmp_loc.map_id = initial_group.find("initial_map").asString(); }
+    else { yError() << "missing initial_map param"; return false; }
+    if (this->initializeLocalization(tmp_loc) == false)
+    {
+        yError() << "Unable to initialize the localization on map" << tmp_loc.map_id;
+        return false;
+    }
+
+    return true;
+}
+
+void scanMatchLocalizerThread::threadRelease()
+{
+    m_workers.stop();
+    m_port_odometry_input.interrupt();
+    m_port_odometry_input.close();
+    if (m_pLas.isValid()) m_pLas.close();
+    if (m_pMap.isValid()) m_pMap.close();
+}
+
+
+bool scanMatchLocalizer::open(yarp::os::Searchable& config)
+{
+    yDebug() << "config configuration: \n" << config.toString().c_str();
+
+    std::string context_name = "scanMatchLocalizer";
+    std::string file_name = "scanMatchLocalizer.ini";
+
+    if (config.check("context"))   context_name = config.find("context").asString();
+    if (config.check("from")) file_name = config.find("from").asString();
+
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultContext(context_name.c_str());
+    rf.setDefaultConfigFile(file_name.c_str());
+
+    Property p;
+    std::string configFile = rf.findFile("from");
+    if (configFile != "") p.fromConfigFile(configFile.c_str());
+    yDebug() << "scanMatchLocalizer configuration: \n" << p.toString().c_str();
+
+    thread = new scanMatchLocalizerThread(0.010, p);
+
+    if (!thread->start())
+    {
+        delete thread;
+        thread = NULL;
+        return false;
+    }
+
+    std::string local_name = "scanMatchLocalizer";
+    Bottle general_group = p.findGroup("GENERAL");
+    if (general_group.isNull()==false)
+    {
+        if (general_group.check("local_name")) { local_name = general_group.find("local_name").asString(); }
+    }
+    bool ret = rpcPort.open("/"+local_name+"/rpc");
+    if (ret == false)
+    {
+        yError() << "Unable to open module ports";
+        return false;
+    }
+
+    rpcPortHandler.setInterface(this);
+    rpcPort.setReader(rpcPortHandler);
+
+    return true;
+}
+
+scanMatchLocalizer::scanMatchLocalizer()
+{
+    thread = NULL;
+}
+
+scanMatchLocalizer::~scanMatchLocalizer()
+{
+    if (thread)
+    {
+        delete thread;
+        thread = NULL;
+    }
+}
+
+bool scanMatchLocalizer::close()
+{
+    if (thread)
+    {
+        thread->stop();
+    }
+    rpcPort.interrupt();
+    rpcPort.close();
+    return true;
+}
+
+bool   scanMatchLocalizer::getCurrentPosition(Map2DLocation& loc, yarp::sig::Matrix& cov)
+{
+    return thread->getCurrentLoc(loc, cov);
+}
+
+bool   scanMatchLocalizer::setInitialPose(const Map2DLocation& loc, const yarp::sig::Matrix& cov)
+{
+    yWarning() << "Covariance matrix is not currently handled by scanMatchLocalizer";
+    return thread->initializeLocalization(loc);
+}
+
+bool    scanMatchLocalizer::startLocalizationService()
+{
+    thread->enable(true);
+    return true;
+}
+
+bool    scanMatchLocalizer::stopLocalizationService()
+{
+    thread->enable(false);
+    return true;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C)2019  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Port.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/dev/INavigation2D.h>
+#include <yarp/dev/IMap2D.h>
+#include <yarp/dev/IRangefinder2D.h>
+#include <yarp/dev/PreciselyTimed.h>
+#include <yarp/dev/OdometryData.h>
+#include <yarp/os/PeriodicThread.h>
+#include <likelihood_field.h>
+#include <pose_buffer.h>
+#include <worker_pool.h>
+#include <memory>
+#include <mutex>
+#include <math.h>
+
+using namespace yarp::os;
+
+/**
+ * \section scanMatchLocalizer
+ * A localization device which can be wrapped by a Localization2DServer.
+ * The pose is propagated with the odometry data (as done by odomLocalizer) and the odometry drift is corrected by
+ * matching the laser scans against the current map. The map is converted in a likelihood field when it is loaded,
+ * then each scan is aligned with a correlative search over a (x, y, theta) window centered on the odometry prediction.
+ * The orientations of the window are evaluated in parallel by `num_threads` worker threads.
+ *
+ *  Parameters required by this device are:
+ * | Parameter name | SubParameter       | Type    | Units  | Default Value      | Required | Description                                                       | Notes |
+ * |:--------------:|:------------------:|:-------:|:------:|:------------------:|:--------:|:-----------------------------------------------------------------:|:-----:|
+ * | GENERAL        |  local_name        | string  | -      | scanMatchLocalizer | No       | The name of the module use to open ports                          |       |
+ * | INITIAL_POS    |  initial_x         | double  | m      | 0.0                | Yes      | Initial estimation of robot position                              | -     |
+ * | INITIAL_POS    |  initial_y         | double  | m      | 0.0                | Yes      | Initial estimation of robot position                              | -     |
+ * | INITIAL_POS    |  initial_theta     | double  | deg    | 0.0                | Yes      | Initial estimation of robot position                              | -     |
+ * | INITIAL_POS    |  initial_map       | string  | -      |   -                | Yes      | Name of the map on which localization is performed                | -     |
+ * | ODOMETRY       |  odometry_broadcast_port | string | - |   -                | Yes      | Full name of port broadcasting the odometry data. The device will connect to this port. | - |
+ * | MAP            |  mapServer_name    | string  | -      | /mapServer         | No       | Full name of the map server                                       | -     |
+ * | LASER          |  laser_port        | string  | -      |   -                | Yes      | Full name of the port broadcasting the laser scans                | -     |
+ * | LASER          |  laser_pos_x       | double  | m      | 0.0                | No       | Position of the laser w.r.t. the robot frame                      | -     |
+ * | LASER          |  laser_pos_y       | double  | m      | 0.0                | No       | Position of the laser w.r.t. the robot frame                      | -     |
+ * | LASER          |  laser_pos_theta   | double  | deg    | 0.0                | No       | Orientation of the laser w.r.t. the robot frame                   | -     |
+ * | LASER          |  max_range         | double  | m      | 10.0               | No       | Laser measurements beyond this distance are discarded             | -     |
+ * | LASER          |  max_points        | int     | -      | 180                | No       | The scan is decimated to this number of points before matching    | -     |
+ * | SCAN_MATCHING  |  linear_window     | double  | m      | 0.3                | No       | Half size of the translational search window                      | -     |
+ * | SCAN_MATCHING  |  angular_window    | double  | deg    | 10.0               | No       | Half size of the rotational search window                         | -     |
+ * | SCAN_MATCHING  |  linear_step       | int     | cells  | 1                  | No       | Step of the translational search                                  | -     |
+ * | SCAN_MATCHING  |  angular_step      | double  | deg    | 1.0                | No       | Step of the rotational search                                     | -     |
+ * | SCAN_MATCHING  |  likelihood_sigma  | double  | m      | 0.1                | No       | Standard deviation of the laser measurement noise                 | -     |
+ * | SCAN_MATCHING  |  likelihood_max_dist | double | m     | 0.5                | No       | Maximum distance from an obstacle considered by the likelihood field | - |
+ * | SCAN_MATCHING  |  min_score         | double  | -      | 0.4                | No       | Minimum average likelihood (0-1) required to accept a match       | -     |
+ * | SCAN_MATCHING  |  correction_gain   | double  | -      | 1.0                | No       | Fraction of the correction applied to the current pose (0-1)      | -     |
+ * | SCAN_MATCHING  |  num_threads       | int     | -      | 4                  | No       | Number of threads used by the correlative search                  | -     |
+ */
+
+class scanMatchLocalizer;
+class scanMatchLocalizerThread;
+
+class scanMatchLocalizerRPCHandler : public yarp::dev::DeviceResponder
+{
+protected:
+    scanMatchLocalizer * interface;
+    bool respond(const yarp::os::Bottle& cmd, yarp::os::Bottle& response) override;
+
+public:
+    scanMatchLocalizerRPCHandler() : interface(NULL) { }
+    void setInterface(scanMatchLocalizer* iface);
+};
+
+class scanMatchLocalizer : public yarp::dev::DeviceDriver,
+                           public yarp::dev::ILocalization2D
+{
+public:
+    scanMatchLocalizerThread*    thread;
+    scanMatchLocalizerRPCHandler rpcPortHandler;
+    yarp::os::Port               rpcPort;
+
+public:
+    virtual bool open(yarp::os::Searchable& config) override;
+
+    scanMatchLocalizer();
+    virtual ~scanMatchLocalizer();
+
+    virtual bool close() override;
+
+public:
+    /**
+    * Gets the current status of the localization task.
+    * @return true/false
+    */
+    bool   getLocalizationStatus(yarp::dev::LocalizationStatusEnum& status) override;
+
+    /**
+    * Gets a set of pose estimates computed by the localization algorithm.
+    * @return true/false
+    */
+    bool   getEstimatedPoses(std::vector<yarp::dev::Nav2D::Map2DLocation>& poses) override;
+
+    /**
+    * Gets the current position of the robot w.r.t world reference frame
+    * @param loc the location of the robot
+    * @return true/false
+    */
+    bool   getCurrentPosition(yarp::dev::Nav2D::Map2DLocation& loc) override;
+
+    /**
+    * Sets the initial pose for the localization algorithm which estimates the current position of the robot w.r.t world reference frame.
+    * @param loc the location of the robot
+    * @return true/false
+    */
+    bool   setInitialPose(const yarp::dev::Nav2D::Map2DLocation& loc) override;
+
+    /**
+     * Gets the current position of the robot w.r.t world reference frame, plus the covariance
+     * @param loc the location of the robot
+     * @param cov the 3x3 covariance matrix
+     * @return true/false
+     */
+    bool   getCurrentPosition(yarp::dev::Nav2D::Map2DLocation& loc, yarp::sig::Matrix& cov) override;
+
+    /**
+    * Sets the initial pose for the localization algorithm which estimates the current position of the robot w.r.t world reference frame.
+    * @param loc the location of the robot
+    * @param cov the 3x3 covariance matrix
+    * @return true/false
+    */
+    bool   setInitialPose(const yarp::dev::Nav2D::Map2DLocation& loc, const yarp::sig::Matrix& cov) override;
+
+    /**
+    * Starts the localization service
+    * @return true/false
+    */
+    bool   startLocalizationService() override;
+
+    /**
+    * Stops the localization service
+    * @return true/false
+    */
+    bool   stopLocalizationService() override;
+};
+
+class scanMatchLocalizerThread : public yarp::os::PeriodicThread
+{
+protected:
+    //general
+    double                       m_last_statistics_printed;
+    yarp::dev::Nav2D::Map2DLocation     m_current_loc;
+    yarp::dev::Nav2D::Map2DLocation     m_last_odom;
+    bool                         m_odom_received;
+    std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
+    yarp::os::Searchable&        m_cfg;
+    std::string                  m_local_name;
+    bool                         m_enabled;
+    size_t                       m_init_counter;
+
+    //odometry port
+    std::string                  m_port_broadcast_odometry_name;
+    yarp::os::BufferedPort<yarp::dev::OdometryData>  m_port_odometry_input;
+    double                       m_last_odometry_data_received;
+
+    //map
+    std::string                  m_map_server_name;
+    yarp::dev::PolyDriver        m_pMap;
+    yarp::dev::Nav2D::IMap2D*    m_iMap;
+    std::shared_ptr<const likelihood_field> m_field;
+
+    //laser
+    yarp::dev::PolyDriver        m_pLas;
+    yarp::dev::IRangefinder2D*   m_iLaser;
+    yarp::dev::IPreciselyTimed*  m_iLaserTimed;
+    double                       m_last_scan_stamp;
+    double                       m_laser_pos_x;
+    double                       m_laser_pos_y;
+    double                       m_laser_pos_t;
+    double                       m_max_range;
+    size_t                       m_max_points;
+    std::vector<double>          m_scan_x;
+    std::vector<double>          m_scan_y;
+
+    //scan matching parameters
+    double                       m_linear_window;
+    double                       m_angular_window;
+    int                          m_linear_step;
+    double                       m_angular_step;
+    double                       m_likelihood_sigma;
+    double                       m_likelihood_max_dist;
+    double                       m_min_score;
+    double                       m_correction_gain;
+    int                          m_num_threads;
+    worker_pool                  m_workers;
+
+    //scan matching status/statistics
+    bool                         m_localized;
+    double                       m_last_score;
+    size_t                       m_stat_matches;
+    size_t                       m_stat_accepted;
+    double                       m_stat_match_time;
+
+public:
+    scanMatchLocalizerThread(const double _period, yarp::os::Searchable& _cfg);
+    virtual bool threadInit() override;
+    virtual void threadRelease() override;
+    virtual void run() override;
+
+public:
+    bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc);
+    bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
+    bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc, yarp::sig::Matrix& cov);
+    bool isLocalized();
+    void enable(bool val);
+
+private:
+    void updateOdometry();
+    bool readScan();
+    void matchScan();
+    void searchOrientations(const likelihood_field& field, const yarp::dev::Nav2D::Map2DLocation& pred, int t_begin, int t_end,
+                            double& best_score, int& best_ix, int& best_iy, int& best_it) const;
+};
@@ -45,6 +45,10 @@ void t265LocalizerRPCHandler::setInterface(t265Localizer* iface)
 bool t265LocalizerRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
 {
     reply.clear();
+    if (interface->thread && interface->thread->getPoseBuffer().respond(command, reply))
+    {
+        return true;
+    }
     reply.addVocab(Vocab::encode("many"));
     reply.addString("Not yet Implemented");
     return true;
@@ -200,6 +204,7 @@ void t265LocalizerThread::run()
 
     if (m_current_loc.theta >= +360) m_current_loc.theta -= 360;
     else if (m_current_loc.theta <= -360) m_current_loc.theta += 360;
+    m_pose_buffer.add_pose(current_time, m_current_loc);
 }
 
 bool t265LocalizerThread::initializeLocalization(const Map2DLocation& loc)
@@ -213,6 +218,7 @@ bool t265LocalizerThread::initializeLocalization(const Map2DLocation& loc)
     m_initial_device_data.x = m_current_device_data.x;
     m_initial_device_data.y = m_current_device_data.y;
     m_initial_device_data.theta = m_current_device_data.theta;
+    m_pose_buffer.clear();
 
     if (m_current_loc.map_id != m_initial_loc.map_id)
     {
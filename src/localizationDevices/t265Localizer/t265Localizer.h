@@ -21,6 +21,7 @@
 #include <yarp/os/PeriodicThread.h>
 #include <math.h>
 #include <mutex>
+#include <pose_buffer.h>
 #include <yarp/dev/IMap2D.h>
 #include <movable_localization_device.h>
 
@@ -140,6 +141,7 @@ protected:
     double                       m_last_statistics_printed;
     yarp::dev::Nav2D::Map2DLocation     m_map_to_device_transform;
     std::mutex                   m_mutex;
+    pose_buffer                  m_pose_buffer;
     yarp::os::Searchable&        m_cfg;
     std::string                  m_local_name;
     std::string                  m_local_name_prefix;
@@ -171,6 +173,7 @@ public:
 public:
     bool initializeLocalization(const yarp::dev::Nav2D::Map2DLocation& loc);
     bool getCurrentLoc(yarp::dev::Nav2D::Map2DLocation& loc);
+    const pose_buffer& getPoseBuffer() const { return m_pose_buffer; }
     void odometry_update();
 };
 
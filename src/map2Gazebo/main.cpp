@@ -27,12 +27,16 @@
 #include <iostream>
 #include <algorithm>
 #include <yarp/sig/ImageFile.h>
+#include "tiledHeightmap.h"
+#include "map_file.h"
 
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::dev;
 using namespace yarp::dev::Nav2D;
 
+const int MAX_THREADS = 256;
+
 class map2GazeboModule : public yarp::os::RFModule
 {
 protected:
@@ -43,6 +47,9 @@ protected:
     double                       m_ceiling;
     double                       m_floor_c;
     bool                         m_crop;
+    bool                         m_incremental;
+    size_t                       m_tile_size;
+    size_t                       m_num_threads;
     
     string model_file_string =  "\
     <?xml version=\"1.0\"?> \n \
@@ -127,6 +134,9 @@ public:
         m_ceiling = 3.0; //m
         m_floor_c = 50; //units (0-255)
         m_crop = false;
+        m_incremental = false;
+        m_tile_size = 256;
+        m_num_threads = 0; //as many as the cores
     }
 
     void replace(const string& find_str, string& sdf_str, double val)
@@ -161,11 +171,52 @@ public:
 			m_crop = true;
 			yInfo() << "crop option enabled";
 		}
+
+        if (rf.check("tile_size"))
+        {
+            int tile_size = rf.find("tile_size").asInt32();
+            if (tile_size <= 0)
+            {
+                yError() << "tile_size must be positive";
+                return false;
+            }
+            m_tile_size = tile_size;
+            yInfo() << "Using tile_size =" << m_tile_size << "cells";
+        }
+
+        if (rf.check("threads"))
+        {
+            int num_threads = rf.find("threads").asInt32();
+            if (num_threads <= 0 || num_threads > MAX_THREADS)
+            {
+                yError() << "threads must be between 1 and" << MAX_THREADS;
+                return false;
+            }
+            m_num_threads = num_threads;
+            yInfo() << "Using" << m_num_threads << "threads";
+        }
+
+        if (rf.check("incremental"))
+        {
+            m_incremental = true;
+            yInfo() << "incremental option enabled";
+        }
 		
         if (rf.check("from_file"))
         {
             string map_name = rf.find("from_file").asString();
-            if (m_yarp_map.loadFromFile(map_name) == false)
+            bool is_navmap = map_name.size() > 7 && map_name.compare(map_name.size() - 7, 7, ".navmap") == 0;
+            if (is_navmap)
+            {
+                //the compact binary format, see mapFileConverter
+                map_file file;
+                if (file.open(map_name) == false || file.to_map(m_yarp_map) == false)
+                {
+                    yError() << "Failed to open map: " << map_name;
+                    return false;
+                }
+            }
+            else if (m_yarp_map.loadFromFile(map_name) == false)
             {
                 yError() << "Failed to open map: " << map_name;
                 return false;
@@ -233,15 +284,7 @@ public:
 		}       
 
         //heightmaps in gazebo must be square, with size n^2+1. 
-        size_t map_size = std::max(w, h);
-        map_size--;
-        map_size |= map_size >> 1;
-        map_size |= map_size >> 2;
-        map_size |= map_size >> 4;
-        map_size |= map_size >> 8;
-        map_size |= map_size >> 16;
-        map_size++;
-        map_size++;
+        size_t map_size = tiledHeightmap::heightmapSize(w, h);
         yInfo() << "Heightmap size (cells)" << map_size << "x" << map_size;
         yInfo() << "Heightmap size (m)" << map_size*r << "x" << map_size*r;
         double x_off =map_size*r-w*r;
@@ -249,64 +292,36 @@ public:
         yDebug() << "Computed offset" << x_off << "," << y_off << "(m)";
         
 
-        //heightmap color code is the following: black=bottom, white=top
-        MapGrid2D::map_flags flag;
-        XYCell cell;
+        //the map is converted in parallel tiles. In incremental mode, only the tiles changed since the previous export are drawn again.
+        tiledHeightmap converter(m_tile_size, m_num_threads);
         yarp::sig::ImageOf<yarp::sig::PixelMono> heightmap;
-        heightmap.setQuantum(1);
-        heightmap.resize(map_size, map_size);
-        
-        //prepare an empty heightmap
-        for (cell.y = 0; cell.y < map_size; cell.y++)
-            for (cell.x = 0; cell.x < map_size; cell.x++)
-            {
-                heightmap.safePixel(cell.x, cell.y) = 0;
-            }
-        
-        int align = 1;
-        yDebug() << "Alignment type:" << align;
-        for (cell.y=0; cell.y<h; cell.y++)
-            for (cell.x=0; cell.x < w; cell.x++)
+        bool reuse = false;
+        if (m_incremental && converter.loadHashes("heightmap.tiles"))
+        {
+            reuse = yarp::sig::file::read(heightmap, "heightmap.png") && converter.canReuse(m_yarp_map, (int)m_floor_c, heightmap);
+            if (!reuse)
             {
-                m_yarp_map.getMapFlag(cell, flag);
-                size_t computed_x = 0;
-                size_t computed_y = 0;
-                switch (align)
-                {
-                     case 0:
-                    //align top-left
-                    computed_x = cell.x;
-                    computed_y = cell.y;
-                    break;
-
-                    case 1:
-                    default:
-                    //align center
-                    computed_x = cell.x + (map_size - w) / 2;
-                    computed_y = cell.y + (map_size - h) / 2;
-                    break;
-                }
-                switch (flag)
-                {
-                    case MapGrid2D::map_flags::MAP_CELL_WALL:
-                    {
-                        heightmap.safePixel(computed_x, computed_y) = 255;
-                    } break;
-                    case MapGrid2D::map_flags::MAP_CELL_UNKNOWN:
-                    {
-                        heightmap.safePixel(computed_x, computed_y) = 0;
-                    } break;
-                    case MapGrid2D::map_flags::MAP_CELL_FREE:
-                    default:
-                    {
-                        heightmap.safePixel(computed_x, computed_y) = m_floor_c;
-                    } break;
-                }
+                yInfo() << "The previous heightmap does not match the map, it will be regenerated";
             }
+        }
+        double t_start = yarp::os::Time::now();
+        size_t drawn = converter.convert(m_yarp_map, (int)m_floor_c, heightmap, reuse);
+        yInfo() << "Heightmap converted in" << yarp::os::Time::now() - t_start << "s:" << drawn << "of" << converter.numTiles() << "tiles drawn";
 
         //save the heightmap to disk
-        yarp::sig::file::write(heightmap, "heightmap.png",yarp::sig::file::FORMAT_PNG);
-        yInfo() << "File " << "heightmap.png" << "saved.";
+        if (drawn > 0 || !reuse)
+        {
+            yarp::sig::file::write(heightmap, "heightmap.png",yarp::sig::file::FORMAT_PNG);
+            yInfo() << "File " << "heightmap.png" << "saved.";
+        }
+        else
+        {
+            yInfo() << "The map is not changed, heightmap.png is up to date";
+        }
+        if (m_incremental)
+        {
+            converter.saveHashes("heightmap.tiles");
+        }
 
         //process the sdf template
         size_t pos = 0;
@@ -403,9 +418,12 @@ int main(int argc, char *argv[])
     {
         yInfo() << "Options:";
         yInfo() << "--from_server <map_id>";
-        yInfo() << "--from_file <file.map>";
+        yInfo() << "--from_file <file.map | file.navmap>";
         yInfo() << "--ceiling <meters>";
         yInfo() << "--crop";
+        yInfo() << "--tile_size <cells>";
+        yInfo() << "--threads <number>";
+        yInfo() << "--incremental (redraws only the tiles changed since the previous export)";
         return 0;
     }
 
@@ -0,0 +1,207 @@
+/*
+* Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+* All rights reserved.
+* Author: Marco Randazzo
+* email:  marco.randazzo@iit.it
+
+* This software may be modified and distributed under the terms of the
+* BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+#include "tiledHeightmap.h"
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace yarp::dev::Nav2D;
+
+tiledHeightmap::tiledHeightmap(size_t tile_size, size_t num_threads)
+{
+    m_tile_size = (tile_size > 0) ? tile_size : 256;
+    m_num_threads = num_threads;
+    if (m_num_threads == 0) m_num_threads = std::thread::hardware_concurrency();
+    if (m_num_threads == 0) m_num_threads = 1;
+    m_map_w = 0;
+    m_map_h = 0;
+    m_heightmap_size = 0;
+    m_floor_c = 0;
+}
+
+size_t tiledHeightmap::heightmapSize(size_t w, size_t h)
+{
+    //heightmaps in gazebo must be square, with size 2^n+1.
+    size_t map_size = std::max(w, h);
+    map_size--;
+    map_size |= map_size >> 1;
+    map_size |= map_size >> 2;
+    map_size |= map_size >> 4;
+    map_size |= map_size >> 8;
+    map_size |= map_size >> 16;
+    map_size++;
+    map_size++;
+    return map_size;
+}
+
+bool tiledHeightmap::canReuse(const MapGrid2D& map, int floor_c, const yarp::sig::ImageOf<yarp::sig::PixelMono>& heightmap) const
+{
+    size_t size = heightmapSize(map.width(), map.height());
+    return m_hashes.empty() == false &&
+           m_map_w == map.width() &&
+           m_map_h == map.height() &&
+           m_floor_c == floor_c &&
+           m_heightmap_size == size &&
+           heightmap.width() == size &&
+           heightmap.height() == size;
+}
+
+size_t tiledHeightmap::convert(const MapGrid2D& map, int floor_c, yarp::sig::ImageOf<yarp::sig::PixelMono>& heightmap, bool reuse)
+{
+    size_t w = map.width();
+    size_t h = map.height();
+    size_t size = heightmapSize(w, h);
+    size_t tiles_x = (w + m_tile_size - 1) / m_tile_size;
+    size_t tiles_y = (h + m_tile_size - 1) / m_tile_size;
+
+    if (!reuse)
+    {
+        //prepare an empty heightmap
+        heightmap.setQuantum(1);
+        heightmap.resize(size, size);
+        for (size_t y = 0; y < size; y++)
+        {
+            memset(heightmap.getRow(y), 0, size);
+        }
+        m_hashes.assign(tiles_x * tiles_y, 0);
+    }
+
+    //each thread takes the next tile to process
+    std::atomic<size_t> next_tile(0);
+    std::vector<size_t> drawn(m_num_threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < m_num_threads; i++)
+    {
+        workers.push_back(std::thread(&tiledHeightmap::processTiles, this, std::cref(map), (unsigned char)floor_c, std::ref(heightmap),
+                                      reuse, std::ref(next_tile), std::ref(drawn[i])));
+    }
+    processTiles(map, (unsigned char)floor_c, heightmap, reuse, next_tile, drawn[0]);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    m_map_w = w;
+    m_map_h = h;
+    m_heightmap_size = size;
+    m_floor_c = floor_c;
+
+    size_t total = 0;
+    for (size_t i = 0; i < drawn.size(); i++) total += drawn[i];
+    return total;
+}
+
+void tiledHeightmap::processTiles(const MapGrid2D& map, unsigned char floor_c, yarp::sig::ImageOf<yarp::sig::PixelMono>& heightmap,
+                                  bool reuse, std::atomic<size_t>& next_tile, size_t& drawn)
+{
+    size_t w = map.width();
+    size_t h = map.height();
+    size_t size = heightmap.width();
+    size_t tiles_x = (w + m_tile_size - 1) / m_tile_size;
+    //align center
+    size_t off_x = (size - w) / 2;
+    size_t off_y = (size - h) / 2;
+
+    std::vector<unsigned char> values(m_tile_size * m_tile_size);
+    for (size_t t = next_tile++; t < m_hashes.size(); t = next_tile++)
+    {
+        size_t x0 = (t % tiles_x) * m_tile_size;
+        size_t y0 = (t / tiles_x) * m_tile_size;
+        size_t x1 = std::min(x0 + m_tile_size, w);
+        size_t y1 = std::min(y0 + m_tile_size, h);
+
+        //heightmap color code is the following: black=bottom, white=top
+        uint64_t hash = 14695981039346656037ULL;
+        size_t i = 0;
+        XYCell cell;
+        for (cell.y = y0; cell.y < y1; cell.y++)
+        {
+            for (cell.x = x0; cell.x < x1; cell.x++, i++)
+            {
+                MapGrid2D::map_flags flag;
+                map.getMapFlag(cell, flag);
+                unsigned char v;
+                switch (flag)
+                {
+                    case MapGrid2D::map_flags::MAP_CELL_WALL:    v = 255; break;
+                    case MapGrid2D::map_flags::MAP_CELL_UNKNOWN: v = 0; break;
+                    case MapGrid2D::map_flags::MAP_CELL_FREE:
+                    default:                                     v = floor_c; break;
+                }
+                values[i] = v;
+                hash = (hash ^ v) * 1099511628211ULL;
+            }
+        }
+
+        if (reuse && m_hashes[t] == hash)
+        {
+            continue;
+        }
+        m_hashes[t] = hash;
+
+        size_t tile_w = x1 - x0;
+        for (size_t y = y0; y < y1; y++)
+        {
+            memcpy(heightmap.getRow(y + off_y) + x0 + off_x, &values[(y - y0) * tile_w], tile_w);
+        }
+        drawn++;
+    }
+}
+
+bool tiledHeightmap::loadHashes(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in.is_open())
+    {
+        return false;
+    }
+    std::string magic;
+    size_t tile_size = 0, num_tiles = 0;
+    in >> magic >> m_map_w >> m_map_h >> m_heightmap_size >> tile_size >> m_floor_c >> num_tiles;
+    if (!in || magic != "tiledHeightmap" || tile_size != m_tile_size)
+    {
+        yWarning() << "tiledHeightmap: the tiles of" << filename << "can not be reused";
+        m_hashes.clear();
+        return false;
+    }
+    m_hashes.resize(num_tiles);
+    for (size_t i = 0; i < num_tiles; i++)
+    {
+        in >> std::hex >> m_hashes[i];
+    }
+    if (!in)
+    {
+        yWarning() << "tiledHeightmap: invalid file" << filename;
+        m_hashes.clear();
+        return false;
+    }
+    return true;
+}
+
+bool tiledHeightmap::saveHashes(const std::string& filename) const
+{
+    std::ofstream out(filename);
+    if (!out.is_open())
+    {
+        yError() << "tiledHeightmap: unable to write" << filename;
+        return false;
+    }
+    out << "tiledHeightmap " << m_map_w << " " << m_map_h << " " << m_heightmap_size << " " << m_tile_size << " " << m_floor_c << " " << m_hashes.size() << "\n";
+    out << std::hex;
+    for (size_t i = 0; i < m_hashes.size(); i++)
+    {
+        out << m_hashes[i] << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+* Copyright (C) 2006-2018 Istituto Italiano di Tecnologia (IIT)
+* All rights reserved.
+* Author: Marco Randazzo
+* email:  marco.randazzo@iit.it
+
+* This software may be modified and distributed under the terms of the
+* BSD-3-Clause license. See the accompanying LICENSE file for details.
+*/
+
+#ifndef TILED_HEIGHTMAP_H
+#define TILED_HEIGHTMAP_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/sig/Image.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * Converts a MapGrid2D into a gazebo heightmap (square, (2^n+1)x(2^n+1) pixels, map centered).
+ * The map is split in tiles of tile_size x tile_size cells which are converted in parallel by num_threads threads.
+ * For each tile a hash of the cell flags is computed: if the hashes of a previous export are available (see loadHashes())
+ * and the previous heightmap is provided, only the tiles whose hash changed are drawn again.
+ */
+class tiledHeightmap
+{
+    size_t                   m_tile_size;
+    size_t                   m_num_threads;
+
+    //identifies the export to which the hashes refer
+    size_t                   m_map_w;
+    size_t                   m_map_h;
+    size_t                   m_heightmap_size;
+    int                      m_floor_c;
+    std::vector<uint64_t>    m_hashes;
+
+public:
+    tiledHeightmap(size_t tile_size = 256, size_t num_threads = 0);
+
+    /**
+    * Computes the size of the heightmap required by a map of w x h cells.
+    */
+    static size_t heightmapSize(size_t w, size_t h);
+
+    /**
+    * Converts the map.
+    * @param map the map to convert
+    * @param floor_c the value of the free cells (0-255)
+    * @param heightmap the heightmap. If reuse is true, it must contain the heightmap of the previous export.
+    * @param reuse if true, the tiles not changed since the previous export are not drawn
+    * @return the number of tiles drawn
+    */
+    size_t convert(const yarp::dev::Nav2D::MapGrid2D& map, int floor_c, yarp::sig::ImageOf<yarp::sig::PixelMono>& heightmap, bool reuse);
+
+    /**
+    * @return true if the hashes loaded by loadHashes() can be used to update the heightmap of the given map
+    */
+    bool canReuse(const yarp::dev::Nav2D::MapGrid2D& map, int floor_c, const yarp::sig::ImageOf<yarp::sig::PixelMono>& heightmap) const;
+
+    bool loadHashes(const std::string& filename);
+    bool saveHashes(const std::string& filename) const;
+
+    size_t numTiles() const { return m_hashes.size(); }
+
+private:
+    void   processTiles(const yarp::dev::Nav2D::MapGrid2D& map, unsigned char floor_c, yarp::sig::ImageOf<yarp::sig::PixelMono>& heightmap,
+                        bool reuse, std::atomic<size_t>& next_tile, size_t& drawn);
+};
+
+#endif
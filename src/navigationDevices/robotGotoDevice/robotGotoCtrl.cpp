@@ -87,6 +87,15 @@ GotoThread::GotoThread(double _period, Searchable &_cfg) :
     m_robot_laser_y = 0;
     m_robot_laser_t = 0;
     m_rosNode = 0;
+    m_tracking_gain_x = 1.0;
+    m_tracking_gain_y = 5.0;
+    m_tracking_gain_theta = 2.0;
+    m_tracking_max_lag = 0.3;
+    m_default_lookahead_distance = m_lookahead_distance = 0.5;
+    m_trajectory_index = 0;
+    m_trajectory_time = 0;
+    m_trajectory_last_update = 0;
+    m_approach_limits_pending = false;
     m_stats_time_curr = yarp::os::Time::now();
     m_stats_time_last = yarp::os::Time::now();
 }
@@ -244,6 +253,11 @@ bool GotoThread::threadInit()
     if (trajectory_group.check("min_ang_speed"))      { m_default_max_ang_speed      = m_min_ang_speed      = trajectory_group.find("min_ang_speed").asDouble(); }
     if (trajectory_group.check("goal_tolerance_lin")) { m_default_goal_tolerance_lin = m_goal_tolerance_lin = trajectory_group.find("goal_tolerance_lin").asDouble(); }
     if (trajectory_group.check("goal_tolerance_ang")) { m_default_goal_tolerance_lin = m_goal_tolerance_ang = trajectory_group.find("goal_tolerance_ang").asDouble(); }
+    if (trajectory_group.check("tracking_gain_x"))    { m_tracking_gain_x     = trajectory_group.find("tracking_gain_x").asDouble(); }
+    if (trajectory_group.check("tracking_gain_y"))    { m_tracking_gain_y     = trajectory_group.find("tracking_gain_y").asDouble(); }
+    if (trajectory_group.check("tracking_gain_theta")) { m_tracking_gain_theta = trajectory_group.find("tracking_gain_theta").asDouble(); }
+    if (trajectory_group.check("tracking_max_lag"))   { m_tracking_max_lag    = trajectory_group.find("tracking_max_lag").asDouble(); }
+    if (trajectory_group.check("lookahead_distance")) { m_default_lookahead_distance = m_lookahead_distance = trajectory_group.find("lookahead_distance").asDouble(); }
 
     Bottle geometry_group = m_cfg.findGroup("ROBOT_GEOMETRY");
     if (geometry_group.isNull())
@@ -742,8 +756,18 @@ void GotoThread::run()
             m_control_out.linear_vel *= speed_ramp;
             m_control_out.angular_vel*= speed_ramp;
 
+            //follow the trajectory, if any. Its last setpoint is then reached as a regular target.
+            if (m_trajectory.empty() == false && trackTrajectory(current_time))
+            {
+                //the control outputs have been computed by trackTrajectory()
+            }
+            //follow the intermediate waypoints, if any. The target is then reached as usual.
+            else if (m_lookahead_path.empty() == false && followPath())
+            {
+                //the control outputs have been computed by followPath()
+            }
             //you are near to goal
-            if (fabs(distance)< m_goal_tolerance_lin)
+            else if (fabs(distance)< m_goal_tolerance_lin)
             {
                 if (m_target_data.weak_angle)
                 {
@@ -894,6 +918,169 @@ void GotoThread::run()
     m_mutex.post();
 }
 
+bool GotoThread::trackTrajectory(double current_time)
+{
+    //the reference time advances with the clock, but it stops when the robot lags behind (e.g. after an obstacle)
+    double dt = std::min(current_time - m_trajectory_last_update, 0.1);
+    m_trajectory_last_update = current_time;
+
+    while (m_trajectory_index + 1 < m_trajectory.size() && m_trajectory[m_trajectory_index + 1].t <= m_trajectory_time)
+    {
+        m_trajectory_index++;
+    }
+    if (m_trajectory_index + 1 >= m_trajectory.size())
+    {
+        m_trajectory.clear();
+        applyApproachLimits();
+        return false;
+    }
+
+    //the reference, interpolated between two setpoints
+    const trajectory_setpoint_type& p0 = m_trajectory[m_trajectory_index];
+    const trajectory_setpoint_type& p1 = m_trajectory[m_trajectory_index + 1];
+    double alpha = (p1.t > p0.t) ? (m_trajectory_time - p0.t) / (p1.t - p0.t) : 1.0;
+    alpha = std::max(0.0, std::min(alpha, 1.0));
+    double ref_x = p0.x + (p1.x - p0.x) * alpha;
+    double ref_y = p0.y + (p1.y - p0.y) * alpha;
+    double ref_theta = p0.theta + normalize_angle(p1.theta - p0.theta) * alpha;
+    double ref_v = p0.lin_vel + (p1.lin_vel - p0.lin_vel) * alpha;
+    double ref_w = p0.ang_vel + (p1.ang_vel - p0.ang_vel) * alpha;
+
+    //the tracking errors, in the robot reference frame
+    double dx = ref_x - m_localization_data.x;
+    double dy = ref_y - m_localization_data.y;
+    double a = m_localization_data.theta * DEG2RAD;
+    double err_x = dx * cos(a) + dy * sin(a);
+    double err_y = -dx * sin(a) + dy * cos(a);
+    double err_theta = normalize_angle(ref_theta - m_localization_data.theta);
+    bool lagging = sqrt(dx * dx + dy * dy) > m_tracking_max_lag;
+
+    if (m_robot_is_holonomic)
+    {
+        //feedforward velocity plus a proportional correction of the position, the heading follows the reference
+        double vx = ref_v * cos(err_theta * DEG2RAD) + m_tracking_gain_x * err_x;
+        double vy = ref_v * sin(err_theta * DEG2RAD) + m_tracking_gain_x * err_y;
+        m_control_out.linear_vel = sqrt(vx * vx + vy * vy);
+        m_control_out.linear_dir = atan2(vy, vx) * RAD2DEG;
+        m_control_out.angular_vel = ref_w + m_gain_ang * err_theta;
+    }
+    else if (fabs(err_theta) > m_beta_angle_threshold)
+    {
+        //the robot is not aligned with the trajectory (e.g. at its start or at a sharp corner): rotate in place
+        m_control_out.linear_vel = 0.0;
+        m_control_out.linear_dir = 0.0;
+        m_control_out.angular_vel = m_gain_ang * err_theta;
+        lagging = true;
+    }
+    else
+    {
+        //Kanayama tracking controller
+        double e_theta = err_theta * DEG2RAD;
+        double v = ref_v * cos(e_theta) + m_tracking_gain_x * err_x;
+        double w = ref_w * DEG2RAD + ref_v * (m_tracking_gain_y * err_y + m_tracking_gain_theta * sin(e_theta));
+        m_control_out.linear_vel = std::max(v, 0.0);
+        m_control_out.linear_dir = 0.0;
+        m_control_out.angular_vel = w * RAD2DEG;
+    }
+
+    if (!lagging)
+    {
+        m_trajectory_time += dt;
+    }
+    return true;
+}
+
+bool GotoThread::followPath()
+{
+    double lookahead = std::max(m_lookahead_distance, m_goal_tolerance_lin);
+    double rx = m_localization_data.x;
+    double ry = m_localization_data.y;
+
+    //the waypoints inside the look-ahead circle have been passed
+    while (m_lookahead_path.empty() == false &&
+           sqrt(pow(m_lookahead_path.front().x - rx, 2) + pow(m_lookahead_path.front().y - ry, 2)) < lookahead)
+    {
+        m_lookahead_segment_start = m_lookahead_path.front();
+        m_lookahead_path.pop_front();
+    }
+    const Map2DLocation& segment_end = m_lookahead_path.empty() ? m_target_data.target : m_lookahead_path.front();
+    double distance_to_end = sqrt(pow(segment_end.x - rx, 2) + pow(segment_end.y - ry, 2));
+    if (m_lookahead_path.empty() && distance_to_end < lookahead)
+    {
+        applyApproachLimits();
+        return false;
+    }
+
+    //the look-ahead point is the farthest intersection of the look-ahead circle with the current segment.
+    //If the robot is too far from the segment, the end of the segment is pursued.
+    double sx = m_lookahead_segment_start.x;
+    double sy = m_lookahead_segment_start.y;
+    double dx = segment_end.x - sx;
+    double dy = segment_end.y - sy;
+    double fx = sx - rx;
+    double fy = sy - ry;
+    double a = dx * dx + dy * dy;
+    double b = 2 * (fx * dx + fy * dy);
+    double c = fx * fx + fy * fy - lookahead * lookahead;
+    double discriminant = b * b - 4 * a * c;
+    double lx = segment_end.x;
+    double ly = segment_end.y;
+    if (a > 1e-9 && discriminant >= 0)
+    {
+        double t = std::min((-b + sqrt(discriminant)) / (2 * a), 1.0);
+        if (t >= 0)
+        {
+            lx = sx + t * dx;
+            ly = sy + t * dy;
+        }
+    }
+
+    //the speed is limited by the length of the path which remains to the target, so the robot slows down only there
+    double remaining = distance_to_end;
+    Map2DLocation prev = segment_end;
+    for (auto it = m_lookahead_path.begin(); it != m_lookahead_path.end(); it++)
+    {
+        remaining += sqrt(pow(it->x - prev.x, 2) + pow(it->y - prev.y, 2));
+        prev = *it;
+    }
+    remaining += sqrt(pow(m_target_data.target.x - prev.x, 2) + pow(m_target_data.target.y - prev.y, 2));
+    double speed = std::min(m_max_lin_speed, m_gain_lin * remaining);
+
+    //the look-ahead point in the robot reference frame
+    double theta = m_localization_data.theta * DEG2RAD;
+    double local_x = (lx - rx) * cos(theta) + (ly - ry) * sin(theta);
+    double local_y = -(lx - rx) * sin(theta) + (ly - ry) * cos(theta);
+    double alpha = atan2(local_y, local_x) * RAD2DEG;
+
+    if (m_robot_is_holonomic)
+    {
+        m_control_out.linear_vel = speed;
+        m_control_out.linear_dir = alpha;
+        m_control_out.angular_vel = m_gain_ang * alpha;
+    }
+    else if (local_x <= 0)
+    {
+        //the look-ahead point is behind the robot: rotate in place
+        m_control_out.linear_vel = 0.0;
+        m_control_out.linear_dir = 0.0;
+        m_control_out.angular_vel = m_gain_ang * alpha;
+    }
+    else
+    {
+        //pure pursuit: the arc through the look-ahead point, the speed is reduced on the tight arcs
+        double dist2 = local_x * local_x + local_y * local_y;
+        double curvature = 2 * local_y / dist2;
+        if (fabs(curvature) > 1e-6)
+        {
+            speed = std::min(speed, m_max_ang_speed * DEG2RAD / fabs(curvature));
+        }
+        m_control_out.linear_vel = speed;
+        m_control_out.linear_dir = 0.0;
+        m_control_out.angular_vel = speed * curvature * RAD2DEG;
+    }
+    return true;
+}
+
 void GotoThread::sendOutput()
 {
     static yarp::os::Stamp stamp;
@@ -944,9 +1131,106 @@ void GotoThread::sendOutput()
     }
 }
 
+bool GotoThread::setNewTrajectory(const std::vector<trajectory_setpoint_type>& trajectory, double final_theta, bool weak_angle)
+{
+    if (trajectory.empty())
+    {
+        yError() << "Received an empty trajectory";
+        return false;
+    }
+    m_trajectory = trajectory;
+    m_approach_limits_pending = false;
+    m_trajectory_index = 0;
+    m_trajectory_time = 0;
+    m_trajectory_last_update = yarp::os::Time::now();
+
+    //the last setpoint is the target of the terminal approach
+    const trajectory_setpoint_type& last = m_trajectory.back();
+    m_target_data.weak_angle = weak_angle;
+    m_target_data.target = Map2DLocation("unknown_to_robotGoto", last.x, last.y, weak_angle ? last.theta : final_theta);
+    m_lookahead_path.clear();
+    prepareBeforeMove();
+
+    yDebug("received new trajectory: %d setpoints, %.2f s, target abs(%.3f %.3f %.2f)", (int)m_trajectory.size(), last.t, m_target_data.target.x, m_target_data.target.y, m_target_data.target.theta);
+    publishCurrentGoal();
+    return true;
+}
+
+bool GotoThread::setNewPath(const std::vector<Map2DLocation>& waypoints, double final_theta, bool weak_angle)
+{
+    if (waypoints.empty())
+    {
+        yError() << "Received an empty path";
+        return false;
+    }
+    m_trajectory.clear();
+    m_approach_limits_pending = false;
+    m_lookahead_path.assign(waypoints.begin(), waypoints.end() - 1);
+    m_lookahead_segment_start = m_localization_data;
+
+    //the last waypoint is the target of the terminal approach
+    const Map2DLocation& last = waypoints.back();
+    m_target_data.weak_angle = weak_angle;
+    if (weak_angle)
+    {
+        //as in setNewAbsTarget(), the final orientation is the direction of the last segment
+        const Map2DLocation& prev = m_lookahead_path.empty() ? m_localization_data : m_lookahead_path.back();
+        final_theta = atan2(last.y - prev.y, last.x - prev.x) * RAD2DEG;
+    }
+    m_target_data.target = Map2DLocation("unknown_to_robotGoto", last.x, last.y, final_theta);
+    prepareBeforeMove();
+
+    yDebug("received new path: %d waypoints, target abs(%.3f %.3f %.2f)", (int)waypoints.size(), m_target_data.target.x, m_target_data.target.y, m_target_data.target.theta);
+    publishCurrentGoal();
+    return true;
+}
+
+void GotoThread::setApproachLimits(const approach_limits_type& limits)
+{
+    m_approach_limits = limits;
+    m_approach_limits_pending = true;
+}
+
+void GotoThread::applyApproachLimits()
+{
+    if (m_approach_limits_pending == false) return;
+    m_min_lin_speed = m_approach_limits.min_lin_speed;
+    m_max_lin_speed = m_approach_limits.max_lin_speed;
+    m_min_ang_speed = m_approach_limits.min_ang_speed;
+    m_max_ang_speed = m_approach_limits.max_ang_speed;
+    m_gain_lin      = m_approach_limits.gain_lin;
+    m_gain_ang      = m_approach_limits.gain_ang;
+    m_approach_limits_pending = false;
+    yDebug("terminal approach: max_lin_speed %.2f max_ang_speed %.2f", m_max_lin_speed, m_max_ang_speed);
+}
+
+void GotoThread::prepareBeforeMove()
+{
+    if (m_status == navigation_status_moving)
+    {
+        //the robot continues along the new path without stopping
+        return;
+    }
+    m_status = navigation_status_preparing_before_move;
+    m_status_after_approach = navigation_status_moving;
+    if (m_enable_retreat)
+    {
+        m_retreat_duration_time    = m_retreat_duration_default;
+        m_retreat_starting_time    = yarp::os::Time::now();
+        m_approach_direction       = m_default_approach_direction;
+        m_approach_speed           = m_default_approach_speed;
+    }
+    else
+    {
+        m_retreat_duration_time = 0;
+    }
+}
+
 void GotoThread::setNewAbsTarget(yarp::sig::Vector target)
 {
     //data is formatted as follows: x, y, angle
+    m_trajectory.clear();
+    m_lookahead_path.clear();
     m_target_data.weak_angle = false;
     if (target.size() == 2)
     {
@@ -1009,11 +1293,14 @@ void GotoThread::resetParamsToDefaultValue()
     m_min_ang_speed      = m_default_min_ang_speed;
     m_approach_direction = m_default_approach_direction;
     m_approach_speed     = m_approach_speed;
+    m_lookahead_distance = m_default_lookahead_distance;
 }
 
 void GotoThread::setNewRelTarget(yarp::sig::Vector target)
 {
     //target and localization data are formatted as follows: x, y, angle (in degrees)
+    m_trajectory.clear();
+    m_lookahead_path.clear();
     m_target_data.weak_angle = false;
     if (target.size() == 2)
     {
@@ -1103,6 +1390,8 @@ bool GotoThread::stopMovement()
     bool ret = true;
     yInfo( "asked to stop");
     m_status = navigation_status_idle;
+    m_trajectory.clear();
+    m_lookahead_path.clear();
     return ret;
 }
 
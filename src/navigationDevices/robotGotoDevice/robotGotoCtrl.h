@@ -42,6 +42,7 @@
 #include <string>
 #include <math.h>
 #include <mutex>
+#include <deque>
 #include <yarp/rosmsg/visualization_msgs/MarkerArray.h>
 #include <yarp/rosmsg/geometry_msgs/PoseStamped.h>
 #include <yarp/rosmsg/nav_msgs/Path.h>
@@ -71,6 +72,27 @@ struct target_type
     target_type() {weak_angle = false;}
 };
 
+struct trajectory_setpoint_type
+{
+    double t;            //s, from the start of the trajectory
+    double x;            //m
+    double y;            //m
+    double theta;        //deg
+    double lin_vel;      //m/s
+    double ang_vel;      //deg/s
+};
+
+//the speed limits and gains of the terminal approach which follows a trajectory or a path
+struct approach_limits_type
+{
+    double min_lin_speed;   //m/s
+    double max_lin_speed;   //m/s
+    double min_ang_speed;   //deg/s
+    double max_ang_speed;   //deg/s
+    double gain_lin;
+    double gain_ang;
+};
+
 class GotoThread: public yarp::os::PeriodicThread
 {
     /////////////////////////////////////
@@ -102,6 +124,7 @@ public:
     double m_min_ang_speed;       //deg/s
     double m_approach_direction;
     double m_approach_speed;
+    double m_lookahead_distance;  //m
     double m_default_beta_angle_threshold;
     double m_default_gain_lin;
     double m_default_gain_ang;
@@ -113,6 +136,13 @@ public:
     double m_default_min_ang_speed;       //deg/s
     double m_default_approach_direction;
     double m_default_approach_speed;
+    double m_default_lookahead_distance;  //m
+
+    //trajectory tracking parameters
+    double m_tracking_gain_x;     //1/s
+    double m_tracking_gain_y;     //1/m^2
+    double m_tracking_gain_theta; //1/m
+    double m_tracking_max_lag;    //m
 
     //watchdogs for data received from external sources
     double m_stats_time_last;
@@ -172,6 +202,21 @@ protected:
     //obstacle handler
     obstacles_class*     m_obstacle_handler;
 
+    //the trajectory being tracked, if any. The reference time stops while the robot is too far from the reference.
+    std::vector<trajectory_setpoint_type> m_trajectory;
+    size_t               m_trajectory_index;
+    double               m_trajectory_time;
+    double               m_trajectory_last_update;
+
+    //the limits of the terminal approach, which replace the current ones when the approach starts
+    approach_limits_type m_approach_limits;
+    bool                 m_approach_limits_pending;
+
+    //the intermediate waypoints being followed, if any, before the target. The robot moves along the segments
+    //which join them, starting from m_lookahead_segment_start, and never stops on them.
+    std::deque<yarp::dev::Nav2D::Map2DLocation> m_lookahead_path;
+    yarp::dev::Nav2D::Map2DLocation             m_lookahead_segment_start;
+
     //internal type definition to store control output
     struct
     {
@@ -217,6 +262,33 @@ public:
     * @param target a three-elements vector containing the robot pose (x,y,theta)
     */
     void          setNewRelTarget(yarp::sig::Vector target);
+
+    /**
+    * Sets a time-parameterized trajectory, expressed in the map reference frame. The robot tracks the setpoints and then
+    * reaches the last one as a regular target.
+    * @param trajectory the setpoints, ordered by time
+    * @param final_theta the final orientation of the robot [deg]
+    * @param weak_angle if true, the final orientation is not requested
+    * @return false if the trajectory is empty
+    */
+    bool          setNewTrajectory(const std::vector<trajectory_setpoint_type>& trajectory, double final_theta, bool weak_angle);
+
+    /**
+    * Sets the speed limits and gains of the terminal approach of the current trajectory or path. The trajectory (or the
+    * path) is followed with the current limits, the new ones are applied only when the approach starts.
+    */
+    void          setApproachLimits(const approach_limits_type& limits);
+
+    /**
+    * Sets a sequence of waypoints, expressed in the map reference frame. The robot blends through the intermediate
+    * waypoints without stopping (pure pursuit of a point at m_lookahead_distance along the path) and then reaches
+    * the last one as a regular target.
+    * @param waypoints the waypoints, the target last
+    * @param final_theta the final orientation of the robot [deg]
+    * @param weak_angle if true, the final orientation is not requested
+    * @return false if there are no waypoints
+    */
+    bool          setNewPath(const std::vector<yarp::dev::Nav2D::Map2DLocation>& waypoints, double final_theta, bool weak_angle);
     
     /**
     * Performs an open-loop movement: the robot is commanded to move in the desired direction for 
@@ -327,6 +399,30 @@ private:
     */
     void saturateRobotControls();
 
+    /**
+    * Computes the control outputs which track the current trajectory.
+    * @return false if the end of the trajectory has been reached, i.e. the last setpoint must be reached as a regular target
+    */
+    bool trackTrajectory(double current_time);
+
+    /**
+    * Applies the limits set by setApproachLimits(), if any.
+    */
+    void applyApproachLimits();
+
+    /**
+    * Computes the control outputs which follow the intermediate waypoints. The limits set by setApproachLimits() are
+    * applied when the target is handed over to the terminal approach.
+    * @return false if the target is closer than the look-ahead distance, i.e. it must be reached as a regular target
+    */
+    bool followPath();
+
+    /**
+    * Starts the navigation towards a new target, possibly after a retreat. If the robot is already moving, it
+    * continues without stopping.
+    */
+    void prepareBeforeMove();
+
 };
 
 #endif
@@ -36,6 +36,20 @@
 
 using namespace yarp::dev::Nav2D;
 
+//(min_lin_speed max_lin_speed min_ang_speed max_ang_speed lin_speed_gain ang_speed_gain)
+static bool parse_approach_limits(const yarp::os::Value& v, approach_limits_type& limits)
+{
+    yarp::os::Bottle* b = v.asList();
+    if (b == nullptr || b->size() != 6) return false;
+    limits.min_lin_speed = b->get(0).asDouble();
+    limits.max_lin_speed = b->get(1).asDouble();
+    limits.min_ang_speed = b->get(2).asDouble();
+    limits.max_ang_speed = b->get(3).asDouble();
+    limits.gain_lin      = b->get(4).asDouble();
+    limits.gain_ang      = b->get(5).asDouble();
+    return true;
+}
+
 void robotGotoRPCHandler::setInterface(robotGotoDev* iface)
 {
     this->interface = iface;
@@ -136,6 +150,81 @@ bool robotGotoDev  ::parse_respond_string(const yarp::os::Bottle& command, yarp:
         reply.addString("approach command received");
     }
 
+    else if (command.get(0).isString() && command.get(0).asString() == "follow_trajectory")
+    {
+        //follow_trajectory <final_theta> <weak_angle> ((t x y theta lin_vel ang_vel) ...) [(terminal approach limits)]
+        double final_theta = command.get(1).asDouble();
+        bool weak_angle = command.get(2).asInt() != 0;
+        yarp::os::Bottle* list = command.get(3).asList();
+        std::vector<trajectory_setpoint_type> trajectory;
+        for (size_t i = 0; list != nullptr && i < list->size(); i++)
+        {
+            yarp::os::Bottle* b = list->get(i).asList();
+            if (b == nullptr || b->size() != 6)
+            {
+                trajectory.clear();
+                break;
+            }
+            trajectory_setpoint_type sp;
+            sp.t = b->get(0).asDouble();
+            sp.x = b->get(1).asDouble();
+            sp.y = b->get(2).asDouble();
+            sp.theta = b->get(3).asDouble();
+            sp.lin_vel = b->get(4).asDouble();
+            sp.ang_vel = b->get(5).asDouble();
+            trajectory.push_back(sp);
+        }
+        approach_limits_type limits;
+        bool has_limits = command.size() > 4;
+        if (has_limits && parse_approach_limits(command.get(4), limits) == false)
+        {
+            reply.addString("invalid trajectory");
+        }
+        else if (gotoThread->setNewTrajectory(trajectory, final_theta, weak_angle))
+        {
+            if (has_limits) gotoThread->setApproachLimits(limits);
+            reply.addString("trajectory received");
+        }
+        else
+        {
+            reply.addString("invalid trajectory");
+        }
+    }
+
+    else if (command.get(0).isString() && command.get(0).asString() == "follow_path")
+    {
+        //follow_path <final_theta> <weak_angle> ((x y) ...) [(terminal approach limits)]
+        double final_theta = command.get(1).asDouble();
+        bool weak_angle = command.get(2).asInt() != 0;
+        yarp::os::Bottle* list = command.get(3).asList();
+        std::vector<Map2DLocation> waypoints;
+        for (size_t i = 0; list != nullptr && i < list->size(); i++)
+        {
+            yarp::os::Bottle* b = list->get(i).asList();
+            if (b == nullptr || b->size() != 2)
+            {
+                waypoints.clear();
+                break;
+            }
+            waypoints.push_back(Map2DLocation("unknown_to_robotGoto", b->get(0).asDouble(), b->get(1).asDouble(), 0));
+        }
+        approach_limits_type limits;
+        bool has_limits = command.size() > 4;
+        if (has_limits && parse_approach_limits(command.get(4), limits) == false)
+        {
+            reply.addString("invalid path");
+        }
+        else if (gotoThread->setNewPath(waypoints, final_theta, weak_angle))
+        {
+            if (has_limits) gotoThread->setApproachLimits(limits);
+            reply.addString("path received");
+        }
+        else
+        {
+            reply.addString("invalid path");
+        }
+    }
+
     else if (command.get(0).asString() == "set")
     {
         if (command.get(1).asString() == "linear_tol")
@@ -178,6 +267,11 @@ bool robotGotoDev  ::parse_respond_string(const yarp::os::Bottle& command, yarp:
             gotoThread->m_gain_lin = command.get(2).asDouble();
             reply.addString("lin_speed_gain set.");
         }
+        else if (command.get(1).asString() == "lookahead_distance")
+        {
+            gotoThread->m_lookahead_distance = command.get(2).asDouble();
+            reply.addString("lookahead_distance set.");
+        }
         else if (command.get(1).asString() == "obstacle_avoidance")
         {
             if (command.get(2).asInt() == 0)
@@ -324,6 +418,8 @@ bool robotGotoRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bot
         reply.addVocab(Vocab::encode("many"));
         reply.addString("Available commands are:");
         reply.addString("approach <angle in degrees> <linear velocity> <time>");
+        reply.addString("follow_trajectory <final angle in degrees> <weak angle 0/1> ((<time> <x> <y> <angle in degrees> <linear velocity> <angular velocity>) ...) [(<approach min_lin_speed> <max_lin_speed> <min_ang_speed> <max_ang_speed> <lin_speed_gain> <ang_speed_gain>)]");
+        reply.addString("follow_path <final angle in degrees> <weak angle 0/1> ((<x> <y>) ...) [(<approach min_lin_speed> <max_lin_speed> <min_ang_speed> <max_ang_speed> <lin_speed_gain> <ang_speed_gain>)]");
         reply.addString("reset_params");
         reply.addString("set linear_tol <m>");
         reply.addString("set linear_ang <deg>");
@@ -331,6 +427,7 @@ bool robotGotoRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bot
         reply.addString("set max_ang_speed <deg/s>");
         reply.addString("set min_lin_speed <m/s>");
         reply.addString("set min_ang_speed <deg/s>");
+        reply.addString("set lookahead_distance <m>");
         reply.addString("set obstacle_stop <0/1>");
         reply.addString("set obstacle_avoidance <0/1>");
     }
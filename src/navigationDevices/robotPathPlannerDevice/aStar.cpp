@@ -66,7 +66,7 @@ namespace aStar_algorithm
     {
         public:
         node_map_type();
-        node_map_type(yarp::dev::Nav2D::MapGrid2D& map);
+        node_map_type(const bit_grid& blocked);
         ~node_map_type();
 
         public:
@@ -116,20 +116,17 @@ bool aStar_algorithm::operator < (const node_type &a, const node_type &b)
 }
 
 /////////// node_map_type
-aStar_algorithm::node_map_type::node_map_type(MapGrid2D& map)
+aStar_algorithm::node_map_type::node_map_type(const bit_grid& blocked)
 {
-    w = map.width();
-    h = map.height();
+    w = blocked.width();
+    h = blocked.height();
     nodes = new node_type* [w];
     for (int i = 0; i < w; ++i)  nodes[i] = new node_type[h];
 
     for (int y=0; y<h; y++)
         for (int x=0; x<w; x++)
             {
-                if (map.isFree(XYCell(x, y)))
-                    nodes [x][y].empty = true;
-                else
-                    nodes [x][y].empty = false;
+                nodes [x][y].empty = !blocked.get(x, y);
                 nodes [x][y].x = x;
                 nodes [x][y].y = y;
                 //--- ---
@@ -205,11 +202,18 @@ bool aStar_algorithm::unordered_set_type::find(node_type t)
 }
 
 /////////// various
-bool aStar_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path)
+bool aStar_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path, const std::atomic<bool>* cancel)
+{
+    bit_grid blocked;
+    blocked.from_map(map);
+    return find_astar_path(blocked, start, goal, path, cancel);
+}
+
+bool aStar_algorithm::find_astar_path(const bit_grid& blocked, XYCell start, XYCell goal, std::deque<XYCell>& path, const std::atomic<bool>* cancel)
 {
     //implementation of A* algorithm
     std::vector<XYCell> inverse_path;
-    node_map_type node_map(map);
+    node_map_type node_map(blocked);
     int sx=start.x;
     int sy=start.y;
     int gx=goal.x;
@@ -232,6 +236,10 @@ bool aStar_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal,
     int iterations=0;
     while (open_set.size()>0)
     {
+        if (cancel && cancel->load())
+        {
+            return false;
+        }
         iterations++;
         //yDebug ("%d\n", iterations++);
         //open_set.print();
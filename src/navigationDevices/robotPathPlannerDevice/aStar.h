@@ -21,6 +21,8 @@
 
 #include <yarp/dev/MapGrid2D.h>
 
+#include "bit_grid.h"
+#include <atomic>
 #include <vector>
 #include <queue>
 
@@ -33,9 +35,16 @@ namespace aStar_algorithm
     * @param start the start cell(x,y)
     * @param goal the arrival cell(x,y)
     * @param path the computed sequence of cells required to go from  start cell to goal cell
-    * @return true if the path exists, false if no valid path has been found
+    * @param cancel if not null, the search is interrupted as soon as it becomes true
+    * @return true if the path exists, false if no valid path has been found or the search has been interrupted
     */
-    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path);
+    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, const std::atomic<bool>* cancel = nullptr);
+
+    /**
+    * Same as above, with the obstacles given as a bit_grid (1 = blocked cell), which can be shared by several searches
+    * on the same map.
+    */
+    bool find_astar_path(const bit_grid& blocked, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, const std::atomic<bool>* cancel = nullptr);
 };
 
 #endif
@@ -22,6 +22,7 @@
 #include <yarp/dev/Map2DPath.h>
 #include <yarp/dev/Map2DLocation.h>
 #include <string>
+#include <cstdint>
 #include <math.h>
 #include <cv.h>
 #include <highgui.h> 
@@ -36,6 +37,13 @@ using namespace yarp::dev::Nav2D;
 using namespace map_utilites;
 
 bool map_utilites::simplifyPath(MapGrid2D& map, Map2DPath input_path, Map2DPath& output_path)
+{
+    bit_grid blocked;
+    blocked.from_map(map);
+    return simplifyPath(map, blocked, input_path, output_path);
+}
+
+bool map_utilites::simplifyPath(MapGrid2D& map, const bit_grid& blocked, Map2DPath input_path, Map2DPath& output_path)
 {
     size_t path_size = input_path.size();
     if (path_size==0) return false;
@@ -64,7 +72,7 @@ bool map_utilites::simplifyPath(MapGrid2D& map, Map2DPath input_path, Map2DPath&
             old_stop_cell = path.at(j-1);
             stop_cell     = path.at(j);
             //yDebug ("%d %d -> %d %d\n", start_cell.x, start_cell.y, stop_cell.x, stop_cell.y);
-            if (checkStraightLine(map, start_cell, stop_cell))
+            if (checkStraightLine(blocked, start_cell, stop_cell))
             {
                 best_old_stop_cell=old_stop_cell;
                 best_stop_cell=stop_cell;
@@ -87,32 +95,6 @@ bool map_utilites::simplifyPath(MapGrid2D& map, Map2DPath input_path, Map2DPath&
     return true;
 };
 
-void map_utilites::update_obstacles_map(MapGrid2D& map_to_be_updated, const MapGrid2D& obstacles_map)
-{
-    //copies obstacles (and only them) from a source map to a destination map
-    if (map_to_be_updated.width() != obstacles_map.width() ||
-        map_to_be_updated.height() != map_to_be_updated.height())
-    {
-        yError() << "update_obstacles_map: the two maps must have the same size!";
-        return;
-    }
-    for (size_t y=0; y<map_to_be_updated.height(); y++)
-        for (size_t x=0; x<map_to_be_updated.width(); x++)
-        {
-            MapGrid2D::map_flags flag_src;
-            MapGrid2D::map_flags flag_dst;
-            map_to_be_updated.getMapFlag(XYCell (x,y), flag_dst);
-            obstacles_map.getMapFlag(XYCell (x,y), flag_src);
-            if (flag_dst==MapGrid2D::MAP_CELL_FREE)
-            {
-                if      (flag_src==MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE)
-                { flag_dst=MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE; }
-                else if (flag_src==MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE)
-                { flag_dst=MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE; }
-            }
-        }
-}
-
 bool map_utilites::checkStraightLine(MapGrid2D& map, XYCell src, XYCell dst)
 {
     //here using the fast Bresenham algorithm to check if cells belonging to a straight line (from src to dst)
@@ -145,11 +127,23 @@ bool map_utilites::checkStraightLine(MapGrid2D& map, XYCell src, XYCell dst)
     return true;
 }
 
-bool map_utilites::findPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path)
+bool map_utilites::checkStraightLine(const bit_grid& blocked, XYCell src, XYCell dst)
+{
+    return blocked.is_line_clear(src, dst);
+}
+
+bool map_utilites::findPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path, const std::atomic<bool>* cancel)
+{
+    bit_grid blocked;
+    blocked.from_map(map);
+    return findPath(map, blocked, start, goal, path, cancel);
+}
+
+bool map_utilites::findPath(MapGrid2D& map, const bit_grid& blocked, XYCell start, XYCell goal, Map2DPath& path, const std::atomic<bool>* cancel)
 {
     //computes path from start to goal using A* algorithm
     std::deque<XYCell> cell_path;
-    bool b = aStar_algorithm::find_astar_path(map, start, goal, cell_path);
+    bool b = aStar_algorithm::find_astar_path(blocked, start, goal, cell_path, cancel);
     if (b)
     {
         for (auto it = cell_path.begin(); it != cell_path.end(); it++)
@@ -161,3 +155,26 @@ bool map_utilites::findPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath
     }
     return false;
 }
+
+size_t map_utilites::computeMapRevision(const MapGrid2D& map)
+{
+    //FNV-1a hash of the name, the size and the flags of the cells
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    std::string name = map.getMapName();
+    for (size_t i = 0; i < name.size(); i++) mix((unsigned char)name[i]);
+    mix(map.width());
+    mix(map.height());
+    for (size_t y = 0; y < map.height(); y++)
+        for (size_t x = 0; x < map.width(); x++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            mix(flag);
+        }
+    return size_t(hash);
+}
@@ -30,6 +30,8 @@
 #include <cv.h>
 #include <highgui.h> 
 #include <queue>
+#include <atomic>
+#include "bit_grid.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -44,14 +46,19 @@ namespace map_utilites
     //return true if the straight line that connects src with dst does not contain any obstacles
     bool checkStraightLine(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell src, yarp::dev::Nav2D::XYCell dst);
 
-    //simplify the path
+    //same as above, checking the line a word (64 cells) at a time against the blocked cells of the map
+    bool checkStraightLine(const bit_grid& blocked, yarp::dev::Nav2D::XYCell src, yarp::dev::Nav2D::XYCell dst);
+
+    //simplify the path. The version with the blocked cells of the map avoids to build them again.
     bool simplifyPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::Map2DPath input_path, yarp::dev::Nav2D::Map2DPath& output_path);
+    bool simplifyPath(yarp::dev::Nav2D::MapGrid2D& map, const bit_grid& blocked, yarp::dev::Nav2D::Map2DPath input_path, yarp::dev::Nav2D::Map2DPath& output_path);
 
-    //compute a path, given a start cell, a goal cell and a map grid.
-    bool findPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path);
+    //compute a path, given a start cell, a goal cell and a map grid. The search stops (returning false) when cancel becomes true.
+    bool findPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path, const std::atomic<bool>* cancel = nullptr);
+    bool findPath(yarp::dev::Nav2D::MapGrid2D& map, const bit_grid& blocked, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path, const std::atomic<bool>* cancel = nullptr);
 
-    // register new obstacles into a map
-    void update_obstacles_map(yarp::dev::Nav2D::MapGrid2D& map_to_be_updated, const yarp::dev::Nav2D::MapGrid2D& obstacles_map);
+    //computes a hash of the content of a map, which identifies the revision of the map
+    size_t computeMapRevision(const yarp::dev::Nav2D::MapGrid2D& map);
 };
 
 #endif
@@ -0,0 +1,503 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Os.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Image.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "mapManager.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    //the header of a cache file, followed by the name of the map and by three planes of w*h bytes:
+    //the flags of the map, the flags of the enlarged map, the occupancy
+    struct cache_header_t
+    {
+        char     magic[8];
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t name_length;
+        double   resolution;
+        double   origin_x;
+        double   origin_y;
+        double   origin_theta;
+        double   radius;
+        uint64_t hash;
+    };
+    static_assert(sizeof(cache_header_t) == 72, "unexpected padding in cache_header_t");
+
+    const char     CACHE_MAGIC[8] = { 'N', 'A', 'V', 'M', 'A', 'P', 'C', '1' };
+    const uint32_t CACHE_FORMAT = 1;
+
+    //failed downloads are not retried more often than this [s]
+    const double   RETRY_PERIOD = 1.0;
+
+    inline uint64_t fnv_mix(uint64_t h, uint64_t value)
+    {
+        h ^= value;
+        h *= 1099511628211ULL;
+        return h;
+    }
+
+    void get_flags(const MapGrid2D& map, std::vector<unsigned char>& flags)
+    {
+        size_t w = map.width();
+        size_t h = map.height();
+        flags.resize(w * h);
+        for (size_t y = 0; y < h; y++)
+            for (size_t x = 0; x < w; x++)
+            {
+                MapGrid2D::map_flags flag;
+                map.getMapFlag(XYCell(x, y), flag);
+                flags[y * w + x] = (unsigned char)flag;
+            }
+    }
+
+    //fills a map with the content of a cache file
+    bool parse_cache(const unsigned char* data, size_t size, MapGrid2D& map, MapGrid2D& enlarged, cache_header_t& header)
+    {
+        if (size < sizeof(cache_header_t)) return false;
+        memcpy(&header, data, sizeof(cache_header_t));
+        if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.format != CACHE_FORMAT) return false;
+        size_t w = header.width;
+        size_t h = header.height;
+        if (size != sizeof(cache_header_t) + header.name_length + 3 * w * h) return false;
+
+        const unsigned char* p = data + sizeof(cache_header_t);
+        std::string name((const char*)p, header.name_length);
+        p += header.name_length;
+        const unsigned char* flags = p;
+        const unsigned char* enlarged_flags = p + w * h;
+        const unsigned char* occupancy = p + 2 * w * h;
+
+        yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy_image;
+        occupancy_image.resize(w, h);
+        for (size_t y = 0; y < h; y++)
+        {
+            memcpy(occupancy_image.getRow(y), occupancy + y * w, w);
+        }
+        MapGrid2D* maps[2] = { &map, &enlarged };
+        const unsigned char* planes[2] = { flags, enlarged_flags };
+        for (size_t m = 0; m < 2; m++)
+        {
+            maps[m]->setSize_in_cells(w, h);
+            maps[m]->setResolution(header.resolution);
+            maps[m]->setOrigin(header.origin_x, header.origin_y, header.origin_theta);
+            maps[m]->setMapName(name);
+            for (size_t y = 0; y < h; y++)
+                for (size_t x = 0; x < w; x++)
+                    maps[m]->setMapFlag(XYCell(x, y), (MapGrid2D::map_flags)planes[m][y * w + x]);
+            maps[m]->setOccupancyGrid(occupancy_image);
+        }
+        return true;
+    }
+}
+
+MapManager::MapManager()
+{
+    m_iMap = nullptr;
+    m_robot_radius = 0;
+    m_stop = false;
+    m_last_version = 0;
+}
+
+MapManager::~MapManager()
+{
+    stop();
+}
+
+bool MapManager::start(IMap2D* iMap, double robot_radius, const std::string& cache_dir, const std::vector<std::string>& prefetch_list)
+{
+    if (iMap == nullptr) return false;
+    if (m_thread.joinable()) return true;
+    m_iMap = iMap;
+    m_robot_radius = robot_radius;
+    m_cache_dir = cache_dir;
+    if (m_cache_dir != "" && yarp::os::mkdir_p(m_cache_dir.c_str()) != 0)
+    {
+        yWarning() << "MapManager: unable to create the cache folder" << m_cache_dir << ", the maps will not be cached on disk";
+        m_cache_dir = "";
+    }
+
+    std::vector<std::string> names = prefetch_list;
+    if (names.size() == 1 && names[0] == "all")
+    {
+        names.clear();
+        m_iMap->get_map_names(names);
+    }
+    m_stop = false;
+    m_thread = std::thread(&MapManager::loop, this);
+    prefetch(names);
+    return true;
+}
+
+void MapManager::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void MapManager::setRobotRadius(double robot_radius)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (robot_radius == m_robot_radius) return;
+        m_robot_radius = robot_radius;
+        //all the known maps are enlarged again, in background
+        for (auto it = m_maps.begin(); it != m_maps.end(); it++)
+        {
+            if (std::find(m_requests.begin(), m_requests.end(), it->first) == m_requests.end())
+            {
+                m_requests.push_back(it->first);
+            }
+        }
+    }
+    m_cv.notify_one();
+}
+
+bool MapManager::getMap(const std::string& map_name, MapGrid2D& map, MapGrid2D& enlarged, unsigned int& version)
+{
+    std::shared_ptr<const entry_t> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_maps.find(map_name);
+        if (it != m_maps.end() && it->second->radius == m_robot_radius)
+        {
+            entry = it->second;
+        }
+        else
+        {
+            //the requested map is the most urgent one
+            if (m_requests.empty() || m_requests.front() != map_name)
+            {
+                auto req = std::find(m_requests.begin(), m_requests.end(), map_name);
+                if (req != m_requests.end()) m_requests.erase(req);
+                m_requests.push_front(map_name);
+                m_cv.notify_one();
+            }
+            return false;
+        }
+    }
+    //the copy is performed outside the critical section, the entry is immutable
+    map = entry->map;
+    enlarged = entry->enlarged;
+    version = entry->version;
+    return true;
+}
+
+unsigned int MapManager::getVersion(const std::string& map_name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_maps.find(map_name);
+    if (it == m_maps.end() || it->second->radius != m_robot_radius) return 0;
+    return it->second->version;
+}
+
+void MapManager::prefetch(const std::vector<std::string>& map_names)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < map_names.size(); i++)
+        {
+            if (std::find(m_requests.begin(), m_requests.end(), map_names[i]) == m_requests.end())
+            {
+                m_requests.push_back(map_names[i]);
+            }
+        }
+    }
+    m_cv.notify_one();
+}
+
+void MapManager::revalidate(const std::string& map_name)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stale.insert(map_name);
+        if (std::find(m_requests.begin(), m_requests.end(), map_name) == m_requests.end())
+        {
+            m_requests.push_front(map_name);
+        }
+    }
+    m_cv.notify_one();
+}
+
+void MapManager::loop()
+{
+    std::map<std::string, double> failures;
+    for (;;)
+    {
+        std::string map_name;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+            if (m_stop) return;
+            map_name = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        //the planner asks a missing map at each cycle, so the failed downloads are retried only after a while
+        auto failure = failures.find(map_name);
+        if (failure != failures.end() && yarp::os::Time::now() - failure->second < RETRY_PERIOD)
+        {
+            continue;
+        }
+
+        double t1 = yarp::os::Time::now();
+        load(map_name);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_maps.find(map_name);
+        if (it != m_maps.end() && it->second->validated)
+        {
+            failures.erase(map_name);
+            yDebug() << "MapManager: map" << map_name << "ready in" << yarp::os::Time::now() - t1 << "s";
+        }
+        else
+        {
+            failures[map_name] = yarp::os::Time::now();
+        }
+    }
+}
+
+void MapManager::load(const std::string& map_name)
+{
+    std::shared_ptr<const entry_t> current;
+    double radius = 0;
+    bool stale = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_maps.find(map_name);
+        if (it != m_maps.end()) current = it->second;
+        radius = m_robot_radius;
+        stale = m_stale.erase(map_name) > 0;
+    }
+    if (current && current->validated && current->radius == radius && !stale)
+    {
+        return;
+    }
+
+    //a map found in the cache can be used immediately, it is validated below
+    if (!current && m_cache_dir != "")
+    {
+        std::shared_ptr<entry_t> cached = std::make_shared<entry_t>();
+        if (read_cache(map_name, *cached) && cached->radius == radius)
+        {
+            yInfo() << "MapManager: map" << map_name << "loaded from the cache";
+            publish(map_name, cached);
+            current = cached;
+        }
+    }
+
+    std::shared_ptr<entry_t> entry = std::make_shared<entry_t>();
+    if (current && current->validated && !stale)
+    {
+        //only the robot radius changed
+        entry->map = current->map;
+        entry->hash = current->hash;
+    }
+    else
+    {
+        if (m_iMap->get_map(map_name, entry->map) == false)
+        {
+            yError() << "MapManager: unable to get map" << map_name << "from the map server";
+            return;
+        }
+        entry->hash = compute_hash(entry->map);
+        if (current && current->hash == entry->hash && current->radius == radius)
+        {
+            //the cached (or current) map is up to date
+            if (!current->validated)
+            {
+                std::shared_ptr<entry_t> validated = std::make_shared<entry_t>(*current);
+                validated->validated = true;
+                publish(map_name, validated);
+            }
+            return;
+        }
+    }
+
+    entry->enlarged = entry->map;
+    entry->enlarged.enlargeObstacles(radius);
+    entry->radius = radius;
+    entry->validated = true;
+    publish(map_name, entry);
+    if (m_cache_dir != "" && write_cache(map_name, *entry) == false)
+    {
+        yWarning() << "MapManager: unable to write the cache of map" << map_name;
+    }
+}
+
+void MapManager::publish(const std::string& map_name, std::shared_ptr<entry_t> entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_maps.find(map_name);
+    if (it != m_maps.end() && it->second->hash == entry->hash && it->second->radius == entry->radius)
+    {
+        entry->version = it->second->version;
+    }
+    else
+    {
+        entry->version = ++m_last_version;
+    }
+    m_maps[map_name] = entry;
+}
+
+std::string MapManager::cache_file(const std::string& map_name) const
+{
+    std::string file_name = map_name;
+    for (size_t i = 0; i < file_name.size(); i++)
+    {
+        char c = file_name[i];
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_') file_name[i] = '_';
+    }
+    return m_cache_dir + "/" + file_name + ".navcache";
+}
+
+bool MapManager::read_cache(const std::string& map_name, entry_t& entry) const
+{
+    std::string file = cache_file(map_name);
+    cache_header_t header;
+    bool ret = false;
+#ifndef _WIN32
+    //the file is memory-mapped, the maps are filled directly from the page cache
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            ret = parse_cache((const unsigned char*)data, st.st_size, entry.map, entry.enlarged, header);
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+#else
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in) return false;
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ret = parse_cache(data.data(), data.size(), entry.map, entry.enlarged, header);
+#endif
+    if (!ret || entry.map.getMapName() != map_name)
+    {
+        return false;
+    }
+    entry.hash = header.hash;
+    entry.radius = header.radius;
+    entry.validated = false;
+    entry.version = 0;
+    return true;
+}
+
+bool MapManager::write_cache(const std::string& map_name, const entry_t& entry) const
+{
+    const MapGrid2D& map = entry.map;
+    size_t w = map.width();
+    size_t h = map.height();
+    cache_header_t header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.format = CACHE_FORMAT;
+    header.width = (uint32_t)w;
+    header.height = (uint32_t)h;
+    header.name_length = (uint32_t)map_name.size();
+    map.getResolution(header.resolution);
+    map.getOrigin(header.origin_x, header.origin_y, header.origin_theta);
+    header.radius = entry.radius;
+    header.hash = entry.hash;
+
+    std::vector<unsigned char> flags;
+    std::vector<unsigned char> enlarged_flags;
+    get_flags(entry.map, flags);
+    get_flags(entry.enlarged, enlarged_flags);
+    yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy;
+    map.getOccupancyGrid(occupancy);
+    if (occupancy.width() != w || occupancy.height() != h) return false;
+
+    //the file is written with a temporary name and then renamed, so a reader never finds a partial file
+    std::string file = cache_file(map_name);
+    std::string tmp_file = file + ".tmp";
+    {
+        std::ofstream out(tmp_file.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write((const char*)&header, sizeof(header));
+        out.write(map_name.data(), map_name.size());
+        out.write((const char*)flags.data(), flags.size());
+        out.write((const char*)enlarged_flags.data(), enlarged_flags.size());
+        for (size_t y = 0; y < h; y++)
+        {
+            out.write((const char*)occupancy.getRow(y), w);
+        }
+        if (!out) return false;
+    }
+#ifdef _WIN32
+    std::remove(file.c_str());
+#endif
+    return std::rename(tmp_file.c_str(), file.c_str()) == 0;
+}
+
+uint64_t MapManager::compute_hash(const MapGrid2D& map)
+{
+    //FNV-1a hash of the geometry, of the flags and of the occupancy of the map
+    uint64_t h = 14695981039346656037ULL;
+    std::string name = map.getMapName();
+    for (size_t i = 0; i < name.size(); i++) h = fnv_mix(h, (unsigned char)name[i]);
+    h = fnv_mix(h, map.width());
+    h = fnv_mix(h, map.height());
+    double geometry[4];
+    map.getResolution(geometry[0]);
+    map.getOrigin(geometry[1], geometry[2], geometry[3]);
+    for (size_t i = 0; i < 4; i++)
+    {
+        uint64_t bits;
+        memcpy(&bits, &geometry[i], sizeof(bits));
+        h = fnv_mix(h, bits);
+    }
+
+    std::vector<unsigned char> flags;
+    get_flags(map, flags);
+    for (size_t i = 0; i < flags.size(); i++) h = fnv_mix(h, flags[i]);
+
+    yarp::sig::ImageOf<yarp::sig::PixelMono> occupancy;
+    map.getOccupancyGrid(occupancy);
+    for (size_t y = 0; y < occupancy.height(); y++)
+    {
+        const unsigned char* row = occupancy.getRow(y);
+        for (size_t x = 0; x < occupancy.width(); x++) h = fnv_mix(h, row[x]);
+    }
+    return h;
+}
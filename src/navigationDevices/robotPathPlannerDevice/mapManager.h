@@ -0,0 +1,124 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef MAP_MANAGER_H
+#define MAP_MANAGER_H
+
+#include <yarp/dev/IMap2D.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+* Provides the maps to the planner without blocking its control loop.
+* The maps are downloaded from the map server and their obstacles are enlarged by the robot radius in a dedicated thread.
+* Besides the maps requested by the planner, the thread prefetches a list of maps (e.g. the other floors of the building),
+* so that a change of map (e.g. when the robot leaves an elevator) is immediate.
+* The enlarged maps are also stored in a binary cache on disk, which is memory-mapped when loaded. A cached map is used
+* as soon as it is requested, then it is validated in background against the hash of the map provided by the server:
+* if the map has been modified, it is enlarged again and its version changes. A map already validated is checked again
+* only when revalidate() is called.
+*/
+class MapManager
+{
+    struct entry_t
+    {
+        yarp::dev::Nav2D::MapGrid2D   map;        //the map provided by the server
+        yarp::dev::Nav2D::MapGrid2D   enlarged;   //the same map, with the obstacles enlarged by the robot radius
+        uint64_t                      hash;       //the hash of map
+        double                        radius;     //the radius used to enlarge the obstacles
+        bool                          validated;  //map has been checked against the map server
+        unsigned int                  version;
+    };
+
+    yarp::dev::Nav2D::IMap2D*                               m_iMap;
+    std::string                                             m_cache_dir;
+    double                                                  m_robot_radius;
+    std::thread                                             m_thread;
+    std::mutex                                              m_mutex;
+    std::condition_variable                                 m_cv;
+    bool                                                    m_stop;
+    std::deque<std::string>                                 m_requests;     //the maps to be loaded, the most urgent first
+    std::set<std::string>                                   m_stale;        //the maps to be checked again against the server
+    std::map<std::string, std::shared_ptr<const entry_t> >  m_maps;
+    unsigned int                                            m_last_version;
+
+public:
+    MapManager();
+    ~MapManager();
+
+    /**
+    * Starts the thread which loads the maps.
+    * @param iMap the interface of the map server
+    * @param robot_radius the radius used to enlarge the obstacles
+    * @param cache_dir the folder of the binary cache. An empty string disables the cache on disk.
+    * @param prefetch the maps to be loaded in advance. The single element "all" means all the maps of the server.
+    */
+    bool start(yarp::dev::Nav2D::IMap2D* iMap, double robot_radius, const std::string& cache_dir, const std::vector<std::string>& prefetch);
+    void stop();
+
+    /**
+    * Changes the radius used to enlarge the obstacles. The maps are enlarged again the next time they are requested.
+    */
+    void setRobotRadius(double robot_radius);
+
+    /**
+    * Gets a map, if it is ready. Otherwise its loading is started and the method returns false immediately.
+    * @param map the map provided by the server
+    * @param enlarged the same map, with the obstacles enlarged by the robot radius
+    * @param version changes each time the content of the map changes
+    */
+    bool getMap(const std::string& map_name, yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::MapGrid2D& enlarged, unsigned int& version);
+
+    /**
+    * @return the version of a map ready to be used, 0 if the map is not ready
+    */
+    unsigned int getVersion(const std::string& map_name);
+
+    /**
+    * Loads a list of maps in background.
+    */
+    void prefetch(const std::vector<std::string>& map_names);
+
+    /**
+    * Checks again a map against the map server, in background. The current map remains available meanwhile.
+    * If it has been modified on the server, it is enlarged again and its version changes.
+    */
+    void revalidate(const std::string& map_name);
+
+private:
+    void loop();
+    void load(const std::string& map_name);
+    void publish(const std::string& map_name, std::shared_ptr<entry_t> entry);
+
+    std::string cache_file(const std::string& map_name) const;
+    bool read_cache(const std::string& map_name, entry_t& entry) const;
+    bool write_cache(const std::string& map_name, const entry_t& entry) const;
+
+    static uint64_t compute_hash(const yarp::dev::Nav2D::MapGrid2D& map);
+};
+
+#endif
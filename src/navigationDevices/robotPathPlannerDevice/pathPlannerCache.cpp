@@ -0,0 +1,98 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include "pathPlannerCache.h"
+
+using namespace yarp::dev::Nav2D;
+
+PathPlannerCache::PathPlannerCache()
+{
+    m_capacity = 32;
+    m_region_size = 5;
+    m_hits = 0;
+    m_misses = 0;
+}
+
+void PathPlannerCache::configure(size_t capacity, size_t region_size)
+{
+    m_capacity = capacity;
+    m_region_size = (region_size > 0) ? region_size : 1;
+    clear();
+}
+
+PathPlannerCache::key_t PathPlannerCache::make_key(const std::string& map_name, size_t revision, XYCell start, XYCell goal) const
+{
+    return key_t(map_name, revision, start.x / m_region_size, start.y / m_region_size, goal.x, goal.y);
+}
+
+bool PathPlannerCache::lookup(const std::string& map_name, size_t revision, XYCell start, XYCell goal, PlannerResult& result)
+{
+    if (m_capacity == 0) return false;
+    auto it = m_index.find(make_key(map_name, revision, start, goal));
+    if (it == m_index.end())
+    {
+        m_misses++;
+        return false;
+    }
+    //moves the entry to the front of the list
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    result = it->second->second;
+    m_hits++;
+    return true;
+}
+
+void PathPlannerCache::store(const std::string& map_name, size_t revision, XYCell start, XYCell goal, const PlannerResult& result)
+{
+    if (m_capacity == 0 || result.found == false) return;
+    key_t key = make_key(map_name, revision, start, goal);
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+    m_entries.push_front(std::make_pair(key, result));
+    m_index[key] = m_entries.begin();
+    while (m_entries.size() > m_capacity)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+void PathPlannerCache::evict(const std::string& map_name, size_t current_revision)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (std::get<0>(it->first) == map_name && std::get<1>(it->first) != current_revision)
+        {
+            m_index.erase(it->first);
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void PathPlannerCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+}
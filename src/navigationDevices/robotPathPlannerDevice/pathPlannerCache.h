@@ -0,0 +1,75 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef PATH_PLANNER_CACHE_H
+#define PATH_PLANNER_CACHE_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <list>
+#include <map>
+#include <string>
+#include <tuple>
+#include "pathPlannerWorker.h"
+
+/**
+* Stores the most recently computed paths, so that the routes travelled again and again do not need a new search.
+* A path is identified by the map (name and revision), the goal cell and the region which contains the start cell:
+* the paths starting from a few cells apart are considered the same path.
+* The revision of the map (see map_utilites::computeMapRevision()) changes each time the map is modified, so the paths
+* computed on a previous version of the map are never returned.
+* The least recently used entry is discarded when the cache is full.
+*/
+class PathPlannerCache
+{
+    typedef std::tuple<std::string, size_t, size_t, size_t, size_t, size_t> key_t;   //map, revision, start region x/y, goal x/y
+    typedef std::list<std::pair<key_t, PlannerResult> >                             entries_t;
+
+    entries_t                            m_entries;     //the most recently used first
+    std::map<key_t, entries_t::iterator> m_index;
+    size_t                               m_capacity;
+    size_t                               m_region_size; //cells
+    size_t                               m_hits;
+    size_t                               m_misses;
+
+public:
+    PathPlannerCache();
+
+    /**
+    * @param capacity the maximum number of paths, 0 disables the cache
+    * @param region_size the size (in cells) of the square regions in which the start cells are grouped
+    */
+    void configure(size_t capacity, size_t region_size);
+
+    bool lookup(const std::string& map_name, size_t revision, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, PlannerResult& result);
+    void store(const std::string& map_name, size_t revision, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, const PlannerResult& result);
+
+    /**
+    * Removes the paths computed on the other revisions of a map, e.g. because the map has been modified
+    */
+    void evict(const std::string& map_name, size_t current_revision);
+    void clear();
+
+    size_t size() const { return m_entries.size(); }
+    size_t hits() const { return m_hits; }
+    size_t misses() const { return m_misses; }
+
+private:
+    key_t make_key(const std::string& map_name, size_t revision, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal) const;
+};
+
+#endif
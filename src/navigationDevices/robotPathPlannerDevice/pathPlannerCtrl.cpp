@@ -36,6 +36,8 @@
 
 #include <cv.h>
 #include <highgui.h> 
+#include <chrono>
+#include <algorithm>
 
 #include "pathPlannerCtrl.h"
 #include "pathPlannerCtrlHelpers.h"
@@ -51,10 +53,14 @@ using namespace yarp::dev::Nav2D;
 
 bool  PlannerThread::readLocalizationData()
 {
+    //the localization data is stamped with the middle of the rpc round trip
+    double t1 = yarp::os::Time::now();
     bool ret = m_iLoc->getCurrentPosition(m_localization_data);
+    double t2 = yarp::os::Time::now();
     if (ret)
     {
         m_loc_timeout_counter = 0;
+        m_localization_buffer.add_pose((t1 + t2) / 2, m_localization_data);
     }
     else
     {
@@ -63,40 +69,53 @@ bool  PlannerThread::readLocalizationData()
         return false;
     }
 
+    //the maps are loaded and enlarged in background by the map manager, so a change of map does not block this loop.
+    //The current map is checked periodically against the map server: a new version (e.g. modified on the map server)
+    //replaces it as soon as it is ready.
+    if (m_map_check_period > 0 &&
+        m_localization_data.map_id == m_current_map.getMapName() &&
+        yarp::os::Time::now() - m_last_map_check_time > m_map_check_period)
+    {
+        m_map_manager.revalidate(m_localization_data.map_id);
+        m_last_map_check_time = yarp::os::Time::now();
+    }
+    unsigned int map_version = m_map_manager.getVersion(m_localization_data.map_id);
     if (m_localization_data.map_id != m_current_map.getMapName() ||
-        m_force_map_reload == true)
+        m_force_map_reload == true ||
+        (map_version != 0 && map_version != m_current_map_version))
     {
+        static double last_print_time = 0;
         if (m_force_map_reload)
         {
             yInfo() << "m_force_map_reload requested";
+            m_map_manager.setRobotRadius(m_robot_radius);
+            m_map_manager.revalidate(m_localization_data.map_id);
+            m_current_map_version = 0;
         }
         m_force_map_reload = false;
-        yWarning() << "Current map name ("<<m_current_map.getMapName()<<") != m_localization_data.map_id ("<< m_localization_data.map_id <<")";
-        yInfo() << "Asking the map '"<< m_localization_data.map_id << "' to the MAP server";
-        bool map_get_succesfull = this->m_iMap->get_map(m_localization_data.map_id, m_current_map);
-        if (map_get_succesfull)
+        MapGrid2D map;
+        MapGrid2D enlarged_map;
+        unsigned int version = 0;
+        if (m_map_manager.getMap(m_localization_data.map_id, map, enlarged_map, version))
         {
             m_temporary_obstacles_map_mutex.lock();
-            m_temporary_obstacles_map = m_current_map;
+            m_temporary_obstacles_map = map;
             m_temporary_obstacles_map_mutex.unlock();
-            yInfo() << "Map '" << m_localization_data.map_id << "' successfully obtained from server";
-            m_current_map.enlargeObstacles(m_robot_radius);
-            m_augmented_map = m_current_map;
-            yDebug() << "Obstacles enlargement performed ("<<m_robot_radius<<"m)";
+            m_empty_obstacles_map = map;
+            for (size_t y = 0; y < map.height(); y++)
+                for (size_t x = 0; x < map.width(); x++)
+                    m_empty_obstacles_map.setMapFlag(XYCell(x, y), MapGrid2D::MAP_CELL_FREE);
+            m_current_map = enlarged_map;
+            m_obstacles_merger.reset(m_current_map);
+            m_current_map_version = version;
+            m_last_map_check_time = yarp::os::Time::now();
+            updateMapRevision();
+            yInfo() << "Map '" << m_localization_data.map_id << "' loaded (obstacles enlarged by " << m_robot_radius << "m)";
         }
-        else
+        else if (yarp::os::Time::now() - last_print_time > 1.0)
         {
-            yError() << "Unable to get map '" << m_localization_data.map_id << "' from map server";
-            std::vector<string> names_vector;
-            m_iMap->get_map_names(names_vector);
-            string names = "Known maps are:" ;
-            for (auto it = names_vector.begin(); it != names_vector.end(); it++)
-            {
-                names = names + " " + (*it);
-            }
-            yInfo() << names;
-            yarp::os::Time::delay(1.0);
-            return true; //consider changing this to false
+            yWarning() << "Current map name (" << m_current_map.getMapName() << ") != m_localization_data.map_id (" << m_localization_data.map_id << "), waiting for the map";
+            last_print_time = yarp::os::Time::now();
         }
     }
 
@@ -144,6 +163,23 @@ void  PlannerThread::readLaserData()
 
     if (ret)
     {
+        //the scan is projected with the pose of the robot at the time of the acquisition, if available.
+        //Otherwise the most recent localization data is used.
+        Map2DLocation scan_pose = m_localization_data;
+        if (m_iLaserTimed)
+        {
+            yarp::os::Stamp stamp = m_iLaserTimed->getLastInputStamp();
+            Map2DLocation pose_at_stamp;
+            if (stamp.isValid() &&
+                m_localization_buffer.get_pose_at(stamp.getTime(), pose_at_stamp) &&
+                pose_at_stamp.map_id == m_localization_data.map_id)
+            {
+                scan_pose = pose_at_stamp;
+            }
+        }
+        double ss = sin(scan_pose.theta * DEG2RAD);
+        double cs = cos(scan_pose.theta * DEG2RAD);
+
         m_laser_map_cells.clear();
         size_t scansize = scan.size();
         for (size_t i = 0; i<scansize; i++)
@@ -153,10 +189,8 @@ void  PlannerThread::readLaserData()
             scan[i].get_cartesian(las_x, las_y);
             //performs a rotation from the robot to the world reference frame
             XYWorld world;
-            double ss = sin(m_localization_data.theta * DEG2RAD);
-            double cs = cos(m_localization_data.theta * DEG2RAD);
-            world.x = las_x*cs - las_y*ss + m_localization_data.x;
-            world.y = las_x*ss + las_y*cs + m_localization_data.y;
+            world.x = las_x*cs - las_y*ss + scan_pose.x;
+            world.y = las_x*ss + las_y*cs + scan_pose.y;
         //    if (!std::isinf(world.x) &&  !std::isinf(world.y))
             if (std::isfinite(world.x) && std::isfinite(world.y))
                { m_laser_map_cells.push_back(m_current_map.world2Cell(world));}
@@ -169,14 +203,9 @@ void  PlannerThread::readLaserData()
     }
 
     //transform the laser measurement in a temporary map
-    //the purpose of the following copy of m_temporary_obstacles_map in temp_map is to minimize the duration of the critical section
-    //protected by the mutex. Indeed enlargeObstacles() can take some time and should be outside the mutex.
-    m_temporary_obstacles_map_mutex.lock();
-    MapGrid2D temp_map = m_temporary_obstacles_map;
-    m_temporary_obstacles_map_mutex.unlock();
-    for (size_t y=0; y< temp_map.height(); y++)
-        for (size_t x=0; x< temp_map.width(); x++)
-            temp_map.setMapFlag(XYCell(x,y),MapGrid2D::MAP_CELL_FREE);
+    //the temporary map is built outside the critical section protected by the mutex, because enlargeObstacles() can
+    //take some time. It starts from a copy of the map without obstacles, instead of clearing each cell.
+    MapGrid2D temp_map = m_empty_obstacles_map;
     for (size_t i=0; i< m_laser_map_cells.size(); i++)
     {
         temp_map.setMapFlag(m_laser_map_cells[i],MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE);
@@ -186,6 +215,28 @@ void  PlannerThread::readLaserData()
     m_temporary_obstacles_map_mutex.lock();
     m_temporary_obstacles_map = temp_map;
     m_temporary_obstacles_map_mutex.unlock();
+
+    //stream the changes of the obstacles map to the clients (e.g. navigationGUI).
+    //A new client cannot decode the deltas, so a keyframe is sent as soon as it connects.
+    int obstacles_output_count = m_port_obstacles_output.getOutputCount();
+    if (obstacles_output_count > m_obstacles_output_count)
+    {
+        m_obstacles_encoder.reset();
+    }
+    m_obstacles_output_count = obstacles_output_count;
+    if (obstacles_output_count > 0)
+    {
+        yarp::os::Bottle& delta = m_port_obstacles_output.prepare();
+        if (m_obstacles_encoder.encode(temp_map, yarp::os::Time::now(), delta))
+        {
+            //strict: a delta dropped by the port would leave the clients unsynced until the next keyframe
+            m_port_obstacles_output.write(true);
+        }
+        else
+        {
+            m_port_obstacles_output.unprepare();
+        }
+    }
 }
 
 bool prepare_image(IplImage* & image_to_be_prepared, const IplImage* template_image)
@@ -242,6 +293,11 @@ void PlannerThread::run()
     //double check1 = yarp::os::Time::now();
     readLocalizationData();
     readLaserData();
+    //the obstacles merged by a recovery leave the map after the decay time
+    if (m_obstacles_merger.decay(yarp::os::Time::now()) && m_obstacles_merger.apply(m_current_map) > 0)
+    {
+        updateMapRevision();
+    }
     //double check2 = yarp::os::Time::now();
     //yDebug() << check2-check1;
     if (readInnerNavigationStatus() == false)
@@ -259,9 +315,40 @@ void PlannerThread::run()
     {
         case navigation_status_moving:
         {
+            //a path recomputed by recomputePath() replaces the current one before the next waypoint is sent
+            if (m_replan_result.valid() &&
+                m_replan_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                PlannerResult result = m_replan_result.get();
+                if (result.cancelled == false && splicePath(result) && m_path_following_mode != FOLLOW_WAYPOINTS)
+                {
+                    //the inner controller receives the new path, and continues along it without stopping
+                    sendWaypoint();
+                }
+            }
+
             if (m_inner_status == navigation_status_goal_reached)
             {
-                if (m_current_path_iterator == m_current_path->end())
+                if (m_path_following_mode != FOLLOW_WAYPOINTS && m_current_path_iterator != m_current_path->end())
+                {
+                    //the whole path has been sent and it ends on the final goal, so all the waypoints have been passed
+                    m_current_path_iterator = m_current_path->end();
+                    m_remaining_path.clear();
+                }
+
+                if (m_current_path_iterator == m_current_path->end() && m_sequence_of_goals.size() > 1)
+                {
+                    //the next goal of the route is planned
+                    m_sequence_of_goals.pop();
+                    m_final_goal = m_sequence_of_goals.front();
+                    yInfo("goal reached, %d goal(s) remaining in the route", (int)m_sequence_of_goals.size());
+                    if (startPath() == false)
+                    {
+                        yError("unable to start the path towards the next goal, aborting navigation");
+                        m_planner_status = navigation_status_aborted;
+                    }
+                }
+                else if (m_current_path_iterator == m_current_path->end())
                 {
                     //navigation is complete
                     yInfo("goal reached, navigation complete");
@@ -277,63 +364,7 @@ void PlannerThread::run()
 
                     //send the final waypoint
                     yInfo("sending the last waypoint (final goal)");
-                    {
-                        //send the tolerance to the inner controller
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("linear_tol");
-                        cmd.addDouble(m_goal_tolerance_lin);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd2, ans2;
-                        cmd2.addString("set");
-                        cmd2.addString("angular_tol");
-                        cmd2.addDouble(m_goal_tolerance_ang);
-                        m_port_commands_output.write(cmd2, ans2);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_lin_speed");
-                        cmd.addDouble(m_goal_min_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_lin_speed");
-                        cmd.addDouble(m_goal_max_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_ang_speed");
-                        cmd.addDouble(m_goal_min_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_ang_speed");
-                        cmd.addDouble(m_goal_max_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("ang_speed_gain");
-                        cmd.addDouble(m_goal_ang_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("lin_speed_gain");
-                        cmd.addDouble(m_goal_lin_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
+                    sendGoalParameters();
                     sendFinalGoal();
                 }
                 else
@@ -345,48 +376,7 @@ void PlannerThread::run()
 
                     //send the next waypoint
                     yInfo("sending the next waypoint");
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_lin_speed");
-                        cmd.addDouble(m_waypoint_min_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_lin_speed");
-                        cmd.addDouble(m_waypoint_max_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_ang_speed");
-                        cmd.addDouble(m_waypoint_min_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_ang_speed");
-                        cmd.addDouble(m_waypoint_max_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("ang_speed_gain");
-                        cmd.addDouble(m_waypoint_ang_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("lin_speed_gain");
-                        cmd.addDouble(m_waypoint_lin_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
+                    sendWaypointParameters();
                     sendWaypoint();
                 }
             }
@@ -396,7 +386,10 @@ void PlannerThread::run()
             }
             else if (m_inner_status == navigation_status_moving)
             {
-                //do nothing, just wait
+                if (m_path_following_mode != FOLLOW_WAYPOINTS)
+                {
+                    advancePassedWaypoints();
+                }
             }
             else if (m_inner_status == navigation_status_waiting_obstacle)
             {
@@ -412,8 +405,21 @@ void PlannerThread::run()
                     Bottle cmd, ans;
                     cmd.addString("stop");
                     m_port_commands_output.write(cmd, ans);
-                    map_utilites::update_obstacles_map(m_current_map, m_augmented_map);
-                    sendWaypoint();
+                    //the obstacles currently detected are merged into the map, so the new path avoids them
+                    m_temporary_obstacles_map_mutex.lock();
+                    m_obstacles_merger.merge(m_temporary_obstacles_map, yarp::os::Time::now());
+                    m_temporary_obstacles_map_mutex.unlock();
+                    if (m_obstacles_merger.apply(m_current_map) > 0)
+                    {
+                        updateMapRevision();
+                    }
+                    //a new path to the current goal is computed from the current position of the robot.
+                    //It is sent by the main loop as soon as it is ready.
+                    if (startPath() == false)
+                    {
+                        yError("unable to recompute the path, aborting navigation");
+                        m_planner_status = navigation_status_aborted;
+                    }
                 }
                 else
                 {
@@ -443,63 +449,8 @@ void PlannerThread::run()
                 m_current_path_iterator = m_current_path->begin();
                 yInfo("sending the first waypoint");
 
-                //send the tolerance to the inner controller
-                {
-                    Bottle cmd1, ans1;
-                    cmd1.addString("set");
-                    cmd1.addString("linear_tol");
-                    cmd1.addDouble(m_waypoint_tolerance_lin);
-                    m_port_commands_output.write(cmd1, ans1);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("angular_tol");
-                    cmd.addDouble(m_waypoint_tolerance_ang);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("max_lin_speed");
-                    cmd.addDouble(m_waypoint_max_lin_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("max_ang_speed");
-                    cmd.addDouble(m_waypoint_max_ang_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("min_lin_speed");
-                    cmd.addDouble(m_waypoint_min_lin_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("min_ang_speed");
-                    cmd.addDouble(m_waypoint_min_ang_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("ang_speed_gain");
-                    cmd.addDouble(m_waypoint_ang_gain);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("lin_speed_gain");
-                    cmd.addDouble(m_waypoint_lin_gain);
-                    m_port_commands_output.write(cmd, ans);
-                }
+                //send the tolerances, the speed limits and the gains of the waypoints to the inner controller
+                sendWaypointParameters();
                 sendWaypoint();
             }
             else
@@ -536,7 +487,17 @@ void PlannerThread::run()
         break;
         case  navigation_status_thinking:
         {
-            //do nothing, just wait
+            //the path is computed by the worker thread, in the meanwhile the robot is still supervised
+            if (m_planner_result.valid() &&
+                m_planner_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                PlannerResult result = m_planner_result.get();
+                if (result.cancelled == false)
+                {
+                    m_path_cache.store(m_current_map.getMapName(), m_planner_request_revision, m_planner_request_start, m_planner_request_goal, result);
+                    completePath(result);
+                }
+            }
         }
         break;
         case  navigation_status_paused:
@@ -650,6 +611,17 @@ bool PlannerThread::getOstaclesMap(MapGrid2D& obstacles_map)
 
 void PlannerThread::sendWaypoint()
 {
+    if (m_path_following_mode == FOLLOW_TRAJECTORY)
+    {
+        sendTrajectory();
+        return;
+    }
+    if (m_path_following_mode == FOLLOW_LOOKAHEAD)
+    {
+        sendLookaheadPath();
+        return;
+    }
+
     size_t path_size = m_current_path->size();
     if (path_size==0)
     {
@@ -686,6 +658,204 @@ void PlannerThread::sendWaypoint()
     m_inner_status = inner_status;
 }
 
+void PlannerThread::sendSetCommand(const std::string& param, double value)
+{
+    Bottle cmd, ans;
+    cmd.addString("set");
+    cmd.addString(param);
+    cmd.addDouble(value);
+    m_port_commands_output.write(cmd, ans);
+}
+
+void PlannerThread::sendGoalParameters()
+{
+    sendSetCommand("linear_tol", m_goal_tolerance_lin);
+    sendSetCommand("angular_tol", m_goal_tolerance_ang);
+    sendSetCommand("min_lin_speed", m_goal_min_lin_speed);
+    sendSetCommand("max_lin_speed", m_goal_max_lin_speed);
+    sendSetCommand("min_ang_speed", m_goal_min_ang_speed);
+    sendSetCommand("max_ang_speed", m_goal_max_ang_speed);
+    sendSetCommand("ang_speed_gain", m_goal_ang_gain);
+    sendSetCommand("lin_speed_gain", m_goal_lin_gain);
+}
+
+void PlannerThread::sendWaypointParameters()
+{
+    sendSetCommand("linear_tol", m_waypoint_tolerance_lin);
+    sendSetCommand("angular_tol", m_waypoint_tolerance_ang);
+    sendSetCommand("min_lin_speed", m_waypoint_min_lin_speed);
+    sendSetCommand("max_lin_speed", m_waypoint_max_lin_speed);
+    sendSetCommand("min_ang_speed", m_waypoint_min_ang_speed);
+    sendSetCommand("max_ang_speed", m_waypoint_max_ang_speed);
+    sendSetCommand("ang_speed_gain", m_waypoint_ang_gain);
+    sendSetCommand("lin_speed_gain", m_waypoint_lin_gain);
+}
+
+void PlannerThread::addApproachLimits(Bottle& cmd)
+{
+    //the speed limits and gains of the goal, applied by the inner controller only at the terminal approach
+    Bottle& limits = cmd.addList();
+    limits.addDouble(m_goal_min_lin_speed);
+    limits.addDouble(m_goal_max_lin_speed);
+    limits.addDouble(m_goal_min_ang_speed);
+    limits.addDouble(m_goal_max_ang_speed);
+    limits.addDouble(m_goal_lin_gain);
+    limits.addDouble(m_goal_ang_gain);
+}
+
+void PlannerThread::sendTrajectory()
+{
+    if (m_current_path->size() == 0 || m_current_path_iterator == m_current_path->end())
+    {
+        yWarning ("Path queue is empty!");
+        m_planner_status = navigation_status_idle;
+        return;
+    }
+
+    //the trajectory goes through the waypoints not yet reached and ends exactly on the final goal
+    Map2DPath path;
+    for (auto it = m_current_path_iterator; it != m_current_path->end(); it++)
+    {
+        path.push_back(*it);
+    }
+    path.back().x = m_final_goal.x;
+    path.back().y = m_final_goal.y;
+
+    //the trajectory starts from the current speed of the robot, so it is not slowed down when the path is recomputed
+    const double speed_window = 0.2;
+    double start_speed = 0;
+    Map2DLocation past;
+    if (m_localization_buffer.get_pose_at(yarp::os::Time::now() - speed_window, past) && past.map_id == m_localization_data.map_id)
+    {
+        start_speed = sqrt(pow(m_localization_data.x - past.x, 2) + pow(m_localization_data.y - past.y, 2)) / speed_window;
+    }
+
+    std::vector<trajectory_generator::setpoint_t> trajectory;
+    if (trajectory_generator::compute_trajectory(m_current_map, m_current_map_blocked, m_localization_data, start_speed, path, m_trajectory_limits, trajectory) == false)
+    {
+        yError("unable to compute the trajectory");
+        m_planner_status = navigation_status_aborted;
+        return;
+    }
+
+    //the trajectory is tracked with the limits used to compute it. The minimum speeds are not enforced, otherwise they
+    //would cut the planned decelerations. The final approach at the end of the trajectory uses the limits of the goal.
+    sendSetCommand("linear_tol", m_goal_tolerance_lin);
+    sendSetCommand("angular_tol", m_goal_tolerance_ang);
+    sendSetCommand("min_lin_speed", 0.0);
+    sendSetCommand("max_lin_speed", m_trajectory_limits.max_lin_speed);
+    sendSetCommand("min_ang_speed", 0.0);
+    sendSetCommand("max_ang_speed", m_trajectory_limits.max_ang_speed);
+    sendSetCommand("ang_speed_gain", m_waypoint_ang_gain);
+    sendSetCommand("lin_speed_gain", m_waypoint_lin_gain);
+
+    //send the trajectory to the inner controller
+    bool weak_angle = std::isnan(m_final_goal.theta);
+    Bottle cmd, ans;
+    cmd.addString("follow_trajectory");
+    cmd.addDouble(weak_angle ? 0.0 : m_final_goal.theta);
+    cmd.addInt(weak_angle ? 1 : 0);
+    Bottle& list = cmd.addList();
+    for (size_t i = 0; i < trajectory.size(); i++)
+    {
+        Bottle& b = list.addList();
+        b.addDouble(trajectory[i].t);
+        b.addDouble(trajectory[i].x);
+        b.addDouble(trajectory[i].y);
+        b.addDouble(trajectory[i].theta);
+        b.addDouble(trajectory[i].lin_vel);
+        b.addDouble(trajectory[i].ang_vel);
+    }
+    addApproachLimits(cmd);
+    yDebug("sending trajectory: %d setpoints, %d waypoints, duration %.2f s", (int)trajectory.size(), (int)path.size(), trajectory.back().t);
+    m_port_commands_output.write(cmd, ans);
+    if (ans.get(0).asString() != "trajectory received")
+    {
+        yError("the inner controller did not accept the trajectory: %s", ans.toString().c_str());
+        m_planner_status = navigation_status_aborted;
+        return;
+    }
+
+    //get inner navigation status
+    NavigationStatusEnum inner_status;
+    m_iInnerNav_ctrl->getNavigationStatus(inner_status);
+    m_inner_status = inner_status;
+}
+
+void PlannerThread::sendLookaheadPath()
+{
+    if (m_current_path->size() == 0 || m_current_path_iterator == m_current_path->end())
+    {
+        yWarning ("Path queue is empty!");
+        m_planner_status = navigation_status_idle;
+        return;
+    }
+
+    //the path is followed with the speed limits and gains of the waypoints, which are never stopped at.
+    //The final approach uses the tolerances and the limits of the goal.
+    sendSetCommand("linear_tol", m_goal_tolerance_lin);
+    sendSetCommand("angular_tol", m_goal_tolerance_ang);
+    sendSetCommand("min_lin_speed", m_waypoint_min_lin_speed);
+    sendSetCommand("max_lin_speed", m_waypoint_max_lin_speed);
+    sendSetCommand("min_ang_speed", m_waypoint_min_ang_speed);
+    sendSetCommand("max_ang_speed", m_waypoint_max_ang_speed);
+    sendSetCommand("ang_speed_gain", m_waypoint_ang_gain);
+    sendSetCommand("lin_speed_gain", m_waypoint_lin_gain);
+    sendSetCommand("lookahead_distance", m_lookahead_distance);
+
+    //send the waypoints not yet reached, the last one is exactly the final goal
+    bool weak_angle = std::isnan(m_final_goal.theta);
+    Bottle cmd, ans;
+    cmd.addString("follow_path");
+    cmd.addDouble(weak_angle ? 0.0 : m_final_goal.theta);
+    cmd.addInt(weak_angle ? 1 : 0);
+    Bottle& list = cmd.addList();
+    for (auto it = m_current_path_iterator; it != m_current_path->end(); it++)
+    {
+        Bottle& b = list.addList();
+        if (it + 1 == m_current_path->end())
+        {
+            b.addDouble(m_final_goal.x);
+            b.addDouble(m_final_goal.y);
+        }
+        else
+        {
+            b.addDouble(it->x);
+            b.addDouble(it->y);
+        }
+    }
+    addApproachLimits(cmd);
+    yDebug("sending path: %d waypoints", (int)list.size());
+    m_port_commands_output.write(cmd, ans);
+    if (ans.get(0).asString() != "path received")
+    {
+        yError("the inner controller did not accept the path: %s", ans.toString().c_str());
+        m_planner_status = navigation_status_aborted;
+        return;
+    }
+
+    //get inner navigation status
+    NavigationStatusEnum inner_status;
+    m_iInnerNav_ctrl->getNavigationStatus(inner_status);
+    m_inner_status = inner_status;
+}
+
+void PlannerThread::advancePassedWaypoints()
+{
+    //the inner controller reports only the end of the path: a waypoint is considered reached when the robot passes
+    //near it. The curves of the trajectory start at most blend_distance before each waypoint, while the inner
+    //controller leaves a waypoint when it is closer than the look-ahead distance.
+    double blend = (m_path_following_mode == FOLLOW_TRAJECTORY) ? m_trajectory_limits.blend_distance : m_lookahead_distance;
+    double threshold = std::max(m_waypoint_tolerance_lin, blend);
+    while (m_current_path_iterator != m_current_path->end() && m_current_path_iterator + 1 != m_current_path->end())
+    {
+        double d = sqrt(pow(m_current_path_iterator->x - m_localization_data.x, 2) + pow(m_current_path_iterator->y - m_localization_data.y, 2));
+        if (d > threshold) break;
+        m_current_path_iterator++;
+        if (m_remaining_path.empty() == false) m_remaining_path.pop_front();
+    }
+}
+
 void PlannerThread::sendFinalGoal()
 {
     if (std::isnan(m_final_goal.theta) == false)
@@ -726,25 +896,47 @@ bool PlannerThread::startPath()
     start.x = 150;//&&&&&
     start.y = 150;//&&&&&
 #endif
-    double t1 = yarp::os::Time::now();
     //clear the memory 
+    m_current_path = nullptr;
     m_computed_path.clear();
     m_computed_simplified_path.clear();
+    m_remaining_path.clear();
+    m_replan_result = std::future<PlannerResult>();
+
+    //a path already computed for the same route is used if the temporary obstacles do not block it
+    PlannerResult cached;
+    if (m_path_cache.lookup(m_current_map.getMapName(), m_map_revision, start, goal, cached) &&
+        isCachedPathFree(cached, start))
+    {
+        m_planner_worker.cancel();
+        m_planner_result = std::future<PlannerResult>();
+        cached.duration = 0;
+        yInfo("path found in cache (%d hits, %d misses)", (int)m_path_cache.hits(), (int)m_path_cache.misses());
+        completePath(cached);
+        return true;
+    }
+
+    //search for a path. The search is performed by the worker thread, the result is collected by run().
+    //A request still in progress (e.g. for a previous goal) is interrupted.
+    m_planner_request_revision = m_map_revision;
+    m_planner_request_start = start;
+    m_planner_request_goal = goal;
+    m_planner_result = m_planner_worker.request(m_current_map, start, goal);
     m_planner_status = navigation_status_thinking;
+    return true;
+}
 
-    //search for a path
-    bool b = map_utilites::findPath(m_current_map, start, goal, m_computed_path);
-    if (!b)
+void PlannerThread::completePath(const PlannerResult& result)
+{
+    if (!result.found)
     {
         yError ("path not found");
         m_planner_status = navigation_status_aborted;
-        return false;
+        return;
     }
-    double t2 = yarp::os::Time::now();
-
-    //search for an simpler path (waypoint optimization)
-    map_utilites::simplifyPath(m_current_map, m_computed_path, m_computed_simplified_path);
-    yInfo("path size:%d simplified path size:%d time: %.2f", (int)m_computed_path.size(), (int)m_computed_simplified_path.size(), t2 - t1);
+    m_computed_path = result.path;
+    m_computed_simplified_path = result.simplified_path;
+    yInfo("path size:%d simplified path size:%d time: %.2f", (int)m_computed_path.size(), (int)m_computed_simplified_path.size(), result.duration);
 
     //choose the path to use
     if (m_use_optimized_path)
@@ -769,7 +961,8 @@ bool PlannerThread::startPath()
         {
             yWarning() << "Requested path has zero length. Aborting;";
             m_planner_status = navigation_status_goal_reached;
-            return true;
+            m_current_path_iterator = m_current_path->end();
+            return;
         }
     }
 
@@ -779,15 +972,96 @@ bool PlannerThread::startPath()
     //debug print
     if (1)
     {
-        yDebug() << "Current pos" << " x:" << start_vec.x << " y:" << start_vec.y;
+        yDebug() << "Current pos" << " x:" << m_localization_data.x << " y:" << m_localization_data.y;
         yDebug() << m_current_path->toString();
-        yDebug() << "Final goal" << " x:" << goal_vec.x << " y:" << goal_vec.y << " t:" << m_sequence_of_goals.front().theta;
+        yDebug() << "Final goal" << " x:" << m_sequence_of_goals.front().x << " y:" << m_sequence_of_goals.front().y << " t:" << m_sequence_of_goals.front().theta;
     }
 
     //just set the status to moving, do not set position commands.
     //The waypoint is set in the main 'run' loop.
     m_planner_status = navigation_status_moving;
     m_navigation_started_at_timeX = yarp::os::Time::now();
+}
+
+bool PlannerThread::splicePath(const PlannerResult& result)
+{
+    if (!result.found)
+    {
+        yWarning("recomputed path not found, the current path is kept");
+        return false;
+    }
+    size_t current_index = m_current_path_iterator - m_current_path->begin();
+    if (m_replan_map_id != m_current_map.getMapName() ||
+        current_index > m_replan_splice_index ||
+        m_replan_splice_index >= m_current_path->size())
+    {
+        yWarning("the robot has already passed the start of the recomputed path, the current path is kept");
+        return false;
+    }
+
+    //the waypoints up to the splice point are kept, so the waypoint currently pursued by the inner controller
+    //does not change and the robot is not stopped.
+    const Map2DPath& new_path = m_use_optimized_path ? result.simplified_path : result.path;
+    Map2DPath spliced_path;
+    for (auto it = m_current_path_iterator; it != m_current_path->begin() + m_replan_splice_index + 1; it++)
+    {
+        spliced_path.push_back(*it);
+    }
+    for (auto it = new_path.begin(); it != new_path.end(); it++)
+    {
+        spliced_path.push_back(*it);
+    }
+
+    if (m_use_optimized_path)
+    {
+        m_computed_simplified_path = spliced_path;
+        m_computed_path = result.path;
+    }
+    else
+    {
+        m_computed_path = spliced_path;
+        m_computed_simplified_path = result.simplified_path;
+    }
+    m_current_path_iterator = m_current_path->begin();
+    m_remaining_path.clear();
+    std::copy(m_current_path->begin(), m_current_path->end(), std::back_inserter(m_remaining_path));
+    yInfo("path recomputed: %d waypoints kept, %d new waypoints, time: %.2f", (int)(m_replan_splice_index + 1 - current_index), (int)new_path.size(), result.duration);
     return true;
 }
 
+bool PlannerThread::isCachedPathFree(const PlannerResult& result, XYCell start)
+{
+    //the cached path may start from a cell near the robot, so the segment from the robot to the first waypoint is checked
+    //against the map too. The rest of the path was computed on the same revision of the map.
+    Map2DPath path = m_use_optimized_path ? result.simplified_path : result.path;
+    if (path.size() > 0 && map_utilites::checkStraightLine(m_current_map_blocked, start, m_current_map.toXYCell(path[0])) == false)
+    {
+        return false;
+    }
+
+    //line of sight check of each segment against the obstacles currently detected by the laser
+    bool free = true;
+    m_temporary_obstacles_map_mutex.lock();
+    XYCell prev = start;
+    for (size_t i = 0; i < path.size() && free; i++)
+    {
+        XYCell curr = m_temporary_obstacles_map.toXYCell(path[i]);
+        free = map_utilites::checkStraightLine(m_temporary_obstacles_map, prev, curr);
+        prev = curr;
+    }
+    m_temporary_obstacles_map_mutex.unlock();
+    if (!free)
+    {
+        yDebug("the cached path is blocked by an obstacle");
+    }
+    return free;
+}
+
+void PlannerThread::updateMapRevision()
+{
+    //the revision depends only on the content of the map, so the paths of a map are still valid when the robot comes back
+    //to it (e.g. from another floor), while the paths computed before a modification of the map will never be used again
+    m_map_revision = map_utilites::computeMapRevision(m_current_map);
+    m_current_map_blocked.from_map(m_current_map);
+    m_path_cache.evict(m_current_map.getMapName(), m_map_revision);
+}
@@ -33,6 +33,7 @@
 #include <yarp/dev/PolyDriver.h>
 #include <yarp/os/RateThread.h>
 #include <yarp/dev/IRangefinder2D.h>
+#include <yarp/dev/PreciselyTimed.h>
 #include <yarp/dev/IMap2D.h>
 #include <yarp/dev/MapGrid2D.h>
 #include <yarp/os/Log.h>
@@ -47,6 +48,13 @@
 #include <yarp/dev/Map2DPath.h>
 #include <yarp/dev/Map2DLocation.h>
 #include "map.h"
+#include "pathPlannerWorker.h"
+#include "pathPlannerCache.h"
+#include "mapManager.h"
+#include "trajectoryGenerator.h"
+#include <pose_buffer.h>
+#include <obstacles_delta.h>
+#include <obstacles_merger.h>
 
 using namespace std;
 using namespace yarp::os;
@@ -61,6 +69,14 @@ const double DEG2RAD = M_PI / 180.0;
 
 #define TIMEOUT_MAX 100
 
+//how the path is sent to the inner controller
+enum path_following_mode_t
+{
+    FOLLOW_WAYPOINTS = 0,      //one waypoint at time, each one is reached before sending the next one
+    FOLLOW_TRAJECTORY = 1,     //the whole path, as a smoothed and time-parameterized trajectory
+    FOLLOW_LOOKAHEAD = 2       //the whole path, the inner controller blends through the intermediate waypoints
+};
+
 class PlannerThread: public yarp::os::PeriodicThread
 {
     protected:
@@ -82,6 +98,11 @@ class PlannerThread: public yarp::os::PeriodicThread
     double m_waypoint_ang_gain;        //deg/s
     double m_waypoint_lin_gain;        //m/s
     int    m_min_waypoint_distance;    //cells
+    bool   m_seamless_replan;          //recompute the path without stopping the robot
+    double m_replan_horizon;           //s
+    path_following_mode_t m_path_following_mode;
+    trajectory_generator::limits_t m_trajectory_limits;
+    double m_lookahead_distance;       //m
 
     //semaphore
     public:
@@ -105,8 +126,14 @@ class PlannerThread: public yarp::os::PeriodicThread
     yarp::dev::Nav2D::MapGrid2D m_current_map;
     yarp::dev::Nav2D::MapGrid2D m_temporary_obstacles_map;
     std::mutex m_temporary_obstacles_map_mutex;
-    yarp::dev::Nav2D::MapGrid2D m_augmented_map;
+    obstacles_merger            m_obstacles_merger;       //merges into m_current_map the obstacles found during a recovery
+    yarp::dev::Nav2D::MapGrid2D m_empty_obstacles_map;    //the map without any obstacle, copied to clear m_temporary_obstacles_map
+    bit_grid                    m_current_map_blocked;    //the cells of m_current_map which are not free
     bool      m_force_map_reload;
+    MapManager                  m_map_manager;            //downloads, enlarges and caches the maps in background
+    unsigned int                m_current_map_version;    //the version of m_current_map provided by m_map_manager
+    double                      m_map_check_period;       //the period of the check of m_current_map against the map server [s], 0 to disable
+    double                      m_last_map_check_time;
 
     //yarp device drivers and interfaces
     PolyDriver                                             m_ptf;
@@ -114,12 +141,16 @@ class PlannerThread: public yarp::os::PeriodicThread
     PolyDriver                                             m_pLas;
     PolyDriver                                             m_pMap;
     IRangefinder2D*                                        m_iLaser;
+    IPreciselyTimed*                                       m_iLaserTimed;
     IMap2D*                                                m_iMap;
     ILocalization2D*                                       m_iLoc;
 
     //yarp ports
     BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelRgb> > m_port_map_output;
     BufferedPort<yarp::os::Bottle>                         m_port_status_output;
+    BufferedPort<yarp::os::Bottle>                         m_port_obstacles_output;
+    obstacles_delta_encoder                                m_obstacles_encoder;      //streams the changes of m_temporary_obstacles_map
+    int                                                    m_obstacles_output_count; //the clients of m_port_obstacles_output at the last update
     RpcClient                                              m_port_commands_output;
     yarp::dev::PolyDriver                                  m_pInnerNav;
     yarp::dev::INavigation2DControlActions*                m_iInnerNav_ctrl;
@@ -129,6 +160,7 @@ class PlannerThread: public yarp::os::PeriodicThread
     //internal data
     Searchable                             &m_cfg;
     yarp::dev::Nav2D::Map2DLocation        m_localization_data;
+    pose_buffer                            m_localization_buffer;   //recent localization data, used to motion-compensate the laser scans
     yarp::dev::Nav2D::Map2DLocation        m_final_goal;
     double                                 m_navigation_started_at_timeX;
     double                                 m_final_goal_reached_at_timeX;
@@ -143,6 +175,23 @@ class PlannerThread: public yarp::os::PeriodicThread
     yarp::dev::Nav2D::Map2DPath::iterator         m_current_path_iterator;
     std::deque< yarp::dev::Nav2D::Map2DLocation>  m_remaining_path;
 
+    //the paths are computed by the worker thread, the result is collected by run() while the status is navigation_status_thinking
+    PathPlannerWorker                             m_planner_worker;
+    std::future<PlannerResult>                    m_planner_result;
+
+    //the paths already computed, reused when the same route is requested again. The key of the request in progress
+    //is kept to store its result.
+    PathPlannerCache                              m_path_cache;
+    size_t                                        m_map_revision;
+    size_t                                        m_planner_request_revision;
+    yarp::dev::Nav2D::XYCell                      m_planner_request_start;
+    yarp::dev::Nav2D::XYCell                      m_planner_request_goal;
+
+    //a path recomputed while the robot is moving, spliced onto the current path by run() after the waypoint m_replan_splice_index
+    std::future<PlannerResult>                    m_replan_result;
+    size_t                                        m_replan_splice_index;
+    std::string                                   m_replan_map_id;
+
     //statuses of the internal finite-state machine
     NavigationStatusEnum   m_planner_status;
     NavigationStatusEnum   m_inner_status;
@@ -186,6 +235,48 @@ class PlannerThread: public yarp::os::PeriodicThread
     * @return true if the operation was successful, false otherwise.
     */
     bool          resumeMovement();
+
+    /**
+    * Recomputes the path to the current goal without stopping the robot.
+    * The new path starts from the first waypoint that the robot will reach after m_replan_horizon seconds. It is computed
+    * by the worker thread while the robot follows the current path, which is replaced after that waypoint as soon as
+    * the new one is available.
+    * @return true if the recomputation has been started (or it is not needed), false if the robot is not moving.
+    */
+    bool          recomputePath();
+
+    /**
+    * @return true if recomputePath() should be used instead of stopping the robot and setting again the goal
+    */
+    bool          isSeamlessReplanEnabled() const { return m_seamless_replan; }
+
+    /**
+    * Computes the order in which a set of goals should be visited, starting from the current robot position, to minimize
+    * the length of the route. The lengths of the paths between the goals are computed in parallel on a copy of the current map,
+    * so the navigation is not blocked. This method must not be called while holding m_mutex.
+    * @param goals the goals to be visited, all in the current map
+    * @param order the indices of the goals, in the order they should be visited
+    * @param length the length of the route [m]
+    * @return true if all the goals can be reached, false otherwise
+    */
+    bool          optimizeRoute(const std::vector<yarp::dev::Nav2D::Map2DLocation>& goals, std::vector<size_t>& order, double& length);
+
+    /**
+    * Sets a sequence of targets, expressed in the map reference frame. Each goal is planned when the previous one is reached.
+    * @param goals the goals, in the order they must be reached
+    * @return true if the navigation towards the first goal has been started
+    */
+    bool          setNewRoute(const std::vector<yarp::dev::Nav2D::Map2DLocation>& goals);
+
+    /**
+    * Retrieves the goals still to be reached, the current one first.
+    */
+    bool          getRoute(std::vector<yarp::dev::Nav2D::Map2DLocation>& goals);
+
+    /**
+    * Retrieves a location stored into the map server
+    */
+    bool          getLocation(const std::string& location_name, yarp::dev::Nav2D::Map2DLocation& loc);
     
     /**
     * Returns robot current position
@@ -273,7 +364,18 @@ class PlannerThread: public yarp::os::PeriodicThread
 
     private:
     bool          startPath();
+    void          completePath(const PlannerResult& result);
+    bool          splicePath(const PlannerResult& result);
+    bool          isCachedPathFree(const PlannerResult& result, yarp::dev::Nav2D::XYCell start);
+    void          updateMapRevision();
     void          sendWaypoint();
+    void          sendSetCommand(const std::string& param, double value);
+    void          sendGoalParameters();
+    void          sendWaypointParameters();
+    void          addApproachLimits(yarp::os::Bottle& cmd);
+    void          sendTrajectory();
+    void          sendLookaheadPath();
+    void          advancePassedWaypoints();
     void          sendFinalGoal();
     bool          readLocalizationData();
     void          readLaserData();
@@ -18,6 +18,8 @@
 
 #include "pathPlannerCtrl.h"
 #include "pathPlannerCtrlHelpers.h"
+#include "routeOptimizer.h"
+#include <limits>
 
 using namespace std;
 using namespace yarp::dev;
@@ -25,17 +27,22 @@ using namespace yarp::dev::Nav2D;
 
 bool PlannerThread::setNewAbsTarget(Map2DLocation target)
 {
+    //a goal received while the previous one is still being planned replaces it
+    m_mutex.wait();
     if (m_planner_status != navigation_status_idle &&
         m_planner_status != navigation_status_goal_reached &&
         m_planner_status != navigation_status_aborted &&
-        m_planner_status != navigation_status_failing)
+        m_planner_status != navigation_status_failing &&
+        m_planner_status != navigation_status_thinking)
     {
         yError ("Not in idle state, send a 'stop' first\n");
+        m_mutex.post();
         return false;
     }
 
     m_final_goal = target;
 
+    bool ret = true;
     if (target.map_id == m_current_map.getMapName())
     {
         //this a trick to clean the queue
@@ -43,14 +50,10 @@ bool PlannerThread::setNewAbsTarget(Map2DLocation target)
         std::swap(m_sequence_of_goals, empty);
 
         m_sequence_of_goals.push(m_final_goal);
-        if (startPath())
-        {
-            return true;
-        }
-        else
+        if (startPath() == false)
         {
             yError() << "PlannerThread::setNewAbsTarget() Unable to start path";
-            return false;
+            ret = false;
         }
     }
     else
@@ -63,9 +66,10 @@ bool PlannerThread::setNewAbsTarget(Map2DLocation target)
         std::queue<Map2DLocation> empty;
         std::swap(m_sequence_of_goals, empty);
         m_sequence_of_goals.push(m_final_goal);
-        return false;
+        ret = false;
     }
-    return true;
+    m_mutex.post();
+    return ret;
 }
 
 bool PlannerThread::setNewRelTarget(yarp::sig::Vector target)
@@ -84,12 +88,16 @@ bool PlannerThread::setNewRelTarget(yarp::sig::Vector target)
     }
 
     //target and localization data are formatted as follows: x, y, angle (in degrees)
+    //a goal received while the previous one is still being planned replaces it
+    m_mutex.wait();
     if (m_planner_status != navigation_status_idle &&
         m_planner_status != navigation_status_goal_reached &&
         m_planner_status != navigation_status_aborted &&
-        m_planner_status != navigation_status_failing)
+        m_planner_status != navigation_status_failing &&
+        m_planner_status != navigation_status_thinking)
     {
         yError ("Not in idle state, send a 'stop' first");
+        m_mutex.post();
         return false;
     }
     yDebug() << "received new relative target at:" << target[0] << target[1] << target[2];
@@ -104,20 +112,23 @@ bool PlannerThread::setNewRelTarget(yarp::sig::Vector target)
     std::queue<Map2DLocation> empty;
     std::swap(m_sequence_of_goals, empty);
     m_sequence_of_goals.push(m_final_goal);
-    if (startPath())
-    {
-        return true;
-    }
-    else
+    bool ret = startPath();
+    if (ret == false)
     {
         yError() << "PlannerThread::setNewRelTarget() Unable to start path";
-        return false;
     }
+    m_mutex.post();
+    return ret;
 }
 
 bool PlannerThread::stopMovement()
 {
     bool ret = true;
+    m_mutex.wait();
+    //discard the path under computation, if any
+    m_planner_worker.cancel();
+    m_replan_result = std::future<PlannerResult>();
+
     //stop the inner navigation loop
     m_iInnerNav_ctrl->stopNavigation();
 
@@ -132,9 +143,193 @@ bool PlannerThread::stopMovement()
         yWarning ("Already not moving");
         ret = false;
     }
+    m_mutex.post();
     return ret;
 }
 
+bool PlannerThread::recomputePath()
+{
+    m_mutex.wait();
+    if (m_planner_status != navigation_status_moving || m_current_path == nullptr || m_sequence_of_goals.empty())
+    {
+        yError() << "PlannerThread::recomputePath() the robot is not moving";
+        m_mutex.post();
+        return false;
+    }
+
+    //the robot keeps following the current path while the new one is computed, so the new path starts from the first
+    //waypoint which is farther than the distance that the robot can travel in m_replan_horizon seconds.
+    double lookahead = m_waypoint_max_lin_speed * m_replan_horizon;
+    double distance = 0;
+    double prev_x = m_localization_data.x;
+    double prev_y = m_localization_data.y;
+    Map2DPath::iterator splice = m_current_path_iterator;
+    for (; splice != m_current_path->end(); splice++)
+    {
+        distance += sqrt(pow(splice->x - prev_x, 2) + pow(splice->y - prev_y, 2));
+        if (distance >= lookahead) break;
+        prev_x = splice->x;
+        prev_y = splice->y;
+    }
+
+    //nothing to recompute if the robot will be on the last segment of the path (or on the way to the final goal)
+    if (splice == m_current_path->end() || splice == m_current_path->end() - 1)
+    {
+        yInfo() << "PlannerThread::recomputePath() the goal is closer than the replan horizon, the current path is kept";
+        m_mutex.post();
+        return true;
+    }
+
+    yarp::math::Vec2D<double> goal_vec;
+    goal_vec.x = m_sequence_of_goals.front().x;
+    goal_vec.y = m_sequence_of_goals.front().y;
+    XYCell start = m_current_map.toXYCell(*splice);
+    XYCell goal = m_current_map.world2Cell(goal_vec);
+
+    //a previous recomputation still in progress is interrupted
+    m_replan_splice_index = splice - m_current_path->begin();
+    m_replan_map_id = m_current_map.getMapName();
+    m_replan_result = m_planner_worker.request(m_current_map, start, goal);
+    yInfo() << "PlannerThread::recomputePath() recomputing the path from waypoint" << m_replan_splice_index << ":" << splice->toString();
+    m_mutex.post();
+    return true;
+}
+
+bool PlannerThread::optimizeRoute(const std::vector<Map2DLocation>& goals, std::vector<size_t>& order, double& length)
+{
+    order.clear();
+    length = 0;
+    if (goals.empty())
+    {
+        yError() << "PlannerThread::optimizeRoute() no goals";
+        return false;
+    }
+
+    //the route is computed on a copy of the map, so the control loop keeps running in the meanwhile
+    m_mutex.wait();
+    MapGrid2D map = m_current_map;
+    Map2DLocation robot = m_localization_data;
+    m_mutex.post();
+
+    yarp::math::Vec2D<double> start_vec;
+    start_vec.x = robot.x;
+    start_vec.y = robot.y;
+    if (map.isInsideMap(start_vec) == false)
+    {
+        yError() << "PlannerThread::optimizeRoute() current robot location (" << start_vec.toString() << ") is not inside map" << map.getMapName();
+        return false;
+    }
+    std::vector<XYCell> points;
+    points.push_back(map.world2Cell(start_vec));
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        yarp::math::Vec2D<double> goal_vec;
+        goal_vec.x = goals[i].x;
+        goal_vec.y = goals[i].y;
+        if (goals[i].map_id != map.getMapName() || map.isInsideMap(goal_vec) == false)
+        {
+            yError() << "PlannerThread::optimizeRoute() goal" << goals[i].toString() << "is not inside map" << map.getMapName();
+            return false;
+        }
+        points.push_back(map.world2Cell(goal_vec));
+    }
+
+    double t1 = yarp::os::Time::now();
+    std::vector<std::vector<double> > costs;
+    route_optimizer::compute_cost_matrix(map, points, costs);
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        if (costs[0][i + 1] == std::numeric_limits<double>::infinity())
+        {
+            yError() << "PlannerThread::optimizeRoute() goal" << goals[i].toString() << "cannot be reached";
+            return false;
+        }
+    }
+
+    std::vector<size_t> tour;
+    length = route_optimizer::solve_open_tour(costs, tour);
+    for (size_t k = 1; k < tour.size(); k++)
+    {
+        order.push_back(tour[k] - 1);
+    }
+    double given_length = 0;
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        given_length += costs[i - 1][i];
+    }
+    yInfo("route of %d goals: %.2f m (%.2f m in the given order), time: %.2f", (int)goals.size(), length, given_length, yarp::os::Time::now() - t1);
+    return true;
+}
+
+bool PlannerThread::setNewRoute(const std::vector<Map2DLocation>& goals)
+{
+    if (goals.empty())
+    {
+        yError() << "PlannerThread::setNewRoute() no goals";
+        return false;
+    }
+
+    m_mutex.wait();
+    if (m_planner_status != navigation_status_idle &&
+        m_planner_status != navigation_status_goal_reached &&
+        m_planner_status != navigation_status_aborted &&
+        m_planner_status != navigation_status_failing &&
+        m_planner_status != navigation_status_thinking)
+    {
+        yError ("Not in idle state, send a 'stop' first");
+        m_mutex.post();
+        return false;
+    }
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        if (goals[i].map_id != m_current_map.getMapName())
+        {
+            yError() << "PlannerThread::setNewRoute() goal" << goals[i].toString() << "is not in the current map";
+            m_mutex.post();
+            return false;
+        }
+    }
+
+    std::queue<Map2DLocation> empty;
+    std::swap(m_sequence_of_goals, empty);
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        m_sequence_of_goals.push(goals[i]);
+    }
+    m_final_goal = m_sequence_of_goals.front();
+    bool ret = startPath();
+    if (ret == false)
+    {
+        yError() << "PlannerThread::setNewRoute() Unable to start path";
+    }
+    m_mutex.post();
+    return ret;
+}
+
+bool PlannerThread::getRoute(std::vector<Map2DLocation>& goals)
+{
+    m_mutex.wait();
+    goals.clear();
+    std::queue<Map2DLocation> copy = m_sequence_of_goals;
+    while (!copy.empty())
+    {
+        goals.push_back(copy.front());
+        copy.pop();
+    }
+    m_mutex.post();
+    return true;
+}
+
+bool PlannerThread::getLocation(const std::string& location_name, Map2DLocation& loc)
+{
+    if (m_iMap->getLocation(location_name, loc) == false)
+    {
+        yError() << "PlannerThread::getLocation() location" << location_name << "not found";
+        return false;
+    }
+    return true;
+}
+
 bool PlannerThread::resumeMovement()
 {
     bool ret = true;
@@ -144,7 +339,8 @@ bool PlannerThread::resumeMovement()
     //resume the outer navigation loop
     if (m_planner_status != navigation_status_moving)
     {
-        m_planner_status = navigation_status_moving;
+        //the navigation may have been paused while the path was still being computed
+        m_planner_status = (m_current_path == nullptr) ? navigation_status_thinking : navigation_status_moving;
         yInfo ("Navigation resumed");
     }
     else
@@ -27,6 +27,7 @@ PlannerThread::PlannerThread(double _period, Searchable &_cfg) :
 {
     m_planner_status = navigation_status_idle;
     m_inner_status = navigation_status_idle;
+    m_current_path = nullptr;
     m_loc_timeout_counter = 0;
     m_laser_timeout_counter = 0;
     m_inner_status_timeout_counter = 0;
@@ -45,7 +46,15 @@ PlannerThread::PlannerThread(double _period, Searchable &_cfg) :
     m_use_optimized_path = true;
     m_current_path = &m_computed_simplified_path;
     m_min_waypoint_distance = 0;
+    m_seamless_replan = true;
+    m_replan_horizon = 1.0;
+    m_path_following_mode = FOLLOW_WAYPOINTS;
+    m_lookahead_distance = 0.5;
+    m_replan_splice_index = 0;
+    m_map_revision = 0;
+    m_planner_request_revision = 0;
     m_iLaser = 0;
+    m_iLaserTimed = 0;
     m_iLoc = 0;
     m_min_laser_angle = 0;
     m_max_laser_angle = 0;
@@ -59,6 +68,10 @@ PlannerThread::PlannerThread(double _period, Searchable &_cfg) :
     m_iInnerNav_ctrl = 0;
     m_iInnerNav_target = 0;
     m_force_map_reload = false;
+    m_obstacles_output_count = 0;
+    m_current_map_version = 0;
+    m_map_check_period = 30.0;
+    m_last_map_check_time = 0;
     m_navigation_started_at_timeX = 0;
     m_final_goal_reached_at_timeX = 0;
 }
@@ -116,6 +129,38 @@ bool PlannerThread::threadInit()
     else { yError() << "Missing min_waypoint_distance parameter"; return false; }
     if (navigation_group.check("enable_try_recovery")) { m_enable_try_recovery = (navigation_group.find("enable_try_recovery").asInt() == 1); }
     else { yError() << "Missing enable_try_recovery parameter"; return false; }
+    if (navigation_group.check("replan_mode"))
+    {
+        string mode = navigation_group.find("replan_mode").asString();
+        if      (mode == "seamless") { m_seamless_replan = true; }
+        else if (mode == "stop")     { m_seamless_replan = false; }
+        else { yError() << "Invalid replan_mode parameter:" << mode << "(valid values are: seamless, stop)"; return false; }
+    }
+    if (navigation_group.check("replan_horizon")) { m_replan_horizon = navigation_group.find("replan_horizon").asDouble(); }
+    if (m_replan_horizon <= 0) { yError() << "Invalid replan_horizon parameter:" << m_replan_horizon << "(it must be positive)"; return false; }
+    {
+        size_t cache_size = 32;
+        size_t cache_region = 5;
+        if (navigation_group.check("path_cache_size")) { cache_size = navigation_group.find("path_cache_size").asInt(); }
+        if (navigation_group.check("path_cache_start_region")) { cache_region = navigation_group.find("path_cache_start_region").asInt(); }
+        m_path_cache.configure(cache_size, cache_region);
+    }
+    if (navigation_group.check("path_following_mode"))
+    {
+        string mode = navigation_group.find("path_following_mode").asString();
+        if      (mode == "waypoints")  { m_path_following_mode = FOLLOW_WAYPOINTS; }
+        else if (mode == "trajectory") { m_path_following_mode = FOLLOW_TRAJECTORY; }
+        else if (mode == "lookahead")  { m_path_following_mode = FOLLOW_LOOKAHEAD; }
+        else { yError() << "Invalid path_following_mode parameter:" << mode << "(valid values are: waypoints, trajectory, lookahead)"; return false; }
+    }
+    m_trajectory_limits.max_lin_speed = m_waypoint_max_lin_speed;
+    m_trajectory_limits.max_ang_speed = m_waypoint_max_ang_speed;
+    if (navigation_group.check("trajectory_max_lin_acc")) { m_trajectory_limits.max_lin_acc = navigation_group.find("trajectory_max_lin_acc").asDouble(); }
+    if (navigation_group.check("trajectory_max_lat_acc")) { m_trajectory_limits.max_lat_acc = navigation_group.find("trajectory_max_lat_acc").asDouble(); }
+    if (navigation_group.check("trajectory_blend_distance")) { m_trajectory_limits.blend_distance = navigation_group.find("trajectory_blend_distance").asDouble(); }
+    if (navigation_group.check("trajectory_sample_distance")) { m_trajectory_limits.sample_distance = navigation_group.find("trajectory_sample_distance").asDouble(); }
+    if (navigation_group.check("lookahead_distance")) { m_lookahead_distance = navigation_group.find("lookahead_distance").asDouble(); }
+    if (navigation_group.check("obstacles_decay_time")) { m_obstacles_merger.configure(navigation_group.find("obstacles_decay_time").asDouble()); }
 
     Bottle general_group = m_cfg.findGroup("GENERAL");
     if (general_group.isNull())
@@ -142,6 +187,25 @@ bool PlannerThread::threadInit()
     if (localization_group.check("localizationServer_name")) localizationServer_name = localization_group.find("localizationServer_name").asString();
     if (localization_group.check("mapServer_name")) mapServer_name = localization_group.find("mapServer_name").asString();
     if (general_group.check("name")) localName = general_group.find("name").asString();
+    if (general_group.check("obstacles_keyframe_period")) m_obstacles_encoder.set_keyframe_period(general_group.find("obstacles_keyframe_period").asDouble());
+    string map_cache_dir = yarp::os::ResourceFinder::getDataHome() + "/robotPathPlanner/map_cache";
+    if (general_group.check("map_cache_dir")) map_cache_dir = general_group.find("map_cache_dir").asString();
+    if (map_cache_dir == "none") map_cache_dir = "";
+    if (general_group.check("map_check_period")) m_map_check_period = general_group.find("map_check_period").asDouble();
+    std::vector<std::string> prefetch_maps(1, "all");
+    if (general_group.check("prefetch_maps"))
+    {
+        Value& v = general_group.find("prefetch_maps");
+        prefetch_maps.clear();
+        if (v.isList())
+        {
+            for (size_t i = 0; i < v.asList()->size(); i++) prefetch_maps.push_back(v.asList()->get(i).asString());
+        }
+        else if (v.asString() != "none")
+        {
+            prefetch_maps.push_back(v.asString());
+        }
+    }
     
     bool ff = geometry_group.check("robot_radius");
     ff &= geometry_group.check("laser_pos_x");
@@ -165,6 +229,7 @@ bool PlannerThread::threadInit()
     ret &= m_port_status_output.open((localName + "/plannerStatus:o").c_str());
     ret &= m_port_commands_output.open((localName + "/commands:o").c_str());
     ret &= m_port_map_output.open((localName + "/map:o").c_str());
+    ret &= m_port_obstacles_output.open((localName + "/obstacles:o").c_str());
     if (ret == false)
     {
         yError() << "Unable to open module ports";
@@ -207,6 +272,11 @@ bool PlannerThread::threadInit()
             yError() << "Unable to open map interface";
             return false;
         }
+        if (m_map_manager.start(m_iMap, m_robot_radius, map_cache_dir, prefetch_maps) == false)
+        {
+            yError() << "Unable to start the map manager";
+            return false;
+        }
     }
 
     //open the laser interface
@@ -239,6 +309,11 @@ bool PlannerThread::threadInit()
             yError() << "Unable to open laser interface";
             return false;
         }
+        m_pLas.view(m_iLaserTimed);
+        if (m_iLaserTimed == 0)
+        {
+            yWarning() << "Laser timestamps not available, laser scans will not be motion-compensated";
+        }
         if (m_iLaser->getScanLimits(m_min_laser_angle, m_max_laser_angle) == false)
         {
             yError() << "Unable to obtain laser scan limits";
@@ -290,16 +365,27 @@ bool PlannerThread::threadInit()
             return false;
         }
     }
+
+    //start the thread which computes the paths
+    if (m_planner_worker.start() == false)
+    {
+        yError() << "Unable to start the planner worker";
+        return false;
+    }
     return true;
 }
 
 void PlannerThread :: threadRelease()
 {
+    m_planner_worker.stop();
+    m_map_manager.stop();
     if (m_pLoc.isValid()) m_pLoc.close();
     if (m_ptf.isValid()) m_ptf.close();
     if (m_pLas.isValid()) m_pLas.close();
     m_port_map_output.interrupt();
     m_port_map_output.close();
+    m_port_obstacles_output.interrupt();
+    m_port_obstacles_output.close();
     m_port_status_output.interrupt();
     m_port_status_output.close();
     m_port_commands_output.interrupt();
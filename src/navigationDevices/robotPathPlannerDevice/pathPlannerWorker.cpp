@@ -0,0 +1,141 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include "pathPlannerWorker.h"
+#include "map.h"
+
+using namespace yarp::dev::Nav2D;
+
+PathPlannerWorker::PathPlannerWorker()
+{
+    m_busy = false;
+    m_stop = false;
+    m_cancel = false;
+}
+
+PathPlannerWorker::~PathPlannerWorker()
+{
+    stop();
+}
+
+bool PathPlannerWorker::start()
+{
+    if (m_thread.joinable()) return true;
+    m_stop = false;
+    m_thread = std::thread(&PathPlannerWorker::loop, this);
+    return true;
+}
+
+void PathPlannerWorker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_cancel = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+
+    //nobody will process the pending request
+    if (m_pending)
+    {
+        PlannerResult result;
+        result.cancelled = true;
+        m_pending->promise.set_value(result);
+        m_pending.reset();
+    }
+}
+
+std::future<PlannerResult> PathPlannerWorker::request(const MapGrid2D& map, XYCell start, XYCell goal)
+{
+    std::unique_ptr<job_t> job(new job_t);
+    job->map = map;
+    job->start = start;
+    job->goal = goal;
+    std::future<PlannerResult> future = job->promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending)
+        {
+            PlannerResult result;
+            result.cancelled = true;
+            m_pending->promise.set_value(result);
+        }
+        m_pending = std::move(job);
+        if (m_busy) m_cancel = true;
+    }
+    m_cv.notify_one();
+    return future;
+}
+
+void PathPlannerWorker::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending)
+    {
+        PlannerResult result;
+        result.cancelled = true;
+        m_pending->promise.set_value(result);
+        m_pending.reset();
+    }
+    if (m_busy) m_cancel = true;
+}
+
+bool PathPlannerWorker::isBusy()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_busy || m_pending;
+}
+
+void PathPlannerWorker::loop()
+{
+    for (;;)
+    {
+        std::unique_ptr<job_t> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_busy = false;
+            m_cv.wait(lock, [this] { return m_stop || m_pending; });
+            if (m_stop) return;
+            job = std::move(m_pending);
+            m_busy = true;
+            m_cancel = false;
+        }
+
+        PlannerResult result;
+        double t1 = yarp::os::Time::now();
+        //the blocked cells are extracted once from the map and shared by the search and by the simplification of the path
+        bit_grid blocked;
+        blocked.from_map(job->map);
+        result.found = map_utilites::findPath(job->map, blocked, job->start, job->goal, result.path, &m_cancel);
+        if (result.found)
+        {
+            map_utilites::simplifyPath(job->map, blocked, result.path, result.simplified_path);
+        }
+        result.duration = yarp::os::Time::now() - t1;
+        result.cancelled = m_cancel;
+        if (result.cancelled)
+        {
+            result.found = false;
+            yDebug() << "PathPlannerWorker: search interrupted after" << result.duration << "s";
+        }
+        job->promise.set_value(result);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef PATH_PLANNER_WORKER_H
+#define PATH_PLANNER_WORKER_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DPath.h>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//! the outcome of a path search
+struct PlannerResult
+{
+    bool                          found;            //a path exists
+    bool                          cancelled;        //the search has been interrupted by a newer request or by cancel()
+    yarp::dev::Nav2D::Map2DPath   path;             //the path computed by A*
+    yarp::dev::Nav2D::Map2DPath   simplified_path;  //the same path, with the minimum number of waypoints
+    double                        duration;         //time spent in the search [s]
+
+    PlannerResult() : found(false), cancelled(false), duration(0) {}
+};
+
+/**
+* Computes the paths in a dedicated thread, so that the control loop of the planner never waits for the search.
+* Only the most recent request matters: a new request replaces the one still waiting in the queue and interrupts
+* the one in progress, whose futures return a cancelled result.
+*/
+class PathPlannerWorker
+{
+    struct job_t
+    {
+        yarp::dev::Nav2D::MapGrid2D     map;
+        yarp::dev::Nav2D::XYCell        start;
+        yarp::dev::Nav2D::XYCell        goal;
+        std::promise<PlannerResult>     promise;
+    };
+
+    std::thread                  m_thread;
+    std::mutex                   m_mutex;
+    std::condition_variable      m_cv;
+    std::unique_ptr<job_t>       m_pending;     //the next job to be processed
+    bool                         m_busy;        //a job is in progress
+    bool                         m_stop;
+    std::atomic<bool>            m_cancel;      //interrupts the job in progress
+
+public:
+    PathPlannerWorker();
+    ~PathPlannerWorker();
+
+    bool start();
+    void stop();
+
+    /**
+    * Requests a new path. The map is copied, so it can be modified while the search is in progress.
+    * @return the future which receives the result of the search
+    */
+    std::future<PlannerResult> request(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal);
+
+    /**
+    * Discards the pending request and interrupts the search in progress, if any.
+    */
+    void cancel();
+
+    bool isBusy();
+
+private:
+    void loop();
+};
+
+#endif
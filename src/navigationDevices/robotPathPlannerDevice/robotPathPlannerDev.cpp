@@ -121,7 +121,6 @@ bool robotPathPlannerDev::read(yarp::os::ConnectionReader& connection)
     if (!ok) return false;
     reply.clear();
 
-    m_plannerThread->m_mutex.wait();
     if (command.get(0).isString())
     {
         if (command.get(0).asString()=="help")
@@ -129,10 +128,19 @@ bool robotPathPlannerDev::read(yarp::os::ConnectionReader& connection)
             reply.addVocab(Vocab::encode("many"));
             reply.addString("set_robot_radius <size_m>");
             reply.addString("get_robot_radius");
+            reply.addString("optimize_route <location_name1> <location_name2> ...");
+            reply.addString("goto_route <location_name1> <location_name2> ...");
+            reply.addString("get_route");
+        }
+        else if (parse_route_command(command, reply))
+        {
+            //the route commands take the mutex only when needed, since the optimization of a route may take some time
         }
         else if (command.get(0).isString())
         {
+            m_plannerThread->m_mutex.wait();
             parse_respond_string(command, reply);
+            m_plannerThread->m_mutex.post();
         }
     }
     else
@@ -146,7 +154,6 @@ bool robotPathPlannerDev::read(yarp::os::ConnectionReader& connection)
     {
         reply.write(*returnToSender);
     }
-    m_plannerThread->m_mutex.post();
     return true;
 }
 
@@ -190,6 +197,18 @@ bool robotPathPlannerDev::recomputeCurrentNavigationPath()
         return false;
     }
 
+    //while moving, the new path is computed in background and spliced onto the current one, without stopping the robot
+    if (m_plannerThread->isSeamlessReplanEnabled() &&
+        m_plannerThread->getNavigationStatusAsInt() == yarp::dev::navigation_status_moving)
+    {
+        if (m_plannerThread->recomputePath() == false)
+        {
+            yError() << "robotPathPlannerDev::recomputeCurrentNavigationPath(). An error occurred while performing the requested operation.";
+            return false;
+        }
+        return true;
+    }
+
     Map2DLocation loc;
     bool b = true;
     b &= m_plannerThread->getCurrentAbsTarget(loc);
@@ -319,3 +338,60 @@ bool robotPathPlannerDev::parse_respond_string(const yarp::os::Bottle& command,
     }
     return true;
 }
+
+bool robotPathPlannerDev::parse_route_command(const yarp::os::Bottle& command, yarp::os::Bottle& reply)
+{
+    std::string cmd = command.get(0).asString();
+    if (cmd == "optimize_route" || cmd == "goto_route")
+    {
+        std::vector<std::string> names;
+        std::vector<Map2DLocation> goals;
+        for (size_t i = 1; i < command.size(); i++)
+        {
+            Map2DLocation loc;
+            if (m_plannerThread->getLocation(command.get(i).asString(), loc) == false)
+            {
+                reply.addString(cmd + " failed");
+                return true;
+            }
+            names.push_back(command.get(i).asString());
+            goals.push_back(loc);
+        }
+
+        std::vector<size_t> order;
+        double length = 0;
+        if (m_plannerThread->optimizeRoute(goals, order, length) == false)
+        {
+            reply.addString(cmd + " failed");
+            return true;
+        }
+        std::vector<Map2DLocation> ordered_goals;
+        Bottle ordered_names;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            ordered_goals.push_back(goals[order[i]]);
+            ordered_names.addString(names[order[i]]);
+        }
+
+        if (cmd == "goto_route" && m_plannerThread->setNewRoute(ordered_goals) == false)
+        {
+            reply.addString(cmd + " failed");
+            return true;
+        }
+        reply.addList() = ordered_names;
+        reply.addFloat64(length);
+        return true;
+    }
+    if (cmd == "get_route")
+    {
+        std::vector<Map2DLocation> goals;
+        m_plannerThread->getRoute(goals);
+        Bottle& route = reply.addList();
+        for (size_t i = 0; i < goals.size(); i++)
+        {
+            route.addString(goals[i].toString());
+        }
+        return true;
+    }
+    return false;
+}
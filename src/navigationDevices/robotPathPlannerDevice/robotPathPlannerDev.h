@@ -53,6 +53,7 @@ public:
 
     /* RPC responder */
     bool parse_respond_string(const yarp::os::Bottle& command, yarp::os::Bottle& reply);
+    bool parse_route_command(const yarp::os::Bottle& command, yarp::os::Bottle& reply);
     virtual bool read(yarp::os::ConnectionReader& connection) override;
 
 public:
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+#include "routeOptimizer.h"
+
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    //the costs of a straight and of a diagonal step, the same used by aStar_algorithm::find_astar_path()
+    const int STEP_COST = 10;
+    const int DIAGONAL_STEP_COST = 14;
+
+    /**
+    * Dijkstra search from the cell source, which stops as soon as all the targets have been reached.
+    * @param dist a w*h buffer, reused between the searches
+    * @param target_costs the cost to reach each target, -1 if it is not reachable
+    * @return false if the search has been interrupted
+    */
+    bool multi_target_search(const std::vector<unsigned char>& free_cells, size_t w, size_t h, size_t source,
+                             const std::vector<size_t>& targets, std::vector<int>& dist, std::vector<int>& target_costs,
+                             const std::atomic<bool>* cancel)
+    {
+        typedef std::pair<int, size_t> entry_t;
+        std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t> > open_set;
+        std::fill(dist.begin(), dist.end(), std::numeric_limits<int>::max());
+        target_costs.assign(targets.size(), -1);
+
+        //several points may share the same cell
+        size_t remaining = targets.size();
+        std::vector<std::pair<size_t, size_t> > sorted_targets;
+        for (size_t i = 0; i < targets.size(); i++) sorted_targets.push_back(std::make_pair(targets[i], i));
+        std::sort(sorted_targets.begin(), sorted_targets.end());
+
+        dist[source] = 0;
+        open_set.push(entry_t(0, source));
+        const int dx[8] = { 1, -1, 0,  0, 1,  1, -1, -1 };
+        const int dy[8] = { 0,  0, 1, -1, 1, -1,  1, -1 };
+        size_t iterations = 0;
+        while (!open_set.empty() && remaining > 0)
+        {
+            if (cancel && (++iterations & 0xFFF) == 0 && cancel->load())
+            {
+                return false;
+            }
+            entry_t curr = open_set.top();
+            open_set.pop();
+            if (curr.first > dist[curr.second]) continue;
+
+            //the cell is settled: its cost is final
+            auto range = std::equal_range(sorted_targets.begin(), sorted_targets.end(), std::make_pair(curr.second, size_t(0)),
+                                          [](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) { return a.first < b.first; });
+            for (auto it = range.first; it != range.second; it++)
+            {
+                target_costs[it->second] = curr.first;
+                remaining--;
+            }
+
+            int cx = int(curr.second % w);
+            int cy = int(curr.second / w);
+            for (size_t n = 0; n < 8; n++)
+            {
+                int nx = cx + dx[n];
+                int ny = cy + dy[n];
+                if (nx < 0 || ny < 0 || nx >= int(w) || ny >= int(h)) continue;
+                size_t next = size_t(ny) * w + size_t(nx);
+                if (!free_cells[next]) continue;
+                int cost = curr.first + (n < 4 ? STEP_COST : DIAGONAL_STEP_COST);
+                if (cost < dist[next])
+                {
+                    dist[next] = cost;
+                    open_set.push(entry_t(cost, next));
+                }
+            }
+        }
+        return true;
+    }
+}
+
+bool route_optimizer::compute_cost_matrix(const MapGrid2D& map, const std::vector<XYCell>& points,
+                                          std::vector<std::vector<double> >& costs, size_t num_threads, const std::atomic<bool>* cancel)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    size_t n = points.size();
+    costs.assign(n, std::vector<double>(n, inf));
+    for (size_t i = 0; i < n; i++) costs[i][i] = 0;
+    if (n < 2) return true;
+
+    size_t w = map.width();
+    size_t h = map.height();
+    std::vector<unsigned char> free_cells(w * h);
+    for (size_t y = 0; y < h; y++)
+        for (size_t x = 0; x < w; x++)
+            free_cells[y * w + x] = map.isFree(XYCell(x, y)) ? 1 : 0;
+
+    //the points outside the map or on an obstacle cannot be reached. Only the first one may be a start point.
+    std::vector<size_t> cells(n);
+    std::vector<unsigned char> valid(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        bool inside = points[i].x < w && points[i].y < h;
+        cells[i] = inside ? points[i].y * w + points[i].x : 0;
+        valid[i] = inside && (i == 0 || free_cells[cells[i]]);
+    }
+
+    //the grid is undirected, so the costs are symmetric: the search from the point i looks only for the points j>i
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    num_threads = std::max<size_t>(1, std::min(num_threads, n - 1));
+    std::atomic<size_t> next_search(0);
+    std::atomic<bool> interrupted(false);
+    double resolution = 1.0;
+    map.getResolution(resolution);
+    auto worker = [&]()
+    {
+        std::vector<int> dist(w * h);
+        std::vector<size_t> targets;
+        std::vector<size_t> target_ids;
+        std::vector<int> target_costs;
+        for (size_t i = next_search++; i < n - 1; i = next_search++)
+        {
+            if (!valid[i]) continue;
+            targets.clear();
+            target_ids.clear();
+            for (size_t j = i + 1; j < n; j++)
+            {
+                if (!valid[j]) continue;
+                targets.push_back(cells[j]);
+                target_ids.push_back(j);
+            }
+            if (!multi_target_search(free_cells, w, h, cells[i], targets, dist, target_costs, cancel))
+            {
+                interrupted = true;
+                return;
+            }
+            //costs[i][j] and costs[j][i] (j>i) are written only by the thread which searched from i
+            for (size_t t = 0; t < target_ids.size(); t++)
+            {
+                if (target_costs[t] < 0) continue;
+                double c = target_costs[t] / double(STEP_COST) * resolution;
+                costs[i][target_ids[t]] = c;
+                costs[target_ids[t]][i] = c;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; t++) threads.push_back(std::thread(worker));
+    worker();
+    for (auto& t : threads) t.join();
+    return !interrupted;
+}
+
+double route_optimizer::solve_open_tour(const std::vector<std::vector<double> >& costs, std::vector<size_t>& order)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    size_t n = costs.size();
+    order.clear();
+    if (n == 0) return 0;
+
+    //nearest neighbour tour
+    std::vector<unsigned char> visited(n, 0);
+    order.push_back(0);
+    visited[0] = 1;
+    for (size_t k = 1; k < n; k++)
+    {
+        size_t last = order.back();
+        size_t best = n;
+        for (size_t j = 0; j < n; j++)
+        {
+            if (visited[j]) continue;
+            if (best == n || costs[last][j] < costs[last][best]) best = j;
+        }
+        order.push_back(best);
+        visited[best] = 1;
+    }
+
+    double length = 0;
+    for (size_t k = 1; k < n; k++) length += costs[order[k - 1]][order[k]];
+    if (length == inf) return inf;
+
+    //2-opt: reverses the segment order[i..k] while this shortens the tour. The tour is open, so the last segment
+    //has no following edge.
+    const double eps = 1e-9;
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+        for (size_t i = 1; i + 1 < n; i++)
+        {
+            for (size_t k = i + 1; k < n; k++)
+            {
+                size_t a = order[i - 1];
+                size_t b = order[i];
+                size_t c = order[k];
+                double delta = costs[a][c] - costs[a][b];
+                if (k + 1 < n)
+                {
+                    size_t d = order[k + 1];
+                    delta += costs[b][d] - costs[c][d];
+                }
+                if (delta < -eps)
+                {
+                    std::reverse(order.begin() + i, order.begin() + k + 1);
+                    length += delta;
+                    improved = true;
+                }
+            }
+        }
+    }
+    return length;
+}
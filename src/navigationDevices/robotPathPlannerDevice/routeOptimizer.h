@@ -0,0 +1,54 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef ROUTE_OPTIMIZER_H
+#define ROUTE_OPTIMIZER_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <atomic>
+#include <vector>
+
+//! Helper functions which compute the best order to visit a set of goals
+namespace route_optimizer
+{
+    /**
+    * Computes the length of the shortest path between each pair of cells, with the same metric used by the A* search
+    * (8-connected grid, only free cells are crossed).
+    * Instead of searching each pair of cells, a single Dijkstra search from each cell reaches all the following ones,
+    * i.e. N-1 searches for N cells. The searches are executed in parallel.
+    * @param map the gridmap containing the obstacles
+    * @param points the cells. The first one (usually the robot position) is allowed to be not free.
+    * @param costs costs[i][j] is the length [m] of the path between points[i] and points[j], infinity if there is no path
+    * @param num_threads the number of threads, 0 means one per core
+    * @param cancel if not null, the computation is interrupted as soon as it becomes true
+    * @return false if the computation has been interrupted
+    */
+    bool compute_cost_matrix(const yarp::dev::Nav2D::MapGrid2D& map, const std::vector<yarp::dev::Nav2D::XYCell>& points,
+                             std::vector<std::vector<double> >& costs, size_t num_threads = 0, const std::atomic<bool>* cancel = nullptr);
+
+    /**
+    * Computes the order in which the points should be visited, starting from the point 0 and without coming back,
+    * to minimize the total length. The tour built by the nearest neighbour heuristic is improved by 2-opt moves.
+    * @param costs the symmetric matrix computed by compute_cost_matrix()
+    * @param order the indices of the points, in the order they should be visited (order[0] is 0)
+    * @return the total length of the tour, infinity if some point is not reachable
+    */
+    double solve_open_tour(const std::vector<std::vector<double> >& costs, std::vector<size_t>& order);
+};
+
+#endif
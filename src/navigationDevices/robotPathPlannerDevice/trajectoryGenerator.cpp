@@ -0,0 +1,252 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "trajectoryGenerator.h"
+
+using namespace yarp::dev::Nav2D;
+
+#ifndef M_PI
+#define M_PI 3.14159265
+#endif
+
+namespace
+{
+    const double RAD2DEG = 180.0 / M_PI;
+    const double DEG2RAD = M_PI / 180.0;
+
+    struct point_t
+    {
+        double x;
+        double y;
+    };
+
+    point_t make_point(double x, double y)
+    {
+        point_t p;
+        p.x = x;
+        p.y = y;
+        return p;
+    }
+
+    double distance(const point_t& a, const point_t& b)
+    {
+        return hypot(b.x - a.x, b.y - a.y);
+    }
+
+    double normalize_angle(double angle)
+    {
+        //returns an angle in (-pi,pi]
+        angle = fmod(angle, 2 * M_PI);
+        if (angle > M_PI) angle -= 2 * M_PI;
+        if (angle <= -M_PI) angle += 2 * M_PI;
+        return angle;
+    }
+
+    //checks the straight lines which join the consecutive points
+    bool is_polyline_free(const MapGrid2D& map, const bit_grid& blocked, const std::vector<point_t>& points)
+    {
+        XYCell prev;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            XYWorld world(points[i].x, points[i].y);
+            if (map.isInsideMap(world) == false) return false;
+            XYCell curr = map.world2Cell(world);
+            if (i > 0 && blocked.is_line_clear(prev, curr) == false) return false;
+            prev = curr;
+        }
+        return true;
+    }
+
+    //samples the segment a-b every ds. The point a is not added.
+    void sample_segment(const point_t& a, const point_t& b, double ds, std::vector<point_t>& points)
+    {
+        double length = distance(a, b);
+        if (length < 1e-6) return;
+        size_t n = std::max<size_t>(1, size_t(ceil(length / ds)));
+        for (size_t i = 1; i <= n; i++)
+        {
+            double s = double(i) / n;
+            points.push_back(make_point(a.x + (b.x - a.x) * s, a.y + (b.y - a.y) * s));
+        }
+    }
+
+    //samples the quadratic Bezier curve from a to b with control point c, about every ds. The point a is not added.
+    void sample_curve(const point_t& a, const point_t& c, const point_t& b, double ds, std::vector<point_t>& points)
+    {
+        //the length of the control polygon is an upper bound of the length of the curve
+        double length = distance(a, c) + distance(c, b);
+        size_t n = std::max<size_t>(2, size_t(ceil(length / ds)));
+        for (size_t i = 1; i <= n; i++)
+        {
+            double s = double(i) / n;
+            double k0 = (1 - s) * (1 - s);
+            double k1 = 2 * s * (1 - s);
+            double k2 = s * s;
+            points.push_back(make_point(k0 * a.x + k1 * c.x + k2 * b.x, k0 * a.y + k1 * c.y + k2 * b.y));
+        }
+    }
+}
+
+trajectory_generator::limits_t::limits_t()
+{
+    max_lin_speed = 0.9;
+    max_lin_acc = 0.3;
+    max_lat_acc = 0.3;
+    max_ang_speed = 10.0;
+    blend_distance = 0.5;
+    sample_distance = 0.05;
+}
+
+bool trajectory_generator::compute_trajectory(const MapGrid2D& map, const bit_grid& blocked,
+                                              const Map2DLocation& start, double start_speed,
+                                              const Map2DPath& path, const limits_t& limits,
+                                              std::vector<setpoint_t>& trajectory)
+{
+    trajectory.clear();
+    if (path.size() == 0) return false;
+
+    double resolution = 0.05;
+    map.getResolution(resolution);
+    double ds = std::max(limits.sample_distance, 0.01);
+
+    //the corners of the path, starting from the robot position
+    std::vector<point_t> corners;
+    corners.push_back(make_point(start.x, start.y));
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        point_t p = make_point(path[i].x, path[i].y);
+        if (distance(corners.back(), p) > 1e-6) corners.push_back(p);
+    }
+    if (corners.size() < 2)
+    {
+        //the robot is already on the goal
+        setpoint_t sp;
+        sp.t = 0;
+        sp.x = start.x;
+        sp.y = start.y;
+        sp.theta = start.theta;
+        sp.lin_vel = 0;
+        sp.ang_vel = 0;
+        trajectory.push_back(sp);
+        return true;
+    }
+
+    //the smoothed path, sampled every ds. Each corner is replaced by a curve from the point a (on the incoming segment)
+    //to the point b (on the outgoing segment). A corner whose curves are all blocked is kept.
+    std::vector<point_t> samples;
+    samples.push_back(corners[0]);
+    point_t entry = corners[0];
+    for (size_t i = 1; i + 1 < corners.size(); i++)
+    {
+        const point_t& prev = corners[i - 1];
+        const point_t& corner = corners[i];
+        const point_t& next = corners[i + 1];
+        double len_in = distance(prev, corner);
+        double len_out = distance(corner, next);
+        double d = std::min(limits.blend_distance, std::min(len_in, len_out) / 2);
+        std::vector<point_t> curve;
+        point_t a = corner;
+        point_t b = corner;
+        for (; d >= resolution; d /= 2)
+        {
+            a = make_point(corner.x + (prev.x - corner.x) * d / len_in, corner.y + (prev.y - corner.y) * d / len_in);
+            b = make_point(corner.x + (next.x - corner.x) * d / len_out, corner.y + (next.y - corner.y) * d / len_out);
+            curve.clear();
+            curve.push_back(a);
+            sample_curve(a, corner, b, ds, curve);
+            if (is_polyline_free(map, blocked, curve)) break;
+        }
+        if (d < resolution)
+        {
+            sample_segment(entry, corner, ds, samples);
+            entry = corner;
+        }
+        else
+        {
+            sample_segment(entry, a, ds, samples);
+            samples.insert(samples.end(), curve.begin() + 1, curve.end());
+            entry = b;
+        }
+    }
+    sample_segment(entry, corners.back(), ds, samples);
+
+    //the direction of motion and the curvature of each sample. At a kept corner the direction changes in a single step,
+    //so the curvature limits bring the speed almost to zero.
+    size_t n = samples.size();
+    std::vector<double> heading(n);
+    std::vector<double> curvature(n, 0.0);
+    std::vector<double> step(n, 0.0);       //step[k] is the distance between the samples k-1 and k
+    for (size_t k = 1; k < n; k++)
+    {
+        step[k] = distance(samples[k - 1], samples[k]);
+        heading[k - 1] = atan2(samples[k].y - samples[k - 1].y, samples[k].x - samples[k - 1].x);
+    }
+    heading[n - 1] = heading[n - 2];
+    for (size_t k = 1; k + 1 < n; k++)
+    {
+        curvature[k] = normalize_angle(heading[k] - heading[k - 1]) / ((step[k] + step[k + 1]) / 2);
+    }
+
+    //the speed profile: the limits of each sample, then the acceleration limits in both directions
+    double max_ang_speed = std::max(limits.max_ang_speed * DEG2RAD, 1e-3);
+    std::vector<double> speed(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        double v = limits.max_lin_speed;
+        double c = fabs(curvature[k]);
+        if (c > 1e-6)
+        {
+            v = std::min(v, sqrt(limits.max_lat_acc / c));
+            v = std::min(v, max_ang_speed / c);
+        }
+        speed[k] = v;
+    }
+    speed[0] = std::min(speed[0], std::max(start_speed, 0.0));
+    speed[n - 1] = 0;
+    for (size_t k = 1; k < n; k++)
+    {
+        speed[k] = std::min(speed[k], sqrt(speed[k - 1] * speed[k - 1] + 2 * limits.max_lin_acc * step[k]));
+    }
+    for (size_t k = n - 1; k > 0; k--)
+    {
+        speed[k - 1] = std::min(speed[k - 1], sqrt(speed[k] * speed[k] + 2 * limits.max_lin_acc * step[k]));
+    }
+
+    //the timestamps, with constant acceleration between consecutive samples. A step is never shorter than the time
+    //needed to rotate by the change of direction at its start, which matters only at the kept corners.
+    trajectory.resize(n);
+    double t = 0;
+    for (size_t k = 0; k < n; k++)
+    {
+        if (k > 0)
+        {
+            double turn = fabs(curvature[k - 1]) * (step[k - 1] + step[k]) / 2;
+            t += std::max(step[k] / std::max((speed[k - 1] + speed[k]) / 2, 1e-3), turn / max_ang_speed);
+        }
+        setpoint_t& sp = trajectory[k];
+        sp.t = t;
+        sp.x = samples[k].x;
+        sp.y = samples[k].y;
+        sp.theta = heading[k] * RAD2DEG;
+        sp.lin_vel = speed[k];
+        sp.ang_vel = speed[k] * curvature[k] * RAD2DEG;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef TRAJECTORY_GENERATOR_H
+#define TRAJECTORY_GENERATOR_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DLocation.h>
+#include <yarp/dev/Map2DPath.h>
+#include <vector>
+#include "bit_grid.h"
+
+//! Helper functions which turn the path computed by the planner into a time-parameterized trajectory
+namespace trajectory_generator
+{
+    struct limits_t
+    {
+        double max_lin_speed;       //m/s
+        double max_lin_acc;         //m/s^2, both acceleration and deceleration
+        double max_lat_acc;         //m/s^2, centripetal acceleration in the curves
+        double max_ang_speed;       //deg/s
+        double blend_distance;      //m, the maximum distance from a corner at which the curve which replaces it starts
+        double sample_distance;     //m, the distance between two consecutive setpoints
+
+        limits_t();
+    };
+
+    struct setpoint_t
+    {
+        double t;                   //s, from the start of the trajectory
+        double x;                   //m
+        double y;                   //m
+        double theta;               //deg, the direction of motion
+        double lin_vel;             //m/s
+        double ang_vel;             //deg/s
+    };
+
+    /**
+    * Computes the trajectory through a sequence of waypoints, starting from the robot position.
+    * Each corner of the path is replaced by a quadratic Bezier curve which starts and ends on the two segments at
+    * blend_distance (at most half of each segment) from the corner. If the curve crosses a blocked cell, the blend
+    * distance is halved until the curve is free, possibly down to the sharp corner, where the robot stops and rotates.
+    * The curve is sampled every sample_distance and the speed of each sample is limited by max_lin_speed and, through the
+    * curvature, by max_lat_acc and max_ang_speed. A forward and a backward pass enforce max_lin_acc, the trajectory ends
+    * with zero speed on the last waypoint.
+    * @param map the map of the waypoints, used to convert them into cells
+    * @param blocked the cells which must not be crossed
+    * @param start the robot position
+    * @param start_speed the current speed of the robot [m/s]
+    * @param path the waypoints, the final goal last
+    * @param limits the kinematic limits of the robot
+    * @param trajectory the computed setpoints
+    * @return false if the path is empty
+    */
+    bool compute_trajectory(const yarp::dev::Nav2D::MapGrid2D& map, const bit_grid& blocked,
+                            const yarp::dev::Nav2D::Map2DLocation& start, double start_speed,
+                            const yarp::dev::Nav2D::Map2DPath& path, const limits_t& limits,
+                            std::vector<setpoint_t>& trajectory);
+};
+
+#endif
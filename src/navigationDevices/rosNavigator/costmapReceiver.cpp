@@ -0,0 +1,172 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/LogStream.h>
+#include <ros_map_conversion.h>
+#include <vector>
+#include "costmapReceiver.h"
+
+using namespace yarp::os;
+using namespace yarp::dev::Nav2D;
+
+costmapReceiver::costmapReceiver(const std::string& map_name, double period) :
+        PeriodicThread(period),
+        m_map_name(map_name),
+        m_front(new MapGrid2D),
+        m_back(new MapGrid2D)
+{
+    m_back_stale = false;
+    m_valid = false;
+    m_received_grids = 0;
+}
+
+bool costmapReceiver::open(const std::string& grid_topic, const std::string& updates_topic)
+{
+    if (!m_sub_grid.topic(grid_topic))
+    {
+        yError() << " opening " << grid_topic << " Topic, check your yarp-ROS network configuration\n";
+        return false;
+    }
+    //each update modifies only a part of the costmap, so none of them can be dropped
+    m_sub_updates.setStrict();
+    if (!m_sub_updates.topic(updates_topic))
+    {
+        yError() << " opening " << updates_topic << " Topic, check your yarp-ROS network configuration\n";
+        return false;
+    }
+    return true;
+}
+
+void costmapReceiver::close()
+{
+    if (isRunning()) stop();
+    m_sub_grid.interrupt();
+    m_sub_grid.close();
+    m_sub_updates.interrupt();
+    m_sub_updates.close();
+}
+
+void costmapReceiver::setInitialMap(const MapGrid2D& map)
+{
+    std::lock_guard<std::mutex> lock(m_front_mutex);
+    if (m_received_grids > 0) return;
+    *m_front = map;
+    m_back_stale = true;
+    m_valid = true;
+}
+
+bool costmapReceiver::getMap(MapGrid2D& map)
+{
+    std::lock_guard<std::mutex> lock(m_front_mutex);
+    if (!m_valid) return false;
+    map = *m_front;
+    return true;
+}
+
+void costmapReceiver::swapBuffers(bool back_stale)
+{
+    //constant time: only the pointers are exchanged
+    std::lock_guard<std::mutex> lock(m_front_mutex);
+    m_front.swap(m_back);
+    m_back_stale = back_stale;
+    m_valid = true;
+}
+
+bool costmapReceiver::applyUpdate(const yarp::rosmsg::map_msgs::OccupancyGridUpdate& update, MapGrid2D& map)
+{
+    size_t w = update.width;
+    size_t h = update.height;
+    if (update.x < 0 || update.y < 0 ||
+        update.x + w > map.width() || update.y + h > map.height() ||
+        update.data.size() != w * h)
+    {
+        return false;
+    }
+
+    //ROS rows are stored bottom-up
+    size_t map_h = map.height();
+    for (size_t j = 0; j < h; j++)
+    {
+        size_t yarp_y = map_h - 1 - (update.y + j);
+        const int8_t* src = update.data.data() + j * w;
+        for (size_t i = 0; i < w; i++)
+        {
+            XYCell cell(update.x + i, yarp_y);
+            int v = src[i];
+            map.setOccupancyData(cell, ros_map_conversion::occupancy_to_yarp(v));
+            map.setMapFlag(cell, ros_map_conversion::occupancy_to_flag(v));
+        }
+    }
+    return true;
+}
+
+void costmapReceiver::run()
+{
+    //full costmap (sent by move_base at startup and when the costmap is resized)
+    yarp::rosmsg::nav_msgs::OccupancyGrid* grid = m_sub_grid.read(false);
+    if (grid)
+    {
+        if (ros_map_conversion::ros_to_yarp(*grid, *m_back, m_map_name))
+        {
+            m_received_grids++;
+            swapBuffers(true);
+        }
+    }
+
+    //partial updates are applied to the back buffer, which then becomes the front one
+    std::vector<yarp::rosmsg::map_msgs::OccupancyGridUpdate> updates;
+    yarp::rosmsg::map_msgs::OccupancyGridUpdate* update = nullptr;
+    while ((update = m_sub_updates.read(false)) != nullptr)
+    {
+        updates.push_back(*update);
+    }
+    if (updates.empty())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_front_mutex);
+        if (!m_valid)
+        {
+            //no full costmap yet, the updates cannot be applied
+            return;
+        }
+        if (m_back_stale)
+        {
+            *m_back = *m_front;
+            m_back_stale = false;
+        }
+    }
+    bool applied = false;
+    for (size_t i = 0; i < updates.size(); i++)
+    {
+        applied |= applyUpdate(updates[i], *m_back);
+    }
+    if (!applied)
+    {
+        yWarning() << "costmapReceiver: the updates of" << m_map_name << "do not match the size of the costmap";
+        return;
+    }
+    swapBuffers(false);
+
+    //the new back buffer is the old front one: the same updates bring it up to date
+    for (size_t i = 0; i < updates.size(); i++)
+    {
+        applyUpdate(updates[i], *m_back);
+    }
+}
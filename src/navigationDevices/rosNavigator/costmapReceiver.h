@@ -0,0 +1,85 @@
+/*
+ * Copyright (C)2019 ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef COSTMAP_RECEIVER_H
+#define COSTMAP_RECEIVER_H
+
+#include <yarp/os/PeriodicThread.h>
+#include <yarp/os/Subscriber.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/rosmsg/nav_msgs/OccupancyGrid.h>
+#include <yarp/rosmsg/map_msgs/OccupancyGridUpdate.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+* Receives a costmap published by move_base (a full nav_msgs/OccupancyGrid followed by map_msgs/OccupancyGridUpdate
+* partial updates) and converts it to a MapGrid2D, in its own thread.
+* The map is double buffered: messages are decoded in a back buffer which is then swapped with the front buffer
+* (the one returned by getMap()) by exchanging two pointers. After the swap, partial updates are applied also to the new
+* back buffer, so that the two buffers stay aligned without copying the whole map.
+*/
+class costmapReceiver : public yarp::os::PeriodicThread
+{
+    std::string                                 m_map_name;
+    yarp::os::Subscriber<yarp::rosmsg::nav_msgs::OccupancyGrid>       m_sub_grid;
+    yarp::os::Subscriber<yarp::rosmsg::map_msgs::OccupancyGridUpdate> m_sub_updates;
+
+    std::mutex                                  m_front_mutex;
+    std::unique_ptr<yarp::dev::Nav2D::MapGrid2D> m_front;
+    std::unique_ptr<yarp::dev::Nav2D::MapGrid2D> m_back;
+    bool                                        m_back_stale;   //the back buffer must be copied from the front one before being updated
+    bool                                        m_valid;        //a map is available in the front buffer
+    std::atomic<size_t>                         m_received_grids;
+
+public:
+    /**
+    * @param map_name the name assigned to the received map
+    * @param period the polling period of the subscribers [s]
+    */
+    costmapReceiver(const std::string& map_name, double period = 0.01);
+
+    /**
+    * Subscribes to the costmap topics. The thread must be started afterwards.
+    * @param grid_topic the topic of the full costmap (e.g. /move_base/local_costmap/costmap)
+    * @param updates_topic the topic of the partial updates (e.g. /move_base/local_costmap/costmap_updates)
+    */
+    bool open(const std::string& grid_topic, const std::string& updates_topic);
+    void close();
+
+    /**
+    * Sets the map returned until the first costmap is received.
+    */
+    void setInitialMap(const yarp::dev::Nav2D::MapGrid2D& map);
+
+    /**
+    * Gets a copy of the most recent map.
+    * @return false if no map has been received yet
+    */
+    bool getMap(yarp::dev::Nav2D::MapGrid2D& map);
+
+    virtual void run() override;
+
+private:
+    void swapBuffers(bool back_stale);
+    bool applyUpdate(const yarp::rosmsg::map_msgs::OccupancyGridUpdate& update, yarp::dev::Nav2D::MapGrid2D& map);
+};
+
+#endif
@@ -38,7 +38,9 @@ using namespace yarp::dev::Nav2D;
 #define DEG2RAD M_PI/180.0
 #endif
 
-rosNavigator::rosNavigator() : PeriodicThread(DEFAULT_THREAD_PERIOD)
+rosNavigator::rosNavigator() : PeriodicThread(DEFAULT_THREAD_PERIOD),
+    m_local_costmap("local_map"),
+    m_global_costmap("global_map")
 {
     m_rosNodeName = "/rosNavigator";
     m_rosTopicName_goal = "/move_base/goal";
@@ -122,16 +124,14 @@ bool rosNavigator::open(yarp::os::Searchable& config)
         yError() << " opening " << m_rosTopicName_result << " Topic, check your yarp-ROS network configuration\n";
         return false;
     }
-    if (!m_rosSubscriber_globalOccupancyGrid.topic(m_rosTopicName_globalOccupancyGrid))
+    //the costmaps are received and decoded by their own threads, in order to not slow down the navigation thread
+    if (!m_global_costmap.open(m_rosTopicName_globalOccupancyGrid, m_rosTopicName_globalOccupancyGrid + "_updates") ||
+        !m_local_costmap.open(m_rosTopicName_localOccupancyGrid, m_rosTopicName_localOccupancyGrid + "_updates"))
     {
-        yError() << " opening " << m_rosTopicName_globalOccupancyGrid << " Topic, check your yarp-ROS network configuration\n";
-        return false;
-    }
-    if (!m_rosSubscriber_localOccupancyGrid.topic(m_rosTopicName_localOccupancyGrid))
-    {
-        yError() << " opening " << m_rosTopicName_localOccupancyGrid << " Topic, check your yarp-ROS network configuration\n";
         return false;
     }
+    m_global_costmap.start();
+    m_local_costmap.start();
 
     this->start();
     return true;
@@ -139,6 +139,8 @@ bool rosNavigator::open(yarp::os::Searchable& config)
 
 bool rosNavigator::close()
 {
+    m_global_costmap.close();
+    m_local_costmap.close();
     if (m_rosNode != nullptr)
     {
         m_rosNode->interrupt();
@@ -186,11 +188,14 @@ bool rosNavigator::threadInit()
 
     //get the map
     yInfo() << "Asking for map 'ros_map'...";
-    bool b = m_iMap->get_map("ros_map",m_global_map);
-    m_global_map.crop(-1,-1,-1,-1);
+    MapGrid2D ros_map;
+    bool b = m_iMap->get_map("ros_map",ros_map);
+    ros_map.crop(-1,-1,-1,-1);
     if (b)
     {
         yInfo() << "'ros_map' received";
+        //used as global map until the first costmap is received
+        m_global_costmap.setInitialMap(ros_map);
     }
     else
     {
@@ -236,70 +241,6 @@ void rosNavigator::run()
 
     bool b1 = m_iLoc->getCurrentPosition(m_current_position);
 
-    if (0)
-    {
-        yarp::rosmsg::nav_msgs::OccupancyGrid* ros_global_map = m_rosSubscriber_globalOccupancyGrid.read(false);
-        if (global_map)
-        {
-            m_global_map.setSize_in_cells(ros_global_map->info.width, ros_global_map->info.height);
-            m_global_map.setResolution(ros_global_map->info.resolution);
-            m_global_map.setMapName("global_map");
-            yarp::math::Quaternion quat(ros_global_map->info.origin.orientation.x,
-                ros_global_map->info.origin.orientation.y,
-                ros_global_map->info.origin.orientation.z,
-                ros_global_map->info.origin.orientation.w);
-            yarp::sig::Matrix mat = quat.toRotationMatrix4x4();
-            yarp::sig::Vector vec = yarp::math::dcm2rpy(mat);
-            double orig_angle = vec[2];
-            m_global_map.setOrigin(ros_global_map->info.origin.position.x, ros_global_map->info.origin.position.y, orig_angle);
-            for (size_t y = 0; y < ros_global_map->info.height; y++)
-            {
-                for (size_t x = 0; x < ros_global_map->info.width; x++)
-                {
-                    XYCell cell(x, ros_global_map->info.height - 1 - y);
-                    double occ = ros_global_map->data[x + y * ros_global_map->info.width];
-                    m_global_map.setOccupancyData(cell, occ);
-
-                    if (occ >= 0 && occ <= 70)         m_global_map.setMapFlag(cell, MapGrid2D::MAP_CELL_FREE);
-                    else if (occ >= 71 && occ <= 100)  m_global_map.setMapFlag(cell, MapGrid2D::MAP_CELL_WALL);
-                    else                               m_global_map.setMapFlag(cell, MapGrid2D::MAP_CELL_UNKNOWN);
-                }
-            }
-        }
-    }
-
-    if (0)
-    {
-        yarp::rosmsg::nav_msgs::OccupancyGrid* ros_local_map = m_rosSubscriber_localOccupancyGrid.read(false);
-        if (local_map)
-        {
-            m_local_map.setSize_in_cells(ros_local_map->info.width, ros_local_map->info.height);
-            m_local_map.setResolution(ros_local_map->info.resolution);
-            m_local_map.setMapName("local_map");
-            yarp::math::Quaternion quat(ros_local_map->info.origin.orientation.x,
-                ros_local_map->info.origin.orientation.y,
-                ros_local_map->info.origin.orientation.z,
-                ros_local_map->info.origin.orientation.w);
-            yarp::sig::Matrix mat = quat.toRotationMatrix4x4();
-            yarp::sig::Vector vec = yarp::math::dcm2rpy(mat);
-            double orig_angle = vec[2];
-            m_local_map.setOrigin(ros_local_map->info.origin.position.x, ros_local_map->info.origin.position.y, orig_angle);
-            for (size_t y = 0; y < ros_local_map->info.height; y++)
-            {
-                for (size_t x = 0; x < ros_local_map->info.width; x++)
-                {
-                    XYCell cell(x, ros_local_map->info.height - 1 - y);
-                    double occ = ros_local_map->data[x + y * ros_local_map->info.width];
-                    m_local_map.setOccupancyData(cell, occ);
-
-                    if (occ >= 0 && occ <= 70)         m_local_map.setMapFlag(cell, MapGrid2D::MAP_CELL_FREE);
-                    else if (occ >= 71 && occ <= 100)  m_local_map.setMapFlag(cell, MapGrid2D::MAP_CELL_WALL);
-                    else                               m_local_map.setMapFlag(cell, MapGrid2D::MAP_CELL_UNKNOWN);
-                }
-            }
-        }
-    }
-    
     yarp::rosmsg::move_base_msgs::MoveBaseActionFeedback* feedback = m_rosSubscriber_feedback.read(false);
     if (feedback)
     {
@@ -475,13 +416,11 @@ bool rosNavigator::getCurrentNavigationMap(yarp::dev::NavigationMapTypeEnum map_
 {
     if (map_type == yarp::dev::NavigationMapTypeEnum::global_map)
     {
-        map = m_global_map;
-        return true;
+        return m_global_costmap.getMap(map);
     }
     else if (map_type == yarp::dev::NavigationMapTypeEnum::local_map)
     {
-        map = m_local_map;
-        return true;
+        return m_local_costmap.getMap(map);
     }
     yError() << "rosNavigator::getCurrentNavigationMap invalid type";
     return false;
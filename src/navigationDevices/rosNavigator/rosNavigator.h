@@ -38,6 +38,7 @@
 #include <yarp/rosmsg/actionlib_msgs/GoalID.h>
 #include <yarp/rosmsg/actionlib_msgs/GoalStatusArray.h>
 #include <yarp/rosmsg/nav_msgs/OccupancyGrid.h>
+#include "costmapReceiver.h"
 #include <math.h>
 
 #ifndef ROS_NAVIGATOR_H
@@ -69,8 +70,8 @@ protected:
     std::string                       m_rosNodeName;
     yarp::os::Node                    *m_rosNode;                  // add a ROS node
     yarp::os::NetUint32               m_rosMsgCounter;             // incremental counter in the ROS message
-    yarp::dev::Nav2D::MapGrid2D       m_local_map;
-    yarp::dev::Nav2D::MapGrid2D       m_global_map;
+    costmapReceiver                   m_local_costmap;
+    costmapReceiver                   m_global_costmap;
 
     std::string                       m_rosTopicName_goal;
     std::string                       m_rosTopicName_cancel;
@@ -86,8 +87,6 @@ protected:
     yarp::os::Subscriber<yarp::rosmsg::move_base_msgs::MoveBaseActionFeedback> m_rosSubscriber_feedback;
     yarp::os::Subscriber<yarp::rosmsg::actionlib_msgs::GoalStatusArray> m_rosSubscriber_status;
     yarp::os::Subscriber<yarp::rosmsg::move_base_msgs::MoveBaseActionResult> m_rosSubscriber_result;
-    yarp::os::Subscriber<yarp::rosmsg::nav_msgs::OccupancyGrid> m_rosSubscriber_localOccupancyGrid;
-    yarp::os::Subscriber<yarp::rosmsg::nav_msgs::OccupancyGrid> m_rosSubscriber_globalOccupancyGrid;
 
 public:
     rosNavigator();
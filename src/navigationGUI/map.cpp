@@ -30,6 +30,7 @@
 #include <yarp/dev/Map2DLocation.h>
 #include <string>
 #include <math.h>
+#include <algorithm>
 #include <cv.h>
 #include <highgui.h> 
 
@@ -45,12 +46,10 @@ bool map_utilites::sendToPort (BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelR
 {
     if (port!=0 && port->getOutputCount()>0)
     {
-        yarp::sig::ImageOf<yarp::sig::PixelRgb> *segImg = new yarp::sig::ImageOf<yarp::sig::PixelRgb>;
-        segImg->resize(image_to_send->width, image_to_send->height );
-        cvCopy(image_to_send, (IplImage*)segImg->getIplImage());
-        port->prepare() = *segImg;
+        yarp::sig::ImageOf<yarp::sig::PixelRgb>& segImg = port->prepare();
+        segImg.resize(image_to_send->width, image_to_send->height );
+        cvCopy(image_to_send, (IplImage*)segImg.getIplImage());
         port->write();
-        delete segImg;
         return true;
     }
     return false;
@@ -185,7 +184,7 @@ void map_utilites::update_obstacles_map(MapGrid2D& map_to_be_updated, const MapG
 {
     //copies obstacles (and only them) from a source map to a destination map
     if (map_to_be_updated.width() != obstacles_map.width() ||
-        map_to_be_updated.height() != map_to_be_updated.height())
+        map_to_be_updated.height() != obstacles_map.height())
     {
         yError() << "update_obstacles_map: the two maps must have the same size!";
         return;
@@ -203,6 +202,137 @@ void map_utilites::update_obstacles_map(MapGrid2D& map_to_be_updated, const MapG
                 { flag_dst=MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE; }
                 else if (flag_src==MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE)
                 { flag_dst=MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE; }
+                map_to_be_updated.setMapFlag(XYCell (x,y), flag_dst);
             }
         }
 }
+
+void DirtyRegion::add(CvRect r)
+{
+    if (m_full || r.width <= 0 || r.height <= 0) return;
+
+    //merges the new rectangle with all the rectangles it overlaps
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (auto it = m_rects.begin(); it != m_rects.end(); it++)
+        {
+            if (r.x <= it->x + it->width && it->x <= r.x + r.width &&
+                r.y <= it->y + it->height && it->y <= r.y + r.height)
+            {
+                int x1 = std::min(r.x, it->x);
+                int y1 = std::min(r.y, it->y);
+                int x2 = std::max(r.x + r.width, it->x + it->width);
+                int y2 = std::max(r.y + r.height, it->y + it->height);
+                r = cvRect(x1, y1, x2 - x1, y2 - y1);
+                m_rects.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+    m_rects.push_back(r);
+
+    //too many small rectangles: they are collapsed in their bounding box
+    const size_t max_rects = 32;
+    if (m_rects.size() > max_rects)
+    {
+        int x1 = m_rects[0].x;
+        int y1 = m_rects[0].y;
+        int x2 = m_rects[0].x + m_rects[0].width;
+        int y2 = m_rects[0].y + m_rects[0].height;
+        for (size_t i = 1; i < m_rects.size(); i++)
+        {
+            x1 = std::min(x1, m_rects[i].x);
+            y1 = std::min(y1, m_rects[i].y);
+            x2 = std::max(x2, m_rects[i].x + m_rects[i].width);
+            y2 = std::max(y2, m_rects[i].y + m_rects[i].height);
+        }
+        m_rects.clear();
+        m_rects.push_back(cvRect(x1, y1, x2 - x1, y2 - y1));
+    }
+}
+
+void DirtyRegion::addCell(XYCell c, int margin)
+{
+    add(cvRect((int)c.x - margin, (int)c.y - margin, 2 * margin + 1, 2 * margin + 1));
+}
+
+void DirtyRegion::addCells(const std::vector<XYCell>& cells, int margin)
+{
+    if (cells.empty()) return;
+    int x1 = (int)cells[0].x;
+    int y1 = (int)cells[0].y;
+    int x2 = x1;
+    int y2 = y1;
+    for (size_t i = 1; i < cells.size(); i++)
+    {
+        x1 = std::min(x1, (int)cells[i].x);
+        y1 = std::min(y1, (int)cells[i].y);
+        x2 = std::max(x2, (int)cells[i].x);
+        y2 = std::max(y2, (int)cells[i].y);
+    }
+    add(cvRect(x1 - margin, y1 - margin, x2 - x1 + 2 * margin + 1, y2 - y1 + 2 * margin + 1));
+}
+
+void DirtyRegion::addLine(XYCell a, XYCell b, int margin)
+{
+    int x1 = std::min((int)a.x, (int)b.x);
+    int y1 = std::min((int)a.y, (int)b.y);
+    int x2 = std::max((int)a.x, (int)b.x);
+    int y2 = std::max((int)a.y, (int)b.y);
+    add(cvRect(x1 - margin, y1 - margin, x2 - x1 + 2 * margin + 1, y2 - y1 + 2 * margin + 1));
+}
+
+void DirtyRegion::addRegion(const DirtyRegion& other)
+{
+    if (other.m_full)
+    {
+        setFull();
+        return;
+    }
+    for (size_t i = 0; i < other.m_rects.size(); i++)
+    {
+        add(other.m_rects[i]);
+    }
+}
+
+bool DirtyRegion::contains(XYCell c) const
+{
+    if (m_full) return true;
+    for (size_t i = 0; i < m_rects.size(); i++)
+    {
+        if ((int)c.x >= m_rects[i].x && (int)c.x < m_rects[i].x + m_rects[i].width &&
+            (int)c.y >= m_rects[i].y && (int)c.y < m_rects[i].y + m_rects[i].height)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirtyRegion::restore(IplImage* dst, const IplImage* src) const
+{
+    if (dst == 0 || src == 0) return;
+    if (m_full)
+    {
+        cvCopy(src, dst);
+        return;
+    }
+    for (size_t i = 0; i < m_rects.size(); i++)
+    {
+        //clip the rectangle to the image
+        int x1 = std::max(m_rects[i].x, 0);
+        int y1 = std::max(m_rects[i].y, 0);
+        int x2 = std::min(m_rects[i].x + m_rects[i].width, dst->width);
+        int y2 = std::min(m_rects[i].y + m_rects[i].height, dst->height);
+        if (x2 <= x1 || y2 <= y1) continue;
+        CvRect roi = cvRect(x1, y1, x2 - x1, y2 - y1);
+        cvSetImageROI(dst, roi);
+        cvSetImageROI(const_cast<IplImage*>(src), roi);
+        cvCopy(src, dst);
+        cvResetImageROI(const_cast<IplImage*>(src));
+        cvResetImageROI(dst);
+    }
+}
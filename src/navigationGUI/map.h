@@ -27,6 +27,7 @@
 #include <yarp/sig/ImageDraw.h>
 #include <yarp/dev/MapGrid2D.h>
 #include <string>
+#include <vector>
 #include <cv.h>
 #include <highgui.h> 
 #include <queue>
@@ -61,4 +62,29 @@ namespace map_utilites
     void update_obstacles_map(yarp::dev::Nav2D::MapGrid2D& map_to_be_updated, const yarp::dev::Nav2D::MapGrid2D& obstacles_map);
 };
 
+//! A set of rectangles of an image which have been modified and need to be redrawn.
+//! Overlapping rectangles are merged, so that each pixel is copied only once when the region is restored.
+class DirtyRegion
+{
+    std::vector<CvRect> m_rects;
+    bool                m_full;
+
+public:
+    DirtyRegion() : m_full(false) {}
+
+    void add(CvRect r);
+    void addCell(XYCell c, int margin);
+    void addCells(const std::vector<XYCell>& cells, int margin);
+    void addLine(XYCell a, XYCell b, int margin);
+    void addRegion(const DirtyRegion& other);
+    void setFull() { m_full = true; m_rects.clear(); }
+    void clear() { m_full = false; m_rects.clear(); }
+    bool isEmpty() const { return m_full == false && m_rects.empty(); }
+    bool isFull() const { return m_full; }
+    bool contains(XYCell c) const;
+
+    //copies the dirty part of src into dst (the two images must have the same size)
+    void restore(IplImage* dst, const IplImage* src) const;
+};
+
 #endif
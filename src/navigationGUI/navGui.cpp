@@ -57,6 +57,16 @@ using namespace yarp::dev::Nav2D;
 #define DEG2RAD M_PI/180
 #endif
 
+//layout of the image [pixels]
+static const int MENU_HEIGHT = 40;          //the strip below the map, with the buttons and the infos
+static const int INFOS_OFFSET = 20;         //the row of the infos, from the top of the menu
+static const int INFOS_HEIGHT = 20;
+
+//margins [pixels] around the moving objects, which cover the region restored from i3_map_menu_scan in the next frame
+static const int LINE_MARGIN = 1;           //laser scans, path and axes
+static const int GOAL_MARGIN = 8;           //drawGoal() and drawPose(): circle and 6 pixels orientation segment
+static const int POSITION_MARGIN = 14;      //drawCurrentPosition(): circle and 12 pixels orientation segment
+
 NavGuiThread::~NavGuiThread()
 {
   /* { m_ptf.close(); };
@@ -212,11 +222,17 @@ bool  NavGuiThread::updateLocations()
     std::vector<std::string> all_locations;
     m_iMap->getLocationsList(all_locations);
     Map2DLocation tmp_loc;
-    m_locations_list.clear();
+    std::vector<Map2DLocation> locations_list;
     for (size_t i=0; i<all_locations.size(); i++)
     {
         m_iMap->getLocation(all_locations[i],tmp_loc);
-        m_locations_list.push_back(tmp_loc);
+        locations_list.push_back(tmp_loc);
+    }
+    if (locations_list != m_locations_list || all_locations != m_locations_names)
+    {
+        m_locations_list = locations_list;
+        m_locations_names = all_locations;
+        m_locations_changed = true;
     }
     return true;
 }
@@ -226,11 +242,17 @@ bool  NavGuiThread::updateAreas()
     std::vector<std::string> all_areas;
     m_iMap->getAreasList(all_areas);
     Map2DArea tmp_area;
-    m_areas_list.clear();
+    std::vector<Map2DArea> areas_list;
     for (size_t i = 0; i<all_areas.size(); i++)
     {
         m_iMap->getArea(all_areas[i], tmp_area);
-        m_areas_list.push_back(tmp_area);
+        areas_list.push_back(tmp_area);
+    }
+    if (areas_list != m_areas_list || all_areas != m_areas_names)
+    {
+        m_areas_list = areas_list;
+        m_areas_names = all_areas;
+        m_locations_changed = true;
     }
     return true;
 }
@@ -240,9 +262,50 @@ bool  NavGuiThread::readMaps()
     bool ret = true;
     ret &= m_iNav->getCurrentNavigationMap(yarp::dev::global_map, m_current_map);
     ret &= m_iNav->getCurrentNavigationMap(yarp::dev::NavigationMapTypeEnum::local_map, m_temporary_obstacles_map);
+    if (ret)
+    {
+        m_obstacles_decoder.load(m_temporary_obstacles_map);
+    }
     return ret;
 }
 
+void  NavGuiThread::readObstaclesData()
+{
+    //apply the deltas received from the navigation server
+    yarp::os::Bottle* delta = nullptr;
+    while ((delta = m_port_obstacles_input.read(false)) != nullptr)
+    {
+        m_obstacles_decoder.apply(*delta);
+    }
+
+    //if the stream is not available (or a message was lost and the next keyframe has not arrived yet),
+    //the whole obstacles map is periodically requested to the navigation server
+    if (m_obstacles_decoder.is_synced() == false &&
+        yarp::os::Time::now() - m_last_obstacles_poll > m_period_draw_enalarged_obstacles)
+    {
+        if (m_iNav->getCurrentNavigationMap(yarp::dev::NavigationMapTypeEnum::local_map, m_temporary_obstacles_map))
+        {
+            m_obstacles_decoder.load(m_temporary_obstacles_map);
+        }
+        if (m_remote_obstacles != "" && m_port_obstacles_input.getInputCount() == 0)
+        {
+            yarp::os::Network::connect(m_remote_obstacles, m_port_obstacles_input.getName(), "", true);
+        }
+        m_last_obstacles_poll = yarp::os::Time::now();
+    }
+
+    //the list of the cells to be drawn is updated only if something changed
+    XYCell dirty_min;
+    XYCell dirty_max;
+    if (m_obstacles_decoder.get_dirty_region(dirty_min, dirty_max))
+    {
+        static const std::vector<MapGrid2D::map_flags> obstacle_flags = { MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE, MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE };
+        m_obstacles_decoder.get_cells(obstacle_flags, m_obstacles_map_cells);
+        m_obstacles_decoder.clear_dirty();
+        m_obstacles_dirty.addLine(dirty_min, dirty_max, 0);
+    }
+}
+
 bool  NavGuiThread::readLocalizationData()
 {
     bool ret = m_iLoc->getCurrentPosition(m_localization_data);
@@ -320,30 +383,6 @@ void  NavGuiThread::readLaserData()
     }
 }
 
-bool prepare_image(IplImage* & image_to_be_prepared, const IplImage* template_image)
-{
-    if (template_image == 0)
-    {
-        yError() << "PlannerThread::draw_map cannot copy an empty image!";
-        return false;
-    }
-    if (image_to_be_prepared == 0) 
-    {
-        image_to_be_prepared = cvCloneImage(template_image);
-    }
-    else if (image_to_be_prepared->width != template_image->width ||
-             image_to_be_prepared->height != template_image->height)
-    {
-        cvResize(template_image, image_to_be_prepared);
-        cvCopy(template_image, image_to_be_prepared);
-    }
-    else
-    {
-        cvCopy(template_image, image_to_be_prepared);
-    }
-    return true;
-}
-
 void NavGuiThread::addMenu(CvFont& font)
 {
     button1_t = i1_map->height;
@@ -431,8 +470,20 @@ void NavGuiThread::draw_map()
     XYCell current_position = m_current_map.world2Cell(XYWorld(m_localization_data.x, m_localization_data.y));
     XYCell final_goal = m_current_map.world2Cell(XYWorld(m_curr_goal.x, m_curr_goal.y));
 
-    if (i1_map == nullptr)
+    //The image is composed by layers, each one obtained from the previous one by adding some overlays:
+    //i2_map_menu:      the map and the menu. It is regenerated only when the map changes.
+    //i3_map_menu_scan: i2_map_menu + the enlarged obstacles and the locations/areas, which change slowly.
+    //i4_map_with_path: i3_map_menu_scan + the moving objects (robot, laser scan, particles, path etc.)
+    //Each layer is updated only in the regions which changed since the previous frame, copying them from the layer below.
+    DirtyRegion slow_dirty;
+
+    //############### map and menu
+    if (i1_map == nullptr || m_drawn_map_name != m_current_map.getMapName())
     {
+        cvReleaseImage(&i1_map);
+        cvReleaseImage(&i2_map_menu);
+        cvReleaseImage(&i3_map_menu_scan);
+        cvReleaseImage(&i4_map_with_path);
 #if 1
         yarp::sig::ImageOf<yarp::sig::PixelRgb> map_image;
         m_current_map.getMapImage(map_image);
@@ -452,36 +503,89 @@ void NavGuiThread::draw_map()
         i1_map = cvCreateImage(CvSize(w, h), 8, 3);
         cvCopyMakeBorder(&tmp, i1_map, CvPoint(0, 0), cv::BORDER_ISOLATED);
 #endif
-
+        i2_map_menu = cvCreateImage(cvSize(i1_map->width, i1_map->height + MENU_HEIGHT), 8, 3);
+        cvCopyMakeBorder(i1_map, i2_map_menu, cvPoint(0, 0), cv::BORDER_ISOLATED);
+        addMenu(font);
+        i3_map_menu_scan = cvCloneImage(i2_map_menu);
+        i4_map_with_path = cvCloneImage(i2_map_menu);
+        m_drawn_map_name = m_current_map.getMapName();
+        m_drawn_menu_status = menuStatus();
+        m_dynamic_drawn.clear();
+        slow_dirty.setFull();
     }
-    if (i2_map_menu == nullptr)
+    CvRect menu_rect = cvRect(0, i1_map->height, i1_map->width, MENU_HEIGHT);
+    if (m_drawn_menu_status != menuStatus())
     {
-        //i2_map_menu = cvCreateImage(CvSize(i1_map->width, i1_map->height), 8, 3);
-        //cvCopy(i1_map, i2_map_menu);
-        i2_map_menu = cvCreateImage(cvSize(i1_map->width, i1_map->height+40), 8, 3);
-        cvCopyMakeBorder(i1_map, i2_map_menu, cvPoint(0, 0), cv::BORDER_ISOLATED);
+        addMenu(font);
+        m_drawn_menu_status = menuStatus();
+        slow_dirty.add(menu_rect);
     }
-    addMenu(font);
 
-    if (i3_map_menu_scan == nullptr)
+    //############### draw enlarged obstacles and locations
+    bool draw_obstacles = (m_laser_timeout_counter < TIMEOUT_MAX && m_enable_draw_enlarged_scans);
+    if (draw_obstacles != m_drawn_obstacles ||
+        m_enable_draw_all_locations != m_drawn_locations ||
+        m_locations_changed)
     {
-        i3_map_menu_scan = cvCreateImage(cvSize(i2_map_menu->width, i2_map_menu->height), 8, 3);
+        slow_dirty.setFull();
+        m_drawn_obstacles = draw_obstacles;
+        m_drawn_locations = m_enable_draw_all_locations;
+        m_locations_changed = false;
     }
-    cvCopy(i2_map_menu, i3_map_menu_scan);
+    if (draw_obstacles)
+    {
+        slow_dirty.addRegion(m_obstacles_dirty);
+    }
+    m_obstacles_dirty.clear();
 
-    //############### draw laser
-    if (m_laser_timeout_counter<TIMEOUT_MAX)
+    if (slow_dirty.isEmpty() == false)
     {
-        if (m_enable_draw_enlarged_scans)
+        slow_dirty.restore(i3_map_menu_scan, i2_map_menu);
+        if (draw_obstacles)
         {
-            map_utilites::drawLaserMap(i3_map_menu_scan, m_temporary_obstacles_map, azure_color);
+            std::vector<XYCell> cells_to_draw;
+            for (size_t i = 0; i < m_obstacles_map_cells.size(); i++)
+            {
+                if (slow_dirty.contains(m_obstacles_map_cells[i])) cells_to_draw.push_back(m_obstacles_map_cells[i]);
+            }
+            map_utilites::drawLaserScan(i3_map_menu_scan, cells_to_draw, azure_color);
         }
-        if (m_enable_draw_laser_scans)
+        //locations and areas are few: they are always redrawn entirely. Only the ones of the current map are drawn.
+        if (m_enable_draw_all_locations)
         {
-            map_utilites::drawLaserScan(i3_map_menu_scan, m_laser_map_cells, blue_color);
+            std::vector<std::string> area_names, location_names;
+            std::vector<Map2DArea> areas;
+            std::vector<Map2DLocation> locations;
+            m_areas_index.get_map(m_current_map.getMapName(), area_names, areas, location_names, locations);
+            for (size_t i=0; i<locations.size(); i++)
+            {
+                map_utilites::drawGoal(i3_map_menu_scan, m_current_map.world2Cell(XYWorld(locations[i].x, locations[i].y)), locations[i].theta* DEG2RAD, blue_color);
+            }
+            for (size_t i = 0; i<areas.size(); i++)
+            {
+                std::vector<XYCell> area;
+                for (size_t j = 0; j < areas[i].points.size(); j++)
+                {
+                    area.push_back(m_current_map.world2Cell(XYWorld(areas[i].points[j].x, areas[i].points[j].y)));
+                }
+                map_utilites::drawArea(i3_map_menu_scan, area, blue_color);
+            }
         }
     }
 
+    //############### restore the regions of the frame covered by the moving objects in the previous frame
+    DirtyRegion frame_dirty = m_dynamic_drawn;
+    frame_dirty.addRegion(slow_dirty);
+    frame_dirty.restore(i4_map_with_path, i3_map_menu_scan);
+    m_dynamic_drawn.clear();
+
+    //############### draw laser
+    if (m_laser_timeout_counter<TIMEOUT_MAX && m_enable_draw_laser_scans)
+    {
+        map_utilites::drawLaserScan(i4_map_with_path, m_laser_map_cells, blue_color);
+        m_dynamic_drawn.addCells(m_laser_map_cells, LINE_MARGIN);
+    }
+
     //############### draw goal
     switch (m_navigation_status)
     {
@@ -492,10 +596,12 @@ void NavGuiThread::draw_map()
         case navigation_status_failing:
         case navigation_status_paused:
         case navigation_status_thinking:
-            map_utilites::drawGoal(i3_map_menu_scan, final_goal, m_curr_goal.theta* DEG2RAD, red_color);
+            map_utilites::drawGoal(i4_map_with_path, final_goal, m_curr_goal.theta* DEG2RAD, red_color);
+            m_dynamic_drawn.addCell(final_goal, GOAL_MARGIN);
         break;
         case navigation_status_goal_reached:
-            map_utilites::drawGoal(i3_map_menu_scan, final_goal, m_curr_goal.theta* DEG2RAD, green_color);
+            map_utilites::drawGoal(i4_map_with_path, final_goal, m_curr_goal.theta* DEG2RAD, green_color);
+            m_dynamic_drawn.addCell(final_goal, GOAL_MARGIN);
         break;
         case navigation_status_idle:
         default:
@@ -507,31 +613,14 @@ void NavGuiThread::draw_map()
     int particles_to_be_drawn = std::min((int)m_enable_estimated_particles, (int)m_estimated_poses.size());
     for (size_t i = 0; i < particles_to_be_drawn; i++)
     {
-         map_utilites::drawPose(i3_map_menu_scan, m_current_map.world2Cell(XYWorld((m_estimated_poses)[i].x, (m_estimated_poses)[i].y)), (m_estimated_poses)[i].theta* DEG2RAD, green_color);
-    }
-    
-
-    //############### draw locations
-    if (m_enable_draw_all_locations)
-    {
-        for (size_t i=0; i<m_locations_list.size(); i++)
-        {
-            map_utilites::drawGoal(i3_map_menu_scan, m_current_map.world2Cell(XYWorld(m_locations_list[i].x, m_locations_list[i].y)), m_locations_list[i].theta* DEG2RAD, blue_color);
-        }
-        for (size_t i = 0; i<m_areas_list.size(); i++)
-        {
-            std::vector<XYCell> area;
-            for (size_t j = 0; j < m_areas_list[i].points.size(); j++)
-            {
-                area.push_back(m_current_map.world2Cell(XYWorld(m_areas_list[i].points[j].x, m_areas_list[i].points[j].y)));
-            }
-            map_utilites::drawArea(i3_map_menu_scan, area, blue_color);
-        }
-
+        XYCell particle = m_current_map.world2Cell(XYWorld((m_estimated_poses)[i].x, (m_estimated_poses)[i].y));
+        map_utilites::drawPose(i4_map_with_path, particle, (m_estimated_poses)[i].theta* DEG2RAD, green_color);
+        m_dynamic_drawn.addCell(particle, GOAL_MARGIN);
     }
 
     //############### draw Current Position
-    map_utilites::drawCurrentPosition(i3_map_menu_scan, current_position, m_localization_data.theta* DEG2RAD, azure_color);
+    map_utilites::drawCurrentPosition(i4_map_with_path, current_position, m_localization_data.theta* DEG2RAD, azure_color);
+    m_dynamic_drawn.addCell(current_position, POSITION_MARGIN);
 
     //############### draw Infos
     if (m_enable_draw_infos)
@@ -542,15 +631,22 @@ void NavGuiThread::draw_map()
         XYCell x_axis = m_current_map.world2Cell(w_x_axis);
         XYCell y_axis = m_current_map.world2Cell(w_y_axis);
         XYCell orig = m_current_map.world2Cell(w_orig);
-//        map_utilites::drawInfo(i3_map_menu_scan, current_position, orig, x_axis, y_axis, getNavigationStatusAsString(), m_localization_data, font, blue_color);
+//        map_utilites::drawInfo(i4_map_with_path, current_position, orig, x_axis, y_axis, getNavigationStatusAsString(), m_localization_data, font, blue_color);
 
         XYCell whereToDraw(10, i1_map->height+32);
-        map_utilites::drawInfoFixed(i3_map_menu_scan, whereToDraw, orig, x_axis, y_axis, getNavigationStatusAsString(), m_localization_data, font2, azure_color2);
+        std::string status = getNavigationStatusAsString();
+        std::string current_area;
+        if (m_areas_index.find_area(m_localization_data, current_area))
+        {
+            status += ", area= " + current_area;
+        }
+        map_utilites::drawInfoFixed(i4_map_with_path, whereToDraw, orig, x_axis, y_axis, status, m_localization_data, font2, azure_color2);
+        m_dynamic_drawn.add(cvRect(0, i1_map->height + INFOS_OFFSET, i1_map->width, INFOS_HEIGHT));
+        m_dynamic_drawn.addLine(orig, x_axis, LINE_MARGIN);
+        m_dynamic_drawn.addLine(orig, y_axis, LINE_MARGIN);
     }
 
     //############### draw path
-    prepare_image(i4_map_with_path, i3_map_menu_scan);
-
     CvScalar color = cvScalar(0, 200, 0);
     CvScalar color2 = cvScalar(0, 200, 100);
     CvScalar color3 = cvScalar(0, 50, 0);
@@ -562,16 +658,21 @@ void NavGuiThread::draw_map()
         m_navigation_status != navigation_status_failing)
         {
             std::queue <XYCell> all_waypoints_cell;
+            std::vector <XYCell> path_cells;
             for (int i = 0; i < m_all_waypoints.size(); i++)
             {
                 XYWorld curr_waypoint_world(m_all_waypoints[i].x, m_all_waypoints[i].y);
                 XYCell curr_waypoint_cell = m_current_map.world2Cell(curr_waypoint_world);
                 all_waypoints_cell.push(curr_waypoint_cell);
+                path_cells.push_back(curr_waypoint_cell);
             }
 
             XYWorld curr_waypoint_world(m_curr_waypoint.x, m_curr_waypoint.y);
             XYCell curr_waypoint_cell = m_current_map.world2Cell(curr_waypoint_world);
             map_utilites::drawPath(i4_map_with_path, current_position, curr_waypoint_cell, all_waypoints_cell, color3, color2);
+            path_cells.push_back(curr_waypoint_cell);
+            path_cells.push_back(current_position);
+            m_dynamic_drawn.addCells(path_cells, LINE_MARGIN);
         }
 
     //############### finished, send to port
@@ -597,12 +698,7 @@ void NavGuiThread::run()
         last_drawn_laser = yarp::os::Time::now();
     }
 
-    static double last_drawn_enlarged_obstacles = yarp::os::Time::now();
-    if (yarp::os::Time::now() - last_drawn_enlarged_obstacles > m_period_draw_enalarged_obstacles)
-    {
-        m_iNav->getCurrentNavigationMap(yarp::dev::NavigationMapTypeEnum::local_map, m_temporary_obstacles_map);
-        last_drawn_enlarged_obstacles = yarp::os::Time::now();
-    }
+    readObstaclesData();
 
     static double last_drawn_estimated_poses = yarp::os::Time::now();
     if (yarp::os::Time::now() - last_drawn_estimated_poses > m_period_draw_estimated_poses)
@@ -617,6 +713,7 @@ void NavGuiThread::run()
     {
         updateLocations();
         updateAreas();
+        m_areas_index.set_all(m_areas_names, m_areas_list, m_locations_names, m_locations_list);
         last_drawn_map_locations = yarp::os::Time::now();
     }
 
@@ -46,6 +46,8 @@
 #include <yarp/rosmsg/visualization_msgs/MarkerArray.h>
 
 #include "map.h"
+#include <obstacles_delta.h>
+#include <areas_index.h>
 
 using namespace std;
 using namespace yarp::os;
@@ -94,7 +96,9 @@ class NavGuiThread: public yarp::os::PeriodicThread
     std::string                                            m_remote_map;
     std::string                                            m_remote_laser;
     std::string                                            m_remote_navigation;
+    std::string                                            m_remote_obstacles;
     BufferedPort<yarp::os::Bottle>                         m_port_yarpview_target_input;
+    BufferedPort<yarp::os::Bottle>                         m_port_obstacles_input;
     BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelRgb> > m_port_map_output;
 
     //internal data
@@ -104,13 +108,21 @@ class NavGuiThread: public yarp::os::PeriodicThread
     yarp::dev::Nav2D::Map2DLocation        m_curr_waypoint;
     yarp::dev::Nav2D::Map2DPath            m_all_waypoints;
     std::vector<Map2DLocation>             m_locations_list;
+    std::vector<std::string>               m_locations_names;
     std::vector<Map2DArea>                 m_areas_list;
+    std::vector<std::string>               m_areas_names;
+    areas_index                            m_areas_index;    //locations and areas of each map, to find the area where the robot is
 
     //storage for the environment map
     yarp::dev::Nav2D::MapGrid2D m_current_map;
     yarp::dev::Nav2D::MapGrid2D m_temporary_obstacles_map;
     std::vector<yarp::dev::Nav2D::XYCell>   m_laser_map_cells;
 
+    //local copy of the obstacles map, kept updated by the stream of deltas published by the navigation server
+    obstacles_delta_decoder                 m_obstacles_decoder;
+    std::vector<yarp::dev::Nav2D::XYCell>   m_obstacles_map_cells;
+    double                                  m_last_obstacles_poll;
+
     //statuses of the internal finite-state machine
     NavigationStatusEnum   m_navigation_status;
     NavigationStatusEnum   m_previous_navigation_status;
@@ -130,6 +142,15 @@ class NavGuiThread: public yarp::os::PeriodicThread
     double              m_period_draw_estimated_poses;
     double              m_period_draw_map_locations;
 
+    //status of the layers of the displayed image, used to redraw only the regions which changed
+    std::string         m_drawn_map_name;
+    int                 m_drawn_menu_status;
+    bool                m_drawn_obstacles;
+    bool                m_drawn_locations;
+    bool                m_locations_changed;
+    DirtyRegion         m_obstacles_dirty;   //cells of the obstacles map changed since the last frame
+    DirtyRegion         m_dynamic_drawn;     //regions covered by the moving objects in the last frame
+
     //drawing flags: enable/disable drawing of particular objects on the GUI
     public:
     int                 m_enable_estimated_particles; //this sets a max number on the particles drawn
@@ -194,6 +215,7 @@ class NavGuiThread: public yarp::os::PeriodicThread
     void          readTargetFromYarpView();
     bool          readLocalizationData();
     bool          readMaps();
+    void          readObstaclesData();
     void          readLaserData();
     bool          readWaypointsAndGoal();
     bool          readNavigationStatus(bool& changed);
@@ -202,6 +224,7 @@ class NavGuiThread: public yarp::os::PeriodicThread
     bool          updateAreas();
     bool          click_in_menu(yarp::os::Bottle *gui_targ, yarp::math::Vec2D<int>& click_p);
     void          addMenu(CvFont& font);
+    int           menuStatus() const { return m_navigation_status * 2 + button3_status; }
 
     public:
     /**
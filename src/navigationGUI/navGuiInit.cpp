@@ -50,6 +50,8 @@ NavGuiThread::NavGuiThread(double _period, ResourceFinder &_rf) :
     m_remote_map = "/mapServer";
     m_remote_laser = "/ikart/laser:o";
     m_remote_navigation = "/navigationServer";
+    m_remote_obstacles = "/robotPathPlanner/obstacles:o";
+    m_last_obstacles_poll = 0;
 
     const int button_w = 70;
     const int button_h = 20;
@@ -80,6 +82,10 @@ NavGuiThread::NavGuiThread(double _period, ResourceFinder &_rf) :
     i2_map_menu = nullptr;
     i3_map_menu_scan = nullptr;
     i4_map_with_path = nullptr;
+    m_drawn_menu_status = -1;
+    m_drawn_obstacles = false;
+    m_drawn_locations = false;
+    m_locations_changed = false;
 }
 
 bool NavGuiThread::threadInit()
@@ -149,17 +155,29 @@ bool NavGuiThread::threadInit()
     {
         m_remote_map = general_group.find("remote_map").asString();
     }
+    if (general_group.check("remote_obstacles"))
+    {
+        m_remote_obstacles = general_group.find("remote_obstacles").asString();
+    }
     if (laser_group.check("remote_laser"))
     {
         m_remote_laser = laser_group.find("remote_laser").asString();
     }
     ret &= m_port_map_output.open((m_local_name_prefix + "/map:o").c_str());
     ret &= m_port_yarpview_target_input.open((m_local_name_prefix + "/yarpviewTarget:i").c_str());
+    //each delta is needed to decode the next ones, so the messages must not be dropped
+    m_port_obstacles_input.setStrict();
+    ret &= m_port_obstacles_input.open((m_local_name_prefix + "/obstacles:i").c_str());
     if (ret == false)
     {
         yError() << "Unable to open module ports";
         return false;
     }
+    if (m_remote_obstacles != "" &&
+        yarp::os::Network::connect(m_remote_obstacles, m_port_obstacles_input.getName()) == false)
+    {
+        yWarning() << "Unable to connect to" << m_remote_obstacles << ", the obstacles map will be periodically requested to the navigation server";
+    }
 
     //localization
     Property loc_options;
@@ -290,6 +308,8 @@ void NavGuiThread:: threadRelease()
     m_port_map_output.close();
     m_port_yarpview_target_input.interrupt();
     m_port_yarpview_target_input.close();
+    m_port_obstacles_input.interrupt();
+    m_port_obstacles_input.close();
 
     cvReleaseImage(&i1_map);
     cvReleaseImage(&i2_map_menu);
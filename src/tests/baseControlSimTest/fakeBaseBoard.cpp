@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * GPL-2+ license. See the accompanying LICENSE file for details.
+ */
+
+#include "fakeBaseBoard.h"
+#include <yarp/os/Value.h>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <cmath>
+
+using namespace yarp::os;
+using namespace yarp::dev;
+
+FakeBaseBoard::FakeBaseBoard()
+{
+    m_axes          = 0;
+    m_wheel_tau     = 0.05;
+    m_pwm_to_vel    = 0.01;
+    m_max_wheel_acc = 10000;
+}
+
+bool FakeBaseBoard::open(yarp::os::Searchable& config)
+{
+    m_axes          = config.check("axes",          Value(3),     "number of simulated wheels").asInt();
+    m_wheel_tau     = config.check("wheel_tau",     Value(0.05),  "time constant of the wheel velocity response [s]").asDouble();
+    m_pwm_to_vel    = config.check("pwm_to_vel",    Value(0.01),  "wheel velocity obtained with a unitary pwm [deg/s]").asDouble();
+    m_max_wheel_acc = config.check("max_wheel_acc", Value(10000), "maximum wheel acceleration [deg/s^2]").asDouble();
+
+    if (m_axes <= 0 || m_wheel_tau < 0 || m_max_wheel_acc <= 0)
+    {
+        yError() << "fakeBaseBoard: invalid parameters";
+        return false;
+    }
+
+    m_mode.assign(m_axes, VOCAB_CM_IDLE);
+    m_ref_vel.assign(m_axes, 0.0);
+    m_ref_acc.assign(m_axes, 0.0);
+    m_ref_pwm.assign(m_axes, 0.0);
+    m_vel.assign(m_axes, 0.0);
+    m_acc.assign(m_axes, 0.0);
+    m_pos.assign(m_axes, 0.0);
+    return true;
+}
+
+bool FakeBaseBoard::close()
+{
+    return true;
+}
+
+void FakeBaseBoard::step(double dt)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (dt <= 0) return;
+
+    //exact discretization of the first order response
+    double alpha = (m_wheel_tau > 0) ? 1.0 - exp(-dt / m_wheel_tau) : 1.0;
+    for (int j = 0; j < m_axes; j++)
+    {
+        double target = 0;
+        if      (m_mode[j] == VOCAB_CM_VELOCITY) target = m_ref_vel[j];
+        else if (m_mode[j] == VOCAB_CM_PWM)      target = m_ref_pwm[j] * m_pwm_to_vel;
+
+        double dv = (target - m_vel[j]) * alpha;
+        double dv_max = m_max_wheel_acc * dt;
+        if (dv >  dv_max) dv =  dv_max;
+        if (dv < -dv_max) dv = -dv_max;
+
+        //trapezoidal integration of the position
+        double old_vel = m_vel[j];
+        m_vel[j] += dv;
+        m_acc[j]  = dv / dt;
+        m_pos[j] += (old_vel + m_vel[j]) / 2.0 * dt;
+    }
+}
+
+double FakeBaseBoard::get_wheel_vel(int j)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return 0;
+    return m_vel[j];
+}
+
+bool FakeBaseBoard::getAxes(int *ax)
+{
+    *ax = m_axes;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------
+// IVelocityControl
+
+bool FakeBaseBoard::velocityMove(int j, double sp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    m_ref_vel[j] = sp;
+    return true;
+}
+
+bool FakeBaseBoard::velocityMove(const double *sp)
+{
+    for (int j = 0; j < m_axes; j++) velocityMove(j, sp[j]);
+    return true;
+}
+
+bool FakeBaseBoard::velocityMove(const int n_joint, const int *joints, const double *spds)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= velocityMove(joints[i], spds[i]);
+    return ret;
+}
+
+bool FakeBaseBoard::getRefVelocity(const int joint, double *vel)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(joint)) return false;
+    *vel = m_ref_vel[joint];
+    return true;
+}
+
+bool FakeBaseBoard::getRefVelocities(double *vels)
+{
+    for (int j = 0; j < m_axes; j++) getRefVelocity(j, &vels[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getRefVelocities(const int n_joint, const int *joints, double *vels)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= getRefVelocity(joints[i], &vels[i]);
+    return ret;
+}
+
+bool FakeBaseBoard::setRefAcceleration(int j, double acc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    m_ref_acc[j] = acc;
+    return true;
+}
+
+bool FakeBaseBoard::setRefAccelerations(const double *accs)
+{
+    for (int j = 0; j < m_axes; j++) setRefAcceleration(j, accs[j]);
+    return true;
+}
+
+bool FakeBaseBoard::setRefAccelerations(const int n_joint, const int *joints, const double *accs)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= setRefAcceleration(joints[i], accs[i]);
+    return ret;
+}
+
+bool FakeBaseBoard::getRefAcceleration(int j, double *acc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    *acc = m_ref_acc[j];
+    return true;
+}
+
+bool FakeBaseBoard::getRefAccelerations(double *accs)
+{
+    for (int j = 0; j < m_axes; j++) getRefAcceleration(j, &accs[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getRefAccelerations(const int n_joint, const int *joints, double *accs)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= getRefAcceleration(joints[i], &accs[i]);
+    return ret;
+}
+
+bool FakeBaseBoard::stop(int j)
+{
+    return velocityMove(j, 0.0);
+}
+
+bool FakeBaseBoard::stop()
+{
+    for (int j = 0; j < m_axes; j++) stop(j);
+    return true;
+}
+
+bool FakeBaseBoard::stop(const int n_joint, const int *joints)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= stop(joints[i]);
+    return ret;
+}
+
+//------------------------------------------------------------------------------------------------------------------
+// IEncoders
+
+bool FakeBaseBoard::resetEncoder(int j)
+{
+    return setEncoder(j, 0.0);
+}
+
+bool FakeBaseBoard::resetEncoders()
+{
+    for (int j = 0; j < m_axes; j++) resetEncoder(j);
+    return true;
+}
+
+bool FakeBaseBoard::setEncoder(int j, double val)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    m_pos[j] = val;
+    return true;
+}
+
+bool FakeBaseBoard::setEncoders(const double *vals)
+{
+    for (int j = 0; j < m_axes; j++) setEncoder(j, vals[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getEncoder(int j, double *v)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    *v = m_pos[j];
+    return true;
+}
+
+bool FakeBaseBoard::getEncoders(double *encs)
+{
+    for (int j = 0; j < m_axes; j++) getEncoder(j, &encs[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getEncoderSpeed(int j, double *sp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    *sp = m_vel[j];
+    return true;
+}
+
+bool FakeBaseBoard::getEncoderSpeeds(double *spds)
+{
+    for (int j = 0; j < m_axes; j++) getEncoderSpeed(j, &spds[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getEncoderAcceleration(int j, double *spds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    *spds = m_acc[j];
+    return true;
+}
+
+bool FakeBaseBoard::getEncoderAccelerations(double *accs)
+{
+    for (int j = 0; j < m_axes; j++) getEncoderAcceleration(j, &accs[j]);
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------
+// IPWMControl
+
+bool FakeBaseBoard::getNumberOfMotors(int *number)
+{
+    *number = m_axes;
+    return true;
+}
+
+bool FakeBaseBoard::setRefDutyCycle(int m, double ref)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(m)) return false;
+    m_ref_pwm[m] = ref;
+    return true;
+}
+
+bool FakeBaseBoard::setRefDutyCycles(const double *refs)
+{
+    for (int j = 0; j < m_axes; j++) setRefDutyCycle(j, refs[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getRefDutyCycle(int m, double *ref)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(m)) return false;
+    *ref = m_ref_pwm[m];
+    return true;
+}
+
+bool FakeBaseBoard::getRefDutyCycles(double *refs)
+{
+    for (int j = 0; j < m_axes; j++) getRefDutyCycle(j, &refs[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getDutyCycle(int m, double *val)
+{
+    return getRefDutyCycle(m, val);
+}
+
+bool FakeBaseBoard::getDutyCycles(double *vals)
+{
+    return getRefDutyCycles(vals);
+}
+
+//------------------------------------------------------------------------------------------------------------------
+// IControlMode
+
+bool FakeBaseBoard::getControlMode(int j, int *mode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    *mode = m_mode[j];
+    return true;
+}
+
+bool FakeBaseBoard::getControlModes(int *modes)
+{
+    for (int j = 0; j < m_axes; j++) getControlMode(j, &modes[j]);
+    return true;
+}
+
+bool FakeBaseBoard::getControlModes(const int n_joint, const int *joints, int *modes)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= getControlMode(joints[i], &modes[i]);
+    return ret;
+}
+
+bool FakeBaseBoard::setControlMode(const int j, const int mode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid(j)) return false;
+    //a force idle request puts the joint in idle, as a real board does
+    m_mode[j] = (mode == VOCAB_CM_FORCE_IDLE) ? VOCAB_CM_IDLE : mode;
+    return true;
+}
+
+bool FakeBaseBoard::setControlModes(const int n_joint, const int *joints, int *modes)
+{
+    bool ret = true;
+    for (int i = 0; i < n_joint; i++) ret &= setControlMode(joints[i], modes[i]);
+    return ret;
+}
+
+bool FakeBaseBoard::setControlModes(int *modes)
+{
+    for (int j = 0; j < m_axes; j++) setControlMode(j, modes[j]);
+    return true;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * GPL-2+ license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef FAKE_BASE_BOARD_H
+#define FAKE_BASE_BOARD_H
+
+#include <yarp/os/Searchable.h>
+#include <yarp/dev/DeviceDriver.h>
+#include <yarp/dev/ControlBoardInterfaces.h>
+#include <mutex>
+#include <vector>
+
+/**
+ * \section fakeBaseBoard
+ * An in-process control board which simulates the wheels of a mobile base.
+ * Each wheel is modeled as a first order system (time constant wheel_tau) tracking either the velocity
+ * reference (VOCAB_CM_VELOCITY) or the pwm reference scaled by pwm_to_vel (VOCAB_CM_PWM).
+ * The simulation does not run on its own: time is advanced explicitly by calling step(), so that the
+ * board can be run in lockstep with baseControl faster than real time.
+ *
+ *  Parameters required by this device are:
+ * | Parameter name | Type    | Units    | Default Value | Required | Description                                   |
+ * |:--------------:|:-------:|:--------:|:-------------:|:--------:|:---------------------------------------------:|
+ * | axes           | int     | -        | 3             | No       | number of simulated wheels                    |
+ * | wheel_tau      | double  | s        | 0.05          | No       | time constant of the wheel velocity response  |
+ * | pwm_to_vel     | double  | deg/s    | 0.01          | No       | wheel velocity obtained with a unitary pwm    |
+ * | max_wheel_acc  | double  | deg/s^2  | 10000         | No       | maximum wheel acceleration                    |
+ */
+class FakeBaseBoard : public yarp::dev::DeviceDriver,
+                      public yarp::dev::IVelocityControl,
+                      public yarp::dev::IEncoders,
+                      public yarp::dev::IPWMControl,
+                      public yarp::dev::IControlMode
+{
+    std::mutex           m_mutex;
+    int                  m_axes;
+    double               m_wheel_tau;
+    double               m_pwm_to_vel;
+    double               m_max_wheel_acc;
+
+    std::vector<int>     m_mode;
+    std::vector<double>  m_ref_vel;
+    std::vector<double>  m_ref_acc;
+    std::vector<double>  m_ref_pwm;
+    std::vector<double>  m_vel;
+    std::vector<double>  m_acc;
+    std::vector<double>  m_pos;
+
+public:
+    FakeBaseBoard();
+
+    /**
+    * Advances the simulation
+    * @param dt the integration step [s]
+    */
+    void   step(double dt);
+
+    /**
+    * Returns the simulated velocity of a wheel [deg/s]
+    */
+    double get_wheel_vel(int j);
+
+    //DeviceDriver
+    virtual bool open(yarp::os::Searchable& config) override;
+    virtual bool close() override;
+
+    //IVelocityControl and IEncoders
+    virtual bool getAxes(int *ax) override;
+
+    //IVelocityControl
+    virtual bool velocityMove(int j, double sp) override;
+    virtual bool velocityMove(const double *sp) override;
+    virtual bool velocityMove(const int n_joint, const int *joints, const double *spds) override;
+    virtual bool getRefVelocity(const int joint, double *vel) override;
+    virtual bool getRefVelocities(double *vels) override;
+    virtual bool getRefVelocities(const int n_joint, const int *joints, double *vels) override;
+    virtual bool setRefAcceleration(int j, double acc) override;
+    virtual bool setRefAccelerations(const double *accs) override;
+    virtual bool setRefAccelerations(const int n_joint, const int *joints, const double *accs) override;
+    virtual bool getRefAcceleration(int j, double *acc) override;
+    virtual bool getRefAccelerations(double *accs) override;
+    virtual bool getRefAccelerations(const int n_joint, const int *joints, double *accs) override;
+    virtual bool stop(int j) override;
+    virtual bool stop() override;
+    virtual bool stop(const int n_joint, const int *joints) override;
+
+    //IEncoders
+    virtual bool resetEncoder(int j) override;
+    virtual bool resetEncoders() override;
+    virtual bool setEncoder(int j, double val) override;
+    virtual bool setEncoders(const double *vals) override;
+    virtual bool getEncoder(int j, double *v) override;
+    virtual bool getEncoders(double *encs) override;
+    virtual bool getEncoderSpeed(int j, double *sp) override;
+    virtual bool getEncoderSpeeds(double *spds) override;
+    virtual bool getEncoderAcceleration(int j, double *spds) override;
+    virtual bool getEncoderAccelerations(double *accs) override;
+
+    //IPWMControl
+    virtual bool getNumberOfMotors(int *number) override;
+    virtual bool setRefDutyCycle(int m, double ref) override;
+    virtual bool setRefDutyCycles(const double *refs) override;
+    virtual bool getRefDutyCycle(int m, double *ref) override;
+    virtual bool getRefDutyCycles(double *refs) override;
+    virtual bool getDutyCycle(int m, double *val) override;
+    virtual bool getDutyCycles(double *vals) override;
+
+    //IControlMode
+    virtual bool getControlMode(int j, int *mode) override;
+    virtual bool getControlModes(int *modes) override;
+    virtual bool getControlModes(const int n_joint, const int *joints, int *modes) override;
+    virtual bool setControlMode(const int j, const int mode) override;
+    virtual bool setControlModes(const int n_joint, const int *joints, int *modes) override;
+    virtual bool setControlModes(int *modes) override;
+
+private:
+    bool   valid(int j) const { return j >= 0 && j < m_axes; }
+};
+
+#endif
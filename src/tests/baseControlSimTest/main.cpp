@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2019 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * GPL-2+ license. See the accompanying LICENSE file for details.
+ */
+
+#include <yarp/os/Network.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Clock.h>
+#include <yarp/os/Time.h>
+#include <yarp/dev/Drivers.h>
+#include <yarp/dev/PolyDriver.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <navigation_defines.h>
+#include "controlThread.h"
+#include "fakeBaseBoard.h"
+
+/**
+ * \section baseControlSimTest
+ * A deterministic simulation harness for baseControl. The ControlThread, together with its MotorControl,
+ * OdometryHandler and Input handlers, is run in lockstep with an in-process simulated control board (fakeBaseBoard).
+ * Time is provided by a simulated clock, so the control loop runs faster than real time and the results are
+ * reproducible. No robot, simulator or yarpserver is required.
+ * The harness drives the robot along a predefined sequence of commands and checks:
+ * - the response of the acceleration limiter (maximum acceleration of the base, rise time)
+ * - the accuracy of the odometry, compared to the ground truth computed from the simulated wheels
+ * - the computational cost of a single iteration of the control loop
+ * The executable returns a non-zero value if one of the checks fails, so it can be used in CI.
+ * Usage: baseControlSimTest --robot_type <cer|ikart_V1|ikart_V2> [--control_mode velocity_no_pid] [--period 0.020]
+ *        [--max_pos_error 0.05] [--max_theta_error 2.0]
+ */
+
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace std;
+
+#ifndef DEG2RAD
+#define DEG2RAD M_PI/180.0
+#endif
+
+//A clock which is advanced explicitly by the harness
+class SimClock : public yarp::os::Clock
+{
+    double m_now;
+public:
+    SimClock() : m_now(1000.0) {}
+    virtual double now() override          { return m_now; }
+    virtual void   delay(double s) override { if (s > 0) m_now += s; }
+    virtual bool   isValid() const override { return true; }
+    void           step(double dt)          { m_now += dt; }
+};
+
+//A command applied for a given amount of time
+struct SimPhase
+{
+    double duration;
+    double vx;   //m/s
+    double vy;   //m/s
+    double w;    //deg/s
+};
+
+//The robot kinematics, used to compute the ground truth from the simulated wheels.
+//It reproduces the kinematic model assumed by the odometry handlers, so that the error measures
+//the estimation error (velocity estimators, integration) and not a model mismatch.
+class SimKinematics
+{
+    string m_robot_type;
+    double m_r;
+    double m_L;
+    double m_g_angle;
+    double m_ikin[3][3];
+
+public:
+    double x;
+    double y;
+    double theta; //rad
+
+    SimKinematics(string robot_type) : m_robot_type(robot_type), x(0), y(0), theta(0)
+    {
+        m_g_angle = 0;
+        if      (robot_type == "cer")      { m_r = 320.0 / 2 / 1000.0; m_L = 338 / 1000.0; }
+        else if (robot_type == "ikart_V1") { m_r = 62.5 / 1000.0;      m_L = 273 / 1000.0; m_g_angle = 0.0; }
+        else                               { m_r = 76.15 / 1000.0;     m_L = 273 / 1000.0; m_g_angle = 45.0; }
+
+        //inverse of the three wheels kinematic matrix (see iKart_Odometry::compute())
+        double k[3][3] = { { -sqrt(3.0) / 2.0, 0.5, m_L }, { sqrt(3.0) / 2.0, 0.5, m_L }, { 0, -1.0, m_L } };
+        double det = k[0][0] * (k[1][1] * k[2][2] - k[1][2] * k[2][1])
+                   - k[0][1] * (k[1][0] * k[2][2] - k[1][2] * k[2][0])
+                   + k[0][2] * (k[1][0] * k[2][1] - k[1][1] * k[2][0]);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+            {
+                int i1 = (j + 1) % 3, i2 = (j + 2) % 3;
+                int j1 = (i + 1) % 3, j2 = (i + 2) % 3;
+                m_ikin[i][j] = (k[i1][j1] * k[i2][j2] - k[i1][j2] * k[i2][j1]) / det * m_r;
+            }
+    }
+
+    int axes() { return (m_robot_type == "cer") ? 2 : 3; }
+
+    //integrates the robot pose, given the wheel velocities (deg/s)
+    void step(const vector<double>& wheel_vel, double dt)
+    {
+        double bx = 0, by = 0, bt = 0;
+        if (m_robot_type == "cer")
+        {
+            double wl = wheel_vel[0] * DEG2RAD;
+            double wr = wheel_vel[1] * DEG2RAD;
+            bx = m_r / 2 * (wl + wr);
+            bt = m_r / m_L * (wr - wl);
+        }
+        else
+        {
+            double w[3] = { -wheel_vel[0] * DEG2RAD, -wheel_vel[1] * DEG2RAD, -wheel_vel[2] * DEG2RAD };
+            double v[3] = { 0, 0, 0 };
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    v[i] += m_ikin[i][j] * w[j];
+            bx = cos(m_g_angle) * v[0] - sin(m_g_angle) * v[1];
+            by = sin(m_g_angle) * v[0] + cos(m_g_angle) * v[1];
+            bt = v[2];
+        }
+        //midpoint integration
+        double tm = theta + bt * dt / 2;
+        x += (bx * cos(tm) - by * sin(tm)) * dt;
+        y += (bx * sin(tm) + by * cos(tm)) * dt;
+        theta += bt * dt;
+    }
+};
+
+static string build_configuration(const string& robot_type, const string& control_mode)
+{
+    string cfg;
+    cfg += "local /baseControlSim\n";
+    cfg += "remote /baseControlSim/fakeBoard\n";
+    cfg += "control_board_device fakeBaseBoard\n";
+    cfg += "[GENERAL]\n";
+    cfg += "joypad1_configuration <none>\n";
+    cfg += "joypad2_configuration <none>\n";
+    cfg += "robot_type " + robot_type + "\n";
+    cfg += "control_mode " + control_mode + "\n";
+    cfg += "linear_angular_ratio 0.7\n";
+    cfg += "ratio_limiter_enabled 0\n";
+    cfg += "input_filter_enabled 0\n";
+    cfg += "max_linear_vel 0.30\n";
+    cfg += "max_angular_vel 30.0\n";
+    cfg += "max_linear_acc 0.30\n";
+    cfg += "max_angular_acc 80.0\n";
+    cfg += "use_ROS false\n";
+    cfg += "[MOTORS]\n";
+    cfg += "max_motor_pwm 10000\n";
+    cfg += "max_motor_vel 200\n";
+    cfg += "motors_filter_enabled 0\n";
+    cfg += "[JOYSTICK]\n";
+    cfg += "linear_vel_at_full_control 0.30\n";
+    cfg += "angular_vel_at_full_control 30.0\n";
+    cfg += "[LINEAR_VELOCITY_PID]\n";
+    cfg += "kp 0.0\nki 0.0\nkd 0.0\nmax +200\nmin -200\n";
+    cfg += "[ANGULAR_VELOCITY_PID]\n";
+    cfg += "kp 0.0\nki 0.0\nkd 0.0\nmax +200\nmin -200\n";
+    cfg += "[HEADING_VELOCITY_PID]\n";
+    cfg += "kp 0.0\nki 0.0\nkd 0.0\nmax +100\nmin -100\n";
+    cfg += "[ROS_ODOMETRY]\n";
+    cfg += "topic_name /odometry\nodom_frame odom\nbase_frame mobile_base_body_link\n";
+    cfg += "[ROS_FOOTPRINT]\n";
+    cfg += "topic_name /footprint\nfootprint_frame mobile_base_body_link\nfootprint_diameter 0.510\n";
+    return cfg;
+}
+
+int main(int argc, char* argv[])
+{
+    ResourceFinder rf;
+    rf.configure(argc, argv);
+
+    if (rf.check("help"))
+    {
+        yInfo("Usage: baseControlSimTest --robot_type <cer|ikart_V1|ikart_V2> [--control_mode velocity_no_pid] [--period 0.020]");
+        return 0;
+    }
+
+    string robot_type      = rf.check("robot_type",      Value("cer")).asString();
+    string control_mode    = rf.check("control_mode",    Value("velocity_no_pid")).asString();
+    double period          = rf.check("period",          Value(0.020)).asDouble();
+    double max_pos_error   = rf.check("max_pos_error",   Value(0.05)).asDouble();
+    double max_theta_error = rf.check("max_theta_error", Value(2.0)).asDouble();
+
+    //no yarpserver is required: the ports opened by baseControl are registered locally
+    Network yarp;
+    Network::setLocalMode(true);
+
+    SimClock clock;
+    Time::useCustomClock(&clock);
+
+    Drivers::factory().add(new DriverCreatorOf<FakeBaseBoard>("fakeBaseBoard", "", "FakeBaseBoard"));
+
+    SimKinematics kin(robot_type);
+    Property ctrl_options;
+    ctrl_options.fromConfig(build_configuration(robot_type, control_mode).c_str());
+
+    ControlThread* control_thr = new ControlThread(period, rf, ctrl_options);
+    if (!control_thr->threadInit())
+    {
+        yError() << "Unable to initialize the control thread";
+        delete control_thr;
+        return 1;
+    }
+
+    FakeBaseBoard* board = nullptr;
+    if (!control_thr->get_control_board_driver() || !control_thr->get_control_board_driver()->view(board) || !board)
+    {
+        yError() << "fakeBaseBoard not available";
+        control_thr->threadRelease();
+        delete control_thr;
+        return 1;
+    }
+
+    //a square path, followed by a stop
+    vector<SimPhase> phases;
+    for (int i = 0; i < 4; i++)
+    {
+        phases.push_back({ 5.0, 0.2, 0.0, 0.0 });
+        phases.push_back({ 1.0, 0.0, 0.0, 0.0 });
+        phases.push_back({ 4.0, 0.0, 0.0, 22.5 });
+        phases.push_back({ 1.0, 0.0, 0.0, 0.0 });
+    }
+    phases.push_back({ 2.0, 0.0, 0.0, 0.0 });
+
+    bool   ok = true;
+    double max_acc = 0;
+    double rise_time = -1;
+    double prev_speed = 0;
+    double loop_cost_tot = 0;
+    double loop_cost_max = 0;
+    size_t iterations = 0;
+    vector<double> wheel_vel(kin.axes(), 0.0);
+    auto sim_start = std::chrono::steady_clock::now();
+
+    for (size_t p = 0; p < phases.size(); p++)
+    {
+        size_t steps = (size_t)(phases[p].duration / period + 0.5);
+        for (size_t s = 0; s < steps; s++)
+        {
+            //the command is sent as it was received from the control:i port
+            Bottle b;
+            b.addInt(BASECONTROL_COMMAND_VELOCIY_CARTESIAN);
+            b.addDouble(phases[p].vx);
+            b.addDouble(phases[p].vy);
+            b.addDouble(phases[p].w);
+            b.addDouble(100);
+            control_thr->get_input_handler()->push_port_command(INPUT_SOURCE_COMMAND, b);
+
+            auto t0 = std::chrono::steady_clock::now();
+            control_thr->run();
+            auto t1 = std::chrono::steady_clock::now();
+            double cost = std::chrono::duration<double>(t1 - t0).count();
+            loop_cost_tot += cost;
+            if (cost > loop_cost_max) loop_cost_max = cost;
+            iterations++;
+
+            board->step(period);
+            for (int j = 0; j < kin.axes(); j++) wheel_vel[j] = board->get_wheel_vel(j);
+            double old_x = kin.x, old_y = kin.y;
+            kin.step(wheel_vel, period);
+            clock.step(period);
+
+            //acceleration limiter check (first phase only, pure translation)
+            double speed = sqrt((kin.x - old_x) * (kin.x - old_x) + (kin.y - old_y) * (kin.y - old_y)) / period;
+            if (p == 0)
+            {
+                double acc = fabs(speed - prev_speed) / period;
+                if (s > 0 && acc > max_acc) max_acc = acc;
+                if (rise_time < 0 && speed >= 0.9 * phases[0].vx) rise_time = (s + 1) * period;
+            }
+            prev_speed = speed;
+        }
+    }
+    auto sim_end = std::chrono::steady_clock::now();
+    double wall_time = std::chrono::duration<double>(sim_end - sim_start).count();
+
+    double odom_x = 0, odom_y = 0, odom_t = 0;
+    if (control_thr->get_odometry_handler())
+    {
+        control_thr->get_odometry_handler()->get_odometry(odom_x, odom_y, odom_t);
+    }
+    double true_t = kin.theta / DEG2RAD;
+    double pos_error = sqrt((odom_x - kin.x) * (odom_x - kin.x) + (odom_y - kin.y) * (odom_y - kin.y));
+    double theta_error = fmod(fabs(odom_t - true_t), 360.0);
+    if (theta_error > 180.0) theta_error = 360.0 - theta_error;
+
+    double sim_time = iterations * period;
+    yInfo("robot_type: %s control_mode: %s period: %.3fs", robot_type.c_str(), control_mode.c_str(), period);
+    yInfo("simulated time: %.1fs wall time: %.3fs (%.0fx real time)", sim_time, wall_time, sim_time / wall_time);
+    yInfo("loop cost: avg %.1fus max %.1fus, throughput %.0f iterations/s", loop_cost_tot / iterations * 1e6, loop_cost_max * 1e6, iterations / loop_cost_tot);
+    yInfo("linear acceleration: max %.3f m/s^2 (limit 0.30), rise time (90%%): %.3fs", max_acc, rise_time);
+    yInfo("ground truth: x %+.3f y %+.3f t %+.2f", kin.x, kin.y, true_t);
+    yInfo("odometry:     x %+.3f y %+.3f t %+.2f", odom_x, odom_y, odom_t);
+    yInfo("odometry error: position %.4fm orientation %.3fdeg", pos_error, theta_error);
+
+    //the limiter is applied to the reference, the wheel dynamics can only smooth it further
+    if (max_acc > 0.30 * 1.05)                    { yError() << "acceleration limiter check failed"; ok = false; }
+    if (rise_time < 0)                            { yError() << "the commanded speed has never been reached"; ok = false; }
+    if (control_thr->get_odometry_handler())
+    {
+        if (pos_error > max_pos_error)            { yError() << "odometry position check failed"; ok = false; }
+        if (theta_error > max_theta_error)        { yError() << "odometry orientation check failed"; ok = false; }
+    }
+
+    control_thr->threadRelease();
+    delete control_thr;
+    Time::useSystemClock();
+
+    yInfo() << (ok ? "All checks passed" : "Some checks failed");
+    return ok ? 0 : 1;
+}